@@ -0,0 +1,99 @@
+/**
+ * Minimal CBOR (RFC 8949) decoder for the payloads sent by the ESP32.
+ * Supports integers, byte/text strings, arrays, maps, floats and simple values
+ * with definite lengths, which is everything the firmware encoder produces.
+ */
+
+/**
+ * Decodes a half precision float
+ */
+function decodeHalf(half) {
+  const exponent = (half >> 10) & 0x1f;
+  const mantissa = half & 0x3ff;
+  const sign = half & 0x8000 ? -1 : 1;
+  if (exponent === 0) return sign * mantissa * 2 ** -24;
+  if (exponent === 0x1f) return mantissa ? NaN : sign * Infinity;
+  return sign * (mantissa + 1024) * 2 ** (exponent - 25);
+}
+
+/**
+ * Decodes one CBOR data item from a Buffer
+ */
+function decode(buffer) {
+  let pos = 0;
+
+  function need(len) {
+    if (pos + len > buffer.length) {
+      throw new Error("CBOR payload truncated");
+    }
+  }
+
+  function readArgument(info) {
+    if (info < 24) return info;
+    if (info === 24) { need(1); return buffer.readUInt8(pos++); }
+    if (info === 25) { need(2); pos += 2; return buffer.readUInt16BE(pos - 2); }
+    if (info === 26) { need(4); pos += 4; return buffer.readUInt32BE(pos - 4); }
+    if (info === 27) { need(8); pos += 8; return Number(buffer.readBigUInt64BE(pos - 8)); }
+    throw new Error(`Unsupported CBOR length encoding ${info}`);
+  }
+
+  function readItem() {
+    need(1);
+    const initial = buffer[pos++];
+    const major = initial >> 5;
+    const info = initial & 0x1f;
+
+    switch (major) {
+      case 0:
+        return readArgument(info);
+      case 1:
+        return -1 - readArgument(info);
+      case 2: {
+        const len = readArgument(info);
+        need(len);
+        pos += len;
+        return buffer.subarray(pos - len, pos);
+      }
+      case 3: {
+        const len = readArgument(info);
+        need(len);
+        pos += len;
+        return buffer.toString("utf8", pos - len, pos);
+      }
+      case 4: {
+        const len = readArgument(info);
+        const items = [];
+        for (let i = 0; i < len; i++) items.push(readItem());
+        return items;
+      }
+      case 5: {
+        const len = readArgument(info);
+        const map = {};
+        for (let i = 0; i < len; i++) {
+          const key = readItem();
+          map[key] = readItem();
+        }
+        return map;
+      }
+      case 6:
+        readArgument(info); /** Tags carry no meaning for these payloads, return the tagged item */
+        return readItem();
+      default:
+        if (info === 20) return false;
+        if (info === 21) return true;
+        if (info === 22 || info === 23) return null;
+        if (info === 25) { need(2); pos += 2; return decodeHalf(buffer.readUInt16BE(pos - 2)); }
+        if (info === 26) { need(4); pos += 4; return buffer.readFloatBE(pos - 4); }
+        if (info === 27) { need(8); pos += 8; return buffer.readDoubleBE(pos - 8); }
+        throw new Error(`Unsupported CBOR simple value ${info}`);
+    }
+  }
+
+  const item = readItem();
+  if (pos !== buffer.length) {
+    throw new Error("Trailing bytes after CBOR item");
+  }
+  return item;
+}
+
+module.exports = { decode };
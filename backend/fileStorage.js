@@ -0,0 +1,284 @@
+/**
+ * Local storage engine: append-only files in one directory, for running and load testing the backend offline.
+ * Every change is appended as one JSON line, so a write is atomic (a line torn by a crash is ignored when
+ * the file is read back) and costs the same whatever the amount of data. A file is rewritten with its live
+ * records only once it holds FILE_COMPACT_FACTOR times more lines than that.
+ *
+ *   history/<chipId>.log   time series of a device: { "add": [[key, entry], ...], "del": [key, ...] },
+ *                          the chip id percent-encoded, see historyFileName()
+ *   settings.log           { "id": chipId, "value": settings }, the last line of a device wins
+ *   devices.log            { "id": chipId, "value": info }, value null when the device was removed
+ *
+ * Lines are written without fsync: a crash of the machine may lose the last writes, not corrupt older ones.
+ */
+const fs = require("fs");
+const path = require("path");
+
+const FILE_COMPACT_FACTOR = 4;   /** Lines per live record above which a file is rewritten */
+const FILE_COMPACT_SLACK = 64;   /** Lines always allowed, so small files are never rewritten */
+
+/**
+ * One append-only file. Writes are queued so they reach the file in the order they were made,
+ * compaction included.
+ */
+class AppendFile {
+  constructor(filePath) {
+    this.filePath = filePath;
+    this.handle = null;
+    this.queue = Promise.resolve();
+    this.lines = 0;
+    this.torn = false; /** A write failed, its partial line must be ended before the next one */
+  }
+
+  /**
+   * Reads every complete line of the file, parsed, and counts them for the compaction
+   */
+  async readAll() {
+    let text;
+    try {
+      text = await fs.promises.readFile(this.filePath, "utf8");
+    } catch (error) {
+      if (error.code === "ENOENT") return [];
+      throw error;
+    }
+    /** Drop the line torn by a crash while it was written, so the next append starts on a line of its own */
+    const complete = text.slice(0, text.lastIndexOf("\n") + 1);
+    if (complete.length !== text.length) {
+      await fs.promises.truncate(this.filePath, Buffer.byteLength(complete));
+    }
+    const records = [];
+    for (const line of complete.split("\n")) {
+      if (!line) continue;
+      try {
+        records.push(JSON.parse(line));
+      } catch (error) {
+        /** Corrupted line, skipped */
+      }
+    }
+    this.lines = records.length;
+    return records;
+  }
+
+  /**
+   * Queues an operation after the writes already made to this file
+   */
+  enqueue(operation) {
+    const result = this.queue.then(operation);
+    this.queue = result.catch(() => {});
+    return result;
+  }
+
+  /**
+   * Appends a record as one line. written is called once the line is in the file, before the next queued
+   * operation, so in-memory state follows the file and a failed write leaves it unchanged.
+   */
+  append(record, written = () => {}) {
+    return this.enqueue(async () => {
+      if (!this.handle) {
+        await fs.promises.mkdir(path.dirname(this.filePath), { recursive: true });
+        this.handle = await fs.promises.open(this.filePath, "a");
+      }
+      try {
+        await this.handle.write((this.torn ? "\n" : "") + JSON.stringify(record) + "\n");
+      } catch (error) {
+        this.torn = true; /** The partial line is skipped when the file is read back */
+        throw error;
+      }
+      this.torn = false;
+      this.lines++;
+      written();
+    });
+  }
+
+  /**
+   * Rewrites the file with the given records if it grew FILE_COMPACT_FACTOR times larger than them.
+   * records is called once the writes queued before are done, so it sees the final state.
+   */
+  compact(liveCount, records) {
+    if (this.lines <= FILE_COMPACT_FACTOR * liveCount + FILE_COMPACT_SLACK) {
+      return Promise.resolve();
+    }
+    return this.enqueue(async () => {
+      const lines = records().map((record) => JSON.stringify(record) + "\n");
+      const tmpPath = `${this.filePath}.tmp`;
+      await fs.promises.writeFile(tmpPath, lines.join(""));
+      if (this.handle) {
+        await this.handle.close();
+        this.handle = null;
+      }
+      await fs.promises.rename(tmpPath, this.filePath);
+      this.lines = lines.length;
+    });
+  }
+
+  async close() {
+    await this.queue;
+    if (this.handle) {
+      await this.handle.close();
+      this.handle = null;
+    }
+  }
+}
+
+/**
+ * Map persisted as { id, value } lines, kept whole in memory
+ */
+class KeyValueFile {
+  constructor(filePath) {
+    this.file = new AppendFile(filePath);
+    this.values = new Map();
+  }
+
+  async load() {
+    for (const { id, value } of await this.file.readAll()) {
+      if (value === null) this.values.delete(id);
+      else this.values.set(id, value);
+    }
+  }
+
+  async set(id, value) {
+    await this.file.append({ id, value }, () => {
+      if (value === null) this.values.delete(id);
+      else this.values.set(id, value);
+    });
+    await this.file.compact(this.values.size, () => [...this.values].map(([key, item]) => ({ id: key, value: item })));
+  }
+}
+
+/**
+ * Function to name the history file of a device: every character other than letters, digits, '_' and '-'
+ * is percent-encoded as its UTF-8 bytes, so names are valid on every file system (':' of MAC addresses is not
+ * on Windows) and distinct chip ids never share a file. chipIdFromFileName() reverses it.
+ */
+function historyFileName(chipId) {
+  const encoded = [...chipId].map((c) => (/[0-9A-Za-z_-]/.test(c) ? c :
+    [...Buffer.from(c, "utf8")].map((b) => `%${b.toString(16).toUpperCase().padStart(2, "0")}`).join(""))).join("");
+  return `${encoded}.log`;
+}
+
+/**
+ * Function to return the chip id of a history file name made by historyFileName()
+ */
+function chipIdFromFileName(fileName) {
+  return decodeURIComponent(fileName.replace(/\.log$/, ""));
+}
+
+/**
+ * Function to rename the history file of a device from the former lossy naming, where every other character
+ * became '_', unless the device already has a file under its current name
+ */
+async function adoptLegacyHistory(dir, chipId) {
+  const legacyPath = path.join(dir, "history", `${chipId.replace(/[^0-9A-Za-z_-]/g, "_")}.log`);
+  const currentPath = path.join(dir, "history", historyFileName(chipId));
+  if (legacyPath === currentPath) return;
+  try {
+    await fs.promises.access(currentPath);
+  } catch (error) {
+    try {
+      await fs.promises.rename(legacyPath, currentPath);
+    } catch (renameError) {
+      if (renameError.code !== "ENOENT") throw renameError;
+    }
+  }
+}
+
+class FileStorage {
+  constructor(dir) {
+    this.dir = dir;
+    this.name = `local files in ${dir}`;
+    this.settings = new KeyValueFile(path.join(dir, "settings.log"));
+    this.devices = new KeyValueFile(path.join(dir, "devices.log"));
+    this.histories = new Map(); /** chipId -> { file, live: Map key -> entry } once read */
+    this.lastKeyTime = 0;
+    this.keySeq = 0;
+    this.ready = false;
+  }
+
+  async start() {
+    await fs.promises.mkdir(path.join(this.dir, "history"), { recursive: true });
+    await this.settings.load();
+    await this.devices.load();
+    this.ready = true;
+  }
+
+  isReady() {
+    return this.ready;
+  }
+
+  async getSettings(chipId) {
+    return this.settings.values.get(chipId) || null;
+  }
+
+  async setSettings(chipId, settings) {
+    await this.settings.set(chipId, settings);
+  }
+
+  /**
+   * Returns the history file of a device, replayed into its live entries the first time
+   */
+  async history(chipId) {
+    let history = this.histories.get(chipId);
+    if (!history) {
+      const file = new AppendFile(path.join(this.dir, "history", historyFileName(chipId)));
+      history = adoptLegacyHistory(this.dir, chipId).then(() => file.readAll()).then((records) => {
+        const live = new Map();
+        for (const record of records) {
+          for (const [key, entry] of record.add || []) live.set(key, entry);
+          for (const key of record.del || []) live.delete(key);
+        }
+        return { file, live };
+      });
+      this.histories.set(chipId, history);
+      history.catch(() => this.histories.delete(chipId));
+    }
+    return history;
+  }
+
+  async loadHistory(chipId) {
+    const { live } = await this.history(chipId);
+    return [...live].sort(([a], [b]) => (a < b ? -1 : a > b ? 1 : 0));
+  }
+
+  /**
+   * Returns a new history key; keys sort in creation order, like Firebase push keys
+   */
+  newHistoryKey() {
+    const now = Date.now();
+    if (now !== this.lastKeyTime) {
+      this.lastKeyTime = now;
+      this.keySeq = 0;
+    }
+    return `${now.toString(36).padStart(9, "0")}-${(this.keySeq++).toString(36).padStart(4, "0")}`;
+  }
+
+  async writeHistory(chipId, added, removedKeys) {
+    const { file, live } = await this.history(chipId);
+    await file.append({ add: added, del: removedKeys }, () => {
+      for (const [key, entry] of added) live.set(key, entry);
+      for (const key of removedKeys) live.delete(key);
+    });
+    await file.compact(live.size, () => [{ add: [...live], del: [] }]);
+  }
+
+  async registerDevice(chipId, info) {
+    await this.devices.set(chipId, info);
+  }
+
+  async getRegisteredDevices() {
+    return Object.fromEntries(this.devices.values);
+  }
+
+  async removeDevice(chipId) {
+    await this.devices.set(chipId, null);
+  }
+
+  async close() {
+    await this.settings.file.close();
+    await this.devices.file.close();
+    for (const history of this.histories.values()) {
+      await (await history).file.close();
+    }
+  }
+}
+
+module.exports = { FileStorage, historyFileName, chipIdFromFileName };
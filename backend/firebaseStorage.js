@@ -0,0 +1,141 @@
+/**
+ * Firebase Realtime Database storage engine, the default.
+ * Needs esp32_project_serviceAccountKey.json and internet access; connectivity is checked every 10 seconds and
+ * the database handle dropped while offline, so requests fail fast instead of waiting for the SDK.
+ */
+const FIREBASE_DATABASE_URL = "https://esp32-project-ef103-default-rtdb.firebaseio.com/";
+const CONNECTIVITY_CHECK_MS = 10000;
+
+class FirebaseStorage {
+  constructor() {
+    this.name = "Firebase Realtime Database";
+    /** Loaded here rather than at the top, so the local engine runs without them */
+    this.admin = require("firebase-admin");
+    this.fetch = require("node-fetch");
+    this.serviceAccount = require("./esp32_project_serviceAccountKey.json");
+    this.db = null;
+    this.timer = null;
+  }
+
+  /**
+   * Function to initialize Firebase Admin SDK
+   */
+  initializeFirebase() {
+    const admin = this.admin;
+    if (admin.apps.length) {
+      console.log("Firebase already initialized, skipping reinitialization.");
+      return admin.database();
+    }
+
+    console.log("Initializing Firebase...");
+    admin.initializeApp({
+      credential: admin.credential.cert(this.serviceAccount),
+      databaseURL: FIREBASE_DATABASE_URL /** Firebase Realtime Database URL */
+    });
+    console.log("Firebase initialized successfully.");
+    return admin.database();
+  }
+
+  /**
+   * Function to deinitialize Firebase Admin SDK to free resources
+   */
+  deinitializeFirebase() {
+    const admin = this.admin;
+    if (admin.apps.length) {
+      console.log("Deinitializing Firebase...");
+      admin.app().delete()
+        .then(() => console.log("Firebase deinitialized."))
+        .catch((error) => console.error("Error during Firebase deinitialization:", error));
+    } else {
+      console.log("Firebase is not initialized, skipping deinitialization.");
+    }
+  }
+
+  /**
+   * Function to check internet connectivity by pinging Google
+   */
+  async checkConnectivity() {
+    try {
+      const response = await this.fetch("https://www.google.com", { method: "HEAD", timeout: 5000 });
+      return response.ok; /** Return true if online */
+    } catch (error) {
+      return false; /** Return false if offline */
+    }
+  }
+
+  /**
+   * Initializes Firebase and periodically checks internet connectivity to manage it
+   */
+  async start() {
+    this.db = this.initializeFirebase();
+    this.timer = setInterval(async () => {
+      const isConnected = await this.checkConnectivity();
+
+      if (!isConnected) {
+        console.warn("Internet connection lost. Attempting to deinitialize Firebase...");
+        this.deinitializeFirebase(); /** Clean up Firebase resources */
+        this.db = null; /** Reset database reference */
+      } else if (!this.admin.apps.length) { /** Reinitialize Firebase if it is not active */
+        console.log("Internet connection restored. Reinitializing Firebase...");
+        this.db = this.initializeFirebase();
+      }
+    }, CONNECTIVITY_CHECK_MS);
+  }
+
+  isReady() {
+    return this.db !== null;
+  }
+
+  async getSettings(chipId) {
+    /** Fetch settings from /devices/{chipId}/settings */
+    const snapshot = await this.db.ref(`devices/${chipId}/settings`).once("value");
+    const settings = snapshot.val();
+    return settings !== null && typeof settings === "object" ? settings : null;
+  }
+
+  async setSettings(chipId, settings) {
+    await this.db.ref(`devices/${chipId}/settings`).set(settings);
+  }
+
+  async loadHistory(chipId) {
+    const snapshot = await this.db.ref(`devices/${chipId}/SensActHistory`).orderByKey().once("value");
+    return Object.entries(snapshot.val() || {}).sort(([a], [b]) => (a < b ? -1 : a > b ? 1 : 0));
+  }
+
+  /**
+   * Returns a push key, generated locally; push keys sort in creation order
+   */
+  newHistoryKey(chipId) {
+    return this.db.ref(`devices/${chipId}/SensActHistory`).push().key;
+  }
+
+  /**
+   * Writes the added entries and removes the given ones in one multi-path update
+   */
+  async writeHistory(chipId, added, removedKeys) {
+    const updates = {};
+    for (const [key, entry] of added) updates[key] = entry;
+    for (const key of removedKeys) updates[key] = null;
+    await this.db.ref(`devices/${chipId}/SensActHistory`).update(updates);
+  }
+
+  async registerDevice(chipId, info) {
+    await this.db.ref(`RegisteredDevices/${chipId}`).set(info);
+  }
+
+  async getRegisteredDevices() {
+    const snapshot = await this.db.ref("RegisteredDevices").once("value");
+    return snapshot.val() || {};
+  }
+
+  async removeDevice(chipId) {
+    await this.db.ref(`RegisteredDevices/${chipId}`).remove();
+  }
+
+  async close() {
+    clearInterval(this.timer);
+    this.deinitializeFirebase();
+  }
+}
+
+module.exports = { FirebaseStorage };
@@ -0,0 +1,130 @@
+/**
+ * Retention and hot cache of the SensActHistory entries of every device.
+ * The retained entries are kept in memory with their keys, ordered by sample time, so new entries are written and the
+ * oldest ones removed in a single storage write: the write and the trim happen atomically and cost the
+ * same whatever the history size. Reads of the latest data and of the history are answered from the same list
+ * without a database round trip. The entries of a device are loaded once, on its first read or write after a restart.
+ * Like the settings cache in server.js this assumes the server is the only writer of the history.
+ */
+
+/** chipId -> Promise of the retained [key, entry, time] items, ordered by time, oldest first; the promise is shared
+    so concurrent calls see one list */
+const histories = new Map();
+
+/** Reads answered from memory, and reads that had to load the history first */
+const stats = { hits: 0, misses: 0 };
+
+/**
+ * Function to return the sample time of an entry in ms since epoch, or fallback when its timestamp cannot be read
+ */
+function entryTime(entry, fallback) {
+  const time = Date.parse(entry.timestamp);
+  return Number.isFinite(time) ? time : fallback;
+}
+
+/**
+ * Function to insert an item in a list ordered by time, after the items of the same time
+ */
+function insertByTime(history, item) {
+  let low = 0;
+  let high = history.length;
+  while (low < high) {
+    const mid = (low + high) >> 1;
+    if (history[mid][2] <= item[2]) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low === history.length) {
+    history.push(item);
+  } else {
+    history.splice(low, 0, item);
+  }
+}
+
+/**
+ * Returns the retained entries of a device, reading them from the storage the first time.
+ * The storage returns them in order of arrival, samples uploaded late from the flash backlog of a device
+ * come after newer ones, so they are ordered by time once here. Entries without a readable timestamp are
+ * dated from when they were loaded.
+ */
+function loadHistory(storage, chipId) {
+  let history = histories.get(chipId);
+  if (!history) {
+    const loadedAt = Date.now();
+    history = storage.loadHistory(chipId).then((items) => items
+      .map(([key, entry]) => [key, entry, entryTime(entry, loadedAt)])
+      .sort((a, b) => a[2] - b[2]));
+    histories.set(chipId, history);
+    history.catch(() => histories.delete(chipId));
+  }
+  return history;
+}
+
+/**
+ * Appends entries to the SensActHistory of a device and removes, in the same write, the entries whose timestamp
+ * is more than maxAgeMs old and then the oldest entries beyond maxEntries. Samples uploaded late may carry older
+ * timestamps than the entries before them, they are inserted at their place in time so the latest entry is always
+ * the newest sample. Entries without a readable timestamp are dated from their arrival.
+ * Returns the number of stored entries, expired ones excluded.
+ */
+async function append(storage, chipId, entries, maxEntries, maxAgeMs = Infinity) {
+  const history = await loadHistory(storage, chipId);
+  const now = Date.now();
+  const cutoff = now - maxAgeMs;
+
+  /** The list is updated before the write, so a concurrent append trims from where this one left off;
+      the storage applies the writes in the order they were made */
+  const added = [];
+  for (const entry of entries) {
+    const time = entryTime(entry, now);
+    if (time >= cutoff) {
+      const item = [storage.newHistoryKey(chipId), entry, time];
+      added.push(item);
+      insertByTime(history, item);
+    }
+  }
+  /** Ordered by time, the expired entries are at the front: the cost follows the entries removed, not the history size */
+  let expiredCount = 0;
+  while (expiredCount < history.length && history[expiredCount][2] < cutoff) {
+    expiredCount++;
+  }
+  const excess = Math.max(0, history.length - expiredCount - maxEntries);
+  const removed = history.splice(0, expiredCount + excess).map(([key]) => key);
+
+  /** A late sample older than every retained entry is trimmed at once, it is neither written nor removed */
+  const trimmed = new Set(removed);
+  const stored = added.filter(([key]) => !trimmed.has(key));
+  const addedKeys = new Set(added.map(([key]) => key));
+  try {
+    await storage.writeHistory(chipId, stored.map(([key, entry]) => [key, entry]),
+      removed.filter((key) => !addedKeys.has(key)));
+  } catch (error) {
+    histories.delete(chipId); /** Reloaded from the storage on the next call */
+    throw error;
+  }
+  return stored.length;
+}
+
+/**
+ * Returns the latest entries of a device by sample time, oldest first, at most maxEntries
+ */
+async function recent(storage, chipId, maxEntries) {
+  if (histories.has(chipId)) {
+    stats.hits++;
+  } else {
+    stats.misses++;
+  }
+  const history = await loadHistory(storage, chipId);
+  return history.slice(-maxEntries).map(([, entry]) => entry);
+}
+
+/**
+ * Returns the read counters and the number of cached devices
+ */
+function getStats() {
+  return { ...stats, devices: histories.size };
+}
+
+module.exports = { append, recent, getStats };
@@ -0,0 +1,200 @@
+/**
+ * Minimal MQTT 3.1.1 client connecting the backend to the broker used by the devices.
+ * Subscribes to greenhouse/+/telemetry (QoS 0) and greenhouse/+/settings (QoS 1) and
+ * publishes settings changes retained, so a device gets them as soon as it subscribes.
+ */
+const net = require("net");
+
+const MQTT_TOPIC_ROOT = "greenhouse";    /** Same root as SERVER_MQTT_TOPIC_ROOT in the firmware */
+const MQTT_KEEPALIVE_S = 60;
+const MQTT_RECONNECT_MS = 5000;
+const MQTT_MAX_PACKET = 64 * 1024;       /** Same limit as the HTTP batch endpoint */
+
+const CONNECT = 0x10;
+const CONNACK = 0x20;
+const PUBLISH = 0x30;
+const PUBACK = 0x40;
+const SUBSCRIBE = 0x82;
+const PINGREQ = 0xc0;
+
+let socket = null;
+let connected = false;
+let nextPacketId = 1;
+
+/**
+ * Builds a packet from its first byte and body, encoding the remaining length
+ */
+function encodePacket(type, body) {
+  const header = [type];
+  let len = body.length;
+  do {
+    let digit = len % 128;
+    len = Math.floor(len / 128);
+    if (len > 0) digit |= 0x80;
+    header.push(digit);
+  } while (len > 0);
+  return Buffer.concat([Buffer.from(header), body]);
+}
+
+function encodeString(text) {
+  const bytes = Buffer.from(text);
+  const len = Buffer.alloc(2);
+  len.writeUInt16BE(bytes.length);
+  return Buffer.concat([len, bytes]);
+}
+
+function encodePacketId(id) {
+  const buffer = Buffer.alloc(2);
+  buffer.writeUInt16BE(id);
+  return buffer;
+}
+
+function allocPacketId() {
+  const id = nextPacketId;
+  nextPacketId = nextPacketId === 0xffff ? 1 : nextPacketId + 1;
+  return id;
+}
+
+/**
+ * Extracts the next complete packet from the receive buffer, null if more data is needed
+ */
+function decodePacket(buffer) {
+  let len = 0;
+  let multiplier = 1;
+  let pos = 1;
+  for (;;) {
+    if (pos >= buffer.length) return null;
+    const digit = buffer[pos++];
+    len += (digit & 0x7f) * multiplier;
+    if ((digit & 0x80) === 0) break;
+    multiplier *= 128;
+    if (pos > 4) throw new Error("Malformed MQTT length");
+  }
+  if (len > MQTT_MAX_PACKET) {
+    throw new Error("MQTT packet too large");
+  }
+  if (buffer.length < pos + len) return null;
+  return { type: buffer[0], body: buffer.subarray(pos, pos + len), size: pos + len };
+}
+
+/**
+ * Splits an incoming PUBLISH into topic, payload and the packet id (QoS 1 only)
+ */
+function parsePublish(type, body) {
+  const topicLen = body.readUInt16BE(0);
+  const topic = body.subarray(2, 2 + topicLen).toString();
+  let pos = 2 + topicLen;
+  let packetId = null;
+  if ((type & 0x06) !== 0) {
+    packetId = body.readUInt16BE(pos);
+    pos += 2;
+  }
+  return { topic, packetId, retained: (type & 0x01) !== 0, payload: Buffer.from(body.subarray(pos)) };
+}
+
+/**
+ * Handles a PUBLISH from the broker, messages are handled one at a time, in order
+ */
+function dispatch(message, handlers) {
+  const [root, chipId, kind] = message.topic.split("/");
+  if (root !== MQTT_TOPIC_ROOT || !chipId) {
+    return Promise.resolve();
+  }
+  if (kind === "telemetry") {
+    return handlers.onTelemetry(chipId, message.payload);
+  }
+  if (kind === "settings" && message.payload.length > 0) {
+    return handlers.onSettings(chipId, JSON.parse(message.payload.toString()), message.retained);
+  }
+  return Promise.resolve();
+}
+
+/**
+ * Connects to the broker and keeps the connection open, reconnecting after errors
+ * brokerUrl: mqtt://host[:port]
+ * handlers: { onConnect(), onTelemetry(chipId, payload), onSettings(chipId, settings, retained) },
+ * onConnect is called once subscribed, after every reconnection
+ */
+function start(brokerUrl, handlers) {
+  const url = new URL(brokerUrl);
+  const port = Number(url.port) || 1883;
+  const clientId = `greenhouse-backend-${process.pid}`;
+
+  socket = net.connect(port, url.hostname);
+  let received = Buffer.alloc(0);
+  let queue = Promise.resolve();
+  let ping = null;
+
+  socket.on("connect", () => {
+    /** Protocol "MQTT" level 4, clean session */
+    const variableHeader = Buffer.concat([encodeString("MQTT"), Buffer.from([4, 0x02, 0, MQTT_KEEPALIVE_S])]);
+    socket.write(encodePacket(CONNECT, Buffer.concat([variableHeader, encodeString(clientId)])));
+  });
+
+  socket.on("data", (chunk) => {
+    received = Buffer.concat([received, chunk]);
+    try {
+      let packet;
+      while ((packet = decodePacket(received)) !== null) {
+        received = received.subarray(packet.size);
+        const { type, body } = packet;
+
+        if ((type & 0xf0) === CONNACK) {
+          if (body[1] !== 0) {
+            throw new Error(`MQTT connection refused, code ${body[1]}`);
+          }
+          connected = true;
+          console.log("MQTT bridge connected to", url.host);
+          const subscription = Buffer.concat([
+            encodePacketId(allocPacketId()),
+            encodeString(`${MQTT_TOPIC_ROOT}/+/telemetry`), Buffer.from([0]),
+            encodeString(`${MQTT_TOPIC_ROOT}/+/settings`), Buffer.from([1])
+          ]);
+          socket.write(encodePacket(SUBSCRIBE, subscription));
+          queue = queue
+            .then(() => handlers.onConnect && handlers.onConnect())
+            .catch((error) => console.error("Error after MQTT connection:", error.message));
+          ping = setInterval(() => socket.write(encodePacket(PINGREQ, Buffer.alloc(0))), (MQTT_KEEPALIVE_S * 1000) / 2);
+        } else if ((type & 0xf0) === PUBLISH) {
+          const message = parsePublish(type, body);
+          queue = queue
+            .then(() => dispatch(message, handlers))
+            .catch((error) => console.error("Error handling MQTT message on", message.topic, error.message))
+            .then(() => message.packetId !== null && socket.writable &&
+              socket.write(encodePacket(PUBACK, encodePacketId(message.packetId))));
+        }
+        /** SUBACK, PUBACK and PINGRESP need no handling */
+      }
+    } catch (error) {
+      console.error("MQTT bridge error:", error.message);
+      socket.destroy();
+    }
+  });
+
+  socket.on("close", () => {
+    clearInterval(ping);
+    connected = false;
+    console.log(`MQTT bridge disconnected, retrying in ${MQTT_RECONNECT_MS / 1000} s`);
+    setTimeout(() => start(brokerUrl, handlers), MQTT_RECONNECT_MS);
+  });
+  socket.on("error", () => socket.destroy());
+}
+
+/**
+ * Publishes the settings of a device retained with QoS 1
+ * Returns false if the bridge is not connected
+ */
+function publishSettings(chipId, settings) {
+  if (!connected || !socket.writable) {
+    return false;
+  }
+  const body = Buffer.concat([
+    encodeString(`${MQTT_TOPIC_ROOT}/${chipId}/settings`),
+    encodePacketId(allocPacketId()),
+    Buffer.from(JSON.stringify(settings))
+  ]);
+  socket.write(encodePacket(PUBLISH | 0x02 | 0x01, body));
+  return true;
+}
+
+module.exports = { start, publishSettings };
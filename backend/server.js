@@ -1,9 +1,13 @@
 const express = require("express");
-const admin = require("firebase-admin");
 const cors = require("cors");
 const bodyParser = require("body-parser");
 const moment = require("moment-timezone");
-const fetch = require("node-fetch");
+const cbor = require("./cbor");
+const wsChannel = require("./wsChannel");
+const mqttBridge = require("./mqttBridge");
+const historyStore = require("./historyStore");
+const { createStorage } = require("./storage");
+const crypto = require("crypto");
 
 const app = express();
 
@@ -12,80 +16,267 @@ const app = express();
  */
 app.use(bodyParser.json());
 
+/** 
+ * Middleware to receive CBOR requests as raw Buffers
+ */
+app.use(bodyParser.raw({ type: "application/cbor", limit: "64kb" }));
+
 /** Uncomment this line for local testing with the backend, comment it back before deploying */
 app.use(cors());
 
 /** 
- * Load Firebase credentials for initializing Firebase Admin SDK
+ * Storage engine: Firebase by default, local append-only files when LOCAL_STORAGE_DIR is set, see storage.js
+ */
+const storage = createStorage();
+
+/** 
+ * Retention of the SensActHistory of each device, by sample time: 48 hours, longer than the 39 hours a device keeps
+ * in its flash log, so samples uploaded after an outage are still within the window when they arrive.
+ * Samples already older than that when they arrive are not stored.
+ */
+const HISTORY_RETENTION_MS = 48 * 60 * 60 * 1000;
+
+/** 
+ * Maximum number of SensActHistory entries kept per device, a memory bound on top of the retention window:
+ * 48 hours of one heartbeat per minute is 2880 entries, the rest leaves room for change samples
+ */
+const HISTORY_MAX_ENTRIES = 6000;
+
+/** 
+ * Number of entries answered by /getHistoryData, the most recent ones, as many as the dashboard history shows
+ */
+const HISTORY_DASHBOARD_ENTRIES = 60;
+
+/** 
+ * Settings of every device and their version (ETag), kept in memory so settings are answered without reading the storage.
+ * chipId -> { settings, etag }, both null when the device has none. Loaded on the first read, written through by
+ * every settings write of this server; edits made directly in the storage are seen after a restart.
+ */
+const settingsCache = new Map();
+
+/** Settings reads answered from memory, and reads that had to fetch them from the storage */
+const settingsCacheStats = { hits: 0, misses: 0 };
+
+/** 
+ * Function to compute the settings version, keys are sorted so it does not depend on their order
  */
-let serviceAccount = require("./esp32_project_serviceAccountKey.json");
+function settingsEtag(settings) {
+  const canonical = JSON.stringify(settings, Object.keys(settings).sort());
+  return `"${crypto.createHash("sha1").update(canonical).digest("hex").slice(0, 16)}"`;
+}
 
 /** 
- * Function to initialize Firebase Admin SDK
+ * Function to write the settings of a device through to the cache once they are stored
+ * Returns their version.
  */
-function initializeFirebase() {
-  if (admin.apps.length) {
-    console.log("Firebase already initialized, skipping reinitialization.");
-    return admin.database();
+function cacheSettings(chipId, settings) {
+  const etag = settingsEtag(settings);
+  settingsCache.set(chipId, { settings, etag });
+  return etag;
+}
+
+/** 
+ * Function to convert a CBOR telemetry batch into the JSON batch format
+ * CBOR format: { "id": h'<6 byte chip id>', "now", "wall", "ppm", "samples": [[t, lvl, tmp, hum, ldr, pir, well, lmp, pmp, irr], ...] }
+ * Older firmware sends no clock estimate ("now", "wall", "ppm") and the sample age (ageMs) in place of t, see sampleTime().
+ */
+function parseCborBatch(buffer) {
+  const batch = cbor.decode(buffer);
+  if (!batch || !Buffer.isBuffer(batch.id) || !Array.isArray(batch.samples)) {
+    throw new Error("Invalid CBOR batch");
   }
-  
-  console.log("Initializing Firebase...");
-  admin.initializeApp({
-    credential: admin.credential.cert(serviceAccount),
-    databaseURL: "https://esp32-project-ef103-default-rtdb.firebaseio.com/" /** Firebase Realtime Database URL */
-  });
-  console.log("Firebase initialized successfully.");
-  return admin.database();
+
+  const chipId = [...batch.id].map((byte) => byte.toString(16).toUpperCase().padStart(2, "0")).join(":");
+  /** Floats are sent as float32, keep their significant digits only; NaN (no reading) is stored as null like in JSON */
+  const reading = (value) => (Number.isFinite(value) ? Number(value.toPrecision(7)) : null);
+  const flag = (value) => (value ? "1" : "0");
+  const clock = batchClock(batch);
+  const samples = batch.samples.map(([time, lvl, tmp, hum, ldr, pir, well, lmp, pmp, irr]) => ({
+    [clock ? "t" : "ageMs"]: time,
+    sensorData: { lvl, tmp: reading(tmp), hum: reading(hum), ldr: flag(ldr), pir: flag(pir), well: flag(well) },
+    actuatorData: { lmp: flag(lmp), pmp: flag(pmp), irr: flag(irr) }
+  }));
+  return { chipId, samples, clock };
 }
 
 /** 
- * Function to deinitialize Firebase Admin SDK to free resources
+ * Function to read the device clock estimate of a batch, null if the batch has none
  */
-function deinitializeFirebase() {
-  if (admin.apps.length) {
-    console.log("Deinitializing Firebase...");
-    admin.app().delete()
-      .then(() => console.log("Firebase deinitialized."))
-      .catch((error) => console.error("Error during Firebase deinitialization:", error));
-  } else {
-    console.log("Firebase is not initialized, skipping deinitialization.");
+function batchClock(batch) {
+  if (!batch || batch.now === undefined) {
+    return null;
   }
+  return { now: Number(batch.now), wall: Number(batch.wall) || 0, ppm: Number(batch.ppm) || 0 };
 }
 
 /** 
- * Initialize Firebase when the server starts
+ * Function to compute the wall time of a sample, in ms since epoch
+ * Samples are stamped with the device clock (t, us since boot). The batch carries the device clock when it was
+ * sent (now), the device estimate of the wall time at that moment (wall, 0 until the device synced its clock)
+ * and the device clock rate error (ppm). Without an estimate the batch is anchored to its arrival.
+ * Samples of older firmware carry their age when the batch was sent (ageMs) instead.
  */
-let db = initializeFirebase();
+function sampleTime(sample, clock, receivedAt) {
+  if (clock && sample.t !== undefined) {
+    const base = clock.wall > 0 ? clock.wall : receivedAt;
+    return base - ((clock.now - Number(sample.t)) / 1000) * (1 + clock.ppm / 1e6);
+  }
+  return receivedAt - (Number(sample.ageMs) || 0);
+}
 
 /** 
- * Function to check internet connectivity by pinging Google
+ * Function to store a batch of samples under /devices/{chipId}/SensActHistory/ in one write, retention included
+ * Samples are ordered oldest first, their timestamps are derived from the device clock, see sampleTime().
+ * Returns the number of stored samples.
  */
-async function checkConnectivity() {
+async function storeHistoryBatch(chipId, samples, clock) {
+  const receivedAt = Date.now();
+  const entries = samples.map((sample) => ({
+    sensorData: sample.sensorData,
+    actuatorData: sample.actuatorData,
+    timestamp: moment(Math.round(sampleTime(sample, clock, receivedAt))).tz("America/Mexico_City").format()
+  }));
+  return historyStore.append(storage, chipId, entries, HISTORY_MAX_ENTRIES, HISTORY_RETENTION_MS);
+}
+
+/** 
+ * Function to decode a JSON batch: { "chipId": { "now", "wall", "ppm", "samples": [...] } }
+ * Returns { chipId, samples, clock }.
+ */
+function parseJsonBatch(body) {
+  const chipId = Object.keys(body)[0];
+  const batch = body[chipId];
+  return { chipId, samples: batch && batch.samples, clock: batchClock(batch) };
+}
+
+/** 
+ * Function to decode the batch of an HTTP request, CBOR or JSON depending on its Content-Type
+ * Returns { chipId, samples, clock }, throws if a CBOR body is malformed.
+ */
+function decodeBatch(req) {
+  if (req.is("application/cbor")) {
+    return parseCborBatch(req.body);
+  }
+  return parseJsonBatch(req.body);
+}
+
+/** 
+ * Function to read the settings of a device, unless the client already has this version (ifNoneMatch)
+ * Returns { settings, etag }: settings is null when unchanged, etag is null when the device has no settings.
+ * Only the first read after a restart reaches the storage, see settingsCache.
+ */
+async function loadSettings(chipId, ifNoneMatch) {
+  let cached = settingsCache.get(chipId);
+  if (cached) {
+    settingsCacheStats.hits++;
+  } else {
+    settingsCacheStats.misses++;
+    const settings = await storage.getSettings(chipId);
+    /** A settings write that completed meanwhile wins over what was read */
+    if (!settingsCache.has(chipId)) {
+      if (settings === null) {
+        settingsCache.set(chipId, { settings: null, etag: null });
+      } else {
+        cacheSettings(chipId, settings);
+      }
+    }
+    cached = settingsCache.get(chipId);
+  }
+
+  if (!cached.etag) {
+    return { settings: null, etag: null };
+  }
+  return { settings: ifNoneMatch === cached.etag ? null : cached.settings, etag: cached.etag };
+}
+
+/** 
+ * Function to handle a telemetry batch received over the device WebSocket channel
+ * Binary frames carry the CBOR batch, text frames the JSON batch, same formats as /updateSensActHistoryBatch.
+ * The returned object is sent back to the device as the acknowledgement. Errors carry the HTTP status the same
+ * request would get: the device drops a batch refused with a 4xx and retries the others after a backoff.
+ */
+async function handleChannelMessage(chipId, payload, isBinary) {
+  let batch;
   try {
-    const response = await fetch("https://www.google.com", { method: "HEAD", timeout: 5000 });
-    return response.ok; /** Return true if online */
+    if (isBinary) {
+      batch = parseCborBatch(payload);
+    } else {
+      batch = parseJsonBatch(JSON.parse(payload.toString()));
+    }
   } catch (error) {
-    return false; /** Return false if offline */
+    return { error: "Invalid payload", status: 400 };
+  }
+
+  if (batch.chipId !== chipId || !Array.isArray(batch.samples) || batch.samples.length === 0) {
+    return { error: "Invalid payload", status: 400 };
+  }
+  if (!storage.isReady()) {
+    return { error: "Storage is not ready.", status: 503 };
   }
+
+  console.log("Received SensActHistory batch over the device channel for chipId:", chipId, "Samples:", batch.samples.length);
+  const stored = await storeHistoryBatch(chipId, batch.samples, batch.clock);
+  return { ack: true, stored, time: Date.now() };
 }
 
 /** 
- * Periodically check internet connectivity and manage Firebase initialization
+ * Function to handle a telemetry batch published by a device on greenhouse/{chipId}/telemetry
+ * Same formats as /updateSensActHistoryBatch: CBOR, or JSON when the payload starts with '{'.
  */
-setInterval(async () => {
-  const isConnected = await checkConnectivity();
+async function handleMqttTelemetry(chipId, payload) {
+  const result = await handleChannelMessage(chipId, payload, payload[0] !== 0x7b);
+  if (result.error) {
+    console.error("Discarded MQTT telemetry from chipId:", chipId, result.error);
+  }
+}
 
-  if (!isConnected) {
-    console.warn("Internet connection lost. Attempting to deinitialize Firebase...");
-    deinitializeFirebase(); /** Clean up Firebase resources */
-    db = null; /** Reset database reference */
-  } else {
-    if (!admin.apps.length) { /** Reinitialize Firebase if it is not active */
-      console.log("Internet connection restored. Reinitializing Firebase...");
-      db = initializeFirebase(); 
-    } 
+/** 
+ * Function to store the settings published on greenhouse/{chipId}/settings
+ * Our own publications come back here too, they are recognized by their ETag and skipped.
+ * Retained copies are replayed on every reconnect of the bridge and may predate settings saved while it was
+ * down, so they only seed a device that has no stored settings.
+ */
+async function handleMqttSettings(chipId, settings, retained) {
+  await storageStarted;
+  if (!storage.isReady()) {
+    return;
+  }
+  const current = await loadSettings(chipId);
+  if (current.etag === settingsEtag(settings)) {
+    return;
+  }
+  if (retained && current.etag !== null) {
+    console.log("Ignored retained MQTT settings of", chipId, ", the stored ones are newer");
+    return;
+  }
+  await storage.setSettings(chipId, settings);
+  cacheSettings(chipId, settings);
+  console.log("Settings received over MQTT saved for", chipId, ":", settings);
+}
+
+/** 
+ * Function to publish the stored settings of every known device once the MQTT bridge is connected, so the
+ * retained copies the broker hands to devices are current even if settings were saved while it was down
+ */
+async function republishMqttSettings() {
+  await storageStarted;
+  if (!storage.isReady()) {
+    return;
   }
-}, 10000); /** Check every 10 seconds */
+  try {
+    const chipIds = new Set([...settingsCache.keys(), ...Object.keys(await storage.getRegisteredDevices())]);
+    let published = 0;
+    for (const chipId of chipIds) {
+      const { settings } = await loadSettings(chipId);
+      if (settings && mqttBridge.publishSettings(chipId, settings)) {
+        published++;
+      }
+    }
+    console.log("Settings of", published, "devices published over MQTT");
+  } catch (error) {
+    console.error("Error publishing the settings over MQTT:", error.message);
+  }
+}
 
 /** 
  * Root endpoint to confirm the server is running
@@ -114,35 +305,107 @@ app.post("/updateSensActHistory", async (req, res) => {
 
   data.timestamp = moment().tz("America/Mexico_City").format();
 
-  if (db) {
+  if (storage.isReady()) {
     try {
       /** Store under /devices/{chipId}/SensActHistory/ */
-      const ref = db.ref(`devices/${chipId}/SensActHistory`);
-      const newEntryRef = await ref.push({
+      await historyStore.append(storage, chipId, [{
         sensorData: data.sensorData,
         actuatorData: data.actuatorData,
         timestamp: data.timestamp
-      });
-
-      /** Enforce only last 60 entries */
-      const snapshot = await ref.orderByKey().once("value");
-      const entries = snapshot.val();
-      const keys = entries ? Object.keys(entries) : [];
-      if (keys.length > 60) {
-        /** Sort keys (oldest first) and remove the oldest */
-        const keysToDelete = keys.sort().slice(0, keys.length - 60);
-        for (const key of keysToDelete) {
-          await ref.child(key).remove();
-        }
-      }
+      }], HISTORY_MAX_ENTRIES, HISTORY_RETENTION_MS);
 
       res.send({ message: "Sensor/Actuator history stored successfully!" });
     } catch (error) {
       console.error("Error saving history:", error);
-      res.status(500).send({ error: "Error saving history to Firebase" });
+      res.status(500).send({ error: "Error saving history" });
+    }
+  } else {
+    res.status(500).send({ error: "Storage is not ready." });
+  }
+});
+
+/** 
+ * Endpoint to receive and store a batch of sensor/actuator samples from ESP32 devices.
+ * Request from ESP32 devices.
+ * API endpoint: /updateSensActHistoryBatch
+ * Payload format: { "chipId": { "now": 0, "wall": 0, "ppm": 0, "samples": [ { "t": 0, "sensorData": {...}, "actuatorData": {...} }, ... ] } }
+ * Samples are ordered oldest first, t is the device time of a sample, see sampleTime().
+ * The batch may also be sent as Content-Type application/cbor, see parseCborBatch().
+ */
+app.post("/updateSensActHistoryBatch", async (req, res) => {
+  let chipId;
+  let samples;
+  let clock;
+  try {
+    ({ chipId, samples, clock } = decodeBatch(req));
+  } catch (error) {
+    console.error("Error decoding CBOR batch:", error.message);
+    return res.status(400).send({ error: "Invalid payload" });
+  }
+
+  console.log("Received SensActHistory batch for chipId:", chipId, "Samples:", Array.isArray(samples) ? samples.length : 0);
+
+  if (!Array.isArray(samples) || samples.length === 0) {
+    return res.status(400).send({ error: "Invalid payload" });
+  }
+
+  if (storage.isReady()) {
+    try {
+      const stored = await storeHistoryBatch(chipId, samples, clock);
+      res.send({ message: "Sensor/Actuator history batch stored successfully!", stored });
+    } catch (error) {
+      console.error("Error saving history batch:", error);
+      res.status(500).send({ error: "Error saving history batch" });
     }
   } else {
-    res.status(500).send({ error: "Firebase is not initialized." });
+    res.status(500).send({ error: "Storage is not ready." });
+  }
+});
+
+/** 
+ * Endpoint combining the telemetry upload and the settings download of ESP32 devices in one round trip.
+ * Request from ESP32 devices.
+ * API endpoint: /sync
+ * Payload format: a batch as sent to /updateSensActHistoryBatch, JSON or CBOR; its samples may be empty.
+ * Headers: If-None-Match (optional, ETag of the settings the device already has)
+ * Response: { "time": <server time, ms since epoch>, "stored": <samples stored>, ...settings } with the settings
+ * members only when they differ from If-None-Match, or "noSettings": true when the device has none yet.
+ * The ETag header carries the current settings version.
+ */
+app.post("/sync", async (req, res) => {
+  let chipId;
+  let samples;
+  let clock;
+  try {
+    ({ chipId, samples, clock } = decodeBatch(req));
+  } catch (error) {
+    console.error("Error decoding CBOR batch:", error.message);
+    return res.status(400).send({ error: "Invalid payload" });
+  }
+
+  if (!chipId || !Array.isArray(samples)) {
+    return res.status(400).send({ error: "Invalid payload" });
+  }
+  if (!storage.isReady()) {
+    return res.status(500).send({ error: "Storage is not ready." });
+  }
+
+  try {
+    /** Settings first: the device sends the whole batch again when the sync fails, so nothing may fail once it is stored */
+    const { settings, etag } = await loadSettings(chipId, req.get("If-None-Match"));
+    const stored = samples.length > 0 ? await storeHistoryBatch(chipId, samples, clock) : 0;
+    const response = { time: Date.now(), stored };
+    if (etag) {
+      res.set("ETag", etag);
+      Object.assign(response, settings); /** Empty when unchanged */
+    } else {
+      response.noSettings = true;
+    }
+    console.log("Sync for chipId:", chipId, "Samples:", stored, "Settings:", settings ? "sent" : etag ? "unchanged" : "none");
+    res.send(response);
+  } catch (error) {
+    console.error("Error during sync:", error);
+    res.status(500).send({ error: "Error syncing" });
   }
 });
 
@@ -163,17 +426,18 @@ app.post("/updateSettings", async (req, res) => {
     return res.status(400).send({ error: "Invalid payload" });
   }
 
-  if (db) {
+  if (storage.isReady()) {
     try {
       /** Store under /devices/{chipId}/settings */
-      await db.ref(`devices/${chipId}/settings`).set(data.settings);
-      res.send({ message: "Settings stored successfully!" });
+      await storage.setSettings(chipId, data.settings);
+      const etag = cacheSettings(chipId, data.settings);
+      res.set("ETag", etag).send({ message: "Settings stored successfully!" });
     } catch (error) {
       console.error("Error saving settings:", error);
-      res.status(500).send({ error: "Error saving settings to Firebase" });
+      res.status(500).send({ error: "Error saving settings" });
     }
   } else {
-    res.status(500).send({ error: "Firebase is not initialized." });
+    res.status(500).send({ error: "Storage is not ready." });
   }
 });
 
@@ -196,14 +460,13 @@ app.get("/getLastData", async (req, res) => {
     return res.status(400).send({ error: "Invalid or missing 'type' query parameter. Use 'sensors' or 'actuators'." });
   }
 
-  if (db) {
+  if (storage.isReady()) {
     try {
-      /** Fetch the most recent entry from SensActHistory */
-      const snapshot = await db.ref(`devices/${chipId}/SensActHistory`).orderByKey().limitToLast(1).once("value");
-      const data = snapshot.val();
+      /** The most recent entry of SensActHistory, from the history cache */
+      const data = await historyStore.recent(storage, chipId, 1);
 
-      if (data) {
-        const lastEntry = Object.values(data)[0];
+      if (data.length > 0) {
+        const lastEntry = data[0];
         if (type === "sensors" && lastEntry.sensorData) {
           res.send({ ...lastEntry.sensorData, timestamp: lastEntry.timestamp });
         } else if (type === "actuators" && lastEntry.actuatorData) {
@@ -216,10 +479,10 @@ app.get("/getLastData", async (req, res) => {
       }
     } catch (error) {
       console.error("Error fetching last data:", error);
-      res.status(500).send({ error: "Error fetching last data from Firebase." });
+      res.status(500).send({ error: "Error fetching last data." });
     }
   } else {
-    res.status(500).send({ error: "Firebase is not initialized." });
+    res.status(500).send({ error: "Storage is not ready." });
   }
 });
 
@@ -242,17 +505,14 @@ app.get("/getHistoryData", async (req, res) => {
     return res.status(400).send({ error: "Invalid or missing 'type' query parameter. Use 'sensors' or 'actuators'." });
   }
 
-  const dbRef = `devices/${chipId}/SensActHistory`;
-
-  if (db) {
+  if (storage.isReady()) {
     try {
-      /** Fetch the last 60 entries */
-      const snapshot = await db.ref(dbRef).orderByKey().limitToLast(60).once("value");
-      const data = snapshot.val();
+      /** The latest retained entries, from the history cache */
+      const data = await historyStore.recent(storage, chipId, HISTORY_DASHBOARD_ENTRIES);
 
-      if (data) {
+      if (data.length > 0) {
         /** Map to only the requested type data */
-        const result = Object.values(data)
+        const result = data
           .map(entry => {
             if (type === "sensors" && entry.sensorData) {
               return { ...entry.sensorData, timestamp: entry.timestamp };
@@ -270,15 +530,15 @@ app.get("/getHistoryData", async (req, res) => {
       }
     } catch (error) {
       console.error("Error fetching history data:", error);
-      res.status(500).send({ error: "Error fetching history data from Firebase." });
+      res.status(500).send({ error: "Error fetching history data." });
     }
   } else {
-    res.status(500).send({ error: "Firebase is not initialized." });
+    res.status(500).send({ error: "Storage is not ready." });
   }
 });
 
 /** 
- * Endpoint to save settings data from the frontend to Firebase
+ * Endpoint to save settings data from the frontend
  * Request from frontend.
  * API endpoint: /saveSettings
  * Payload format: { "chipId": "XX:XX:XX:XX:XX:XX", "userSettings": {...} }
@@ -295,27 +555,37 @@ app.post("/saveSettings", async (req, res) => {
 
   console.log("Received user settings for", chipId, ":", userSettings);
 
-  if (db) {
+  if (storage.isReady()) {
     try {
-      /** Save settings to Firebase under the device's settings path */
-      await db.ref(`devices/${chipId}/settings`).set(userSettings);
+      /** Save settings under the device's settings path */
+      await storage.setSettings(chipId, userSettings);
+      cacheSettings(chipId, userSettings);
+
+      /** Push the new settings to the device right away if it is connected */
+      if (wsChannel.send(chipId, userSettings)) {
+        console.log("Settings pushed over WebSocket to", chipId);
+      }
+      if (mqttBridge.publishSettings(chipId, userSettings)) {
+        console.log("Settings published over MQTT to", chipId);
+      }
 
-      console.log("Settings saved to Firebase for", chipId, ":", userSettings);
+      console.log("Settings saved for", chipId, ":", userSettings);
       res.send({ message: "Settings saved successfully!" });
     } catch (error) {
-      console.error("Error saving settings to Firebase:", error);
-      res.status(500).send({ error: "Error saving settings to Firebase." });
+      console.error("Error saving settings:", error);
+      res.status(500).send({ error: "Error saving settings." });
     }
   } else {
-    res.status(500).send({ error: "Firebase is not initialized." });
+    res.status(500).send({ error: "Storage is not ready." });
   }
 });
 
 /** 
- * Endpoint to fetch current settings for a specific device from Firebase.
+ * Endpoint to fetch current settings for a specific device.
  * Request from frontend and ESP32 device.
  * API endpoint: /getSettings
  * Query parameters: chipId (unique identifier for the device)
+ * Headers: If-None-Match (optional, ETag of the settings the client already has), answered with 304 when unchanged
  */
 app.get("/getSettings", async (req, res) => {
   const chipId = req.query.chipId;
@@ -323,28 +593,40 @@ app.get("/getSettings", async (req, res) => {
     return res.status(400).send({ error: "Missing 'chipId' query parameter." });
   }
 
-  console.log("Received request to fetch settings for chipId:", chipId);
-
-  if (db) {
+  if (storage.isReady()) {
     try {
-      /** Fetch settings from /devices/{chipId}/settings */
-      const snapshot = await db.ref(`devices/${chipId}/settings`).once("value");
-      const settings = snapshot.val();
-
-      if (settings !== null && typeof settings === "object") {
-        res.send(settings); /** Send the settings object */
-      } else {
-        res.status(404).send({ error: "No settings found in the database for this device." });
+      const { settings, etag } = await loadSettings(chipId, req.get("If-None-Match"));
+      if (!etag) {
+        return res.status(404).send({ error: "No settings found in the database for this device." });
       }
+      res.set("ETag", etag);
+      if (!settings) {
+        return res.status(304).end(); /** Unchanged */
+      }
+      console.log("Sent settings for chipId:", chipId);
+      res.send(settings); /** Send the settings object */
     } catch (error) {
-      console.error("Error fetching settings from Firebase:", error);
-      res.status(500).send({ error: "Error fetching settings from Firebase." });
+      console.error("Error fetching settings:", error);
+      res.status(500).send({ error: "Error fetching settings." });
     }
   } else {
-    res.status(500).send({ error: "Firebase is not initialized." });
+    res.status(500).send({ error: "Storage is not ready." });
   }
 });
 
+/** 
+ * Endpoint to report the hit and miss counts of the in-memory caches since the server started.
+ * API endpoint: /getCacheStats
+ * Response: { "settings": { "hits", "misses", "hitRatio", "devices" }, "history": { ... } }
+ */
+app.get("/getCacheStats", (req, res) => {
+  const withRatio = (stats) => ({ ...stats, hitRatio: stats.hits + stats.misses > 0 ? stats.hits / (stats.hits + stats.misses) : null });
+  res.send({
+    settings: withRatio({ ...settingsCacheStats, devices: settingsCache.size }),
+    history: withRatio(historyStore.getStats())
+  });
+});
+
 /** 
  * Endpoint to register a new device with alias
  * Request from frontend.
@@ -358,7 +640,7 @@ app.post("/registerDevice", async (req, res) => {
   console.log("Received request to register device:", req.body);
 
   try {
-    await db.ref(`RegisteredDevices/${chipId}`).set({
+    await storage.registerDevice(chipId, {
       alias: alias || "",
       registeredAt: registeredAt || new Date().toISOString()
     });
@@ -379,8 +661,7 @@ app.get("/getRegisteredDevices", async (req, res) => {
   console.log("Received request to fetch registered devices");
   
   try {
-    const snapshot = await db.ref("RegisteredDevices").once("value");
-    const devices = snapshot.val() || {};
+    const devices = await storage.getRegisteredDevices();
     res.send(devices);
   } catch (error) {
     res.status(500).send({ error: "Failed to fetch registered devices" });
@@ -397,7 +678,7 @@ app.post("/removeDevice", async (req, res) => {
   if (!chipId) return res.status(400).send({ error: "Missing chipId" });
 
   try {
-    await db.ref(`RegisteredDevices/${chipId}`).remove();
+    await storage.removeDevice(chipId);
     res.send({ message: "Device removed successfully!" });
   } catch (error) {
     res.status(500).send({ error: "Failed to remove device" });
@@ -408,6 +689,29 @@ app.post("/removeDevice", async (req, res) => {
  * Start the server on the specified port
  */
 const PORT = process.env.PORT || 3000;
-app.listen(PORT, () => {
+const server = app.listen(PORT, () => {
   console.log(`Server running on port ${PORT}`);
 });
+
+const storageStarted = storage.start()
+  .then(() => console.log(`Storage ready: ${storage.name}`))
+  .catch((error) => console.error("Error starting the storage:", error));
+
+/** 
+ * Keep idle device connections open longer than their 15 s request interval so they can be reused
+ */
+server.keepAliveTimeout = 65000;
+server.headersTimeout = 66000;
+
+/** 
+ * Persistent device channel on ws://<server>/ws?chipId=<chipId> for telemetry and settings push
+ */
+wsChannel.attach(server, handleChannelMessage);
+
+/** 
+ * Optional MQTT transport, set MQTT_BROKER_URL (e.g. mqtt://localhost:1883) to bridge the broker topics
+ */
+if (process.env.MQTT_BROKER_URL) {
+  mqttBridge.start(process.env.MQTT_BROKER_URL,
+    { onConnect: republishMqttSettings, onTelemetry: handleMqttTelemetry, onSettings: handleMqttSettings });
+}
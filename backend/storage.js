@@ -0,0 +1,30 @@
+/**
+ * Storage engine selection. The server only talks to the engine through this interface, all methods but
+ * isReady() and newHistoryKey() are async:
+ *
+ *   name                                  description for the logs
+ *   start()                               connects or opens the storage
+ *   isReady()                             false while the storage cannot be used, requests then fail with 500
+ *   getSettings(chipId)                   settings object of a device, null if it has none
+ *   setSettings(chipId, settings)         replaces the settings of a device
+ *   loadHistory(chipId)                   [[key, entry], ...] of SensActHistory, oldest first
+ *   newHistoryKey(chipId)                 key of a new history entry, keys sort in creation order
+ *   writeHistory(chipId, added, removed)  adds [[key, entry], ...] and removes [key, ...] in one atomic write
+ *   registerDevice(chipId, info)          stores { alias, registeredAt } under RegisteredDevices
+ *   getRegisteredDevices()                { chipId: info, ... }
+ *   removeDevice(chipId)                  removes a device from RegisteredDevices
+ *   close()                               releases the storage
+ *
+ * Firebase is the default. Set LOCAL_STORAGE_DIR (e.g. ./data) to use local append-only files instead,
+ * without credentials or internet access.
+ */
+function createStorage() {
+  if (process.env.LOCAL_STORAGE_DIR) {
+    const { FileStorage } = require("./fileStorage");
+    return new FileStorage(process.env.LOCAL_STORAGE_DIR);
+  }
+  const { FirebaseStorage } = require("./firebaseStorage");
+  return new FirebaseStorage();
+}
+
+module.exports = { createStorage };
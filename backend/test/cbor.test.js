@@ -0,0 +1,70 @@
+/**
+ * Tests for the CBOR decoder, run with `node --test test/` from the backend folder.
+ * The expected bytes are the ones the firmware encoder writes, see test/test_schema_cbor of the firmware.
+ */
+const test = require("node:test");
+const assert = require("node:assert");
+const cbor = require("../cbor");
+
+const hex = (s) => Buffer.from(s.replace(/\s+/g, ""), "hex");
+
+test("integers in every head size", () => {
+  assert.strictEqual(cbor.decode(hex("17")), 23);
+  assert.strictEqual(cbor.decode(hex("18 18")), 24);
+  assert.strictEqual(cbor.decode(hex("19 0100")), 256);
+  assert.strictEqual(cbor.decode(hex("1a 00000007")), 7);
+  assert.strictEqual(cbor.decode(hex("1b 0000019 9c82cc000")), 1760000000000);
+  assert.strictEqual(cbor.decode(hex("20")), -1);
+  assert.strictEqual(cbor.decode(hex("3b 0000000000000000")), -1);
+  assert.strictEqual(cbor.decode(hex("3a 002625 9f")), -2500000);
+});
+
+test("floats and simple values", () => {
+  assert.strictEqual(cbor.decode(hex("fa 3fc00000")), 1.5);
+  assert.ok(Number.isNaN(cbor.decode(hex("fa 7fc00000"))));
+  assert.strictEqual(cbor.decode(hex("f9 3c00")), 1);
+  assert.strictEqual(cbor.decode(hex("f9 0001")), 2 ** -24);
+  assert.strictEqual(cbor.decode(hex("f9 fc00")), -Infinity);
+  assert.strictEqual(cbor.decode(hex("fb 3ff8000000000000")), 1.5);
+  assert.strictEqual(cbor.decode(hex("f4")), false);
+  assert.strictEqual(cbor.decode(hex("f5")), true);
+  assert.strictEqual(cbor.decode(hex("f6")), null);
+});
+
+test("strings, tags and containers", () => {
+  assert.deepStrictEqual(cbor.decode(hex("42 dead")), hex("dead"));
+  assert.strictEqual(cbor.decode(hex("62 6964")), "id");
+  assert.strictEqual(cbor.decode(hex("c1 1a 68f0a400")), 0x68f0a400);
+  assert.deepStrictEqual(cbor.decode(hex("98 18" + "01".repeat(24))), new Array(24).fill(1));
+  assert.deepStrictEqual(cbor.decode(hex("a2 61 61 01 61 62 82 02 03")), { a: 1, b: [2, 3] });
+});
+
+test("telemetry batch as the firmware writes it", () => {
+  const payload = hex(
+    "a5" +
+      "62 6964 46 aabbccddeeff" +
+      "63 6e6f77 1a 004c4b40" +
+      "64 77616c6c 1b 00000199c82cc07b" +
+      "63 70706d fa bfc00000" +
+      "67 73616d706c6573 81" +
+      "8a 3b 000000000026259f 1a 00000037 fa 41ac0000 fa 42200000 01 00 01 00 01 00"
+  );
+  const batch = cbor.decode(payload);
+
+  assert.deepStrictEqual(batch.id, hex("aabbccddeeff"));
+  assert.strictEqual(batch.now, 5000000);
+  assert.strictEqual(batch.wall, 1760000000123);
+  assert.strictEqual(batch.ppm, -1.5);
+  assert.deepStrictEqual(batch.samples, [[-2500000, 55, 21.5, 40, 1, 0, 1, 0, 1, 0]]);
+});
+
+test("malformed payloads throw", () => {
+  assert.throws(() => cbor.decode(hex("")), /truncated/);
+  assert.throws(() => cbor.decode(hex("1a 0000")), /truncated/);
+  assert.throws(() => cbor.decode(hex("63 6964")), /truncated/);
+  assert.throws(() => cbor.decode(hex("82 01")), /truncated/);
+  assert.throws(() => cbor.decode(hex("01 02")), /Trailing/);
+  assert.throws(() => cbor.decode(hex("1f")), /length encoding/);
+  assert.throws(() => cbor.decode(hex("9f 01 ff")), /length encoding/);
+  assert.throws(() => cbor.decode(hex("f8 20")), /simple value/);
+});
@@ -0,0 +1,154 @@
+/**
+ * Tests for the local storage engine, run with `node --test test/` from the backend folder.
+ */
+const test = require("node:test");
+const assert = require("node:assert");
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { FileStorage, historyFileName, chipIdFromFileName } = require("../fileStorage");
+
+const CHIP_ID = "AA:BB:CC:DD:EE:FF";
+
+/**
+ * Function to start a storage engine on a new empty directory
+ */
+async function openStorage(dir = fs.mkdtempSync(path.join(os.tmpdir(), "fileStorage-"))) {
+  const storage = new FileStorage(dir);
+  await storage.start();
+  return storage;
+}
+
+/**
+ * Function to close a storage engine and start another on the same directory, as a restart would
+ */
+async function reopen(storage) {
+  await storage.close();
+  return openStorage(storage.dir);
+}
+
+function historyPath(storage) {
+  return path.join(storage.dir, "history", historyFileName(CHIP_ID));
+}
+
+function lineCount(filePath) {
+  return fs.readFileSync(filePath, "utf8").split("\n").filter((line) => line).length;
+}
+
+test("history survives a restart", async () => {
+  let storage = await openStorage();
+  await storage.writeHistory(CHIP_ID, [["k1", { lvl: 1 }], ["k2", { lvl: 2 }]], []);
+  await storage.writeHistory(CHIP_ID, [["k3", { lvl: 3 }]], ["k1"]);
+  await storage.setSettings(CHIP_ID, { maxLevel: 80 });
+  await storage.registerDevice(CHIP_ID, { name: "tank" });
+  await storage.registerDevice("other", { name: "well" });
+  await storage.removeDevice("other");
+
+  storage = await reopen(storage);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k2", { lvl: 2 }], ["k3", { lvl: 3 }]]);
+  assert.deepStrictEqual(await storage.getSettings(CHIP_ID), { maxLevel: 80 });
+  assert.deepStrictEqual(await storage.getRegisteredDevices(), { [CHIP_ID]: { name: "tank" } });
+  assert.strictEqual(await storage.getSettings("other"), null);
+  await storage.close();
+});
+
+test("a line torn by a crash is dropped and the next write starts a line of its own", async () => {
+  let storage = await openStorage();
+  await storage.writeHistory(CHIP_ID, [["k1", { lvl: 1 }]], []);
+  await storage.close();
+
+  const filePath = historyPath(storage);
+  const intact = fs.readFileSync(filePath, "utf8");
+  fs.appendFileSync(filePath, "not json\n" + '{"add":[["k2",{"lv');
+
+  storage = await openStorage(storage.dir);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k1", { lvl: 1 }]]);
+  assert.strictEqual(fs.readFileSync(filePath, "utf8"), intact + "not json\n");
+
+  await storage.writeHistory(CHIP_ID, [["k3", { lvl: 3 }]], []);
+  storage = await reopen(storage);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k1", { lvl: 1 }], ["k3", { lvl: 3 }]]);
+  await storage.close();
+});
+
+test("a failed write leaves memory unchanged and does not join the next line", async () => {
+  let storage = await openStorage();
+  await storage.writeHistory(CHIP_ID, [["k1", { lvl: 1 }]], []);
+
+  /** The disk fills up halfway through the next line */
+  const { file } = await storage.history(CHIP_ID);
+  const handle = file.handle;
+  const write = handle.write.bind(handle);
+  handle.write = async (text) => {
+    handle.write = write;
+    await write(text.slice(0, 10));
+    throw Object.assign(new Error("No space left on device"), { code: "ENOSPC" });
+  };
+  await assert.rejects(storage.writeHistory(CHIP_ID, [["k2", { lvl: 2 }]], []), /No space/);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k1", { lvl: 1 }]]);
+
+  await storage.writeHistory(CHIP_ID, [["k3", { lvl: 3 }]], []);
+  storage = await reopen(storage);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k1", { lvl: 1 }], ["k3", { lvl: 3 }]]);
+  await storage.close();
+});
+
+test("files are compacted to their live records", async () => {
+  let storage = await openStorage();
+  const filePath = historyPath(storage);
+  const settingsPath = path.join(storage.dir, "settings.log");
+
+  /** A retention of 10 entries: each write adds one and removes the oldest */
+  for (let i = 0; i < 200; i++) {
+    const key = `k${String(i).padStart(4, "0")}`;
+    const removed = i >= 10 ? [`k${String(i - 10).padStart(4, "0")}`] : [];
+    await storage.writeHistory(CHIP_ID, [[key, { lvl: i }]], removed);
+    await storage.setSettings(CHIP_ID, { maxLevel: i });
+    assert.ok(lineCount(filePath) <= 4 * 10 + 64 + 1, `${lineCount(filePath)} lines after ${i + 1} writes`);
+  }
+  assert.ok(lineCount(settingsPath) <= 4 + 64 + 1);
+  assert.ok(!fs.existsSync(`${filePath}.tmp`));
+
+  /** Appends after a compaction go to the new file */
+  await storage.writeHistory(CHIP_ID, [["k9999", { lvl: 9999 }]], []);
+  const expected = await storage.loadHistory(CHIP_ID);
+  assert.strictEqual(expected.length, 11);
+  assert.deepStrictEqual(expected[0], ["k0190", { lvl: 190 }]);
+
+  storage = await reopen(storage);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), expected);
+  assert.deepStrictEqual(await storage.getSettings(CHIP_ID), { maxLevel: 199 });
+  await storage.close();
+});
+
+test("concurrent writes reach the file in order", async () => {
+  let storage = await openStorage();
+  const writes = [];
+  for (let i = 0; i < 100; i++) {
+    writes.push(storage.writeHistory(CHIP_ID, [[`k${String(i).padStart(3, "0")}`, { lvl: i }]], i > 0 ? [`k${String(i - 1).padStart(3, "0")}`] : []));
+  }
+  await Promise.all(writes);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k099", { lvl: 99 }]]);
+
+  storage = await reopen(storage);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k099", { lvl: 99 }]]);
+  await storage.close();
+});
+
+test("history file names", async () => {
+  for (const chipId of [CHIP_ID, "plain_id-1", "a b/c%d", "é€"]) {
+    const fileName = historyFileName(chipId);
+    assert.match(fileName, /^[0-9A-Za-z_%-]+\.log$/);
+    assert.strictEqual(chipIdFromFileName(fileName), chipId);
+  }
+  assert.notStrictEqual(historyFileName("a:b"), historyFileName("a_b"));
+
+  /** Files of the former naming are adopted */
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), "fileStorage-"));
+  fs.mkdirSync(path.join(dir, "history"));
+  fs.writeFileSync(path.join(dir, "history", "AA_BB_CC_DD_EE_FF.log"), '{"add":[["k1",{"lvl":1}]],"del":[]}\n');
+  const storage = await openStorage(dir);
+  assert.deepStrictEqual(await storage.loadHistory(CHIP_ID), [["k1", { lvl: 1 }]]);
+  assert.ok(fs.existsSync(historyPath(storage)));
+  await storage.close();
+});
@@ -0,0 +1,128 @@
+/**
+ * Tests for the history retention and cache, run with `node --test test/` from the backend folder.
+ */
+const test = require("node:test");
+const assert = require("node:assert");
+const historyStore = require("../historyStore");
+
+/**
+ * In-memory storage recording the writes made to it. Every test uses its own chip id, the cache is shared.
+ */
+class MemoryStorage {
+  constructor() {
+    this.entries = new Map(); /** key -> entry */
+    this.writes = [];
+    this.loads = 0;
+    this.failNext = false;
+    this.seq = 0;
+  }
+
+  async loadHistory() {
+    this.loads++;
+    return [...this.entries].sort(([a], [b]) => (a < b ? -1 : 1));
+  }
+
+  newHistoryKey() {
+    return `k${String(this.seq++).padStart(6, "0")}`;
+  }
+
+  async writeHistory(chipId, added, removed) {
+    await new Promise((resolve) => setImmediate(resolve));
+    if (this.failNext) {
+      this.failNext = false;
+      throw new Error("write failed");
+    }
+    this.writes.push({ added: added.map(([key]) => key), removed });
+    for (const [key, entry] of added) this.entries.set(key, entry);
+    for (const key of removed) this.entries.delete(key);
+  }
+}
+
+const entry = (lvl, timestamp = new Date().toISOString()) => ({ lvl, timestamp });
+const levels = (entries) => entries.map((item) => item.lvl);
+
+test("appends and trims in a single write", async () => {
+  const storage = new MemoryStorage();
+  assert.strictEqual(await historyStore.append(storage, "count", [entry(1), entry(2), entry(3)], 4), 3);
+  assert.strictEqual(await historyStore.append(storage, "count", [entry(4), entry(5), entry(6)], 4), 3);
+
+  assert.deepStrictEqual(storage.writes[1], { added: ["k000003", "k000004", "k000005"], removed: ["k000000", "k000001"] });
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "count", 10)), [3, 4, 5, 6]);
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "count", 2)), [5, 6]);
+  assert.deepStrictEqual(levels([...storage.entries.values()]), [3, 4, 5, 6]);
+  assert.strictEqual(storage.loads, 1);
+});
+
+test("expired entries are not stored and are removed wherever they are", async () => {
+  const storage = new MemoryStorage();
+  const hour = 3600 * 1000;
+  const ago = (ms) => new Date(Date.now() - ms).toISOString();
+
+  /** Uploaded late, the second entry is older than the first */
+  await historyStore.append(storage, "age", [entry(1, ago(1 * hour)), entry(2, ago(3 * hour)), entry(3, "unknown")], 100);
+  assert.strictEqual(await historyStore.append(storage, "age", [entry(4, ago(5 * hour)), entry(5)], 100, 2 * hour), 1);
+
+  assert.deepStrictEqual(storage.writes[1], { added: ["k000003"], removed: ["k000001"] });
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "age", 10)), [1, 3, 5]);
+});
+
+test("late samples take their place in time", async () => {
+  const storage = new MemoryStorage();
+  const ago = (ms) => new Date(Date.now() - ms).toISOString();
+  const hour = 3600 * 1000;
+
+  await historyStore.append(storage, "late", [entry(10, ago(60 * 1000)), entry(11, ago(0))], 5);
+  /** Backfill from the flash log of the device, hours old */
+  await historyStore.append(storage, "late", [entry(1, ago(3 * hour)), entry(2, ago(2 * hour))], 5);
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "late", 1)), [11]);
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "late", 10)), [1, 2, 10, 11]);
+
+  /** The oldest by time are trimmed, a sample older than all of a full history is not even written */
+  await historyStore.append(storage, "late", [entry(3, ago(1 * hour)), entry(0, ago(4 * hour))], 4);
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "late", 10)), [2, 3, 10, 11]);
+  assert.deepStrictEqual(storage.writes[2], { added: ["k000004"], removed: ["k000002"] });
+
+  /** After a restart, the entries stored in order of arrival are ordered by time again */
+  const restarted = new MemoryStorage();
+  restarted.entries = new Map([...storage.entries].map(([key, item]) => [key, item]));
+  assert.deepStrictEqual(levels(await historyStore.recent(restarted, "late-restarted", 10)), [2, 3, 10, 11]);
+});
+
+test("a failed write is not kept in the cache", async () => {
+  const storage = new MemoryStorage();
+  await historyStore.append(storage, "fail", [entry(1)], 10);
+
+  storage.failNext = true;
+  await assert.rejects(historyStore.append(storage, "fail", [entry(2)], 10), /write failed/);
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "fail", 10)), [1]);
+  assert.strictEqual(storage.loads, 2);
+});
+
+test("concurrent appends trim from where the previous one left off", async () => {
+  const storage = new MemoryStorage();
+  const appends = [];
+  for (let i = 0; i < 20; i++) {
+    appends.push(historyStore.append(storage, "concurrent", [entry(i)], 5));
+  }
+  await Promise.all(appends);
+
+  assert.strictEqual(storage.loads, 1);
+  assert.deepStrictEqual(levels(await historyStore.recent(storage, "concurrent", 10)), [15, 16, 17, 18, 19]);
+  assert.deepStrictEqual(levels([...storage.entries.values()]), [15, 16, 17, 18, 19]);
+});
+
+test("reads are counted as hits once the history is cached", async () => {
+  const storage = new MemoryStorage();
+  const before = historyStore.getStats();
+
+  await historyStore.recent(storage, "stats", 10);
+  await historyStore.recent(storage, "stats", 10);
+  await historyStore.append(storage, "stats", [entry(1)], 10);
+  await historyStore.recent(storage, "stats", 10);
+
+  const after = historyStore.getStats();
+  assert.strictEqual(after.misses - before.misses, 1);
+  assert.strictEqual(after.hits - before.hits, 2);
+  assert.strictEqual(after.devices - before.devices, 1);
+  assert.strictEqual(storage.loads, 1);
+});
@@ -0,0 +1,168 @@
+/**
+ * Minimal WebSocket (RFC 6455) server for the ESP32 devices.
+ * One connection per device on /ws?chipId=XX:XX:XX:XX:XX:XX, used to receive telemetry
+ * batches and to push settings changes. Only unfragmented frames are supported,
+ * which is everything the firmware sends.
+ */
+const crypto = require("crypto");
+
+const WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+const WS_MAX_PAYLOAD = 64 * 1024;   /** Same limit as the HTTP batch endpoint */
+const WS_PING_INTERVAL_MS = 30000;  /** Keeps NAT entries alive and detects dead devices */
+
+const OPCODE_TEXT = 0x1;
+const OPCODE_BINARY = 0x2;
+const OPCODE_CLOSE = 0x8;
+const OPCODE_PING = 0x9;
+const OPCODE_PONG = 0xa;
+
+/** Open connections by chip id */
+const devices = new Map();
+
+/**
+ * Builds an unmasked server frame
+ */
+function encodeFrame(opcode, payload) {
+  const len = payload.length;
+  let header;
+  if (len < 126) {
+    header = Buffer.from([0x80 | opcode, len]);
+  } else if (len < 65536) {
+    header = Buffer.alloc(4);
+    header[0] = 0x80 | opcode;
+    header[1] = 126;
+    header.writeUInt16BE(len, 2);
+  } else {
+    header = Buffer.alloc(10);
+    header[0] = 0x80 | opcode;
+    header[1] = 127;
+    header.writeBigUInt64BE(BigInt(len), 2);
+  }
+  return Buffer.concat([header, payload]);
+}
+
+/**
+ * Extracts the next complete frame from the receive buffer, null if more data is needed
+ */
+function decodeFrame(buffer) {
+  if (buffer.length < 2) return null;
+  const opcode = buffer[0] & 0x0f;
+  const masked = (buffer[1] & 0x80) !== 0;
+  let len = buffer[1] & 0x7f;
+  let pos = 2;
+
+  if (len === 126) {
+    if (buffer.length < 4) return null;
+    len = buffer.readUInt16BE(2);
+    pos = 4;
+  } else if (len === 127) {
+    if (buffer.length < 10) return null;
+    len = Number(buffer.readBigUInt64BE(2));
+    pos = 10;
+  }
+  if (len > WS_MAX_PAYLOAD) {
+    throw new Error("WebSocket frame too large");
+  }
+
+  const maskPos = pos;
+  if (masked) pos += 4;
+  if (buffer.length < pos + len) return null;
+
+  const payload = Buffer.from(buffer.subarray(pos, pos + len));
+  if (masked) {
+    for (let i = 0; i < len; i++) {
+      payload[i] ^= buffer[maskPos + (i & 3)];
+    }
+  }
+  return { opcode, payload, size: pos + len };
+}
+
+/**
+ * Accepts the upgrade request of a device and serves its frames.
+ * onMessage(chipId, payload, isBinary) returns the text reply sent back to the device.
+ */
+function accept(req, socket, onMessage) {
+  const url = new URL(req.url, "http://localhost");
+  const chipId = url.searchParams.get("chipId");
+  const key = req.headers["sec-websocket-key"];
+
+  if (url.pathname !== "/ws" || !chipId || !key) {
+    socket.end("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+    return;
+  }
+
+  const acceptKey = crypto.createHash("sha1").update(key + WS_GUID).digest("base64");
+  socket.write(
+    "HTTP/1.1 101 Switching Protocols\r\n" +
+    "Upgrade: websocket\r\n" +
+    "Connection: Upgrade\r\n" +
+    `Sec-WebSocket-Accept: ${acceptKey}\r\n\r\n`
+  );
+  socket.setNoDelay(true);
+
+  /** A reconnecting device replaces its stale connection */
+  const previous = devices.get(chipId);
+  if (previous) previous.destroy();
+  devices.set(chipId, socket);
+  console.log("WebSocket connected for chipId:", chipId);
+
+  let received = Buffer.alloc(0);
+  let queue = Promise.resolve(); /** Messages are handled one at a time, in order */
+  const ping = setInterval(() => socket.write(encodeFrame(OPCODE_PING, Buffer.alloc(0))), WS_PING_INTERVAL_MS);
+
+  socket.on("data", (chunk) => {
+    received = Buffer.concat([received, chunk]);
+    try {
+      let frame;
+      while ((frame = decodeFrame(received)) !== null) {
+        received = received.subarray(frame.size);
+        const { opcode, payload } = frame;
+
+        if (opcode === OPCODE_TEXT || opcode === OPCODE_BINARY) {
+          queue = queue
+            .then(() => onMessage(chipId, payload, opcode === OPCODE_BINARY))
+            .catch((error) => ({ error: error.message, status: 500 }))
+            .then((reply) => socket.writable && socket.write(encodeFrame(OPCODE_TEXT, Buffer.from(JSON.stringify(reply)))));
+        } else if (opcode === OPCODE_PING) {
+          socket.write(encodeFrame(OPCODE_PONG, payload));
+        } else if (opcode === OPCODE_CLOSE) {
+          socket.end(encodeFrame(OPCODE_CLOSE, Buffer.alloc(0)));
+        }
+      }
+    } catch (error) {
+      console.error("WebSocket error for chipId:", chipId, error.message);
+      socket.destroy();
+    }
+  });
+
+  socket.on("close", () => {
+    clearInterval(ping);
+    if (devices.get(chipId) === socket) {
+      devices.delete(chipId);
+      console.log("WebSocket closed for chipId:", chipId);
+    }
+  });
+  socket.on("error", () => socket.destroy());
+}
+
+/**
+ * Sends a JSON message to a connected device
+ * Returns false if the device has no open connection
+ */
+function send(chipId, message) {
+  const socket = devices.get(chipId);
+  if (!socket || !socket.writable) {
+    return false;
+  }
+  socket.write(encodeFrame(OPCODE_TEXT, Buffer.from(JSON.stringify(message))));
+  return true;
+}
+
+/**
+ * Serves WebSocket upgrades of an HTTP server
+ */
+function attach(server, onMessage) {
+  server.on("upgrade", (req, socket) => accept(req, socket, onMessage));
+}
+
+module.exports = { attach, send };
@@ -0,0 +1,35 @@
+#ifndef CBOR_ENCODER_H
+#define CBOR_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* CBOR (RFC 8949) major types, already shifted into the initial byte */
+#define CBOR_MAJOR_UINT   (0x00)
+#define CBOR_MAJOR_NINT   (0x20) /* Negative integer, the argument is -1 - value */
+#define CBOR_MAJOR_BYTES  (0x40)
+#define CBOR_MAJOR_TEXT   (0x60)
+#define CBOR_MAJOR_ARRAY  (0x80)
+#define CBOR_MAJOR_MAP    (0xA0)
+#define CBOR_FLOAT32      (0xFA) /* Major type 7, single precision float follows */
+
+/* Output buffer of the encoder, overflow is sticky so errors only need checking once at the end */
+struct CborEncoder {
+    uint8_t* buf;
+    size_t capacity;
+    size_t len;
+    bool overflow;
+};
+
+void cborBegin(CborEncoder* enc, uint8_t* buf, size_t capacity);
+void cborWriteUint(CborEncoder* enc, uint32_t value);
+void cborWriteUintFixed(CborEncoder* enc, uint32_t value);
+void cborWriteUint64Fixed(CborEncoder* enc, uint64_t value);
+void cborWriteInt64Fixed(CborEncoder* enc, int64_t value);
+void cborWriteFloat(CborEncoder* enc, float value);
+void cborWriteBytes(CborEncoder* enc, const uint8_t* data, size_t len);
+void cborWriteText(CborEncoder* enc, const char* text);
+void cborWriteArray(CborEncoder* enc, uint32_t items);
+void cborWriteMap(CborEncoder* enc, uint32_t pairs);
+
+#endif // CBOR_ENCODER_H
@@ -0,0 +1,29 @@
+#ifndef CLOCK_MGR_H
+#define CLOCK_MGR_H
+
+#include <stdint.h>
+
+#define CLOCK_SYNC_MAX_RTT_US  (1000000)     /* Slower exchanges do not adjust a clock that is already set */
+#define CLOCK_SYNC_STEP_US     (2000000)     /* Larger errors are corrected at once, smaller ones gradually */
+#define CLOCK_SYNC_GAIN        (0.25)        /* Share of the measured error corrected per exchange */
+#define CLOCK_DRIFT_SPAN_US    (600000000LL) /* Shortest span the drift is measured over, 10 minutes */
+#define CLOCK_DRIFT_GAIN       (0.5)         /* Weight of a new drift measurement */
+#define CLOCK_DRIFT_MAX_PPM    (200.0)       /* Bound of the drift estimate, crystals stay well below */
+
+/**
+ * @brief Device clock at a given moment and its relation to wall time, sent with every telemetry batch
+ *        so the backend can turn the device timestamps of the samples into wall time.
+ */
+struct ClockEstimate {
+    int64_t nowUs;      /* Device clock, us since boot */
+    uint64_t wallMs;    /* Estimated wall time at nowUs, ms since epoch, 0 until the first server exchange */
+    float driftPpm;     /* Device clock rate error, positive when it runs slow */
+};
+
+int64_t clockNowUs();
+void clockUpdate(uint64_t serverTimeMs, int64_t receivedUs, int64_t rttUs);
+bool clockSynced();
+uint64_t clockWallMs(int64_t deviceUs);
+void clockEstimate(ClockEstimate* estimate);
+
+#endif // CLOCK_MGR_H
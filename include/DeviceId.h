@@ -0,0 +1,13 @@
+#ifndef DEVICE_ID_H
+#define DEVICE_ID_H
+
+#include <stdint.h>
+
+#define DEVICE_ID_SIZE     (6)  /* Chip id (factory MAC) bytes */
+#define DEVICE_ID_STR_SIZE (18) /* "AA:BB:CC:DD:EE:FF" plus terminator */
+
+void deviceIdInit();
+const uint8_t* deviceIdBytes();
+const char* deviceIdStr();
+
+#endif // DEVICE_ID_H
@@ -4,13 +4,23 @@
 #include "SystemData.h"
 #include "LogMgr.h"
 
-void displayLightAndPresence(SystemData* data);
-void displayWaterLevelAndPump(SystemData* data);
-void displayTemperatureAndHumidity(SystemData* data);
-void displayWiFiStatus(SystemData* data);
-void displayDeviceInfo(SystemData* data);
-void displayLevelSettings(SystemData* data, uint8_t currentValue);
-void displayTempHumSettings(SystemData* data, uint8_t currentValue);
-void displayWiFiSettings(SystemData* data);
+/* Dump every rendered frame over Serial as a PBM image, enable with -D DISPLAY_SNAPSHOT_ENABLED=true in build_flags.
+   At 9600 baud a frame blocks the display task for about a second */
+#ifndef DISPLAY_SNAPSHOT_ENABLED
+#define DISPLAY_SNAPSHOT_ENABLED (false)
+#endif
+
+/* Screen functions return true when a new frame was rendered and needs to be flushed */
+bool displayLightAndPresence(SystemData* data);
+bool displayWaterLevelAndPump(SystemData* data);
+bool displayTemperatureAndHumidity(SystemData* data);
+bool displayWiFiStatus(SystemData* data);
+bool displayDeviceInfo(SystemData* data);
+bool displayLevelSettings(SystemData* data, uint8_t currentValue);
+bool displayTempHumSettings(SystemData* data, uint8_t currentValue);
+bool displayWiFiSettings(SystemData* data);
+void displayInvalidate();
+bool displayRender(SystemData* data);
+const char* displayFrameName();
 
 #endif // DISPLAY_MGR_H
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef FONT_METRICS_H
+#define FONT_METRICS_H
+
+#include <stdint.h>
+
+/* Metrics of the built-in Adafruit GFX 5x7 font (glcdfont) at text size 1 */
+#define FONT_GLYPH_WIDTH   (5) /* Glyph columns */
+#define FONT_GLYPH_SPACING (1) /* Blank column after each glyph */
+#define FONT_CHAR_ADVANCE  (FONT_GLYPH_WIDTH + FONT_GLYPH_SPACING)
+#define FONT_CHAR_HEIGHT   (8)
+
+/**
+ * @brief Width in pixels of a single line string, as reported by getTextBounds for the built-in font.
+ *        Evaluated at compile time for string literals, one step per character otherwise.
+ * @param str The string to measure.
+ * @param width Accumulated width, used by the recursion.
+ * @return The width in pixels.
+ */
+constexpr int16_t fontTextWidth(const char* str, int16_t width = 0) {
+    return (*str == '\0') ? width : fontTextWidth(str + 1, width + FONT_CHAR_ADVANCE);
+}
+
+/**
+ * @brief X position that centers a string on a column.
+ * @param str The string to place.
+ * @param centerX The column to center on.
+ * @return The X position of the first character.
+ */
+constexpr int16_t fontCenteredX(const char* str, int16_t centerX) {
+    return centerX - fontTextWidth(str) / 2;
+}
+
+/**
+ * @brief X position that right aligns a string on a column.
+ * @param str The string to place.
+ * @param rightX The first column after the string.
+ * @return The X position of the first character.
+ */
+constexpr int16_t fontRightAlignedX(const char* str, int16_t rightX) {
+    return rightX - fontTextWidth(str);
+}
+
+#endif // FONT_METRICS_H
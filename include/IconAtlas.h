@@ -0,0 +1,49 @@
+/* Generated by tools/iconAtlas.js, do not edit. */
+#ifndef ICON_ATLAS_H
+#define ICON_ATLAS_H
+
+#include "OledDisplay_classes.h"
+
+static const uint8_t PROGMEM Sun_Icon_Pages[] = {0x10,0x20,0x02,0xc4,0x30,0x10,0x08,0x0b,0x08,0x10,0x30,0xc4,0x02,0x20,0x10,0x04,0x02,0x20,0x11,0x06,0x04,0x08,0x68,0x08,0x04,0x06,0x11,0x20,0x02,0x04};
+static const IconBitmap Sun_Icon = {15, 16, Sun_Icon_Pages};
+
+static const uint8_t PROGMEM Moon_Icon_Pages[] = {0xe0,0xf8,0xfc,0xfe,0x0e,0x03,0x00,0x90,0xd0,0xb0,0x90,0x00,0x12,0x1a,0x16,0x03,0x0f,0x1f,0x3f,0x3f,0x7c,0x7c,0x78,0x78,0x78,0x38,0x3c,0x1c,0x0e,0x02};
+static const IconBitmap Moon_Icon = {15, 16, Moon_Icon_Pages};
+
+static const uint8_t PROGMEM Presence_Icon_Pages[] = {0x00,0x00,0x00,0x1c,0x22,0x41,0x41,0x41,0x22,0x1c,0x00,0x00,0x00,0x00,0x00,0xf0,0x8c,0x82,0x82,0x81,0x81,0x81,0x81,0x81,0x82,0x82,0x8c,0xf0,0x00,0x00};
+static const IconBitmap Presence_Icon = {15, 16, Presence_Icon_Pages};
+
+static const uint8_t PROGMEM Lamp_On_Icon_Pages[] = {0x00,0x80,0x40,0x40,0x38,0x06,0x03,0x06,0x38,0x40,0x40,0x80,0x00,0x09,0x0a,0x42,0x22,0x06,0x0a,0xca,0x0a,0x06,0x22,0x42,0x0a,0x09};
+static const IconBitmap Lamp_On_Icon = {13, 16, Lamp_On_Icon_Pages};
+
+static const uint8_t PROGMEM Lamp_Off_Icon_Pages[] = {0x00,0x80,0x40,0x40,0x38,0x06,0x03,0x06,0x38,0x40,0x40,0x80,0x00,0x01,0x02,0x02,0x02,0x06,0x0a,0x0a,0x0a,0x06,0x02,0x02,0x02,0x01};
+static const IconBitmap Lamp_Off_Icon = {13, 16, Lamp_Off_Icon_Pages};
+
+static const uint8_t PROGMEM Lvl_Icon_Pages[] = {0x00,0x00,0xf0,0xf0,0x00,0x00,0x80,0x80,0x80,0x88,0x9c,0x48,0x00,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0xf0,0xf0,0x00,0x00,0x7f,0xff,0x80,0x3f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x77,0x76,0x7e,0x7e,0x7e,0x7e,0x3f,0x80,0xff,0x7f,0x00,0x00,0x00,0x01,0x01,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x01,0x01,0x00};
+static const IconBitmap Lvl_Icon = {22, 19, Lvl_Icon_Pages};
+
+static const uint8_t PROGMEM Water_well_icon_Pages[] = {0x20,0x78,0x46,0x41,0xc1,0x41,0x41,0x41,0x41,0x41,0x41,0x41,0xc1,0x41,0x41,0x41,0x41,0x41,0x41,0xc1,0x41,0x46,0x78,0x20,0x00,0x00,0x00,0x00,0xff,0x00,0x00,0x04,0x7c,0x84,0x04,0x04,0x07,0x04,0x84,0x7c,0x04,0x00,0x00,0xff,0x00,0x00,0x00,0x00,0x00,0xf8,0x08,0x08,0x0f,0x08,0x08,0xf8,0x08,0x0b,0x0a,0x0a,0xfa,0x0a,0x0b,0x08,0xf8,0x08,0x08,0x0f,0x08,0xf8,0x00,0x00};
+static const IconBitmap Water_well_icon = {24, 24, Water_well_icon_Pages};
+
+static const uint8_t PROGMEM Pump_Icon_Pages[] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x40,0x00,0x20,0x20,0x20,0x20,0x20,0x60,0xa0,0x20,0x20,0x20,0xf0,0xf0,0x00,0x00,0x00,0x00,0x00,0x00,0xe0,0xe0,0x40,0x7e,0x81,0x00,0x00,0x18,0x24,0x40,0x00,0x2c,0x00,0x00,0x00,0x81,0x3e,0x02,0x07,0x07,0x00,0x00,0x00,0x00,0x00,0x00,0x0f,0x0f,0x04,0x04,0x04,0x07,0x06,0x04,0x04,0x04,0x04,0x04,0x00,0x02,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+static const IconBitmap Pump_Icon = {26, 23, Pump_Icon_Pages};
+
+static const uint8_t PROGMEM Temperature_Icon_Pages[] = {0x00,0x00,0xfe,0x01,0xfd,0x01,0xfe,0x54,0x00,0xe0,0x30,0x10,0x10,0x04,0x0a,0x04,0x3c,0x42,0x99,0xb4,0xbf,0xbc,0x99,0x42,0x3c,0x01,0x03,0x02,0x02,0x00,0x00,0x00};
+static const IconBitmap Temperature_Icon = {16, 16, Temperature_Icon_Pages};
+
+static const uint8_t PROGMEM Humidity_Icon_Pages[] = {0x00,0x00,0xc0,0xf0,0xfc,0xff,0xf8,0xe0,0xc0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0c,0x3f,0x7f,0x7f,0xff,0xff,0xff,0xfe,0x79,0x3f,0x0c,0x00,0x00,0x00,0x00,0x00};
+static const IconBitmap Humidity_Icon = {16, 16, Humidity_Icon_Pages};
+
+static const uint8_t PROGMEM Irrigator_Off_Icon_Pages[] = {0x00,0x00,0x00,0x70,0x88,0x44,0x24,0x14,0x08,0x00,0x08,0x10,0x20,0x40,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x05,0x08,0x10,0x20,0x40,0x80,0x00,0x80,0x40,0x20,0x28,0x24,0x22,0x21,0x20,0x20,0x24,0x40,0x7e,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+static const IconBitmap Irrigator_Off_Icon = {22, 18, Irrigator_Off_Icon_Pages};
+
+static const uint8_t PROGMEM Irrigator_On_Icon_Pages[] = {0x00,0x00,0x00,0x70,0x88,0x44,0x24,0x14,0x08,0x00,0x08,0x10,0x20,0x40,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x05,0x08,0x10,0x20,0x40,0x80,0x00,0x80,0x40,0x20,0x28,0x24,0x22,0x21,0x20,0x20,0x24,0x40,0x7e,0x00,0x00,0x80,0x20,0xc8,0x08,0xe0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x00,0x07,0x00,0x07,0x00,0x00,0x00};
+static const IconBitmap Irrigator_On_Icon = {31, 21, Irrigator_On_Icon_Pages};
+
+static const uint8_t PROGMEM WiFi_Connected_Icon_Pages[] = {0x20,0x70,0xb8,0xdc,0xec,0x76,0xb6,0xbb,0xdb,0xdb,0xdb,0xbb,0xb6,0x76,0xec,0xdc,0xb8,0x70,0x20,0x00,0x00,0x00,0x01,0x02,0x07,0x0b,0x1d,0x2e,0x76,0x2e,0x1d,0x0b,0x07,0x02,0x01,0x00,0x00,0x00};
+static const IconBitmap WiFi_Connected_Icon = {19, 16, WiFi_Connected_Icon_Pages};
+
+static const uint8_t PROGMEM WiFi_Not_Connected_Icon_Pages[] = {0x20,0x10,0x89,0x42,0x24,0x0a,0x92,0xa9,0x49,0x89,0x49,0x89,0x92,0x12,0x24,0x44,0x88,0x10,0x20,0x00,0x00,0x00,0x00,0x02,0x01,0x08,0x04,0x24,0x52,0x25,0x02,0x04,0x09,0x12,0x20,0x40,0x00,0x00};
+static const IconBitmap WiFi_Not_Connected_Icon = {19, 16, WiFi_Not_Connected_Icon_Pages};
+
+#endif // ICON_ATLAS_H
@@ -3,16 +3,48 @@
 #define OLED_DISPLAY_H
 
 #include <Adafruit_SSD1306.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
 #define SCREEN_WIDTH 128 // OLED display width, in pixels
 #define SCREEN_HEIGHT 64 // OLED display height, in pixels
 #define OLED_RESET     -1 // Reset pin # (or -1 if sharing Arduino reset pin)
 #define SCREEN_ADDRESS 0x3C ///< See datasheet for Address; 0x3D for 128x64, 0x3C for 128x32
+#define SCREEN_PAGES   (SCREEN_HEIGHT / 8) // Number of 8-pixel tall pages in the SSD1306 framebuffer
+
+#if defined(I2C_BUFFER_LENGTH)
+#define OLED_I2C_CHUNK_SIZE (I2C_BUFFER_LENGTH - 1) // Data bytes per I2C transaction (one byte is the control byte)
+#else
+#define OLED_I2C_CHUNK_SIZE (31)
+#endif
+
+#define OLED_I2C_CLOCK_HZ         (400000) // I2C fast mode, kept during and after transfers
+#define OLED_FLUSH_TASK_STACK     (2048)
+#define OLED_FLUSH_TASK_PRIORITY  (2)
+#define OLED_FLUSH_TASK_CORE      (1)
+
+/* Icon stored in SSD1306 page order: ceil(height / 8) pages of width bytes, LSB on top (see tools/iconAtlas.js) */
+struct IconBitmap {
+    uint8_t width;
+    uint8_t height;
+    const uint8_t* pages;
+};
 
 class OledDisplay {
 private:
     Adafruit_SSD1306 display;
     uint8_t lcd_addr;
+    uint8_t sentBuffer[SCREEN_WIDTH * SCREEN_PAGES]; // Copy of the framebuffer as last transmitted to the panel
+    uint8_t txBuffer[SCREEN_WIDTH * SCREEN_PAGES];   // Frame snapshot being transmitted by the flush task
+    bool sentBufferValid;
+    TaskHandle_t flushTaskHandle;
+    SemaphoreHandle_t xFlushDone;
+
+    static void flushTask(void* pvParameters);
+    void transmitDirtyRegions(const uint8_t* frame);
+    void sendCommands(const uint8_t* cmds, uint8_t len);
+    void sendData(const uint8_t* buf, uint16_t len);
 
 public:
     OledDisplay(uint8_t width, uint8_t height, uint8_t lcd_addr);
@@ -23,10 +55,12 @@ public:
     void SetdisplayData(int16_t posX, int16_t posY, uint16_t data);
     void SetdisplayData(int16_t posX, int16_t posY, uint8_t data);
     void SetdisplayData(int16_t posX, int16_t posY, double data);
-    uint16_t getStringWidth(const char* str);
     void DrawLine(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
-    void DrawIcon(int16_t x, int16_t y, const uint8_t* icon, uint8_t w, uint8_t h);
+    void DrawIcon(int16_t x, int16_t y, const IconBitmap& icon);
+    void ClearArea(int16_t x, int16_t y, int16_t w, int16_t h);
     void PrintdisplayData();
+    bool waitFlushDone(TickType_t timeout);
+    void dumpFramePbm(Print& out, uint8_t screenId, const char* name, uint32_t renderTimeUs);
 };
 
 #endif
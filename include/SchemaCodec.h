@@ -0,0 +1,74 @@
+#ifndef SCHEMA_CODEC_H
+#define SCHEMA_CODEC_H
+
+#include "SystemData.h"
+#include "TelemetryMgr.h"
+#include "CborEncoder.h"
+#include "ClockMgr.h"
+
+/*
+ * Field lists of the payloads exchanged with the backend. Every codec below is generated from them,
+ * so adding a field here updates the JSON and CBOR serializers and the settings parser together.
+ */
+
+/* Settings: X(json key, SystemData member), all members are uint8_t */
+#define SETTINGS_FIELDS(X) \
+    X("maxLevel",       maxLevelPercentage) \
+    X("minLevel",       minLevelPercentage) \
+    X("hotTemperature", hotTemperature) \
+    X("lowHumidity",    lowHumidity)
+
+/* Telemetry sample: X(json key, kind, value from a TelemetrySample named s), kind is UINT, FLOAT or FLAG */
+#define TELEMETRY_SENSOR_FIELDS(X) \
+    X("lvl",  UINT,  s.levelPercentage) \
+    X("tmp",  FLOAT, s.temperature) \
+    X("hum",  FLOAT, s.humidity) \
+    X("ldr",  FLAG,  s.inputs & TELEMETRY_IN_LIGHT) \
+    X("pir",  FLAG,  s.inputs & TELEMETRY_IN_PIR) \
+    X("well", FLAG,  s.inputs & TELEMETRY_IN_WELL)
+
+#define TELEMETRY_ACTUATOR_FIELDS(X) \
+    X("lmp", FLAG, s.actuators & TELEMETRY_ACT_LAMP) \
+    X("pmp", FLAG, s.actuators & TELEMETRY_ACT_PUMP) \
+    X("irr", FLAG, s.actuators & TELEMETRY_ACT_IRRIGATOR)
+
+#define SCHEMA_SETTINGS_JSON_SIZE (128)  /* Worst case size of the settings payload */
+#define SCHEMA_SAMPLE_JSON_SIZE   (176)  /* Worst case size of one JSON sample */
+#define SCHEMA_SAMPLE_CBOR_SIZE   (31)   /* Size of one CBOR sample, its fields are fixed width */
+#define SCHEMA_BATCH_HEADER_SIZE  (128)  /* Chip id, clock estimate and array/map heads of a batch */
+#define SCHEMA_FILTER_TOKEN_SIZE  (16)   /* Longest key or scalar value the settings filter keeps, longer ones are dropped */
+
+/**
+ * @brief State of the streaming settings filter. A document is fed in pieces as it arrives, only the members
+ *        of its top level object named in SETTINGS_FIELDS are kept, as a small JSON object, along with the
+ *        "time" and "noSettings" members of /sync responses. Everything else,
+ *        nested values included, is skipped byte by byte, so the size of the document does not matter.
+ */
+struct SchemaSettingsFilter {
+    char out[SCHEMA_SETTINGS_JSON_SIZE];  /* Kept members as a null terminated JSON object, once complete */
+    size_t outLen;
+    char key[SCHEMA_FILTER_TOKEN_SIZE];   /* Key of the current member */
+    char token[SCHEMA_FILTER_TOKEN_SIZE]; /* Key, then scalar value being read */
+    uint8_t tokenLen;
+    uint8_t state;
+    uint8_t depth;                        /* Nesting of the skipped value */
+    bool escape;                          /* Previous byte was a backslash inside a string */
+    bool inString;                        /* Inside a string of the skipped value */
+    bool keep;                            /* The current member is kept */
+    bool hasError;                        /* The object has an "error" member */
+    bool noSettings;                      /* "noSettings": true, the server has no settings for this device */
+    uint64_t serverTime;                  /* "time" member, server time in ms since epoch, 0 if absent */
+};
+
+size_t schemaWriteSettingsJson(char* buf, size_t capacity, const SystemData* data);
+size_t schemaWriteSettingsObjectJson(char* buf, size_t capacity, const SystemData* data);
+size_t schemaWriteBatchJson(char* buf, size_t capacity, const TelemetrySample* samples, uint16_t count, const ClockEstimate& clock);
+size_t schemaWriteBatchCbor(uint8_t* buf, size_t capacity, const TelemetrySample* samples, uint16_t count, const ClockEstimate& clock);
+int8_t schemaParseSettings(const char* json, size_t len, SystemData* data);
+bool schemaHasKey(const char* json, size_t len, const char* key);
+bool schemaGetUint(const char* json, size_t len, const char* key, uint32_t* value);
+void schemaFilterBegin(SchemaSettingsFilter* f);
+void schemaFilterFeed(SchemaSettingsFilter* f, const char* data, size_t len);
+bool schemaFilterEnd(SchemaSettingsFilter* f);
+
+#endif // SCHEMA_CODEC_H
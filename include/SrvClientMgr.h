@@ -3,9 +3,48 @@
 
 #include "SystemData.h"
 
-void fetchUpdatedSettings(SystemData* data);
-bool checkJsonSettingsExistence(SystemData* data);
-void sendSensActHistory(SystemData* data);
-void sendSystemSettings(SystemData* data);
+#define SERVER_TRANSPORT_MQTT         (false) /* Exchange telemetry and settings through an MQTT broker instead of the backend API */
+#define SERVER_TELEMETRY_CBOR         (true) /* Upload telemetry batches as CBOR (application/cbor) instead of JSON */
+#define SERVER_SETTINGS_RESPONSE_SIZE (256)  /* Largest accepted channel message, /sync responses are streamed */
+#define SERVER_CHANNEL_ACK_TIMEOUT_MS (5000) /* Wait for the acknowledgement of a batch sent over the WebSocket channel */
+#define SERVER_MQTT_RETAINED_WAIT_MS  (2000) /* Wait for the retained settings after subscribing */
+#define SERVER_OP_RETRY_BASE_MS       (1000)  /* Wait before starting an operation again after it failed, doubled with each further failure */
+#define SERVER_OP_RETRY_MAX_MS        (60000) /* Longest wait between two attempts of a failing operation */
+
+/**
+ * @brief Backend operations run by the server task, one at a time and without blocking it.
+ *        Lower values are started first when several are requested.
+ */
+enum ServerOp {
+    SERVER_OP_SETTINGS_SEND,   /* Upload the settings changed on the device */
+    SERVER_OP_SYNC,            /* /sync: upload the buffered samples if any, download the settings if they changed */
+    SERVER_OP_TELEMETRY,       /* Upload the oldest buffered samples, over /sync unless the channel is open */
+    SERVER_OP_BACKFILL,        /* Upload the oldest samples of the flash log, likewise */
+    SERVER_OP_COUNT,
+};
+
+/**
+ * @brief Latency of an operation from its start to its completion, connection setup included,
+ *        and the most heap it took, sampled at each poll.
+ */
+struct ServerOpStats {
+    uint32_t count;
+    uint32_t failures;      /* Rejections included */
+    uint32_t rejections;    /* Refused by the server as bad (400, 413), their samples were dropped */
+    uint32_t lastMs;
+    uint32_t maxMs;
+    uint32_t totalMs;
+    uint32_t maxHeapBytes;
+};
+
+void requestServerOp(ServerOp op);
+void serviceServerRequests(SystemData* data);
+void cancelServerRequests(SystemData* data);
+bool serverRequestsBusy();
+const ServerOpStats& getServerOpStats(ServerOp op);
+uint32_t getServerSyncAge();
+void serviceServerChannel(SystemData* data);
+void beginSettingsEdit(SystemData* data);
+void endSettingsEdit(SystemData* data);
 
 #endif // SRV_CLIENT_MGR_H
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include "TelemetryMgr.h"
+
+#define TELEMETRY_LOG_SEGMENTS          (16)   /* Segment files used as a ring, the oldest is erased when the log wraps */
+#define TELEMETRY_LOG_SEGMENT_RECORDS   (146)  /* Records per segment, 146 x 28 B fits one 4 KB flash block */
+#define TELEMETRY_LOG_PATH_SIZE         (16)   /* "/tlmNN.bin" */
+#define TELEMETRY_LOG_FORMAT            (2)    /* Record layout, segments written with another one are erased at boot */
+#define TELEMETRY_LOG_BOOT_ANCHORS      (8)    /* Boots whose wall time is remembered, to date their samples logged before the clock was set */
+#define TELEMETRY_LOG_ANCHOR_DRIFT_MS   (1000) /* The wall time of this boot is stored again when its estimate moves by more */
+#define TELEMETRY_BACKFILL_INTERVAL_MS  (2000) /* Shortest time between two backfill batches, live samples go first */
+
+void telemetryLogInit();
+void telemetryLogSpill();
+uint32_t telemetryLogCount();
+uint16_t telemetryLogPeek(TelemetrySample* samples, uint16_t maxSamples, uint16_t* records);
+void telemetryLogDrop(uint16_t records);
+
+#endif // TELEMETRY_LOG_H
@@ -0,0 +1,47 @@
+#ifndef TELEMETRY_MGR_H
+#define TELEMETRY_MGR_H
+
+#include "SystemData.h"
+
+#define TELEMETRY_BATCH_SIZE         (15)    /* Samples uploaded per request */
+#define TELEMETRY_RING_CAPACITY      (300)   /* Samples kept in RAM while offline */
+#define TELEMETRY_SPILL_THRESHOLD    (TELEMETRY_RING_CAPACITY - 2 * TELEMETRY_BATCH_SIZE) /* Buffered samples above which the oldest move to flash */
+#define TELEMETRY_SPILL_AGE_MS       (120000) /* Samples not uploaded after this long move to flash, the most a reset can lose */
+
+/* Reporting policy: a sample is recorded only when a value leaves its deadband, on any digital change, or as a heartbeat */
+#define TELEMETRY_DEADBAND_LEVEL     (2)     /* Water level, % */
+#define TELEMETRY_DEADBAND_TEMP      (0.5f)  /* Temperature, C */
+#define TELEMETRY_DEADBAND_HUM       (2.0f)  /* Humidity, % */
+#define TELEMETRY_HEARTBEAT_MS       (60000) /* Longest time without a recorded sample */
+#define TELEMETRY_MAX_LATENCY_MS     (15000) /* Longest time a recorded sample waits for upload */
+
+/* Bit positions inside the packed digital inputs byte */
+#define TELEMETRY_IN_LIGHT (0x01)
+#define TELEMETRY_IN_PIR   (0x02)
+#define TELEMETRY_IN_WELL  (0x04)
+
+/* Bit positions inside the packed actuators byte */
+#define TELEMETRY_ACT_LAMP      (0x01)
+#define TELEMETRY_ACT_PUMP      (0x02)
+#define TELEMETRY_ACT_IRRIGATOR (0x04)
+
+/* One sensor/actuator sample as uploaded to /sync */
+struct TelemetrySample {
+    int64_t timeUs;           /* clockNowUs() when the sample was taken */
+    uint32_t seq;             /* Increments with every recorded sample */
+    float temperature;
+    float humidity;
+    uint16_t levelPercentage;
+    uint8_t inputs;           /* TELEMETRY_IN_* bits */
+    uint8_t actuators;        /* TELEMETRY_ACT_* bits */
+};
+
+void telemetryInit();
+bool telemetryRecordOnChange(SystemData* data);
+uint16_t telemetryCount();
+bool telemetryUploadDue();
+uint16_t telemetryPeek(TelemetrySample* samples, uint16_t maxSamples);
+void telemetryDrop(uint32_t lastSeq);
+uint16_t telemetryTakeOverflow(TelemetrySample* samples, uint16_t maxSamples);
+
+#endif // TELEMETRY_MGR_H
@@ -0,0 +1,70 @@
+#ifndef TRACE_MGR_H
+#define TRACE_MGR_H
+
+#include "SystemData.h"
+
+#ifndef TRACE_RECORDER_ENABLED
+#define TRACE_RECORDER_ENABLED  (false) /* Stream binary sensor/actuator trace records over Serial */
+#endif
+#define TRACE_KEYFRAME_INTERVAL (64)    /* Emit a full (non-delta) record every N records to allow resync */
+#define TRACE_MAX_RECORD_SIZE   (40)    /* Worst case size of a single encoded record */
+#define TRACE_REPLAY_STEP_MS    (100)   /* Period of the process task reproduced by the replay */
+
+#define TRACE_FRAME_SYNC0 (0xA5) /* First sync byte, never produced by the ASCII logs */
+#define TRACE_FRAME_SYNC1 (0x5A) /* Second sync byte */
+
+/* Record header flags, a set bit means the field group follows in the record */
+#define TRACE_FLAG_LEVEL     (0x01) /* Raw level ADC value (zigzag delta) */
+#define TRACE_FLAG_TEMP      (0x02) /* Temperature in 0.1 C (zigzag delta) */
+#define TRACE_FLAG_HUM       (0x04) /* Humidity in 0.1 % (zigzag delta) */
+#define TRACE_FLAG_INPUTS    (0x08) /* Packed digital inputs */
+#define TRACE_FLAG_ACTUATORS (0x10) /* Packed actuator states */
+#define TRACE_FLAG_SETTINGS  (0x20) /* Control thresholds used by ProcessMgr */
+#define TRACE_FLAG_KEYFRAME  (0x80) /* Absolute timestamp and values instead of deltas */
+
+/* Bit positions inside the packed digital inputs byte */
+#define TRACE_IN_PIR     (0x01)
+#define TRACE_IN_LIGHT   (0x02)
+#define TRACE_IN_SELECT  (0x04)
+#define TRACE_IN_ESC     (0x08)
+#define TRACE_IN_UP      (0x10)
+#define TRACE_IN_DOWN    (0x20)
+#define TRACE_IN_WELL    (0x40)
+
+/* Bit positions inside the packed actuators byte */
+#define TRACE_ACT_LAMP      (0x01)
+#define TRACE_ACT_PUMP      (0x02)
+#define TRACE_ACT_IRRIGATOR (0x04)
+
+/* Snapshot of everything ProcessMgr consumes and produces */
+struct TraceSnapshot {
+    uint32_t timeMs;
+    uint16_t level;       /* Raw level ADC value */
+    int16_t temperature;  /* Temperature in 0.1 C */
+    int16_t humidity;     /* Humidity in 0.1 % */
+    uint8_t inputs;       /* TRACE_IN_* bits */
+    uint8_t actuators;    /* TRACE_ACT_* bits */
+    uint8_t settings[4];  /* maxLevel, minLevel, hotTemperature, lowHumidity */
+};
+
+/* Outcome of a replay, see traceReplay() */
+struct TraceReplayStats {
+    uint32_t records;         /* Records decoded and applied */
+    uint32_t crcErrors;       /* Frames dropped, the replay resumes at the next keyframe */
+    uint32_t decisions;       /* Recorded actuator changes compared with the replayed ones */
+    uint32_t mismatches;      /* Recorded actuator changes the replay did not reproduce */
+    uint32_t firstMismatchMs; /* Record time of the first mismatch */
+    uint8_t expected;         /* Recorded TRACE_ACT_* bits of the first mismatch */
+    uint8_t replayed;         /* Replayed TRACE_ACT_* bits of the first mismatch */
+};
+
+/* Presents the recorded readings to the sensor drivers and sets the clock to state->timeMs */
+typedef void (*TraceInputWriter)(const TraceSnapshot* state, void* ctx);
+
+void traceInit();
+void traceRecordSensors(SystemData* data);
+void traceRecordActuators(SystemData* data);
+void traceReplay(SystemData* data, const uint8_t* buf, size_t len, TraceInputWriter writeInputs, void* ctx,
+                 TraceReplayStats* stats);
+
+#endif // TRACE_MGR_H
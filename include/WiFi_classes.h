@@ -5,25 +5,61 @@
 #include <IPAddress.h>
 #include <vector>
 #include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define WIFI_SCAN_CACHE_TTL_MS    (30000) /* Scan results younger than this are reused */
+#define WIFI_SCAN_TIMEOUT_MS      (10000) /* Give up on a scan that never reports completion */
+#define WIFI_CONNECT_TIMEOUT_MS   (5000)  /* Give up on a connection attempt without an IP */
+
+/**
+ * @brief Progress of an asynchronous WiFi operation (scan or connect).
+ */
+enum WiFiOpState {
+    WIFI_OP_IDLE,
+    WIFI_OP_IN_PROGRESS,
+    WIFI_OP_DONE,
+    WIFI_OP_FAILED,
+};
 
 /**
  * @brief Class to manage WiFi functionalities.
+ *        The settings screens (display task) and the reconnection (server task) both drive the connection,
+ *        so the credentials and the connect state are guarded by a mutex and the getters return copies.
  */
 class WiFiManager {
 private:
     String ssid;
     String password;
+    std::vector<String> scanCache;
+    uint32_t scanCacheTime;
+    bool scanCacheValid;
+    WiFiOpState scanState;
+    uint32_t scanStartTime;
+    String pendingSsid;
+    String pendingPassword;
+    WiFiOpState connectState;
+    uint32_t connectStartTime;
+    SemaphoreHandle_t xStateMutex;
+
+    static void onWiFiEvent(WiFiEvent_t event);
 
 public:
     WiFiManager(const char* ssid, const char* password);
-    const char* getSSID();
-    const char* getPassword();
+    void init();
+    String getSSID();
+    String getPassword();
     void setSSID(const char* ssid);
     void setPassword(const char* password);
     void disconnectWiFi();
     bool IsWiFiConnected();
     IPAddress getWiFiLocalIp();
-    std::vector<String> scanNetworks();
+    WiFiOpState startScan(bool forceRefresh = false);
+    WiFiOpState pollScan(std::vector<String>& ssidList);
+    void cancelScan();
+    void beginConnect(const String& ssid, const String& password);
+    WiFiOpState pollConnect();
+    void cancelConnect();
     bool connectToNetwork(const String& ssid, const String& password);
     void saveCredentials(const String& ssid, const String& password);
     bool loadCredentials(String& ssid, String& password);
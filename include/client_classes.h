@@ -3,22 +3,264 @@
 
 #include <HTTPClient.h>
 #include "WiFi_classes.h"
+#include "mqtt_classes.h"
+
+#define SERVER_HTTP_TIMEOUT_MS   (5000) /* Deadline of a whole request, connection setup included */
+#define SERVER_ETAG_SIZE         (48)   /* Settings version (ETag) as sent by the server, quotes included */
+#define SERVER_HTTP_LINE_SIZE    (128)  /* Longest response header line kept, longer ones are truncated */
+
+#define SERVER_BREAKER_THRESHOLD  (3)      /* Consecutive failed requests that open the breaker of an HTTP endpoint */
+#define SERVER_BACKOFF_BASE_MS    (2000)   /* Backoff of an HTTP endpoint once its breaker opens, doubled after each failed probe */
+#define SERVER_BACKOFF_MAX_MS     (300000) /* Longest backoff of any endpoint, before jitter */
+#define SERVER_RETRY_BUDGET       (3)      /* Stale connection retries that can be spent in a row */
+#define SERVER_RETRY_EARN_COUNT   (10)     /* Successful requests that earn one retry back */
+
+#define SERVER_WS_RECONNECT_MS    (10000) /* Backoff after a failed WebSocket connection attempt, doubled after each further one */
+#define SERVER_WS_IDLE_TIMEOUT_MS (75000) /* The server pings every 30 s, a silent connection is considered dead */
+#define SERVER_WS_MAX_FRAME       (4096)  /* Largest frame sent or accepted, bigger server frames are dropped */
+
+#define SERVER_MQTT_PORT          (1883)
+#define SERVER_MQTT_TOPIC_ROOT    "greenhouse"  /* Topics: greenhouse/<chipId>/telemetry, /settings and /status */
+#define SERVER_MQTT_RECONNECT_MS  (10000)       /* Backoff after a failed broker connection attempt, doubled after each further one */
+
+/**
+ * @brief Progress of an asynchronous HTTP request.
+ */
+enum HttpOpState {
+    HTTP_OP_IDLE,
+    HTTP_OP_IN_PROGRESS,
+    HTTP_OP_DONE,
+    HTTP_OP_FAILED,
+};
+
+/**
+ * @brief Receives the response body of a request piece by piece, as it arrives.
+ * @param data Body bytes.
+ * @param len Number of bytes.
+ * @param ctx Context passed to AsyncHttpClient::begin().
+ */
+typedef void (*HttpBodyCallback)(const char* data, size_t len, void* ctx);
+
+/**
+ * @brief Non-blocking HTTP/1.1 client over a raw socket, one request at a time on a kept-alive connection.
+ *        begin() starts a request and poll() advances it with whatever the socket can take or give at that
+ *        moment, so the caller never waits for the network. The response body is handed to a callback as it
+ *        arrives, it is never buffered whole.
+ */
+class AsyncHttpClient {
+private:
+    enum Phase {
+        PHASE_CONNECT,
+        PHASE_SEND,
+        PHASE_STATUS,
+        PHASE_HEADERS,
+        PHASE_BODY,
+        PHASE_CHUNK_SIZE,
+        PHASE_CHUNK_DATA,
+        PHASE_TRAILERS,
+    };
+
+    String host;
+    uint16_t port;
+    bool addressResolved;
+    uint32_t address;       // IPv4 address of host, network byte order
+    int sock;
+    HttpOpState state;
+    Phase phase;
+    bool reused;            // The request went out on a connection kept from a previous one
+    bool retryAllowed;
+    bool retried;
+    bool retrySkipped;      // The request failed on a closed kept-alive connection and was not allowed a retry
+    String request;         // Request line and headers
+    const uint8_t* body;
+    size_t bodyLen;
+    size_t sent;
+    HttpBodyCallback onBody;
+    void* bodyCtx;
+    size_t responseLen;
+    int statusCode;
+    int32_t remaining;      // Body or chunk bytes still expected, -1 to read until the server closes
+    bool chunked;
+    bool closeAfter;
+    char line[SERVER_HTTP_LINE_SIZE];
+    size_t lineLen;
+    char etag[SERVER_ETAG_SIZE];
+    uint32_t startTime;
+    uint32_t latencyMs;
+
+    bool openSocket();
+    void closeSocket();
+    void restart();
+    void finish();
+    void fail(int error);
+    void consume(const uint8_t* data, size_t len);
+    void handleLine();
+
+public:
+    AsyncHttpClient();
+    void setServer(const String& host, uint16_t port);
+    bool begin(const char* method, const String& path, const char* contentType, const uint8_t* body, size_t bodyLen,
+               const char* ifNoneMatch, HttpBodyCallback onBody, void* bodyCtx, bool retryAllowed);
+    HttpOpState poll();
+    void stop();
+    int getStatusCode();
+    size_t getResponseLength();
+    const char* getEtag();
+    bool wasReused();
+    bool wasRetried();
+    bool wasRetrySkipped();
+    uint32_t getLatencyMs();
+};
+
+/**
+ * @brief Minimal WebSocket (RFC 6455) client, unfragmented frames only.
+ *        Pings are answered internally, data frames are returned to the caller.
+ */
+class WebSocketClient {
+private:
+    WiFiClient tcp;
+    bool open;
+    uint32_t lastRxTime;
+    uint32_t readStart;   /* Start of the handshake or frame being read, its reads share one SERVER_HTTP_TIMEOUT_MS */
+
+    bool writeFrame(uint8_t opcode, const uint8_t* payload, size_t len);
+    int readFrame(char* message, size_t capacity, size_t* len);
+    bool readExact(uint8_t* buf, size_t len);
+    bool discard(size_t len);
+    bool readLine(char* line, size_t capacity);
+
+public:
+    WebSocketClient();
+    bool connect(const char* host, uint16_t port, const char* path);
+    void close();
+    bool isOpen();
+    bool send(const uint8_t* payload, size_t len, bool binary);
+    int receive(char* message, size_t capacity, size_t* len, uint32_t timeoutMs);
+};
+
+/**
+ * @brief State of a circuit breaker, ordered from healthy to failing.
+ */
+enum BreakerState {
+    BREAKER_CLOSED,     /* Requests go through */
+    BREAKER_HALF_OPEN,  /* The backoff elapsed, a single probe request goes through */
+    BREAKER_OPEN,       /* Requests are refused until the backoff elapses */
+};
+
+/**
+ * @brief Failure tracker of one backend endpoint. After `threshold` consecutive failures the breaker opens
+ *        and refuses requests for a jittered exponential backoff. Then one probe is let through: its success
+ *        closes the breaker, its failure opens it again with twice the backoff.
+ */
+class CircuitBreaker {
+private:
+    const char* name;
+    uint8_t threshold;
+    uint32_t baseMs;
+    BreakerState state;
+    uint8_t failures;       // Consecutive failures
+    uint8_t backoffLevel;   // Failed probes since the breaker opened
+    uint32_t openTime;
+    uint32_t backoffMs;
+    uint32_t trips;
+
+public:
+    CircuitBreaker(const char* name, uint8_t threshold, uint32_t baseMs);
+    BreakerState check();
+    BreakerState getState();
+    void recordSuccess();
+    bool recordFailure();
+    uint32_t getRetryInMs();
+    uint32_t getTrips();
+};
+
+/**
+ * @brief Backend request started by ServerClient, decides what is done with the response.
+ */
+enum ServerRequest {
+    SERVER_REQ_NONE,
+    SERVER_REQ_SETTINGS_UPLOAD,
+    SERVER_REQ_SYNC,            /* Telemetry upload and settings download in one exchange */
+    SERVER_REQ_COUNT,
+};
+
+/**
+ * @brief Request counters of the backend connection, latency includes connection setup.
+ */
+struct ServerClientStats {
+    uint32_t requests;
+    uint32_t failures;
+    uint32_t reusedConnections;
+    uint32_t reconnects;
+    uint32_t lastLatencyMs;
+    uint32_t totalLatencyMs;
+    uint32_t breakerTrips;       // Times an endpoint breaker opened
+    uint32_t retriesSkipped;     // Stale connection retries refused because the retry budget was spent
+};
 
 /**
  * @brief Class to manage client-server communication.
+ *        A single HTTP/1.1 keep-alive connection to the backend is reused by all requests, which run
+ *        asynchronously: a begin*() call starts one and pollRequest() advances it until it completes.
+ *        A WebSocket channel to /ws carries telemetry and settings pushes while it is open,
+ *        HTTP requests are the fallback when it is not.
+ *        Alternatively an MQTT broker carries telemetry (QoS 0) and retained settings (QoS 1).
  */
 class ServerClient {
 private:
     const char* serverUrl;
-    String payload;
     WiFiManager* wifiManager;
+    String serverHost;                   // Host and port of the http:// server URL
+    uint16_t serverPort;
+    AsyncHttpClient http;
+    ServerRequest pendingRequest;        // Request in progress on the HTTP connection
+    String updateSettingsPath;
+    String syncPath;
+    ServerClientStats stats;
+    CircuitBreaker breakers[SERVER_REQ_COUNT]; // Per HTTP endpoint, indexed by ServerRequest
+    uint8_t retryTokens;                 // Retry budget left, in 1/SERVER_RETRY_EARN_COUNT retries
+    char settingsEtag[SERVER_ETAG_SIZE]; // Version of the settings last received or sent, empty if unknown
+    WebSocketClient channel;             // Persistent channel for telemetry and settings push
+    String channelPath;
+    CircuitBreaker channelBreaker;
+    MqttClient mqtt;                     // Broker connection when MQTT is the selected transport
+    const char* mqttHost;
+    String telemetryTopic;
+    String settingsTopic;
+    String statusTopic;
+    CircuitBreaker mqttBreaker;
+
+    bool beginRequest(ServerRequest request, const char* method, const String& path, const char* contentType,
+                      const uint8_t* body, size_t bodyLen, const char* ifNoneMatch, HttpBodyCallback onBody, void* bodyCtx);
+    void storeSettingsEtag(int httpResponseCode);
 
 public:
     ServerClient(const char* serverUrl, WiFiManager* wifiManager);
     void closeConnection();
     const char* getServerUrl();
-    void sendSysSettingsPayload(const String& settingsPayload);
-    void sendSensActHistoryPayload(const String& sensActPayload);
+    bool beginSettingsUpload(const char* settingsPayload, size_t len);
+    bool beginSync(const uint8_t* batchPayload, size_t len, const char* contentType, HttpBodyCallback onBody, void* bodyCtx);
+    BreakerState checkEndpoint(ServerRequest request);
+    HttpOpState pollRequest();
+    void cancelRequest();
+    int getResponseCode();
+    bool responseRejected();
+    static bool isPayloadRejected(int httpResponseCode);
+    size_t getResponseLength();
+    void clearSettingsVersion();
+    bool maintainChannel();
+    bool channelConnected();
+    bool channelSend(const uint8_t* payload, size_t len, bool binary);
+    int channelReceive(char* message, size_t capacity, size_t* len, uint32_t timeoutMs);
+    void closeChannel();
+    void setMqttBroker(const char* host);
+    bool maintainMqtt();
+    bool mqttConnected();
+    bool mqttPublishTelemetry(const uint8_t* payload, size_t len);
+    bool mqttPublishSettings(const char* settingsPayload, size_t len);
+    int mqttReceiveSettings(char* settingsPayload, size_t capacity, size_t* len, uint32_t timeoutMs);
+    const ServerClientStats& getStats();
+    BreakerState getHealth();
 };
 
 #endif // CLIENT_CLASSES_H
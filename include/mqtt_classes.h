@@ -0,0 +1,46 @@
+#ifndef MQTT_CLASSES_H
+#define MQTT_CLASSES_H
+
+#include <WiFi.h>
+
+#define MQTT_KEEPALIVE_S        (60)   /* Keep alive announced to the broker */
+#define MQTT_TIMEOUT_MS         (5000) /* Deadline of the connection with its CONNACK, and of reading one packet */
+#define MQTT_INFLIGHT_SIZE      (256)  /* Largest QoS 1 PUBLISH kept for retransmission */
+#define MQTT_MAX_TOPIC          (96)   /* Longest topic accepted from the broker */
+
+/**
+ * @brief Minimal MQTT 3.1.1 client: QoS 0 and QoS 1 publish, subscribe, keep alive and last will.
+ *        One outgoing QoS 1 message is kept until the broker acknowledges it and is sent again
+ *        after a reconnect.
+ */
+class MqttClient {
+private:
+    WiFiClient tcp;
+    bool open;
+    uint16_t nextPacketId;
+    uint32_t lastTxTime;
+    uint32_t lastRxTime;
+    uint32_t readStart;   // Start of the connection or packet being read, its reads share one MQTT_TIMEOUT_MS
+    uint8_t inflight[MQTT_INFLIGHT_SIZE]; // Encoded QoS 1 PUBLISH waiting for its PUBACK
+    size_t inflightLen;
+    uint16_t inflightId;
+
+    bool writeHeader(uint8_t type, size_t remainingLen);
+    bool writeString(const char* text);
+    bool readExact(uint8_t* buf, size_t len);
+    bool discard(size_t len);
+    int readPacket(char* topic, size_t topicCapacity, uint8_t* payload, size_t payloadCapacity, size_t* payloadLen);
+    uint16_t allocPacketId();
+
+public:
+    MqttClient();
+    bool connect(const char* host, uint16_t port, const char* clientId, const char* willTopic, const char* willMessage);
+    void close();
+    bool isOpen();
+    bool publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retain);
+    bool subscribe(const char* topic, uint8_t qos);
+    int receive(char* topic, size_t topicCapacity, uint8_t* payload, size_t payloadCapacity, size_t* payloadLen, uint32_t timeoutMs);
+    bool inflightPending();
+};
+
+#endif // MQTT_CLASSES_H
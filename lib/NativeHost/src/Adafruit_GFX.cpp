@@ -0,0 +1,226 @@
+#include "Adafruit_GFX.h"
+
+/* Classic 5x7 font of the Adafruit GFX library (glcdfont.c), printable ASCII 0x20 to 0x7F,
+   5 columns per character, LSB on top */
+static const uint8_t font[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, /* ' ' */
+    0x00, 0x00, 0x5F, 0x00, 0x00, /* '!' */
+    0x00, 0x07, 0x00, 0x07, 0x00, /* '"' */
+    0x14, 0x7F, 0x14, 0x7F, 0x14, /* '#' */
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, /* '$' */
+    0x23, 0x13, 0x08, 0x64, 0x62, /* '%' */
+    0x36, 0x49, 0x56, 0x20, 0x50, /* '&' */
+    0x00, 0x08, 0x07, 0x03, 0x00, /* ''' */
+    0x00, 0x1C, 0x22, 0x41, 0x00, /* '(' */
+    0x00, 0x41, 0x22, 0x1C, 0x00, /* ')' */
+    0x2A, 0x1C, 0x7F, 0x1C, 0x2A, /* '*' */
+    0x08, 0x08, 0x3E, 0x08, 0x08, /* '+' */
+    0x00, 0x80, 0x70, 0x30, 0x00, /* ',' */
+    0x08, 0x08, 0x08, 0x08, 0x08, /* '-' */
+    0x00, 0x00, 0x60, 0x60, 0x00, /* '.' */
+    0x20, 0x10, 0x08, 0x04, 0x02, /* '/' */
+    0x3E, 0x51, 0x49, 0x45, 0x3E, /* '0' */
+    0x00, 0x42, 0x7F, 0x40, 0x00, /* '1' */
+    0x72, 0x49, 0x49, 0x49, 0x46, /* '2' */
+    0x21, 0x41, 0x49, 0x4D, 0x33, /* '3' */
+    0x18, 0x14, 0x12, 0x7F, 0x10, /* '4' */
+    0x27, 0x45, 0x45, 0x45, 0x39, /* '5' */
+    0x3C, 0x4A, 0x49, 0x49, 0x31, /* '6' */
+    0x41, 0x21, 0x11, 0x09, 0x07, /* '7' */
+    0x36, 0x49, 0x49, 0x49, 0x36, /* '8' */
+    0x46, 0x49, 0x49, 0x29, 0x1E, /* '9' */
+    0x00, 0x00, 0x14, 0x00, 0x00, /* ':' */
+    0x00, 0x40, 0x34, 0x00, 0x00, /* ';' */
+    0x00, 0x08, 0x14, 0x22, 0x41, /* '<' */
+    0x14, 0x14, 0x14, 0x14, 0x14, /* '=' */
+    0x00, 0x41, 0x22, 0x14, 0x08, /* '>' */
+    0x02, 0x01, 0x59, 0x09, 0x06, /* '?' */
+    0x3E, 0x41, 0x5D, 0x59, 0x4E, /* '@' */
+    0x7C, 0x12, 0x11, 0x12, 0x7C, /* 'A' */
+    0x7F, 0x49, 0x49, 0x49, 0x36, /* 'B' */
+    0x3E, 0x41, 0x41, 0x41, 0x22, /* 'C' */
+    0x7F, 0x41, 0x41, 0x41, 0x3E, /* 'D' */
+    0x7F, 0x49, 0x49, 0x49, 0x41, /* 'E' */
+    0x7F, 0x09, 0x09, 0x09, 0x01, /* 'F' */
+    0x3E, 0x41, 0x41, 0x51, 0x73, /* 'G' */
+    0x7F, 0x08, 0x08, 0x08, 0x7F, /* 'H' */
+    0x00, 0x41, 0x7F, 0x41, 0x00, /* 'I' */
+    0x20, 0x40, 0x41, 0x3F, 0x01, /* 'J' */
+    0x7F, 0x08, 0x14, 0x22, 0x41, /* 'K' */
+    0x7F, 0x40, 0x40, 0x40, 0x40, /* 'L' */
+    0x7F, 0x02, 0x1C, 0x02, 0x7F, /* 'M' */
+    0x7F, 0x04, 0x08, 0x10, 0x7F, /* 'N' */
+    0x3E, 0x41, 0x41, 0x41, 0x3E, /* 'O' */
+    0x7F, 0x09, 0x09, 0x09, 0x06, /* 'P' */
+    0x3E, 0x41, 0x51, 0x21, 0x5E, /* 'Q' */
+    0x7F, 0x09, 0x19, 0x29, 0x46, /* 'R' */
+    0x26, 0x49, 0x49, 0x49, 0x32, /* 'S' */
+    0x03, 0x01, 0x7F, 0x01, 0x03, /* 'T' */
+    0x3F, 0x40, 0x40, 0x40, 0x3F, /* 'U' */
+    0x1F, 0x20, 0x40, 0x20, 0x1F, /* 'V' */
+    0x3F, 0x40, 0x38, 0x40, 0x3F, /* 'W' */
+    0x63, 0x14, 0x08, 0x14, 0x63, /* 'X' */
+    0x03, 0x04, 0x78, 0x04, 0x03, /* 'Y' */
+    0x61, 0x59, 0x49, 0x4D, 0x43, /* 'Z' */
+    0x00, 0x7F, 0x41, 0x41, 0x41, /* '[' */
+    0x02, 0x04, 0x08, 0x10, 0x20, /* '\' */
+    0x00, 0x41, 0x41, 0x41, 0x7F, /* ']' */
+    0x04, 0x02, 0x01, 0x02, 0x04, /* '^' */
+    0x40, 0x40, 0x40, 0x40, 0x40, /* '_' */
+    0x00, 0x03, 0x07, 0x08, 0x00, /* '`' */
+    0x20, 0x54, 0x54, 0x78, 0x40, /* 'a' */
+    0x7F, 0x28, 0x44, 0x44, 0x38, /* 'b' */
+    0x38, 0x44, 0x44, 0x44, 0x28, /* 'c' */
+    0x38, 0x44, 0x44, 0x28, 0x7F, /* 'd' */
+    0x38, 0x54, 0x54, 0x54, 0x18, /* 'e' */
+    0x00, 0x08, 0x7E, 0x09, 0x02, /* 'f' */
+    0x18, 0xA4, 0xA4, 0x9C, 0x78, /* 'g' */
+    0x7F, 0x08, 0x04, 0x04, 0x78, /* 'h' */
+    0x00, 0x44, 0x7D, 0x40, 0x00, /* 'i' */
+    0x20, 0x40, 0x40, 0x3D, 0x00, /* 'j' */
+    0x7F, 0x10, 0x28, 0x44, 0x00, /* 'k' */
+    0x00, 0x41, 0x7F, 0x40, 0x00, /* 'l' */
+    0x7C, 0x04, 0x78, 0x04, 0x78, /* 'm' */
+    0x7C, 0x08, 0x04, 0x04, 0x78, /* 'n' */
+    0x38, 0x44, 0x44, 0x44, 0x38, /* 'o' */
+    0xFC, 0x18, 0x24, 0x24, 0x18, /* 'p' */
+    0x18, 0x24, 0x24, 0x18, 0xFC, /* 'q' */
+    0x7C, 0x08, 0x04, 0x04, 0x08, /* 'r' */
+    0x48, 0x54, 0x54, 0x54, 0x24, /* 's' */
+    0x04, 0x04, 0x3F, 0x44, 0x24, /* 't' */
+    0x3C, 0x40, 0x40, 0x20, 0x7C, /* 'u' */
+    0x1C, 0x20, 0x40, 0x20, 0x1C, /* 'v' */
+    0x3C, 0x40, 0x30, 0x40, 0x3C, /* 'w' */
+    0x44, 0x28, 0x10, 0x28, 0x44, /* 'x' */
+    0x4C, 0x90, 0x90, 0x90, 0x7C, /* 'y' */
+    0x44, 0x64, 0x54, 0x4C, 0x44, /* 'z' */
+    0x00, 0x08, 0x36, 0x41, 0x00, /* '{' */
+    0x00, 0x00, 0x77, 0x00, 0x00, /* '|' */
+    0x00, 0x41, 0x36, 0x08, 0x00, /* '}' */
+    0x02, 0x01, 0x02, 0x04, 0x02, /* '~' */
+    0x3C, 0x26, 0x23, 0x26, 0x3C, /* DEL */
+};
+
+#define FONT_FIRST_CHAR (0x20)
+#define FONT_LAST_CHAR  (0x7F)
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+    : _width(w), _height(h), cursor_x(0), cursor_y(0), textcolor(0xFFFF), textbgcolor(0xFFFF),
+      textsize_x(1), textsize_y(1), wrap(true) {}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < h; ++i) {
+        drawPixel(x, y + i, color);
+    }
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    for (int16_t i = 0; i < w; ++i) {
+        drawPixel(x + i, y, color);
+    }
+}
+
+/**
+ * @brief Bresenham line, straight lines go through the fast line functions as in the library.
+ */
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (x0 == x1) {
+        if (y0 > y1) std::swap(y0, y1);
+        drawFastVLine(x0, y0, y1 - y0 + 1, color);
+        return;
+    }
+    if (y0 == y1) {
+        if (x0 > x1) std::swap(x0, x1);
+        drawFastHLine(x0, y0, x1 - x0 + 1, color);
+        return;
+    }
+
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = (y0 < y1) ? 1 : -1;
+
+    for (; x0 <= x1; x0++) {
+        if (steep) {
+            drawPixel(y0, x0, color);
+        } else {
+            drawPixel(x0, y0, color);
+        }
+        err -= dy;
+        if (err < 0) {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t i = x; i < x + w; ++i) {
+        drawFastVLine(i, y, h, color);
+    }
+}
+
+/**
+ * @brief Draws a character of the classic font. With an opaque background the unset pixels and the
+ *        spacing column are painted with bg.
+ */
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x,
+                            uint8_t size_y) {
+    if ((x >= _width) || (y >= _height) || ((x + 6 * size_x - 1) < 0) || ((y + 8 * size_y - 1) < 0)) {
+        return;
+    }
+    if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+        c = '?'; /* Only the ASCII part of the font is kept on the host */
+    }
+
+    for (int8_t i = 0; i < 5; i++) {
+        uint8_t line = pgm_read_byte(&font[(c - FONT_FIRST_CHAR) * 5 + i]);
+        for (int8_t j = 0; j < 8; j++, line >>= 1) {
+            if (line & 1) {
+                if (size_x == 1 && size_y == 1) {
+                    drawPixel(x + i, y + j, color);
+                } else {
+                    fillRect(x + i * size_x, y + j * size_y, size_x, size_y, color);
+                }
+            } else if (bg != color) {
+                if (size_x == 1 && size_y == 1) {
+                    drawPixel(x + i, y + j, bg);
+                } else {
+                    fillRect(x + i * size_x, y + j * size_y, size_x, size_y, bg);
+                }
+            }
+        }
+    }
+    if (bg != color) {
+        if (size_x == 1 && size_y == 1) {
+            drawFastVLine(x + 5, y, 8, bg);
+        } else {
+            fillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
+        }
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursor_x = 0;
+        cursor_y += textsize_y * 8;
+    } else if (c != '\r') {
+        if (wrap && ((cursor_x + textsize_x * 6) > _width)) {
+            cursor_x = 0;
+            cursor_y += textsize_y * 8;
+        }
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+        cursor_x += textsize_x * 6;
+    }
+    return 1;
+}
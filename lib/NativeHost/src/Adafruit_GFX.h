@@ -0,0 +1,43 @@
+#ifndef NATIVE_ADAFRUIT_GFX_H
+#define NATIVE_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Host copy of the Adafruit GFX text and line primitives with the classic 5x7 font, drawing through
+ *        drawPixel() like the library does, so frames match the device pixel for pixel.
+ */
+class Adafruit_GFX : public Print {
+protected:
+    int16_t _width;
+    int16_t _height;
+    int16_t cursor_x;
+    int16_t cursor_y;
+    uint16_t textcolor;
+    uint16_t textbgcolor;
+    uint8_t textsize_x;
+    uint8_t textsize_y;
+    bool wrap;
+
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y);
+
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    void setTextSize(uint8_t s) { textsize_x = textsize_y = (s > 0) ? s : 1; }
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; } /* Same colors: transparent background */
+    void setTextColor(uint16_t c, uint16_t bg) { textcolor = c; textbgcolor = bg; }
+    void setTextWrap(bool w) { wrap = w; }
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+
+#endif // NATIVE_ADAFRUIT_GFX_H
@@ -0,0 +1,82 @@
+#include "Adafruit_SSD1306.h"
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t rst_pin, uint32_t clkDuring,
+                                   uint32_t clkAfter)
+    : Adafruit_GFX(w, h), wire(twi), address(0), buffer(NULL) {
+    (void)rst_pin;
+    (void)clkDuring;
+    (void)clkAfter;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+    free(buffer);
+}
+
+/**
+ * @brief Allocates the framebuffer like the library, the splash screen is not drawn.
+ */
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t i2caddr, bool reset, bool periphBegin) {
+    (void)switchvcc;
+    (void)reset;
+    if (buffer == NULL) {
+        buffer = (uint8_t*)malloc(_width * ((_height + 7) / 8));
+        if (buffer == NULL) {
+            return false;
+        }
+    }
+    address = i2caddr;
+    if (periphBegin) {
+        wire->begin();
+    }
+    clearDisplay();
+    return true;
+}
+
+/**
+ * @brief Sends the whole framebuffer to the panel.
+ */
+void Adafruit_SSD1306::display() {
+    const uint8_t window[] = {SSD1306_PAGEADDR, 0, (uint8_t)((_height + 7) / 8 - 1),
+                              SSD1306_COLUMNADDR, 0, (uint8_t)(_width - 1)};
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x00);
+    wire->write(window, sizeof(window));
+    wire->endTransmission();
+
+    size_t len = _width * ((_height + 7) / 8);
+    for (size_t pos = 0; pos < len; pos += 32) {
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x40);
+        wire->write(&buffer[pos], (len - pos < 32) ? len - pos : 32);
+        wire->endTransmission();
+    }
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    memset(buffer, 0, _width * ((_height + 7) / 8));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height)) {
+        return;
+    }
+    uint8_t* cell = &buffer[x + (y / 8) * _width];
+    switch (color) {
+        case SSD1306_WHITE:
+            *cell |= (1 << (y & 7));
+            break;
+        case SSD1306_BLACK:
+            *cell &= ~(1 << (y & 7));
+            break;
+        case SSD1306_INVERSE:
+            *cell ^= (1 << (y & 7));
+            break;
+    }
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x00);
+    wire->write(c);
+    wire->endTransmission();
+}
@@ -0,0 +1,37 @@
+#ifndef NATIVE_ADAFRUIT_SSD1306_H
+#define NATIVE_ADAFRUIT_SSD1306_H
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_BLACK   (0)
+#define SSD1306_WHITE   (1)
+#define SSD1306_INVERSE (2)
+
+#define SSD1306_SWITCHCAPVCC (0x02)
+#define SSD1306_COLUMNADDR   (0x21)
+#define SSD1306_PAGEADDR     (0x22)
+
+/**
+ * @brief In-memory SSD1306: the page ordered framebuffer of the Adafruit driver, display() sends it
+ *        over the host Wire bus to the emulated panel.
+ */
+class Adafruit_SSD1306 : public Adafruit_GFX {
+private:
+    TwoWire* wire;
+    uint8_t address;
+    uint8_t* buffer;
+
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t rst_pin = -1,
+                     uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+    ~Adafruit_SSD1306();
+    bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0, bool reset = true, bool periphBegin = true);
+    void display();
+    void clearDisplay();
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void ssd1306_command(uint8_t c);
+    uint8_t* getBuffer() { return buffer; }
+};
+
+#endif // NATIVE_ADAFRUIT_SSD1306_H
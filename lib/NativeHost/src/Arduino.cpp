@@ -0,0 +1,434 @@
+#include "NativeHost.h"
+#include <esp_system.h>
+#include <new>
+
+#define NATIVE_PIN_COUNT (40)
+
+static int64_t nowUs = 0;
+static uint8_t digitalLevels[NATIVE_PIN_COUNT];
+static bool digitalLevelsInitialized = false;
+static uint16_t analogLevels[NATIVE_PIN_COUNT];
+static std::vector<uint8_t>* serialSink = NULL;
+static bool serialMuted = false;
+static uint32_t randomState = 0x12345678;
+static size_t heapInUse = 0;
+static size_t heapPeak = 0;
+
+HardwareSerial Serial;
+EspClass ESP;
+
+void nativeWiFiTick(); /* WiFi.cpp, fires the WiFi events that are due */
+
+/* ---------------------------------------------------------------- Heap */
+
+/* Every block carries its size in front, so operator delete can count it out */
+struct alignas(16) HeapHeader {
+    size_t size;
+};
+
+static void* heapAllocate(size_t size) {
+    HeapHeader* header = (HeapHeader*)malloc(sizeof(HeapHeader) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->size = size;
+    heapInUse += size;
+    heapPeak = (heapInUse > heapPeak) ? heapInUse : heapPeak;
+    return header + 1;
+}
+
+static void heapFree(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    HeapHeader* header = (HeapHeader*)ptr - 1;
+    heapInUse -= header->size;
+    free(header);
+}
+
+void* operator new(size_t size) {
+    void* ptr = heapAllocate(size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return heapAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return heapAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    heapFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    heapFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    heapFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    heapFree(ptr);
+}
+
+uint32_t nativeHeapInUse() {
+    return (uint32_t)heapInUse;
+}
+
+uint32_t nativeHeapPeak() {
+    return (uint32_t)heapPeak;
+}
+
+void nativeHeapResetPeak() {
+    heapPeak = heapInUse;
+}
+
+/* ---------------------------------------------------------------- Clock */
+
+void nativeSetMicros(int64_t us) {
+    nowUs = us;
+    nativeWiFiTick();
+}
+
+void nativeAdvanceMillis(uint32_t ms) {
+    nativeSetMicros(nowUs + (int64_t)ms * 1000);
+}
+
+int64_t esp_timer_get_time() {
+    return nowUs;
+}
+
+unsigned long millis() {
+    return (uint32_t)(nowUs / 1000); /* 32 bits, wraps like on the ESP32 */
+}
+
+unsigned long micros() {
+    return (uint32_t)nowUs;
+}
+
+void delay(uint32_t ms) {
+    nativeAdvanceMillis(ms);
+}
+
+void yield() {}
+
+/* ---------------------------------------------------------------- GPIO */
+
+static void initDigitalLevels() {
+    if (!digitalLevelsInitialized) {
+        memset(digitalLevels, HIGH, sizeof(digitalLevels)); /* Pulled up, buttons released */
+        digitalLevelsInitialized = true;
+    }
+}
+
+void nativeSetDigitalInput(uint8_t pin, int level) {
+    initDigitalLevels();
+    if (pin < NATIVE_PIN_COUNT) {
+        digitalLevels[pin] = level ? HIGH : LOW;
+    }
+}
+
+void nativeSetAnalogInput(uint8_t pin, uint16_t value) {
+    if (pin < NATIVE_PIN_COUNT) {
+        analogLevels[pin] = value;
+    }
+}
+
+int nativeGetDigitalOutput(uint8_t pin) {
+    initDigitalLevels();
+    return (pin < NATIVE_PIN_COUNT) ? digitalLevels[pin] : LOW;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+    initDigitalLevels();
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    nativeSetDigitalInput(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return nativeGetDigitalOutput(pin);
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return (pin < NATIVE_PIN_COUNT) ? analogLevels[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+    (void)pin;
+    (void)value;
+}
+
+/* ---------------------------------------------------------------- Misc */
+
+uint32_t esp_random() {
+    /* xorshift32, deterministic so test runs repeat */
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+long random(long howBig) {
+    return (howBig <= 0) ? 0 : (long)(esp_random() % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig) {
+    return (howSmall >= howBig) ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+esp_reset_reason_t esp_reset_reason() {
+    return ESP_RST_POWERON;
+}
+
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t copy = (len < size - 1) ? len : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+    return len;
+}
+
+uint64_t EspClass::getEfuseMac() {
+    return NATIVE_EFUSE_MAC;
+}
+
+const char* EspClass::getChipModel() {
+    return "ESP32-D0WDQ6";
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return NATIVE_HEAP_SIZE - (uint32_t)heapInUse;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return NATIVE_HEAP_SIZE - (uint32_t)heapPeak;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return getFreeHeap();
+}
+
+/* ---------------------------------------------------------------- Serial */
+
+void nativeSerialCapture(std::vector<uint8_t>* sink) {
+    serialSink = sink;
+}
+
+void nativeSerialMute(bool mute) {
+    serialMuted = mute;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (serialSink != NULL) {
+        serialSink->insert(serialSink->end(), buffer, buffer + size);
+    } else if (!serialMuted) {
+        fwrite(buffer, 1, size, stdout);
+    }
+    return size;
+}
+
+/* ---------------------------------------------------------------- Print */
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::printNumber(unsigned long long value, uint8_t base) {
+    char buf[8 * sizeof(value) + 1];
+    char* str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        char digit = (char)(value % base);
+        value /= base;
+        *--str = (digit < 10) ? digit + '0' : digit + 'A' - 10;
+    } while (value);
+    return write(str);
+}
+
+size_t Print::printFloat(double value, uint8_t digits) {
+    /* Same rounding and special values as the Arduino core */
+    if (isnan(value)) return print("nan");
+    if (isinf(value)) return print("inf");
+    if (value > 4294967040.0) return print("ovf");
+    if (value < -4294967040.0) return print("ovf");
+
+    size_t n = 0;
+    if (value < 0.0) {
+        n += print('-');
+        value = -value;
+    }
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i) {
+        rounding /= 10.0;
+    }
+    value += rounding;
+
+    unsigned long intPart = (unsigned long)value;
+    double remainder = value - (double)intPart;
+    n += print(intPart);
+    if (digits > 0) {
+        n += print('.');
+    }
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int toPrint = (unsigned int)remainder;
+        n += print(toPrint);
+        remainder -= toPrint;
+    }
+    return n;
+}
+
+size_t Print::print(int value, int base) {
+    return print((long long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+    return print((long long)value, base);
+}
+
+size_t Print::print(long long value, int base) {
+    if (base == 10 && value < 0) {
+        return print('-') + printNumber((unsigned long long)(-(value + 1)) + 1, 10);
+    }
+    return printNumber((unsigned long long)value, base);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buf, ((size_t)len < sizeof(buf)) ? (size_t)len : sizeof(buf) - 1);
+}
+
+/* ---------------------------------------------------------------- String */
+
+static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+    char buf[8 * sizeof(value) + 1];
+    char* str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    do {
+        char digit = (char)(value % base);
+        value /= base;
+        *--str = (digit < 10) ? digit + '0' : digit + 'a' - 10;
+    } while (value);
+    return std::string(str);
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    if (base == 10 && value < 0) {
+        return "-" + formatUnsigned((unsigned long long)(-(value + 1)) + 1, 10);
+    }
+    return formatUnsigned((unsigned long long)value, base);
+}
+
+static std::string formatFloat(double value, unsigned int decimalPlaces) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    return std::string(buf);
+}
+
+String::String(unsigned char value, unsigned char base) : s(formatUnsigned(value, base)) {}
+String::String(int value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : s(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : s(formatUnsigned(value, base)) {}
+String::String(long long value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : s(formatUnsigned(value, base)) {}
+String::String(float value, unsigned int decimalPlaces) : s(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : s(formatFloat(value, decimalPlaces)) {}
+
+String operator+(const String& a, const String& b) {
+    return String(a.s + b.s);
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = s.find(c, from);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& text, unsigned int from) const {
+    size_t pos = s.find(text.s, from);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t pos = s.rfind(c);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    return (from >= s.size()) ? String() : String(s.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        std::swap(from, to);
+    }
+    if (from >= s.size()) {
+        return String();
+    }
+    return String(s.substr(from, std::min<size_t>(to, s.size()) - from));
+}
+
+bool String::startsWith(const String& prefix) const {
+    return s.compare(0, prefix.s.size(), prefix.s) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+}
+
+void String::remove(unsigned int index) {
+    if (index < s.size()) {
+        s.erase(index);
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < s.size()) {
+        s.erase(index, count);
+    }
+}
+
+void String::trim() {
+    size_t first = s.find_first_not_of(" \t\r\n");
+    size_t last = s.find_last_not_of(" \t\r\n");
+    s = (first == std::string::npos) ? std::string() : s.substr(first, last - first + 1);
+}
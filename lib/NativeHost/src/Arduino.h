@@ -0,0 +1,202 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+/*
+ * Host stand-in for the parts of the Arduino-ESP32 core the firmware uses. Time is virtual and only moves
+ * when a test advances it (or a task delays), GPIOs are a table the tests drive, see NativeHost.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#define ARDUINO 10819
+
+#define HIGH (0x1)
+#define LOW  (0x0)
+
+#define INPUT        (0x01)
+#define OUTPUT       (0x03)
+#define INPUT_PULLUP (0x05)
+
+#define DEC (10)
+#define HEX (16)
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::isnan;
+using std::isinf;
+using std::min;
+using std::max;
+
+size_t strlcpy(char* dst, const char* src, size_t size);
+
+/**
+ * @brief Arduino String over std::string, with the constructors and methods the firmware uses.
+ */
+class String {
+private:
+    std::string s;
+
+public:
+    String() {}
+    String(const char* text) : s(text ? text : "") {}
+    String(const std::string& text) : s(text) {}
+    String(char c) : s(1, c) {}
+    String(unsigned char value, unsigned char base = 10);
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(long long value, unsigned char base = 10);
+    String(unsigned long long value, unsigned char base = 10);
+    String(float value, unsigned int decimalPlaces = 2);
+    String(double value, unsigned int decimalPlaces = 2);
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int)s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { s += other ? other : ""; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    bool concat(const String& other) { s += other.s; return true; }
+
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator==(const char* other) const { return s == (other ? other : ""); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s < other.s; }
+    bool equals(const String& other) const { return s == other.s; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& text, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void trim();
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+
+    friend String operator+(const String& a, const String& b);
+};
+
+String operator+(const String& a, const String& b);
+inline String operator+(const char* a, const String& b) { return String(a) + b; }
+inline String operator+(const String& a, const char* b) { return a + String(b); }
+
+/**
+ * @brief Arduino Print: number and float formatting as done by the core, output through write().
+ */
+class Print {
+private:
+    size_t printNumber(unsigned long long value, uint8_t base);
+    size_t printFloat(double value, uint8_t digits);
+
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    virtual void flush() {}
+
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return printNumber(value, base); }
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC) { return printNumber(value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(double value, int digits = 2) { return printFloat(value, digits); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+/**
+ * @brief Arduino Stream, the reading side of a Print.
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long timeout) { (void)timeout; }
+};
+
+/**
+ * @brief Serial port: output goes to stdout, or to the capture buffer set with nativeSerialCapture().
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    int availableForWrite() { return 128; }
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief Chip information, the values are fixed so the rendered device id is stable.
+ */
+class EspClass {
+public:
+    uint64_t getEfuseMac();
+    const char* getChipModel();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+uint32_t esp_random();
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,25 @@
+#include "NativeHost.h"
+#include "../../DTH11/src/DHTesp.h"
+
+/* The DHT11 is read through the library header, the readings come from nativeSetDht() */
+static float dhtTemperature = NAN;
+static float dhtHumidity = NAN;
+
+void nativeSetDht(float temperature, float humidity) {
+    dhtTemperature = temperature;
+    dhtHumidity = humidity;
+}
+
+void DHTesp::setup(uint8_t dhtPin, DHT_MODEL_t dhtModel) {
+    pin = dhtPin;
+    model = dhtModel;
+    error = ERROR_NONE;
+}
+
+float DHTesp::getTemperature() {
+    return dhtTemperature;
+}
+
+float DHTesp::getHumidity() {
+    return dhtHumidity;
+}
@@ -0,0 +1,72 @@
+#include "NativeHost.h"
+
+/* A semaphore only counts, with one thread a take that would block fails instead */
+struct NativeSemaphore {
+    uint32_t count;
+    uint32_t max;
+};
+
+/**
+ * @brief Advances the virtual clock, nothing else runs meanwhile.
+ * @param ticks Ticks of 1 ms.
+ */
+void vTaskDelay(TickType_t ticks) {
+    nativeAdvanceMillis(ticks);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+/**
+ * @brief Tasks are not started on the host, callers fall back to doing the work synchronously.
+ * @return pdFAIL, with a NULL handle.
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId) {
+    (void)task;
+    (void)name;
+    (void)stackDepth;
+    (void)parameters;
+    (void)priority;
+    (void)coreId;
+    if (createdTask != NULL) {
+        *createdTask = NULL;
+    }
+    return pdFAIL;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+    (void)clearCountOnExit;
+    (void)ticksToWait;
+    return 0;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new NativeSemaphore{1, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new NativeSemaphore{0, 1};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    (void)ticksToWait;
+    if (semaphore == NULL || semaphore->count == 0) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (semaphore == NULL || semaphore->count >= semaphore->max) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
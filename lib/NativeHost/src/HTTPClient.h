@@ -0,0 +1,50 @@
+#ifndef NATIVE_HTTPCLIENT_H
+#define NATIVE_HTTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+/* The firmware speaks HTTP over its own sockets, only the codes and their names come from HTTPClient */
+#define HTTP_CODE_OK                (200)
+#define HTTP_CODE_NOT_MODIFIED      (304)
+#define HTTP_CODE_BAD_REQUEST       (400)
+#define HTTP_CODE_REQUEST_TIMEOUT   (408)
+#define HTTP_CODE_PAYLOAD_TOO_LARGE (413)
+#define HTTP_CODE_TOO_MANY_REQUESTS (429)
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_NO_STREAM           (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER      (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM        (-8)
+#define HTTPC_ERROR_ENCODING            (-9)
+#define HTTPC_ERROR_STREAM_WRITE        (-10)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+class HTTPClient {
+public:
+    /**
+     * @brief Same texts as the Arduino-ESP32 HTTPClient.
+     */
+    static String errorToString(int error) {
+        switch (error) {
+            case HTTPC_ERROR_CONNECTION_REFUSED:  return "connection refused";
+            case HTTPC_ERROR_SEND_HEADER_FAILED:  return "send header failed";
+            case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+            case HTTPC_ERROR_NOT_CONNECTED:       return "not connected";
+            case HTTPC_ERROR_CONNECTION_LOST:     return "connection lost";
+            case HTTPC_ERROR_NO_STREAM:           return "no stream";
+            case HTTPC_ERROR_NO_HTTP_SERVER:      return "no HTTP server";
+            case HTTPC_ERROR_TOO_LESS_RAM:        return "too less ram";
+            case HTTPC_ERROR_ENCODING:            return "Transfer-Encoding not supported";
+            case HTTPC_ERROR_STREAM_WRITE:        return "Stream write error";
+            case HTTPC_ERROR_READ_TIMEOUT:        return "read Timeout";
+            default:                              return String();
+        }
+    }
+};
+
+#endif // NATIVE_HTTPCLIENT_H
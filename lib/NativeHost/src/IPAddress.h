@@ -0,0 +1,24 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief IPv4 address, four octets.
+ */
+class IPAddress {
+private:
+    uint8_t octets[4];
+
+public:
+    IPAddress() : octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    uint8_t operator[](int index) const { return octets[index & 3]; }
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+        return String(text);
+    }
+};
+
+#endif // NATIVE_IPADDRESS_H
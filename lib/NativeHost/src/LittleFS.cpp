@@ -0,0 +1,84 @@
+#include "LittleFS.h"
+#include "NativeHost.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+LittleFSFS LittleFS;
+
+void nativePreferencesErase(); /* Preferences.cpp */
+
+static std::string fsPath(const char* path) {
+    return std::string(nativeFsRoot()) + path;
+}
+
+/**
+ * @brief Directory standing in for the flash partition, created on first use.
+ */
+const char* nativeFsRoot() {
+    static char root[64] = "";
+    if (root[0] == '\0') {
+        strlcpy(root, "/tmp/nativefsXXXXXX", sizeof(root));
+        if (mkdtemp(root) == NULL) {
+            fprintf(stderr, "nativeFsRoot: mkdtemp failed\n");
+            abort();
+        }
+    }
+    return root;
+}
+
+/**
+ * @brief Erases the flash: the files and the Preferences.
+ */
+void nativeFlashErase() {
+    DIR* dir = opendir(nativeFsRoot());
+    if (dir != NULL) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_type == DT_REG) {
+                unlink((std::string(nativeFsRoot()) + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    nativePreferencesErase();
+}
+
+size_t File::size() {
+    if (fp == NULL) {
+        return 0;
+    }
+    long pos = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    long end = ftell(fp);
+    fseek(fp, pos, SEEK_SET);
+    return (size_t)end;
+}
+
+void File::close() {
+    if (fp != NULL) {
+        fclose(fp);
+        fp = NULL;
+    }
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return nativeFsRoot()[0] != '\0';
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+    const char* hostMode = (mode[0] == 'a') ? "ab" : (mode[0] == 'w') ? "wb" : "rb";
+    return File(fopen(fsPath(path).c_str(), hostMode));
+}
+
+bool LittleFSFS::exists(const char* path) {
+    return access(fsPath(path).c_str(), F_OK) == 0;
+}
+
+bool LittleFSFS::remove(const char* path) {
+    return unlink(fsPath(path).c_str()) == 0;
+}
@@ -0,0 +1,38 @@
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Open file of the host file system, same calls as fs::File.
+ */
+class File {
+private:
+    FILE* fp;
+
+public:
+    File() : fp(NULL) {}
+    explicit File(FILE* fp) : fp(fp) {}
+    explicit operator bool() const { return fp != NULL; }
+    size_t write(const uint8_t* buf, size_t len) { return fp ? fwrite(buf, 1, len, fp) : 0; }
+    size_t read(uint8_t* buf, size_t len) { return fp ? fread(buf, 1, len, fp) : 0; }
+    bool seek(uint32_t pos) { return fp && fseek(fp, pos, SEEK_SET) == 0; }
+    size_t size();
+    void close();
+};
+
+/**
+ * @brief LittleFS mounted on a temporary directory of the host, see nativeFsRoot().
+ */
+class LittleFSFS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs");
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path);
+    bool remove(const char* path);
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // NATIVE_LITTLEFS_H
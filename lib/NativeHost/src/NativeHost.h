@@ -0,0 +1,48 @@
+#ifndef NATIVE_HOST_H
+#define NATIVE_HOST_H
+
+/*
+ * Controls of the host stand-ins, used by the native tests to script what the hardware would do:
+ * the clock, the inputs, the DHT11 readings, the WiFi networks in range and the flash contents.
+ */
+
+#include <Arduino.h>
+#include <vector>
+
+#define NATIVE_HEAP_SIZE      (327680) /* Heap reported by ESP.getFreeHeap() before any allocation, as on an ESP32 */
+#define NATIVE_EFUSE_MAC      (0xAABBCCDDEEFFull)
+#define NATIVE_SCAN_TIME_MS   (2000)   /* Virtual time a WiFi scan takes */
+#define NATIVE_CONNECT_TIME_MS (1500)  /* Virtual time a WiFi connection takes when the password matches */
+
+/* Virtual clock, millis(), micros() and esp_timer_get_time() read it, vTaskDelay() and delay() advance it */
+void nativeSetMicros(int64_t us);
+void nativeAdvanceMillis(uint32_t ms);
+
+/* Inputs and outputs */
+void nativeSetDigitalInput(uint8_t pin, int level);
+void nativeSetAnalogInput(uint8_t pin, uint16_t value);
+int nativeGetDigitalOutput(uint8_t pin);
+void nativeSetDht(float temperature, float humidity);
+
+/* Serial output, printed to stdout unless captured or muted */
+void nativeSerialCapture(std::vector<uint8_t>* sink);
+void nativeSerialMute(bool mute);
+
+/* WiFi networks in range, scans list them and begin() connects when the password matches. The events fire
+   as the virtual clock passes NATIVE_SCAN_TIME_MS or NATIVE_CONNECT_TIME_MS */
+void nativeWiFiAddNetwork(const char* ssid, const char* password);
+void nativeWiFiClearNetworks();
+
+/* Flash: Preferences and LittleFS survive telemetryLogInit() calls, as across a reset, until erased */
+void nativeFlashErase();
+const char* nativeFsRoot();
+
+/* Heap use of the code under test, counted by the global operator new and delete */
+uint32_t nativeHeapInUse();
+uint32_t nativeHeapPeak();
+void nativeHeapResetPeak();
+
+/* Panel RAM of the SSD1306 as written over I2C, page ordered like the Adafruit framebuffer */
+const uint8_t* nativeOledPanel();
+
+#endif // NATIVE_HOST_H
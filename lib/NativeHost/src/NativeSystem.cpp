@@ -0,0 +1,52 @@
+#include "NativeSystem.h"
+#include "ProcessMgr.h"
+
+SystemData* nativeCreateSystem(OledDisplay* oledDisplay, WiFiManager* wifiManager, ServerClient* serverClient) {
+    static AnalogSensor analogSensor(SENSOR_LVL_PIN);
+    static Dht11TempHumSens dht11Sensor(SENSOR_HUM_TEMP_PIN);
+    static DigitalSensor pirSensor(SENSOR_PIR_PIN);
+    static DigitalSensor ldrSensor(SENSOR_LDR_PIN);
+    static DigitalSensor pbSelectSensor(SENSOR_PB_SELECT_PIN);
+    static DigitalSensor pbEscSensor(SENSOR_PB_ESC_PIN);
+    static DigitalSensor pbUpSensor(SENSOR_PB_UP_PIN);
+    static DigitalSensor pbDownSensor(SENSOR_PB_DOWN_PIN);
+    static DigitalSensor wellSensor(SENSOR_WELL_PIN);
+    static SensorManager sensorManager(&analogSensor, &dht11Sensor, &pirSensor, &ldrSensor, &pbSelectSensor,
+                                       &pbEscSensor, &pbUpSensor, &pbDownSensor, &wellSensor);
+    static Actuator irrigatorActuator(ACTUATOR_IRRIGATOR_PIN);
+    static Actuator pumpActuator(ACTUATOR_PUMP_PIN);
+    static Actuator lampActuator(ACTUATOR_LAMP_PIN);
+    static ActuatorManager actuatorManager(&irrigatorActuator, &pumpActuator, &lampActuator);
+    static SystemData systemData = {
+        &sensorManager,
+        &actuatorManager,
+        oledDisplay,
+        wifiManager,
+        serverClient,
+        true,
+        SCREEN_LGT_PIR_LAMP_DATA,
+        0,
+        0,
+        DFLT_MAX_LVL_PERCENTAGE,
+        DFLT_MIN_LVL_PERCENTAGE,
+        DFLT_SENSOR_HOT_TEMP_C,
+        DFLT_SENSOR_LOW_HUMIDITY
+    };
+
+    xSystemDataMutex = xSemaphoreCreateMutex();
+    systemData.sensorMgr->getTempHumSensor()->dhtSensorInit();
+    return &systemData;
+}
+
+TelemetrySample nativeSample(int64_t timeUs, float temperature, float humidity, uint16_t level, uint8_t inputs,
+                             uint8_t actuators) {
+    TelemetrySample s;
+    s.timeUs = timeUs;
+    s.seq = 1;
+    s.temperature = temperature;
+    s.humidity = humidity;
+    s.levelPercentage = level;
+    s.inputs = inputs;
+    s.actuators = actuators;
+    return s;
+}
@@ -0,0 +1,35 @@
+#ifndef NATIVE_SYSTEM_H
+#define NATIVE_SYSTEM_H
+
+/*
+ * System data of the firmware built on the host stand-ins, shared by the native tests that run the DAL modules
+ * the way the device tasks do.
+ */
+
+#include "ESP32_shield.h"
+#include "SystemData.h"
+#include "TelemetryMgr.h"
+
+/* Same wiring as main.cpp */
+#define SENSOR_LVL_PIN          (SHIELD_POTENTIOMETER_VP_D36)
+#define SENSOR_HUM_TEMP_PIN     (SHIELD_DAC1_D25)
+#define SENSOR_LDR_PIN          (SHIELD_BUZZER_D15)
+#define SENSOR_PIR_PIN          (SHIELD_DHT11_D13)
+#define SENSOR_WELL_PIN         (SHIELD_OPTOIN1_D26)
+#define SENSOR_PB_SELECT_PIN    (SHIELD_PUSHB1_D33)
+#define SENSOR_PB_ESC_PIN       (SHIELD_PUSHB3_D34)
+#define SENSOR_PB_UP_PIN        (SHIELD_PUSHB2_D35)
+#define SENSOR_PB_DOWN_PIN      (SHIELD_PUSHB4_D32)
+#define ACTUATOR_IRRIGATOR_PIN  (SHIELD_RELAY1_D4)
+#define ACTUATOR_PUMP_PIN       (SHIELD_RELAY2_D2)
+#define ACTUATOR_LAMP_PIN       (SHIELD_LED3_D12)
+
+/* Sensors, actuators and default settings as setup() in main.cpp builds them, with the objects a test needs
+   (NULL for the others). Creates xSystemDataMutex, the tasks are not started */
+SystemData* nativeCreateSystem(OledDisplay* oledDisplay, WiFiManager* wifiManager, ServerClient* serverClient);
+
+/* Telemetry sample with the given readings and sequence number 1 */
+TelemetrySample nativeSample(int64_t timeUs, float temperature, float humidity, uint16_t level, uint8_t inputs,
+                             uint8_t actuators);
+
+#endif // NATIVE_SYSTEM_H
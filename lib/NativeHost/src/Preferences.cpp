@@ -0,0 +1,70 @@
+#include "Preferences.h"
+#include "NativeHost.h"
+#include <map>
+#include <vector>
+
+/* Namespace and key to the stored bytes, strings are kept without the terminator */
+static std::map<std::string, std::vector<uint8_t>> nvs;
+
+static std::string nvsKey(const String& space, const char* key) {
+    return std::string(space.c_str()) + "/" + key;
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    space = name;
+    this->readOnly = readOnly;
+    opened = true;
+    return true;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value = defaultValue;
+    auto it = nvs.find(nvsKey(space, key));
+    if (opened && it != nvs.end() && it->second.size() == sizeof(value)) {
+        memcpy(&value, it->second.data(), sizeof(value));
+    }
+    return value;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putBytes(key, value.c_str(), value.length());
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    auto it = nvs.find(nvsKey(space, key));
+    if (!opened || it == nvs.end()) {
+        return defaultValue;
+    }
+    return String(std::string(it->second.begin(), it->second.end()));
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!opened || readOnly) {
+        return 0;
+    }
+    const uint8_t* bytes = (const uint8_t*)value;
+    nvs[nvsKey(space, key)] = std::vector<uint8_t>(bytes, bytes + len);
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    auto it = nvs.find(nvsKey(space, key));
+    if (!opened || it == nvs.end() || it->second.size() > maxLen) {
+        return 0;
+    }
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+void nativePreferencesErase() {
+    nvs.clear();
+}
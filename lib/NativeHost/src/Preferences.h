@@ -0,0 +1,28 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+
+/**
+ * @brief NVS namespace kept in memory, it survives until nativeFlashErase().
+ */
+class Preferences {
+private:
+    String space;
+    bool readOnly;
+    bool opened;
+
+public:
+    Preferences() : readOnly(false), opened(false) {}
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = NULL);
+    void end();
+
+    size_t putUInt(const char* key, uint32_t value);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t putString(const char* key, const String& value);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+};
+
+#endif // NATIVE_PREFERENCES_H
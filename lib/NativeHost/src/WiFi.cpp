@@ -0,0 +1,287 @@
+#include "WiFi.h"
+#include "NativeHost.h"
+#include "esp_wifi.h"
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <vector>
+
+WiFiClass WiFi;
+
+struct NativeNetwork {
+    String ssid;
+    String password;
+};
+
+static std::vector<NativeNetwork> networks;
+static std::vector<WiFiEventCb> callbacks;
+static std::vector<String> scanResults;
+static bool scanRunning = false;
+static bool scanDone = false;
+static uint32_t scanDoneAt = 0;
+static bool connecting = false;
+static bool connectMatches = false;
+static uint32_t connectDoneAt = 0;
+static String connectedSsid;
+static wl_status_t wifiStatus = WL_DISCONNECTED;
+
+static void fireEvent(WiFiEvent_t event) {
+    for (WiFiEventCb callback : callbacks) {
+        callback(event);
+    }
+}
+
+void nativeWiFiAddNetwork(const char* ssid, const char* password) {
+    networks.push_back({String(ssid), String(password)});
+}
+
+void nativeWiFiClearNetworks() {
+    networks.clear();
+    scanResults.clear();
+    scanRunning = false;
+    scanDone = false;
+    connecting = false;
+    connectedSsid = "";
+    wifiStatus = WL_DISCONNECTED;
+}
+
+/**
+ * @brief Completes the scan and the connection that are due at the current virtual time.
+ */
+void nativeWiFiTick() {
+    uint32_t now = millis();
+    if (scanRunning && (int32_t)(now - scanDoneAt) >= 0) {
+        scanRunning = false;
+        scanDone = true;
+        scanResults.clear();
+        for (const NativeNetwork& network : networks) {
+            scanResults.push_back(network.ssid);
+        }
+        fireEvent(ARDUINO_EVENT_WIFI_SCAN_DONE);
+    }
+    if (connecting && (int32_t)(now - connectDoneAt) >= 0) {
+        connecting = false;
+        if (connectMatches) {
+            wifiStatus = WL_CONNECTED;
+            fireEvent(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+            fireEvent(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        } else {
+            connectedSsid = "";
+            wifiStatus = WL_CONNECT_FAILED;
+            fireEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        }
+    }
+}
+
+esp_err_t esp_wifi_scan_stop() {
+    scanRunning = false;
+    return ESP_OK;
+}
+
+int WiFiClass::onEvent(WiFiEventCb callback) {
+    callbacks.push_back(callback);
+    return (int)callbacks.size();
+}
+
+bool WiFiClass::mode(int mode) {
+    (void)mode;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    connectMatches = false;
+    for (const NativeNetwork& network : networks) {
+        if (network.ssid == ssid && network.password == password) {
+            connectMatches = true;
+        }
+    }
+    connectedSsid = ssid;
+    connecting = true;
+    connectDoneAt = millis() + NATIVE_CONNECT_TIME_MS;
+    wifiStatus = WL_DISCONNECTED;
+    return wifiStatus;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+    (void)wifiOff;
+    bool wasConnected = (wifiStatus == WL_CONNECTED);
+    connecting = false;
+    connectedSsid = "";
+    wifiStatus = WL_DISCONNECTED;
+    if (wasConnected) {
+        fireEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    return wifiStatus;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+    (void)autoReconnect;
+    return true;
+}
+
+IPAddress WiFiClass::localIP() {
+    return (wifiStatus == WL_CONNECTED) ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+int8_t WiFiClass::RSSI() {
+    return (wifiStatus == WL_CONNECTED) ? -55 : 0;
+}
+
+String WiFiClass::SSID() {
+    return (wifiStatus == WL_CONNECTED) ? connectedSsid : String();
+}
+
+int16_t WiFiClass::scanNetworks(bool async) {
+    scanRunning = true;
+    scanDone = false;
+    scanDoneAt = millis() + NATIVE_SCAN_TIME_MS;
+    if (!async) {
+        nativeSetMicros((int64_t)scanDoneAt * 1000);
+        return scanComplete();
+    }
+    return WIFI_SCAN_RUNNING;
+}
+
+int16_t WiFiClass::scanComplete() {
+    if (scanRunning) {
+        return WIFI_SCAN_RUNNING;
+    }
+    return scanDone ? (int16_t)scanResults.size() : WIFI_SCAN_FAILED;
+}
+
+void WiFiClass::scanDelete() {
+    scanResults.clear();
+    scanDone = false;
+}
+
+String WiFiClass::SSID(uint8_t index) {
+    return (index < scanResults.size()) ? scanResults[index] : String();
+}
+
+/**
+ * @brief Resolves and connects with a timeout, the socket is left non-blocking.
+ * @return 1 if connected, 0 otherwise.
+ */
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+
+    struct addrinfo hints = {};
+    struct addrinfo* res = NULL;
+    char service[8];
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &res) != 0 || res == NULL) {
+        return 0;
+    }
+
+    fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(res);
+        return 0;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (rc < 0 && errno == EINPROGRESS) {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t errLen = sizeof(err);
+        if (poll(&pfd, 1, timeoutMs) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 && err == 0) {
+            rc = 0;
+        }
+    }
+    if (rc < 0) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiClient::stop() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+uint8_t WiFiClient::connected() {
+    if (fd < 0) {
+        return 0;
+    }
+    uint8_t probe;
+    ssize_t n = recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+    int flag = noDelay ? 1 : 0;
+    if (fd >= 0) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+}
+
+size_t WiFiClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t len) {
+    size_t sent = 0;
+    while (fd >= 0 && sent < len) {
+        ssize_t n = send(fd, &buf[sent], len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, 1000) != 1) {
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (fd < 0) {
+        return 0;
+    }
+    int pending = 0;
+    ioctl(fd, FIONREAD, &pending);
+    if (pending == 0) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        poll(&pfd, 1, 1);
+        ioctl(fd, FIONREAD, &pending);
+    }
+    return pending;
+}
+
+int WiFiClient::read() {
+    uint8_t data;
+    return (read(&data, 1) == 1) ? data : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t len) {
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t n = recv(fd, buf, len, MSG_DONTWAIT);
+    return (n > 0) ? (int)n : -1;
+}
+
+int WiFiClient::peek() {
+    uint8_t data;
+    if (fd < 0 || recv(fd, &data, 1, MSG_PEEK | MSG_DONTWAIT) != 1) {
+        return -1;
+    }
+    return data;
+}
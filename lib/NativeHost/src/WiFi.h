@@ -0,0 +1,84 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+#include "IPAddress.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+} arduino_event_id_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef void (*WiFiEventCb)(WiFiEvent_t event);
+
+#define WIFI_STA (1)
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+/**
+ * @brief TCP client over a host socket. Reads never block: available() gives the peer a millisecond
+ *        of real time, so polling loops driven by the virtual clock still see a real server answer.
+ */
+class WiFiClient : public Stream {
+private:
+    int fd;
+
+public:
+    WiFiClient() : fd(-1) {}
+    ~WiFiClient() { stop(); }
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+
+    int connect(const char* host, uint16_t port, int32_t timeoutMs = 3000);
+    void stop();
+    uint8_t connected();
+    void setNoDelay(bool noDelay);
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buf, size_t len) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t len);
+    int peek() override;
+};
+
+/**
+ * @brief Station mode WiFi over the networks registered with nativeWiFiAddNetwork(). Scans and connections
+ *        complete as the virtual clock moves, firing the events like the WiFi event task does.
+ */
+class WiFiClass {
+public:
+    int onEvent(WiFiEventCb callback);
+    bool mode(int mode);
+    wl_status_t begin(const char* ssid, const char* password);
+    bool disconnect(bool wifiOff = false);
+    wl_status_t status();
+    bool setAutoReconnect(bool autoReconnect);
+    IPAddress localIP();
+    int8_t RSSI();
+    String SSID();
+
+    int16_t scanNetworks(bool async = false);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t index);
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
@@ -0,0 +1,85 @@
+#include "Wire.h"
+#include "NativeHost.h"
+
+#define PANEL_WIDTH (128)
+#define PANEL_PAGES (8)
+
+TwoWire Wire;
+
+static uint8_t panel[PANEL_WIDTH * PANEL_PAGES];
+static uint8_t columnStart = 0, columnEnd = PANEL_WIDTH - 1, column = 0;
+static uint8_t pageStart = 0, pageEnd = PANEL_PAGES - 1, page = 0;
+
+/**
+ * @brief Applies a command stream, only the addressing commands matter for the panel RAM.
+ * @param cmds Command bytes.
+ * @param len Number of bytes.
+ */
+static void panelCommands(const uint8_t* cmds, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (cmds[i] == 0x21 && i + 2 < len) {        /* SSD1306_COLUMNADDR */
+            columnStart = column = cmds[i + 1] % PANEL_WIDTH;
+            columnEnd = cmds[i + 2] % PANEL_WIDTH;
+            i += 2;
+        } else if (cmds[i] == 0x22 && i + 2 < len) { /* SSD1306_PAGEADDR */
+            pageStart = page = cmds[i + 1] % PANEL_PAGES;
+            pageEnd = cmds[i + 2] % PANEL_PAGES;
+            i += 2;
+        }
+    }
+}
+
+/**
+ * @brief Writes data bytes at the RAM pointer, which wraps inside the column and page window.
+ * @param data Framebuffer bytes.
+ * @param len Number of bytes.
+ */
+static void panelData(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        panel[page * PANEL_WIDTH + column] = data[i];
+        if (column == columnEnd) {
+            column = columnStart;
+            page = (page == pageEnd) ? pageStart : page + 1;
+        } else {
+            column++;
+        }
+    }
+}
+
+const uint8_t* nativeOledPanel() {
+    return panel;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    (void)sda;
+    (void)scl;
+    (void)frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    (void)address;
+    txLen = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len) {
+    size_t n = (len < sizeof(txBuffer) - txLen) ? len : sizeof(txBuffer) - txLen;
+    memcpy(&txBuffer[txLen], data, n);
+    txLen += n;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    if (txLen > 0 && txBuffer[0] == 0x00) {
+        panelCommands(&txBuffer[1], txLen - 1);
+    } else if (txLen > 0 && txBuffer[0] == 0x40) {
+        panelData(&txBuffer[1], txLen - 1);
+    }
+    txLen = 0;
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief I2C bus with an SSD1306 attached: the command and data streams are decoded into the panel RAM
+ *        (horizontal addressing, page and column windows), see nativeOledPanel().
+ */
+class TwoWire : public Stream {
+private:
+    uint8_t txBuffer[256];
+    size_t txLen;
+
+public:
+    TwoWire() : txLen(0) {}
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void setClock(uint32_t frequency) { (void)frequency; }
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif // NATIVE_WIRE_H
@@ -0,0 +1,8 @@
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
+
+#endif // NATIVE_ESP_TIMER_H
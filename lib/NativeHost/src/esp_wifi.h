@@ -0,0 +1,12 @@
+#ifndef NATIVE_ESP_WIFI_H
+#define NATIVE_ESP_WIFI_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK (0)
+
+esp_err_t esp_wifi_scan_stop();
+
+#endif // NATIVE_ESP_WIFI_H
@@ -0,0 +1,27 @@
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+/*
+ * Host stand-in for FreeRTOS. The native tests run the firmware modules on one thread: tasks are never started,
+ * semaphores only count, and delays advance the virtual clock.
+ */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef struct NativeTask* TaskHandle_t;
+typedef struct NativeSemaphore* SemaphoreHandle_t;
+
+#define pdFALSE (0)
+#define pdTRUE  (1)
+#define pdFAIL  (0)
+#define pdPASS  (1)
+
+#define portMAX_DELAY      (0xFFFFFFFFu)
+#define portTICK_PERIOD_MS (1)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+
+#endif // NATIVE_FREERTOS_H
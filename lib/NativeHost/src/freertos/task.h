@@ -0,0 +1,13 @@
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+void xTaskNotifyGive(TaskHandle_t task);
+
+#endif // NATIVE_FREERTOS_TASK_H
@@ -0,0 +1,6 @@
+#ifndef NATIVE_LWIP_NETDB_H
+#define NATIVE_LWIP_NETDB_H
+
+#include <netdb.h>
+
+#endif // NATIVE_LWIP_NETDB_H
@@ -0,0 +1,14 @@
+#ifndef NATIVE_LWIP_SOCKETS_H
+#define NATIVE_LWIP_SOCKETS_H
+
+/* lwIP provides the BSD socket API under the usual names, the host sockets stand in for it */
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#endif // NATIVE_LWIP_SOCKETS_H
@@ -0,0 +1,173 @@
+#include "CborEncoder.h"
+#include <string.h>
+
+/**
+ * @brief Appends raw bytes, flags the overflow instead of writing past the buffer.
+ * @param enc The encoder.
+ * @param data Bytes to append.
+ * @param len Number of bytes.
+ */
+static void cborAppend(CborEncoder* enc, const uint8_t* data, size_t len) {
+    if (enc->overflow || enc->len + len > enc->capacity) {
+        enc->overflow = true;
+        return;
+    }
+    memcpy(&enc->buf[enc->len], data, len);
+    enc->len += len;
+}
+
+/**
+ * @brief Writes an initial byte with its argument using the shortest encoding.
+ * @param enc The encoder.
+ * @param major CBOR_MAJOR_* type.
+ * @param value The argument (value, length or item count).
+ */
+static void cborWriteHead(CborEncoder* enc, uint8_t major, uint32_t value) {
+    uint8_t head[5];
+    size_t len;
+
+    if (value < 24) {
+        head[0] = major | (uint8_t)value;
+        len = 1;
+    } else if (value <= 0xFF) {
+        head[0] = major | 24;
+        head[1] = (uint8_t)value;
+        len = 2;
+    } else if (value <= 0xFFFF) {
+        head[0] = major | 25;
+        head[1] = (uint8_t)(value >> 8);
+        head[2] = (uint8_t)value;
+        len = 3;
+    } else {
+        head[0] = major | 26;
+        head[1] = (uint8_t)(value >> 24);
+        head[2] = (uint8_t)(value >> 16);
+        head[3] = (uint8_t)(value >> 8);
+        head[4] = (uint8_t)value;
+        len = 5;
+    }
+    cborAppend(enc, head, len);
+}
+
+/**
+ * @brief Writes an initial byte with its argument always on 4 or 8 bytes, so the item has the same size whatever its value.
+ * @param enc The encoder.
+ * @param major CBOR_MAJOR_UINT or CBOR_MAJOR_NINT.
+ * @param value The argument.
+ * @param bytes Size of the argument, 4 or 8.
+ */
+static void cborWriteHeadFixed(CborEncoder* enc, uint8_t major, uint64_t value, uint8_t bytes) {
+    uint8_t head[9];
+    head[0] = major | ((bytes == 8) ? 27 : 26);
+    for (uint8_t i = 0; i < bytes; ++i) {
+        head[1 + i] = (uint8_t)(value >> (8 * (bytes - 1 - i)));
+    }
+    cborAppend(enc, head, 1 + bytes);
+}
+
+/**
+ * @brief Starts encoding into a caller provided buffer.
+ * @param enc The encoder.
+ * @param buf Output buffer.
+ * @param capacity Size of the output buffer.
+ */
+void cborBegin(CborEncoder* enc, uint8_t* buf, size_t capacity) {
+    enc->buf = buf;
+    enc->capacity = capacity;
+    enc->len = 0;
+    enc->overflow = false;
+}
+
+/**
+ * @brief Writes an unsigned integer.
+ * @param enc The encoder.
+ * @param value The value.
+ */
+void cborWriteUint(CborEncoder* enc, uint32_t value) {
+    cborWriteHead(enc, CBOR_MAJOR_UINT, value);
+}
+
+/**
+ * @brief Writes an unsigned integer, always 5 bytes so samples have a fixed layout.
+ * @param enc The encoder.
+ * @param value The value.
+ */
+void cborWriteUintFixed(CborEncoder* enc, uint32_t value) {
+    cborWriteHeadFixed(enc, CBOR_MAJOR_UINT, value, 4);
+}
+
+/**
+ * @brief Writes a 64 bit unsigned integer, always 9 bytes.
+ * @param enc The encoder.
+ * @param value The value.
+ */
+void cborWriteUint64Fixed(CborEncoder* enc, uint64_t value) {
+    cborWriteHeadFixed(enc, CBOR_MAJOR_UINT, value, 8);
+}
+
+/**
+ * @brief Writes a 64 bit signed integer, always 9 bytes, negative values as CBOR negative integers.
+ * @param enc The encoder.
+ * @param value The value.
+ */
+void cborWriteInt64Fixed(CborEncoder* enc, int64_t value) {
+    if (value < 0) {
+        cborWriteHeadFixed(enc, CBOR_MAJOR_NINT, (uint64_t)(-1 - value), 8);
+    } else {
+        cborWriteHeadFixed(enc, CBOR_MAJOR_UINT, (uint64_t)value, 8);
+    }
+}
+
+/**
+ * @brief Writes a single precision float, always 5 bytes so samples have a fixed layout.
+ * @param enc The encoder.
+ * @param value The value, NaN is allowed.
+ */
+void cborWriteFloat(CborEncoder* enc, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint8_t out[5] = {
+        CBOR_FLOAT32, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits
+    };
+    cborAppend(enc, out, sizeof(out));
+}
+
+/**
+ * @brief Writes a byte string.
+ * @param enc The encoder.
+ * @param data The bytes.
+ * @param len Number of bytes.
+ */
+void cborWriteBytes(CborEncoder* enc, const uint8_t* data, size_t len) {
+    cborWriteHead(enc, CBOR_MAJOR_BYTES, (uint32_t)len);
+    cborAppend(enc, data, len);
+}
+
+/**
+ * @brief Writes a UTF-8 text string.
+ * @param enc The encoder.
+ * @param text Null terminated string.
+ */
+void cborWriteText(CborEncoder* enc, const char* text) {
+    size_t len = strlen(text);
+    cborWriteHead(enc, CBOR_MAJOR_TEXT, (uint32_t)len);
+    cborAppend(enc, (const uint8_t*)text, len);
+}
+
+/**
+ * @brief Starts an array, the items follow.
+ * @param enc The encoder.
+ * @param items Number of items.
+ */
+void cborWriteArray(CborEncoder* enc, uint32_t items) {
+    cborWriteHead(enc, CBOR_MAJOR_ARRAY, items);
+}
+
+/**
+ * @brief Starts a map, the key/value pairs follow.
+ * @param enc The encoder.
+ * @param pairs Number of key/value pairs.
+ */
+void cborWriteMap(CborEncoder* enc, uint32_t pairs) {
+    cborWriteHead(enc, CBOR_MAJOR_MAP, pairs);
+}
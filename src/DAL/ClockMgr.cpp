@@ -0,0 +1,115 @@
+#include "ClockMgr.h"
+#include "LogMgr.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <math.h>
+
+/* Wall time in us = deviceUs + offsetUs + driftPpm * (deviceUs - refUs) / 1e6 */
+static bool synced = false;
+static int64_t offsetUs = 0;        /* Wall time minus device time at refUs */
+static int64_t refUs = 0;           /* Device time of the last adjustment */
+static double driftPpm = 0.0;
+static int64_t anchorUs = 0;        /* Start of the current drift measurement span */
+static int64_t anchorOffsetUs = 0;  /* Offset at anchorUs */
+
+/**
+ * @brief Reads the device clock: the high resolution timer, monotonic and 64 bit so it never wraps.
+ * @return Microseconds since boot.
+ */
+int64_t clockNowUs() {
+    return esp_timer_get_time();
+}
+
+/**
+ * @brief Offset predicted by the current estimate at a device time.
+ * @param deviceUs Device time in us.
+ * @return Wall time minus device time, in us.
+ */
+static int64_t predictedOffsetUs(int64_t deviceUs) {
+    return offsetUs + (int64_t)(driftPpm * (double)(deviceUs - refUs) / 1e6);
+}
+
+/**
+ * @brief Sets the estimate from one exchange, dropping the drift measurement in progress.
+ */
+static void clockReset(int64_t measuredUs, int64_t receivedUs) {
+    offsetUs = measuredUs;
+    refUs = receivedUs;
+    anchorUs = receivedUs;
+    anchorOffsetUs = measuredUs;
+    synced = true;
+}
+
+/**
+ * @brief Adjusts the offset and drift estimate with the server time received in a response.
+ *        The server stamps the time just before answering, so the measured offset is late by the
+ *        time the response took to arrive, a fraction of the round trip. Small errors are corrected
+ *        gradually so the noise of single exchanges averages out, the drift is measured over spans of
+ *        at least CLOCK_DRIFT_SPAN_US. Only used by the server task.
+ * @param serverTimeMs Server time in ms since epoch.
+ * @param receivedUs Device time when the response started arriving.
+ * @param rttUs Time from the start of the request to the response.
+ */
+void clockUpdate(uint64_t serverTimeMs, int64_t receivedUs, int64_t rttUs) {
+    int64_t measuredUs = (int64_t)serverTimeMs * 1000 - receivedUs;
+
+    if (!synced) {
+        clockReset(measuredUs, receivedUs);
+        LogSerialn("Clock set from server time, round trip " + String((uint32_t)(rttUs / 1000)) + " ms", true);
+        return;
+    }
+    if (rttUs > CLOCK_SYNC_MAX_RTT_US) {
+        return;
+    }
+
+    int64_t predictedUs = predictedOffsetUs(receivedUs);
+    int64_t errorUs = measuredUs - predictedUs;
+    if (llabs(errorUs) > CLOCK_SYNC_STEP_US) {
+        LogSerialn("Clock stepped by " + String((int32_t)(errorUs / 1000)) + " ms", true);
+        clockReset(measuredUs, receivedUs);
+        return;
+    }
+
+    offsetUs = predictedUs + (int64_t)(CLOCK_SYNC_GAIN * (double)errorUs);
+    refUs = receivedUs;
+
+    int64_t spanUs = receivedUs - anchorUs;
+    if (spanUs >= CLOCK_DRIFT_SPAN_US) {
+        double measuredPpm = (double)(offsetUs - anchorOffsetUs) * 1e6 / (double)spanUs;
+        driftPpm += CLOCK_DRIFT_GAIN * (measuredPpm - driftPpm);
+        driftPpm = fmin(fmax(driftPpm, -CLOCK_DRIFT_MAX_PPM), CLOCK_DRIFT_MAX_PPM);
+        anchorUs = receivedUs;
+        anchorOffsetUs = offsetUs;
+        LogSerialn("Clock drift " + String(driftPpm, 1) + " ppm", false);
+    }
+}
+
+/**
+ * @brief Checks if the device clock has been related to wall time.
+ * @return True after the first server exchange.
+ */
+bool clockSynced() {
+    return synced;
+}
+
+/**
+ * @brief Converts a device time to wall time with the current estimate.
+ * @param deviceUs Device time in us, see clockNowUs().
+ * @return Milliseconds since epoch, 0 if the clock was never set.
+ */
+uint64_t clockWallMs(int64_t deviceUs) {
+    if (!synced) {
+        return 0;
+    }
+    return (uint64_t)((deviceUs + predictedOffsetUs(deviceUs)) / 1000);
+}
+
+/**
+ * @brief Takes the current device time along with its wall time estimate.
+ * @param estimate[OUT] The estimate.
+ */
+void clockEstimate(ClockEstimate* estimate) {
+    estimate->nowUs = clockNowUs();
+    estimate->wallMs = clockWallMs(estimate->nowUs);
+    estimate->driftPpm = (float)driftPpm;
+}
@@ -0,0 +1,33 @@
+#include "DeviceId.h"
+#include <Arduino.h>
+
+static uint8_t chipIdBytes[DEVICE_ID_SIZE];
+static char chipIdStr[DEVICE_ID_STR_SIZE];
+
+/**
+ * @brief Reads and formats the chip id once. Call at boot before any other module uses it.
+ */
+void deviceIdInit() {
+    uint64_t chipId = ESP.getEfuseMac();
+    for (uint8_t i = 0; i < DEVICE_ID_SIZE; ++i) {
+        chipIdBytes[i] = (uint8_t)(chipId >> (8 * (DEVICE_ID_SIZE - 1 - i)));
+    }
+    snprintf(chipIdStr, sizeof(chipIdStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+        chipIdBytes[0], chipIdBytes[1], chipIdBytes[2], chipIdBytes[3], chipIdBytes[4], chipIdBytes[5]);
+}
+
+/**
+ * @brief Returns the chip id bytes, most significant first.
+ * @return Pointer to DEVICE_ID_SIZE bytes.
+ */
+const uint8_t* deviceIdBytes() {
+    return chipIdBytes;
+}
+
+/**
+ * @brief Returns the chip id formatted as "AA:BB:CC:DD:EE:FF".
+ * @return The formatted chip id.
+ */
+const char* deviceIdStr() {
+    return chipIdStr;
+}
@@ -1,4 +1,7 @@
 #include "DisplayMgr.h"
+#include "FontMetrics.h"
+#include "IconAtlas.h"
+#include "DeviceId.h"
 #include <Arduino.h>
 
 enum wifiSettings_Type {
@@ -11,24 +14,113 @@ enum wifiSettings_Type {
 
 #define HELD_BUTTON_TIME  (3000) // Time in ms to consider a button as held
 #define MIN_PASSWORD_LENGTH (4) // Minimum password length
+#define WIFI_FEEDBACK_TIME_MS (1000) // Time in ms a connect/disconnect result stays on screen
+
+#define FOOTER_POS_Y (55) // Baseline row of the footer labels
+
+/* Column centers of the three-column data screens */
+#define LAMP_SCR_AMBIENT_COL_X    (21)
+#define LAMP_SCR_MOTION_COL_X     (69)
+#define LAMP_SCR_LAMP_COL_X       (112)
+#define CISTERN_SCR_WELL_COL_X    (19)
+#define CISTERN_SCR_LEVEL_COL_X   (64)
+#define CISTERN_SCR_PUMP_COL_X    (106)
+#define IRR_SCR_TEMP_COL_X        (17)
+#define IRR_SCR_HUM_COL_X         (61)
+#define IRR_SCR_IRRIGATOR_COL_X   (108)
+
+/* Footer labels with their positions resolved at compile time */
+struct FooterLayout {
+    const char* left;
+    const char* middle;
+    const char* right;
+    int16_t middleX;
+    int16_t rightX;
+};
+
+/* Builds a footer layout: left aligned, centered and right aligned labels */
+constexpr FooterLayout footerLayout(const char* left, const char* middle, const char* right) {
+    return FooterLayout{left, middle, right, fontCenteredX(middle, SCREEN_WIDTH / 2), fontRightAlignedX(right, SCREEN_WIDTH)};
+}
 
-static const unsigned char PROGMEM Sun_Icon[] = {0x01,0x00,0x21,0x08,0x10,0x10,0x03,0x80,0x8c,0x62,0x48,0x24,0x10,0x10,0x10,0x10,0x10,0x10,0x48,0x24,0x8c,0x62,0x03,0x80,0x10,0x10,0x21,0x08,0x01,0x00,0x00,0x00};
-static const unsigned char PROGMEM Moon_Icon[] = {0x04,0x00,0x1c,0x0e,0x38,0x02,0x78,0x04,0x71,0xee,0xf0,0x40,0xf0,0x80,0xf1,0xe0,0xf8,0x00,0xf8,0x06,0x7e,0x1c,0x7f,0xfc,0x3f,0xf8,0x1f,0xf0,0x07,0xc0,0x00,0x00};
-static const unsigned char PROGMEM Presence_Icon[] = {0x07,0x00,0x08,0x80,0x10,0x40,0x10,0x40,0x10,0x40,0x08,0x80,0x07,0x00,0x00,0x00,0x0f,0x80,0x30,0x60,0x40,0x10,0x40,0x10,0x80,0x08,0x80,0x08,0x80,0x08,0xff,0xf8};
-static const unsigned char PROGMEM Lamp_On_Icon[] = {0x02,0x00,0x07,0x00,0x05,0x00,0x08,0x80,0x08,0x80,0x08,0x80,0x30,0x60,0x40,0x10,0x80,0x08,0x7f,0xf0,0x08,0x80,0xc7,0x18,0x00,0x00,0x10,0x40,0x22,0x20,0x02,0x00};
-static const unsigned char PROGMEM Lamp_Off_Icon[] = {0x02,0x00,0x07,0x00,0x05,0x00,0x08,0x80,0x08,0x80,0x08,0x80,0x30,0x60,0x40,0x10,0x80,0x08,0x7f,0xf0,0x08,0x80,0x07,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+static constexpr FooterLayout FOOTER_NEXT = footerLayout("Next", " ", "");
+static constexpr FooterLayout FOOTER_NEXT_SETTINGS = footerLayout("Next", " ", "Settings");
+static constexpr FooterLayout FOOTER_PARAM_SAVE = footerLayout("Param", "^ v", "save");
+static constexpr FooterLayout FOOTER_SELECT_ESC = footerLayout("Select", "^ v", "Esc");
+static constexpr FooterLayout FOOTER_NEXT_ESC = footerLayout("Next", "^ v", "Esc");
+static constexpr FooterLayout FOOTER_NEXT_ESC_SET = footerLayout("Next", "^ v", "Esc|Set");
+
+/* View models: the inputs each screen depends on. A screen is only re-rendered when its model changes */
+struct LampScreenModel {
+    uint8_t lightState;
+    uint8_t presenceDetected;
+    uint8_t lampState;
+};
 
-static const unsigned char PROGMEM Lvl_Icon[] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x00,0x00,0x70,0x00,0x30,0x24,0x0c,0x30,0x04,0x0c,0x30,0x10,0x0c,0x33,0xe0,0x0c,0x37,0xf8,0x2c,0x37,0xff,0xec,0x37,0xff,0xec,0x37,0xf3,0xec,0x37,0xff,0xec,0x37,0xff,0xec,0x33,0xff,0xcc,0x18,0x00,0x18,0x1f,0xff,0xf8,0x07,0xff,0xe0,0x00,0x00,0x00,0x00,0x00,0x00};
-static const unsigned char PROGMEM Water_well_icon[] = {0x1f,0xff,0xf8,0x20,0x00,0x04,0x20,0x00,0x04,0x40,0x00,0x02,0x40,0x00,0x02,0xc0,0x00,0x03,0x7f,0xff,0xfe,0x08,0x08,0x10,0x08,0x08,0x10,0x08,0x08,0x10,0x09,0xff,0x90,0x08,0x81,0x10,0x08,0x81,0x10,0x08,0x81,0x10,0x08,0x81,0x10,0x08,0x42,0x10,0x08,0x42,0x10,0x08,0x7e,0x10,0x08,0x00,0x10,0x7f,0xff,0xfc,0x41,0x08,0x84,0x41,0x08,0x84,0x41,0x08,0x84,0x41,0x08,0x84};
-static const unsigned char PROGMEM Pump_Icon[] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0x00,0x00,0x1f,0xfe,0x00,0x00,0x40,0x86,0x00,0x00,0x80,0x46,0x00,0x01,0x00,0x26,0x00,0x02,0x00,0x1e,0x00,0x02,0x12,0x16,0x00,0x02,0x22,0x10,0x00,0x02,0x20,0x10,0x00,0x1a,0x12,0x10,0x00,0x1e,0x08,0x00,0x00,0x19,0x00,0x20,0x00,0x18,0x80,0x40,0x00,0x18,0xc0,0x80,0x00,0x1f,0xfe,0x00,0x00,0x18,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+struct CisternScreenModel {
+    uint16_t levelPercentage;
+    uint8_t wellState;
+    uint8_t pumpState;
+};
+
+struct IrrigatorScreenModel {
+    int32_t temperature; /* Hundredths, matches the 2 decimals printed */
+    int32_t humidity;    /* Hundredths, matches the 2 decimals printed */
+    uint8_t irrigatorState;
+};
+
+struct NetworkScreenModel {
+    uint8_t connected;
+    uint8_t serverHealth; /* BreakerState of the backend connection */
+    char ssid[33];
+};
+
+struct DeviceInfoScreenModel {
+    uint8_t unused; /* Static content, only rendered when the screen is entered */
+};
+
+struct SettingsScreenModel {
+    uint8_t settingMenu;
+    uint8_t value;
+};
 
-static const unsigned char PROGMEM Temperature_Icon[] = {0x1c,0x00,0x22,0x02,0x2b,0x05,0x2a,0x02,0x2b,0x38,0x2a,0x60,0x2b,0x40,0x2a,0x40,0x2a,0x60,0x49,0x38,0x9c,0x80,0xae,0x80,0xbe,0x80,0x9c,0x80,0x41,0x00,0x3e,0x00};
-static const unsigned char PROGMEM Humidity_Icon[] = {0x04,0x00,0x04,0x00,0x0c,0x00,0x0e,0x00,0x1e,0x00,0x1f,0x00,0x3f,0x80,0x3f,0x80,0x7e,0xc0,0x7f,0x40,0xff,0x60,0xff,0xe0,0x7f,0xc0,0x7f,0xc0,0x3f,0x80,0x0f,0x00};
-static const unsigned char PROGMEM Irrigator_Off_Icon[] = {0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x00,0x00,0x08,0xa0,0x00,0x11,0x10,0x00,0x12,0x08,0x00,0x14,0x04,0x00,0x08,0x02,0x00,0x20,0x01,0x00,0x40,0x02,0x08,0x20,0x04,0x28,0x10,0x08,0x08,0x08,0x00,0x08,0x04,0x1f,0xe8,0x02,0x20,0x18,0x01,0x40,0x00,0x00,0x80,0x00,0x00,0x00,0x00};
-static const unsigned char PROGMEM Irrigator_On_Icon[] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x08,0xa0,0x00,0x00,0x11,0x10,0x00,0x00,0x12,0x08,0x00,0x00,0x14,0x04,0x00,0x00,0x08,0x02,0x00,0x00,0x20,0x01,0x00,0x00,0x40,0x02,0x08,0x00,0x20,0x04,0x28,0x00,0x10,0x08,0x08,0x60,0x08,0x00,0x08,0x00,0x04,0x1f,0xe8,0x90,0x02,0x20,0x18,0x50,0x01,0x40,0x01,0x50,0x00,0x80,0x01,0x50,0x00,0x00,0x01,0x50,0x00,0x00,0x01,0x50,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+static bool forceRedraw = true; /* Set when the selected screen changes */
+static const char* frameName = "lamp"; /* Name of the last rendered frame, see displayFrameName() */
+
+/* Forces the next screen function call to render, regardless of its view model.
+ * Call when the selected screen changes.
+ */
+void displayInvalidate() {
+    forceRedraw = true;
+}
+
+/* Compares a screen view model with the last rendered one and prepares a new frame if it changed.
+ * @param oledDisplay Pointer to the OledDisplay object.
+ * @param lastModel[IN/OUT] The model of the last rendered frame, updated when a new frame is started.
+ * @param model The current model.
+ * @param size Size of the model struct.
+ * @return True if the screen has to be rendered, false if the last frame is still valid.
+ */
+static bool viewModelChanged(OledDisplay* oledDisplay, void* lastModel, const void* model, size_t size) {
+    if (!forceRedraw && memcmp(lastModel, model, size) == 0) {
+        return false;
+    }
+
+    memcpy(lastModel, model, size);
+    forceRedraw = false;
+    oledDisplay->clearAllDisplay();
+    oledDisplay->setTextProperties(1, SSD1306_WHITE);
+    return true;
+}
+
+/* Converts a sensor reading to hundredths for the view models.
+ * @param value The sensor reading.
+ * @return The reading in hundredths, 0 if it is not a number.
+ */
+static int32_t toHundredths(double value) {
+    return isnan(value) ? 0 : (int32_t)lround(value * 100.0);
+}
 
-static const unsigned char PROGMEM WiFi_Connected_Icon[] = {0x01,0xf0,0x00,0x07,0xfc,0x00,0x1e,0x0f,0x00,0x39,0xf3,0x80,0x77,0xfd,0xc0,0xef,0x1e,0xe0,0x5c,0xe7,0x40,0x3b,0xfb,0x80,0x17,0x1d,0x00,0x0e,0xee,0x00,0x05,0xf4,0x00,0x03,0xb8,0x00,0x01,0x50,0x00,0x00,0xe0,0x00,0x00,0x40,0x00,0x00,0x00,0x00};
-static const unsigned char PROGMEM WiFi_Not_Connected_Icon[] = {0x21,0xf0,0x00,0x16,0x0c,0x00,0x08,0x03,0x00,0x25,0xf0,0x80,0x42,0x0c,0x40,0x89,0x02,0x20,0x10,0xa1,0x00,0x23,0x58,0x80,0x04,0x24,0x00,0x08,0x52,0x00,0x01,0xa8,0x00,0x02,0x04,0x00,0x00,0x42,0x00,0x00,0xa1,0x00,0x00,0x40,0x80,0x00,0x00,0x00};
 /*
  * Displays header with the current screen name.
  * @param oledDisplay Pointer to the OledDisplay object.
@@ -41,127 +133,191 @@ void displayHeader(OledDisplay* oledDisplay, const char* header) {
 
 /* Displays footer with labels for next screen and settings.
  * @param oledDisplay Pointer to the OledDisplay object.
- * @param ltbottom Label for the left bottom corner.
- * @param midbottom Label for the middle bottom corner.
- * @param rtbottom Label for the right bottom corner.
+ * @param footer Footer labels and their precomputed positions.
  */
-void displayFooter(OledDisplay* oledDisplay, const char* ltbottom, const char* midbottom, const char* rtbottom) {
-    const uint16_t displayWidth = SCREEN_WIDTH;
-    const uint16_t y = 55;
+void displayFooter(OledDisplay* oledDisplay, const FooterLayout& footer) {
+    oledDisplay->DrawLine(0, FOOTER_POS_Y - 2, SCREEN_WIDTH, 0, SSD1306_WHITE);
 
-    uint16_t ltWidth = oledDisplay->getStringWidth(ltbottom);
-    uint16_t midWidth = oledDisplay->getStringWidth(midbottom);
-    uint16_t rtWidth = oledDisplay->getStringWidth(rtbottom);
-
-    uint16_t ltX = 0;
-    uint16_t midX = (displayWidth - midWidth) / 2;
-    uint16_t rtX = displayWidth - rtWidth;
-
-    oledDisplay->DrawLine(0, y - 2, displayWidth, 0, SSD1306_WHITE);
-
-    oledDisplay->SetdisplayData(ltX, y, ltbottom);
-    oledDisplay->SetdisplayData(midX, y, midbottom);
-    oledDisplay->SetdisplayData(rtX, y, rtbottom);
+    oledDisplay->SetdisplayData(0, FOOTER_POS_Y, footer.left);
+    oledDisplay->SetdisplayData(footer.middleX, FOOTER_POS_Y, footer.middle);
+    oledDisplay->SetdisplayData(footer.rightX, FOOTER_POS_Y, footer.right);
 }
 
 /* Displays light sensor, PIR presence, and lamp state.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a new frame was rendered.
  */
-void displayLightAndPresence(SystemData* data) {
-    bool lightState = data->sensorMgr->getLightSensorValue();
-    uint8_t LampState =  data->actuatorMgr->getLamp()->getOutstate();
-    bool PirPresenceDetected = data->PirPresenceDetected;
+bool displayLightAndPresence(SystemData* data) {
+    static LampScreenModel lastModel;
+    LampScreenModel model;
+    memset(&model, 0, sizeof(model));
+    model.lightState = data->sensorMgr->getLightSensorValue();
+    model.presenceDetected = data->PirPresenceDetected;
+    model.lampState = data->actuatorMgr->getLamp()->getOutstate();
+
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
 
+    bool lightState = model.lightState;
+    uint8_t LampState = model.lampState;
+    bool PirPresenceDetected = model.presenceDetected;
+    const char* lightText = lightState ? "Dark" : "Light";
+    const char* presenceText = PirPresenceDetected ? "YES" : "NO";
+    const char* lampText = LampState ? "ON" : "OFF";
+
+    frameName = "lamp";
     displayHeader(data->oledDisplay, "Lamp Info");
 
-    data->oledDisplay->SetdisplayData(1, 14, "Ambient");
-    data->oledDisplay->DrawIcon(13, 23, lightState ? Moon_Icon : Sun_Icon, 15, 16);
-    data->oledDisplay->SetdisplayData(9, 41, lightState ? "Dark" : "Light");
+    data->oledDisplay->SetdisplayData(fontCenteredX("Ambient", LAMP_SCR_AMBIENT_COL_X), 14, "Ambient");
+    data->oledDisplay->DrawIcon(13, 23, lightState ? Moon_Icon : Sun_Icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(lightText, LAMP_SCR_AMBIENT_COL_X), 41, lightText);
 
-    data->oledDisplay->SetdisplayData(53, 14, "Motion");
-    data->oledDisplay->DrawIcon(62, 23, Presence_Icon, 15, 16);
-    data->oledDisplay->SetdisplayData(PirPresenceDetected ? 60 : 63, 41, PirPresenceDetected ? "YES" : "NO");
+    data->oledDisplay->SetdisplayData(fontCenteredX("Motion", LAMP_SCR_MOTION_COL_X), 14, "Motion");
+    data->oledDisplay->DrawIcon(62, 23, Presence_Icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(presenceText, LAMP_SCR_MOTION_COL_X), 41, presenceText);
 
-    data->oledDisplay->SetdisplayData(100, 14, "Lamp");
-    data->oledDisplay->DrawIcon(104, 23, LampState ? Lamp_On_Icon : Lamp_Off_Icon, 13, 16);
-    data->oledDisplay->SetdisplayData(LampState ? 106 : 102, 41, LampState ? "ON" : "OFF");
+    data->oledDisplay->SetdisplayData(fontCenteredX("Lamp", LAMP_SCR_LAMP_COL_X), 14, "Lamp");
+    data->oledDisplay->DrawIcon(104, 23, LampState ? Lamp_On_Icon : Lamp_Off_Icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(lampText, LAMP_SCR_LAMP_COL_X), 41, lampText);
 
-    displayFooter(data->oledDisplay, "Next", " ", "");
+    displayFooter(data->oledDisplay, FOOTER_NEXT);
+    return true;
 }
 
 /* Displays water level and pump state.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a new frame was rendered.
  */
-void displayWaterLevelAndPump(SystemData* data) {
-    uint16_t levelValue = data->sensorMgr->getLevelSensorValue();
-    bool wellState = data->sensorMgr->getWellSensorValue();
+bool displayWaterLevelAndPump(SystemData* data) {
+    static CisternScreenModel lastModel;
+    CisternScreenModel model;
+    memset(&model, 0, sizeof(model));
+    model.levelPercentage = data->levelPercentage;
+    model.wellState = data->sensorMgr->getWellSensorValue();
+    model.pumpState = data->actuatorMgr->getPump()->getOutstate();
+
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
+
+    bool wellState = model.wellState;
+    const char* wellText = wellState ? "EMPTY" : "FULL";
+    const char* pumpText = model.pumpState ? "ON" : "OFF";
 
+    frameName = "cistern";
     displayHeader(data->oledDisplay, "Cistern info");
 
-    data->oledDisplay->SetdisplayData(7, 11, "Well");
-    data->oledDisplay->DrawIcon(6, 20, Water_well_icon, 24, 24);
-    data->oledDisplay->SetdisplayData(wellState ? 4 : 8, 45, wellState ? "EMPTY" : "FULL");
+    data->oledDisplay->SetdisplayData(fontCenteredX("Well", CISTERN_SCR_WELL_COL_X), 11, "Well");
+    data->oledDisplay->DrawIcon(6, 20, Water_well_icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(wellText, CISTERN_SCR_WELL_COL_X), 45, wellText);
 
 
-    data->oledDisplay->SetdisplayData(43, 11, "Cistern");
-    data->oledDisplay->DrawIcon(54, 21, Lvl_Icon, 22, 19);
-    data->oledDisplay->SetdisplayData(53, 43, data->levelPercentage);
+    data->oledDisplay->SetdisplayData(fontCenteredX("Cistern", CISTERN_SCR_LEVEL_COL_X), 11, "Cistern");
+    data->oledDisplay->DrawIcon(54, 21, Lvl_Icon);
+    data->oledDisplay->SetdisplayData(53, 43, model.levelPercentage);
     data->oledDisplay->SetdisplayData(73, 43, "%");
 
-    data->oledDisplay->SetdisplayData(97, 11, "Pump");
-    data->oledDisplay->DrawIcon(93, 21, Pump_Icon, 26, 23);
-    data->oledDisplay->SetdisplayData(97, 44, data->actuatorMgr->getPump()->getOutstate() ? "ON" : "OFF");
+    data->oledDisplay->SetdisplayData(fontCenteredX("Pump", CISTERN_SCR_PUMP_COL_X), 11, "Pump");
+    data->oledDisplay->DrawIcon(93, 21, Pump_Icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(pumpText, CISTERN_SCR_PUMP_COL_X), 44, pumpText);
 
-    displayFooter(data->oledDisplay, "Next", " " , "Settings");
+    displayFooter(data->oledDisplay, FOOTER_NEXT_SETTINGS);
+    return true;
 }
 
 /* Displays temperature, humidity, and irrigator state.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a new frame was rendered.
  */
-void displayTemperatureAndHumidity(SystemData* data) {
-    uint8_t irr_state = data->actuatorMgr->getIrrigator()->getOutstate();
-    
+bool displayTemperatureAndHumidity(SystemData* data) {
+    static IrrigatorScreenModel lastModel;
+    IrrigatorScreenModel model;
+    memset(&model, 0, sizeof(model));
+    model.temperature = toHundredths(data->sensorMgr->getTemperature());
+    model.humidity = toHundredths(data->sensorMgr->getHumidity());
+    model.irrigatorState = data->actuatorMgr->getIrrigator()->getOutstate();
+
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
+
+    uint8_t irr_state = model.irrigatorState;
+    const char* irrText = irr_state ? "ON" : "OFF";
+
+    frameName = "irrigator";
     displayHeader(data->oledDisplay, "Irrigator Info");
 
-    data->oledDisplay->SetdisplayData(5, 14, "Temp");
-    data->oledDisplay->DrawIcon(9, 24, Temperature_Icon, 16, 16);
-    data->oledDisplay->SetdisplayData(4, 43, data->sensorMgr->getTemperature());
+    data->oledDisplay->SetdisplayData(fontCenteredX("Temp", IRR_SCR_TEMP_COL_X), 14, "Temp");
+    data->oledDisplay->DrawIcon(9, 24, Temperature_Icon);
+    data->oledDisplay->SetdisplayData(4, 43, model.temperature / 100.0);
     data->oledDisplay->SetdisplayData(28, 43, "C");
 
-    data->oledDisplay->SetdisplayData(51, 14, "Hum");
-    data->oledDisplay->DrawIcon(54, 23, Humidity_Icon, 16, 16);
-    data->oledDisplay->SetdisplayData(46, 43, data->sensorMgr->getHumidity());
+    data->oledDisplay->SetdisplayData(fontCenteredX("Hum", IRR_SCR_HUM_COL_X), 14, "Hum");
+    data->oledDisplay->DrawIcon(54, 23, Humidity_Icon);
+    data->oledDisplay->SetdisplayData(46, 43, model.humidity / 100.0);
     data->oledDisplay->SetdisplayData(71, 43, "%");
 
-    data->oledDisplay->SetdisplayData(90, 14, "Irrgtr");
-    data->oledDisplay->DrawIcon(93, 21, irr_state ? Irrigator_On_Icon : Irrigator_Off_Icon, irr_state ? 31 : 22, irr_state ? 21 : 18);
-    data->oledDisplay->SetdisplayData(100, 43, data->actuatorMgr->getIrrigator()->getOutstate() ? "ON" : "OFF");
+    data->oledDisplay->SetdisplayData(fontCenteredX("Irrgtr", IRR_SCR_IRRIGATOR_COL_X), 14, "Irrgtr");
+    data->oledDisplay->DrawIcon(93, 21, irr_state ? Irrigator_On_Icon : Irrigator_Off_Icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(irrText, IRR_SCR_IRRIGATOR_COL_X), 43, irrText);
 
-    displayFooter(data->oledDisplay, "Next", " ", "Settings");
+    displayFooter(data->oledDisplay, FOOTER_NEXT_SETTINGS);
+    return true;
 }
 
 /* Displays WiFi status and connection information.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a new frame was rendered.
  */
-void displayWiFiStatus(SystemData* data) {
-    bool wifi_state = data->wifiManager->IsWiFiConnected();
+bool displayWiFiStatus(SystemData* data) {
+    static NetworkScreenModel lastModel;
+    NetworkScreenModel model;
+    memset(&model, 0, sizeof(model));
+    model.connected = data->wifiManager->IsWiFiConnected();
+    if (model.connected) {
+        strncpy(model.ssid, data->wifiManager->getSSID().c_str(), sizeof(model.ssid) - 1);
+        model.serverHealth = data->SrvClient->getHealth();
+    }
 
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
+
+    bool wifi_state = model.connected;
+    const char* wifiText = wifi_state ? "Connected" : "Not Connected";
+
+    frameName = "network";
     displayHeader(data->oledDisplay, "Network Info");
+    if (wifi_state) {
+        /* Backend circuit breaker: closed, half-open (probing) or open (backing off) */
+        static const char* const serverText[] = { "Srv OK", "Srv probe", "Srv wait" };
+        const char* text = serverText[model.serverHealth];
+        data->oledDisplay->SetdisplayData(fontRightAlignedX(text, SCREEN_WIDTH), 0, text);
+    }
     
-    data->oledDisplay->DrawIcon(52, 13, wifi_state ? WiFi_Connected_Icon : WiFi_Not_Connected_Icon, 19, 16);
-    data->oledDisplay->SetdisplayData(wifi_state ? 36 : 26, 32, wifi_state ? "Connected" : "Not Connected");
-    data->oledDisplay->SetdisplayData(7, 42, wifi_state ? data->wifiManager->getSSID() : "");
+    data->oledDisplay->DrawIcon(52, 13, wifi_state ? WiFi_Connected_Icon : WiFi_Not_Connected_Icon);
+    data->oledDisplay->SetdisplayData(fontCenteredX(wifiText, SCREEN_WIDTH / 2), 32, wifiText);
+    data->oledDisplay->SetdisplayData(7, 42, model.ssid);
 
-    displayFooter(data->oledDisplay, "Next", " ", "Settings");
+    displayFooter(data->oledDisplay, FOOTER_NEXT_SETTINGS);
+    return true;
 }
 
 /* Displays device information.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a new frame was rendered.
  */
-void displayDeviceInfo(SystemData* data) {
-    char chipIdStr[18];
-    uint64_t chipId = ESP.getEfuseMac();
+bool displayDeviceInfo(SystemData* data) {
+    static DeviceInfoScreenModel lastModel;
+    DeviceInfoScreenModel model;
+    memset(&model, 0, sizeof(model));
 
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
+
+    frameName = "device_info";
     displayHeader(data->oledDisplay, "Device Info");
 
     data->oledDisplay->SetdisplayData(0, 12, "SW Ver: ");
@@ -171,54 +327,86 @@ void displayDeviceInfo(SystemData* data) {
     data->oledDisplay->SetdisplayData(30, 22, ESP.getChipModel());
 
     data->oledDisplay->SetdisplayData(0, 32, "DevID: ");
-    snprintf(chipIdStr, sizeof(chipIdStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-        (uint8_t)(chipId >> 40),
-        (uint8_t)(chipId >> 32),
-        (uint8_t)(chipId >> 24),
-        (uint8_t)(chipId >> 16),
-        (uint8_t)(chipId >> 8),
-        (uint8_t)chipId);
-    data->oledDisplay->SetdisplayData(0, 40, chipIdStr);
-
-    displayFooter(data->oledDisplay, "Next", " ", "");
+    data->oledDisplay->SetdisplayData(0, 40, deviceIdStr());
+
+    displayFooter(data->oledDisplay, FOOTER_NEXT);
+    return true;
 }
 
 /* Displays the current selector state.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
  * @param currentSettingMenu The current setting being displayed.
  * @param currentValue The current value of the setting.
+ * @return True if a new frame was rendered.
  */
-void displayLevelSettings(SystemData* data, uint8_t currentValue) {
+bool displayLevelSettings(SystemData* data, uint8_t currentValue) {
+    static SettingsScreenModel lastModel;
+    SettingsScreenModel model;
+    memset(&model, 0, sizeof(model));
+    model.settingMenu = data->currentSettingMenu;
+    model.value = currentValue;
+
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
+
     const char* settings[] = {
         "Max Level (%)",
         "Min Level (%)",
     };
 
+    frameName = "level_settings";
     displayHeader(data->oledDisplay, "Pump settings");
     data->oledDisplay->SetdisplayData(0, 10, settings[data->currentSettingMenu]);
     data->oledDisplay->SetdisplayData(0, 20, "Set Value:");
     data->oledDisplay->SetdisplayData(65, 20, currentValue);
 
-    displayFooter(data->oledDisplay, "Param", "^ v", "save");
+    displayFooter(data->oledDisplay, FOOTER_PARAM_SAVE);
+    return true;
 }
 
 /* Displays the current selector state.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
  * @param currentSettingMenu The current setting being displayed.
  * @param currentValue The current value of the setting.
+ * @return True if a new frame was rendered.
  */
-void displayTempHumSettings(SystemData* data, uint8_t currentValue) {
+bool displayTempHumSettings(SystemData* data, uint8_t currentValue) {
+    static SettingsScreenModel lastModel;
+    SettingsScreenModel model;
+    memset(&model, 0, sizeof(model));
+    model.settingMenu = data->currentSettingMenu;
+    model.value = currentValue;
+
+    if (!viewModelChanged(data->oledDisplay, &lastModel, &model, sizeof(model))) {
+        return false;
+    }
+
     const char* settings[] = {
         "Hot Temp (C)",
         "Low Humidity (%)",
     };
 
+    frameName = "temp_hum_settings";
     displayHeader(data->oledDisplay, "Irrigator settings");
     data->oledDisplay->SetdisplayData(0, 10, settings[data->currentSettingMenu]);
     data->oledDisplay->SetdisplayData(0, 20, "Set Value:");
     data->oledDisplay->SetdisplayData(65, 20, currentValue);
 
-    displayFooter(data->oledDisplay, "Param", "^ v", "save");
+    displayFooter(data->oledDisplay, FOOTER_PARAM_SAVE);
+    return true;
+}
+
+/* Detects a new press of a button, the screens below poll the buttons on every display cycle.
+ * @param pressed Current state of the button.
+ * @param wasPressed[IN/OUT] State seen on the previous call. Set it to true when entering a screen,
+ *        so a button still held from the previous screen only counts once released and pressed again.
+ * @return True on the released-to-pressed transition only.
+ */
+static bool buttonNewPress(bool pressed, bool* wasPressed) {
+    bool newPress = pressed && !*wasPressed;
+    *wasPressed = pressed;
+    return newPress;
 }
 
 /* Screen to allow the user select the option in wifi settins menu.
@@ -248,6 +436,7 @@ wifiSettings_Type WifiSettinsMenu(SystemData* data) {
     uint32_t now = millis();
 
     /* Display menu options */
+    frameName = "wifi_menu";
     displayHeader(data->oledDisplay, "WiFi Settings");
     for (int i = 0; i < menuCount; ++i) {
         String line = (i == menuIdx ? ">" : " ") + String(menuOptions[i]);
@@ -255,7 +444,7 @@ wifiSettings_Type WifiSettinsMenu(SystemData* data) {
     }
 
     /* Footer for navigation hints */
-    displayFooter(data->oledDisplay, "Select", "^ v", "Esc");
+    displayFooter(data->oledDisplay, FOOTER_SELECT_ESC);
 
     /* Debounce buttons */
     if (now - lastButtonTime > 300) {
@@ -287,6 +476,7 @@ wifiSettings_Type WifiSettinsMenu(SystemData* data) {
 }
 
 /* Start scanning for available WiFi networks and display them. The user can select one to connect or do nothing(esc).
+ * ESC also stops a scan still in progress.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
  * @param selected_ssid[OUT] The SSID of the selected network.
  * @return WIFI_SETTIGNS_SET_PASSWORD: if the user selects a network to connect to, otherwise WIFI_SETTIGNS_MENU.
@@ -296,28 +486,35 @@ wifiSettings_Type WifiSettinsListNetworks(SystemData* data, String& selected_ssi
     static std::vector<String> ssidList;
     static int selectedIdx = 0;
     static bool scanned = false;
+    static WiFiOpState scanState = WIFI_OP_IDLE;
     static uint32_t lastButtonTime = 0;
+    static bool escWasPressed = false;
     uint32_t now = millis();
 
     data->currentDisplayDataSelec = SCREEN_WIFI_SETT_SUB_MENU;
 
     /* Read button states */
     bool selectPressed = !data->sensorMgr->getButtonSelectorValue();
-    bool escPressed = !data->sensorMgr->getButtonEscValue();
     bool upPressed = !data->sensorMgr->getButtonUpValue();
     bool downPressed = !data->sensorMgr->getButtonDownValue();
 
-    /* Scan only once when entering this state */
+    /* Start the scan once when entering this state, recent results are reused */
     if (!scanned) {
-        data->oledDisplay->SetdisplayData(0, 0, "Scanning Networks..");
-        data->oledDisplay->PrintdisplayData();
-        ssidList = data->wifiManager->scanNetworks();
+        escWasPressed = true; /* ESC may still be held from the password entry */
+        ssidList.clear();
         selectedIdx = 0;
+        scanState = data->wifiManager->startScan();
         scanned = true;
     }
+    bool escPressed = buttonNewPress(!data->sensorMgr->getButtonEscValue(), &escWasPressed);
+    if (scanState == WIFI_OP_IN_PROGRESS) {
+        scanState = data->wifiManager->pollScan(ssidList);
+    } else if (scanState == WIFI_OP_DONE && ssidList.empty()) {
+        data->wifiManager->pollScan(ssidList); /* Cached results */
+    }
     
     /* Footer for navigation hints */
-    displayFooter(data->oledDisplay, "Select", "^ v", "Esc");
+    displayFooter(data->oledDisplay, FOOTER_SELECT_ESC);
 
     /* Debounce buttons */
     if (now - lastButtonTime > 300) {
@@ -333,6 +530,8 @@ wifiSettings_Type WifiSettinsListNetworks(SystemData* data, String& selected_ssi
             lastButtonTime = now;
             return WIFI_SETTIGNS_SET_PASSWORD;
         } else if (escPressed) {
+            data->wifiManager->cancelScan();
+            scanState = WIFI_OP_IDLE;
             scanned = false; /* Reset for next entry */
             lastButtonTime = now;
             data->currentDisplayDataSelec = SCREEN_WIFI_SETT_MENU; /* Return to main wifi settins */
@@ -340,7 +539,14 @@ wifiSettings_Type WifiSettinsListNetworks(SystemData* data, String& selected_ssi
         }
     }
 
-    /* Display scanned SSIDs */
+    /* Display scanned SSIDs, the buttons stay responsive while the scan runs */
+    if (scanState == WIFI_OP_IN_PROGRESS) {
+        frameName = "wifi_scanning";
+        displayHeader(data->oledDisplay, "Scanning Networks..");
+        return WIFI_SETTIGNS_LIST_NETWORKS;
+    }
+
+    frameName = "wifi_networks";
     displayHeader(data->oledDisplay, "Select WiFi:");
     if (ssidList.empty()) {
         data->oledDisplay->SetdisplayData(0, 10, "No networks found");
@@ -434,7 +640,7 @@ wifiSettings_Type WifiSettinsSetPassword(SystemData* data, String selected_ssid,
                 passwordBuffer[0] = characterSet[0];
                 passwordLength = 1;
             } else {
-                char* foundChar = strchr(characterSet, passwordBuffer[cursorPosition]);
+                const char* foundChar = strchr(characterSet, passwordBuffer[cursorPosition]);
                 int charIndex = foundChar ? (foundChar - characterSet) : 0;
                 charIndex = (charIndex + step) % characterSetLength;
                 passwordBuffer[cursorPosition] = characterSet[charIndex];
@@ -446,7 +652,7 @@ wifiSettings_Type WifiSettinsSetPassword(SystemData* data, String selected_ssid,
                 passwordBuffer[0] = characterSet[0];
                 passwordLength = 1;
             } else {
-                char* foundChar = strchr(characterSet, passwordBuffer[cursorPosition]);
+                const char* foundChar = strchr(characterSet, passwordBuffer[cursorPosition]);
                 int charIndex = foundChar ? (foundChar - characterSet) : 0;
                 charIndex = (charIndex - step + characterSetLength) % characterSetLength;
                 passwordBuffer[cursorPosition] = characterSet[charIndex];
@@ -498,6 +704,7 @@ wifiSettings_Type WifiSettinsSetPassword(SystemData* data, String selected_ssid,
     }
 
     /* Display UI */
+    frameName = "wifi_password";
     data->oledDisplay->SetdisplayData(0, 0, "SSID:");
     data->oledDisplay->SetdisplayData(40, 0, selected_ssid.c_str());
     data->oledDisplay->SetdisplayData(0, 10, "Password:");
@@ -509,85 +716,134 @@ wifiSettings_Type WifiSettinsSetPassword(SystemData* data, String selected_ssid,
     cursorLine[cursorPosition] = '^';
     data->oledDisplay->SetdisplayData(0, 30, cursorLine);
 
-    displayFooter(data->oledDisplay, "Next", "^ v", "Esc|Set");
+    displayFooter(data->oledDisplay, FOOTER_NEXT_ESC_SET);
 
     return WIFI_SETTIGNS_SET_PASSWORD;
 }
 
-/* Show "Connecting..." and then "Success!" or "Failed!" with reason.
+/* Show "Connecting..." while the connection is in progress and then "Success!" or "Failed!" with reason.
+ * The connection runs in the background, the screen is polled on every display cycle.
+ * ESC cancels the attempt, it only counts once released since the password entry confirmed with it.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
  * @param selected_ssid The SSID of the selected network.
  * @param password The entered password for the selected network.
  * @return WIFI_SETTIGNS_SET_PASSWORD: if the user selects to set the password again.
+ *         WIFI_SETTIGNS_CONNECT_FEEDBACK: while connecting or showing the result.
+ *         WIFI_SETTIGNS_MENU: once the result has been shown.
  */
 wifiSettings_Type WifiSettinsConnectFeedack(SystemData* data, String selected_ssid, String password) {
+    static bool started = false;
+    static uint32_t resultTime = 0;
+    static bool escWasPressed = false;
+    WiFiOpState connectState;
+
     data->currentDisplayDataSelec = SCREEN_WIFI_SETT_SUB_MENU;
 
+    /* Attempt to connect to the selected network */
+    if (!started) {
+        data->wifiManager->beginConnect(selected_ssid, password);
+        started = true;
+        resultTime = 0;
+        escWasPressed = true; /* The ESC press that confirmed the password */
+    }
+
     /* Read button states */
-    bool escPressed = !data->sensorMgr->getButtonEscValue();
+    bool escPressed = buttonNewPress(!data->sensorMgr->getButtonEscValue(), &escWasPressed);
 
-    /* Display connecting message */
-    data->oledDisplay->SetdisplayData(0, 0, "Connecting to WiFi...");
-    data->oledDisplay->PrintdisplayData();
+    connectState = data->wifiManager->pollConnect();
 
-    /* Attempt to connect to the selected network */
-    if (data->wifiManager->connectToNetwork(selected_ssid, password)) {
+    if (connectState == WIFI_OP_IN_PROGRESS) {
+        frameName = "wifi_connecting";
+        data->oledDisplay->SetdisplayData(0, 0, "Connecting to WiFi...");
+        data->oledDisplay->SetdisplayData(0, 10, selected_ssid.c_str());
+        displayFooter(data->oledDisplay, FOOTER_NEXT_ESC_SET);
+
+        if (escPressed) {
+            data->wifiManager->cancelConnect();
+            started = false;
+            return WIFI_SETTIGNS_SET_PASSWORD;
+        }
+        return WIFI_SETTIGNS_CONNECT_FEEDBACK;
+    }
+
+    if (connectState == WIFI_OP_DONE) {
+        frameName = "wifi_connected";
         data->oledDisplay->SetdisplayData(0, 0, "Connection Success!");
-        data->oledDisplay->PrintdisplayData();
     } else {
+        frameName = "wifi_failed";
         data->oledDisplay->SetdisplayData(0, 0, "Failed!");
         data->oledDisplay->SetdisplayData(0, 10, "Check password");
-        data->oledDisplay->PrintdisplayData();
     }
 
-    displayFooter(data->oledDisplay, "Next", "^ v", "Esc|Set");
+    displayFooter(data->oledDisplay, FOOTER_NEXT_ESC_SET);
+
+    if (resultTime == 0) {
+        resultTime = millis();
+    }
 
     if (escPressed) {
+        started = false;
         return WIFI_SETTIGNS_SET_PASSWORD;
     }
-    
-    vTaskDelay(pdMS_TO_TICKS(1000));
 
-    return WIFI_SETTIGNS_MENU;
+    if (millis() - resultTime >= WIFI_FEEDBACK_TIME_MS) {
+        started = false;
+        return WIFI_SETTIGNS_MENU;
+    }
+
+    return WIFI_SETTIGNS_CONNECT_FEEDBACK;
 }
 
-/* Disconnect from the current WiFi network.
+/* Disconnect from the current WiFi network and show the result for a moment.
  * @param data Pointer to the SystemData structure containing sensor and actuator objects.
- * @return WIFI_SETTIGNS_MENU: if the user selects to go back to the main menu.
+ * @return WIFI_SETTIGNS_DISCONNECT: while the result is shown.
+ *         WIFI_SETTIGNS_MENU: once the result has been shown or the user goes back to the main menu.
  */
 wifiSettings_Type WifiSettinsDisconnect(SystemData* data) {
-    data->currentDisplayDataSelec = SCREEN_WIFI_SETT_SUB_MENU;
+    static bool disconnected = false;
+    static uint32_t disconnectTime = 0;
+    static bool escWasPressed = false;
 
-    /* Read button states */
-    bool escPressed = !data->sensorMgr->getButtonEscValue();
+    data->currentDisplayDataSelec = SCREEN_WIFI_SETT_SUB_MENU;
 
     /* Disconnect from the current network */
-    data->oledDisplay->SetdisplayData(0, 0, "WiFi Disconnecting...");
-    data->oledDisplay->PrintdisplayData();
-    data->wifiManager->disconnectWiFi();
+    if (!disconnected) {
+        data->wifiManager->disconnectWiFi();
+        disconnected = true;
+        disconnectTime = millis();
+        escWasPressed = true;
+    }
+
+    /* Read button states */
+    bool escPressed = buttonNewPress(!data->sensorMgr->getButtonEscValue(), &escWasPressed);
+    frameName = "wifi_disconnected";
     data->oledDisplay->SetdisplayData(0, 0, "WiFi Disconnected!");
-    data->oledDisplay->PrintdisplayData();
 
-    displayFooter(data->oledDisplay, "Next", "^ v", "Esc");
+    displayFooter(data->oledDisplay, FOOTER_NEXT_ESC);
 
-    if (escPressed) {
+    if (escPressed || (millis() - disconnectTime >= WIFI_FEEDBACK_TIME_MS)) {
+        disconnected = false;
         return WIFI_SETTIGNS_MENU;
     }
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-
-    return WIFI_SETTIGNS_MENU;
+    return WIFI_SETTIGNS_DISCONNECT;
 }
 
 /* Displays the WiFi settings screen with a list of available SSIDs.
  * State machine: menu -> scan/list -> password -> connect feedback -> disconnect.
+ * The screens poll the buttons themselves, so a frame is rendered on every call.
+ * @return True, a new frame is always rendered.
  */
-void displayWiFiSettings(SystemData* data) {
+bool displayWiFiSettings(SystemData* data) {
     /* Static variables for state machine */
     static wifiSettings_Type wifiSettings = WIFI_SETTIGNS_MENU;
     static String selected_ssid = "";
     static String password = "";
 
+    data->oledDisplay->clearAllDisplay();
+    data->oledDisplay->setTextProperties(1, SSD1306_WHITE);
+    forceRedraw = true; /* The next regular screen starts from a cleared frame */
+
     switch(wifiSettings) {
         case WIFI_SETTIGNS_MENU:
             wifiSettings = WifiSettinsMenu(data);
@@ -608,4 +864,58 @@ void displayWiFiSettings(SystemData* data) {
             wifiSettings = WIFI_SETTIGNS_MENU;
             break;
     }
-}
\ No newline at end of file
+
+    return true;
+}
+
+/* Renders the selected screen, the task loop of TaskDisplay and the host snapshot test share it.
+ * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a new frame was rendered and needs to be flushed.
+ */
+bool displayRender(SystemData* data) {
+    static pb1Selector lastRenderedScreen = SCREEN_LGT_PIR_LAMP_DATA;
+    uint8_t* Levelsettings[] = {
+        &data->maxLevelPercentage,
+        &data->minLevelPercentage,
+    };
+    uint8_t* TempHumsettings[] = {
+        &data->hotTemperature,
+        &data->lowHumidity
+    };
+    pb1Selector currentScreen = data->currentDisplayDataSelec;
+
+    /* Screens only re-render when their view model changes, force it when the screen changes */
+    if (currentScreen != lastRenderedScreen) {
+        lastRenderedScreen = currentScreen;
+        displayInvalidate();
+    }
+
+    switch (currentScreen) {
+        case SCREEN_LGT_PIR_LAMP_DATA:
+            return displayLightAndPresence(data);
+        case SCREEN_LVL_PUMP_DATA:
+            return displayWaterLevelAndPump(data);
+        case SCREEN_TEMP_HUM_IRR_DATA:
+            return displayTemperatureAndHumidity(data);
+        case SCREEN_WIFI_STATUS:
+            return displayWiFiStatus(data);
+        case SCREEN_DEV_INFO:
+            return displayDeviceInfo(data);
+        case SCREEN_LVL_SETT_MENU:
+            return displayLevelSettings(data, *Levelsettings[data->currentSettingMenu]);
+        case SCREEN_TEMP_HUM_SETT_MENU:
+            return displayTempHumSettings(data, *TempHumsettings[data->currentSettingMenu]);
+        case SCREEN_WIFI_SETT_MENU:
+        case SCREEN_WIFI_SETT_SUB_MENU:
+            return displayWiFiSettings(data);
+        default:
+            return displayLightAndPresence(data);
+    }
+}
+
+/* Name of the last rendered frame, it tags the snapshots so they are compared screen by screen.
+ * @return A constant string such as "lamp" or "wifi_password".
+ */
+const char* displayFrameName() {
+    return frameName;
+}
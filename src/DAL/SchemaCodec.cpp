@@ -0,0 +1,765 @@
+#include "SchemaCodec.h"
+#include "DeviceId.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+/* JSON output into a caller provided buffer, overflow is sticky and reported once at the end */
+struct JsonWriter {
+    char* buf;
+    size_t capacity;
+    size_t len;
+    bool overflow;
+    bool needComma; /* A value has been written at the current nesting level */
+};
+
+/* Value of a top level member found by jsonWalkObject */
+struct JsonMember {
+    const char* key;
+    size_t keyLen;
+    const char* value;
+    size_t valueLen;
+};
+
+typedef void (*JsonMemberCallback)(const JsonMember* member, void* ctx);
+
+/**
+ * @brief Starts writing into a caller provided buffer, one byte is kept for the terminator.
+ * @param w The writer.
+ * @param buf Output buffer.
+ * @param capacity Size of the output buffer.
+ */
+static void jsonBegin(JsonWriter* w, char* buf, size_t capacity) {
+    w->buf = buf;
+    w->capacity = capacity;
+    w->len = 0;
+    w->overflow = (capacity == 0);
+    w->needComma = false;
+}
+
+/**
+ * @brief Appends raw text.
+ * @param w The writer.
+ * @param text Text to append.
+ * @param len Length of the text.
+ */
+static void jsonAppend(JsonWriter* w, const char* text, size_t len) {
+    if (w->overflow || w->len + len >= w->capacity) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buf[w->len], text, len);
+    w->len += len;
+}
+
+/**
+ * @brief Terminates the output.
+ * @param w The writer.
+ * @return The length of the output, 0 if it did not fit.
+ */
+static size_t jsonEnd(JsonWriter* w) {
+    if (w->overflow) {
+        return 0;
+    }
+    w->buf[w->len] = '\0';
+    return w->len;
+}
+
+static void jsonSeparator(JsonWriter* w) {
+    if (w->needComma) {
+        jsonAppend(w, ",", 1);
+    }
+}
+
+static void jsonOpen(JsonWriter* w, char bracket) {
+    jsonSeparator(w);
+    jsonAppend(w, &bracket, 1);
+    w->needComma = false;
+}
+
+static void jsonClose(JsonWriter* w, char bracket) {
+    jsonAppend(w, &bracket, 1);
+    w->needComma = true;
+}
+
+/**
+ * @brief Writes a member key, the value follows. Keys are schema literals and are not escaped.
+ * @param w The writer.
+ * @param key The key.
+ */
+static void jsonKey(JsonWriter* w, const char* key) {
+    jsonSeparator(w);
+    jsonAppend(w, "\"", 1);
+    jsonAppend(w, key, strlen(key));
+    jsonAppend(w, "\":", 2);
+    w->needComma = false;
+}
+
+static void jsonWriteUINT(JsonWriter* w, uint32_t value) {
+    char text[11];
+    jsonSeparator(w);
+    jsonAppend(w, text, snprintf(text, sizeof(text), "%lu", (unsigned long)value));
+    w->needComma = true;
+}
+
+static void jsonWriteUINT64(JsonWriter* w, uint64_t value) {
+    char text[21];
+    jsonSeparator(w);
+    jsonAppend(w, text, snprintf(text, sizeof(text), "%llu", (unsigned long long)value));
+    w->needComma = true;
+}
+
+static void jsonWriteINT64(JsonWriter* w, int64_t value) {
+    char text[21];
+    jsonSeparator(w);
+    jsonAppend(w, text, snprintf(text, sizeof(text), "%lld", (long long)value));
+    w->needComma = true;
+}
+
+static void jsonWriteFLOAT(JsonWriter* w, float value) {
+    char text[16];
+    jsonSeparator(w);
+    if (isnan(value)) {
+        jsonAppend(w, "null", 4); /* No reading yet */
+    } else {
+        jsonAppend(w, text, snprintf(text, sizeof(text), "%g", value));
+    }
+    w->needComma = true;
+}
+
+static void jsonWriteFLAG(JsonWriter* w, bool value) {
+    jsonSeparator(w);
+    jsonAppend(w, value ? "\"1\"" : "\"0\"", 3);
+    w->needComma = true;
+}
+
+static void cborWriteFieldUINT(CborEncoder* enc, uint32_t value) {
+    cborWriteUintFixed(enc, value);
+}
+
+static void cborWriteFieldFLOAT(CborEncoder* enc, float value) {
+    cborWriteFloat(enc, value);
+}
+
+static void cborWriteFieldFLAG(CborEncoder* enc, bool value) {
+    cborWriteUint(enc, value ? 1 : 0); /* 0 and 1 fit the initial byte, always 1 byte */
+}
+
+#define SCHEMA_COUNT_FIELD(key, kind, value) + 1
+#define SCHEMA_SAMPLE_FIELD_COUNT (1 TELEMETRY_SENSOR_FIELDS(SCHEMA_COUNT_FIELD) TELEMETRY_ACTUATOR_FIELDS(SCHEMA_COUNT_FIELD))
+
+#define SCHEMA_JSON_SETTINGS_FIELD(key, member) \
+    jsonKey(&w, key); \
+    jsonWriteUINT(&w, data->member);
+
+#define SCHEMA_JSON_SAMPLE_FIELD(key, kind, value) \
+    jsonKey(&w, key); \
+    jsonWrite##kind(&w, value);
+
+#define SCHEMA_CBOR_SAMPLE_FIELD(key, kind, value) \
+    cborWriteField##kind(&enc, value);
+
+/**
+ * @brief Writes the settings object.
+ * @param w The writer.
+ * @param data Pointer to the SystemData structure holding the settings.
+ */
+static void jsonWriteSettings(JsonWriter& w, const SystemData* data) {
+    jsonOpen(&w, '{');
+    SETTINGS_FIELDS(SCHEMA_JSON_SETTINGS_FIELD)
+    jsonClose(&w, '}');
+}
+
+/**
+ * @brief Serializes the settings as { "<chipId>": { "settings": { ... } } }.
+ * @param buf Output buffer, null terminated on success.
+ * @param capacity Size of the output buffer.
+ * @param data Pointer to the SystemData structure holding the settings.
+ * @return The payload length, 0 if it did not fit.
+ */
+size_t schemaWriteSettingsJson(char* buf, size_t capacity, const SystemData* data) {
+    JsonWriter w;
+    jsonBegin(&w, buf, capacity);
+
+    jsonOpen(&w, '{');
+    jsonKey(&w, deviceIdStr());
+    jsonOpen(&w, '{');
+    jsonKey(&w, "settings");
+    jsonWriteSettings(w, data);
+    jsonClose(&w, '}');
+    jsonClose(&w, '}');
+
+    return jsonEnd(&w);
+}
+
+/**
+ * @brief Serializes the settings as a flat object, the format of the MQTT settings topic and of /getSettings.
+ * @param buf Output buffer, null terminated on success.
+ * @param capacity Size of the output buffer.
+ * @param data Pointer to the SystemData structure holding the settings.
+ * @return The payload length, 0 if it did not fit.
+ */
+size_t schemaWriteSettingsObjectJson(char* buf, size_t capacity, const SystemData* data) {
+    JsonWriter w;
+    jsonBegin(&w, buf, capacity);
+    jsonWriteSettings(w, data);
+    return jsonEnd(&w);
+}
+
+/**
+ * @brief Serializes a telemetry batch as
+ *        { "<chipId>": { "now", "wall", "ppm", "samples": [ { "t", "sensorData", "actuatorData" }, ... ] } }.
+ *        "t" is the device time of a sample in us, "now", "wall" and "ppm" relate it to wall time, see ClockEstimate.
+ *        It is negative for samples logged to flash before this boot.
+ * @param buf Output buffer, null terminated on success.
+ * @param capacity Size of the output buffer.
+ * @param samples The samples, oldest first.
+ * @param count Number of samples.
+ * @param clock Current device time and wall time estimate.
+ * @return The payload length, 0 if it did not fit.
+ */
+size_t schemaWriteBatchJson(char* buf, size_t capacity, const TelemetrySample* samples, uint16_t count, const ClockEstimate& clock) {
+    JsonWriter w;
+    jsonBegin(&w, buf, capacity);
+
+    jsonOpen(&w, '{');
+    jsonKey(&w, deviceIdStr());
+    jsonOpen(&w, '{');
+    jsonKey(&w, "now");
+    jsonWriteUINT64(&w, clock.nowUs);
+    jsonKey(&w, "wall");
+    jsonWriteUINT64(&w, clock.wallMs);
+    jsonKey(&w, "ppm");
+    jsonWriteFLOAT(&w, clock.driftPpm);
+    jsonKey(&w, "samples");
+    jsonOpen(&w, '[');
+
+    for (uint16_t i = 0; i < count; ++i) {
+        const TelemetrySample& s = samples[i];
+        jsonOpen(&w, '{');
+        jsonKey(&w, "t");
+        jsonWriteINT64(&w, s.timeUs);
+        jsonKey(&w, "sensorData");
+        jsonOpen(&w, '{');
+        TELEMETRY_SENSOR_FIELDS(SCHEMA_JSON_SAMPLE_FIELD)
+        jsonClose(&w, '}');
+        jsonKey(&w, "actuatorData");
+        jsonOpen(&w, '{');
+        TELEMETRY_ACTUATOR_FIELDS(SCHEMA_JSON_SAMPLE_FIELD)
+        jsonClose(&w, '}');
+        jsonClose(&w, '}');
+    }
+
+    jsonClose(&w, ']');
+    jsonClose(&w, '}');
+    jsonClose(&w, '}');
+
+    return jsonEnd(&w);
+}
+
+/**
+ * @brief Serializes a telemetry batch as CBOR:
+ *        { "id": h'<chip id>', "now", "wall", "ppm", "samples": [[t, <sensor fields>, <actuator fields>], ...] }
+ *        t is the device time of a sample in us, see schemaWriteBatchJson(). Every sample field is fixed width: t and
+ *        the clock fields take 9 bytes, integers 5, floats are always float32 and flags the one byte integers 0/1,
+ *        so each sample is SCHEMA_SAMPLE_CBOR_SIZE bytes.
+ * @param buf Output buffer.
+ * @param capacity Size of the output buffer.
+ * @param samples The samples, oldest first.
+ * @param count Number of samples.
+ * @param clock Current device time and wall time estimate.
+ * @return The payload length, 0 if it did not fit.
+ */
+size_t schemaWriteBatchCbor(uint8_t* buf, size_t capacity, const TelemetrySample* samples, uint16_t count, const ClockEstimate& clock) {
+    CborEncoder enc;
+    cborBegin(&enc, buf, capacity);
+
+    cborWriteMap(&enc, 5);
+    cborWriteText(&enc, "id");
+    cborWriteBytes(&enc, deviceIdBytes(), DEVICE_ID_SIZE);
+    cborWriteText(&enc, "now");
+    cborWriteUint64Fixed(&enc, clock.nowUs);
+    cborWriteText(&enc, "wall");
+    cborWriteUint64Fixed(&enc, clock.wallMs);
+    cborWriteText(&enc, "ppm");
+    cborWriteFloat(&enc, clock.driftPpm);
+    cborWriteText(&enc, "samples");
+    cborWriteArray(&enc, count);
+
+    for (uint16_t i = 0; i < count; ++i) {
+        const TelemetrySample& s = samples[i];
+        cborWriteArray(&enc, SCHEMA_SAMPLE_FIELD_COUNT);
+        cborWriteInt64Fixed(&enc, s.timeUs);
+        TELEMETRY_SENSOR_FIELDS(SCHEMA_CBOR_SAMPLE_FIELD)
+        TELEMETRY_ACTUATOR_FIELDS(SCHEMA_CBOR_SAMPLE_FIELD)
+    }
+
+    return enc.overflow ? 0 : enc.len;
+}
+
+static const char* jsonSkipWs(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Skips a string starting at its opening quote.
+ * @return Pointer after the closing quote, NULL if the string is not terminated.
+ */
+static const char* jsonSkipString(const char* p, const char* end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Skips any value, nested objects and arrays included.
+ * @return Pointer after the value, NULL if the value is malformed.
+ */
+static const char* jsonSkipValue(const char* p, const char* end) {
+    if (p >= end) {
+        return NULL;
+    }
+    if (*p == '"') {
+        return jsonSkipString(p, end);
+    }
+    if (*p == '{' || *p == '[') {
+        uint8_t depth = 0;
+        while (p < end) {
+            if (*p == '"') {
+                p = jsonSkipString(p, end);
+                if (p == NULL) {
+                    return NULL;
+                }
+                continue;
+            }
+            if (*p == '{' || *p == '[') {
+                depth++;
+            } else if ((*p == '}' || *p == ']') && --depth == 0) {
+                return p + 1;
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    /* Number or literal */
+    const char* start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\r' && *p != '\n' && *p != '\t') {
+        p++;
+    }
+    return (p > start) ? p : NULL;
+}
+
+/**
+ * @brief Calls back for every member of the top level object, without copying or allocating.
+ * @param json The document.
+ * @param len Length of the document.
+ * @param callback Called for each member.
+ * @param ctx Passed to the callback.
+ * @return False if the document is not a well formed object.
+ */
+static bool jsonWalkObject(const char* json, size_t len, JsonMemberCallback callback, void* ctx) {
+    const char* end = json + len;
+    const char* p = jsonSkipWs(json, end);
+
+    if (p >= end || *p != '{') {
+        return false;
+    }
+    p = jsonSkipWs(p + 1, end);
+    if (p < end && *p == '}') {
+        return true;
+    }
+
+    while (p < end) {
+        JsonMember member;
+        if (*p != '"') {
+            return false;
+        }
+        const char* keyEnd = jsonSkipString(p, end);
+        if (keyEnd == NULL) {
+            return false;
+        }
+        member.key = p + 1;
+        member.keyLen = keyEnd - p - 2;
+
+        p = jsonSkipWs(keyEnd, end);
+        if (p >= end || *p != ':') {
+            return false;
+        }
+        p = jsonSkipWs(p + 1, end);
+        const char* valueEnd = jsonSkipValue(p, end);
+        if (valueEnd == NULL) {
+            return false;
+        }
+        member.value = p;
+        member.valueLen = valueEnd - p;
+        callback(&member, ctx);
+
+        p = jsonSkipWs(valueEnd, end);
+        if (p < end && *p == ',') {
+            p = jsonSkipWs(p + 1, end);
+        } else {
+            return (p < end && *p == '}');
+        }
+    }
+    return false;
+}
+
+static bool jsonKeyEquals(const JsonMember* member, const char* key) {
+    return strlen(key) == member->keyLen && memcmp(member->key, key, member->keyLen) == 0;
+}
+
+/**
+ * @brief Parses a member value as an integer setting.
+ * @param member The member.
+ * @param value[OUT] The value.
+ * @return True if the value is an integer between 0 and 255.
+ */
+static bool jsonSettingValue(const JsonMember* member, uint8_t* value) {
+    uint16_t result = 0;
+    if (member->valueLen == 0 || member->valueLen > 3) {
+        return false;
+    }
+    for (size_t i = 0; i < member->valueLen; ++i) {
+        char c = member->value[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    if (result > 255) {
+        return false;
+    }
+    *value = (uint8_t)result;
+    return true;
+}
+
+/* Context of schemaParseSettings, the settings are applied once the whole document has been read */
+struct SettingsParseCtx {
+    SystemData parsed;
+    int8_t applied;
+};
+
+#define SCHEMA_PARSE_SETTINGS_FIELD(key, member) \
+    if (jsonKeyEquals(m, key)) { \
+        if (jsonSettingValue(m, &value)) { \
+            parse->parsed.member = value; \
+            parse->applied++; \
+        } \
+        return; \
+    }
+
+#define SCHEMA_APPLY_SETTINGS_FIELD(key, member) \
+    data->member = parse.parsed.member;
+
+static void settingsMemberCallback(const JsonMember* m, void* ctx) {
+    SettingsParseCtx* parse = (SettingsParseCtx*)ctx;
+    uint8_t value;
+    SETTINGS_FIELDS(SCHEMA_PARSE_SETTINGS_FIELD)
+}
+
+/**
+ * @brief Fills the SystemData settings from a flat settings object, without heap use.
+ *        Unknown members are skipped, members that are not integers between 0 and 255 are ignored.
+ *        Nothing is applied from a malformed document.
+ * @param json The settings document, as returned by /getSettings.
+ * @param len Length of the document.
+ * @param data[OUT] Pointer to the SystemData structure to update.
+ * @return Number of settings applied, -1 if the document is malformed.
+ */
+int8_t schemaParseSettings(const char* json, size_t len, SystemData* data) {
+    SettingsParseCtx parse = { *data, 0 };
+    if (!jsonWalkObject(json, len, settingsMemberCallback, &parse)) {
+        return -1;
+    }
+    SETTINGS_FIELDS(SCHEMA_APPLY_SETTINGS_FIELD)
+    return parse.applied;
+}
+
+/* Context of schemaHasKey */
+struct HasKeyCtx {
+    const char* key;
+    bool found;
+};
+
+static void hasKeyMemberCallback(const JsonMember* m, void* ctx) {
+    HasKeyCtx* search = (HasKeyCtx*)ctx;
+    if (jsonKeyEquals(m, search->key)) {
+        search->found = true;
+    }
+}
+
+/**
+ * @brief Checks if the top level object of a document has a member.
+ * @param json The document.
+ * @param len Length of the document.
+ * @param key The member name.
+ * @return True if the document is an object with that member.
+ */
+bool schemaHasKey(const char* json, size_t len, const char* key) {
+    HasKeyCtx search = { key, false };
+    return jsonWalkObject(json, len, hasKeyMemberCallback, &search) && search.found;
+}
+
+/* Context of schemaGetUint */
+struct GetUintCtx {
+    const char* key;
+    uint32_t value;
+    bool found;
+};
+
+static void getUintMemberCallback(const JsonMember* m, void* ctx) {
+    GetUintCtx* search = (GetUintCtx*)ctx;
+    if (!jsonKeyEquals(m, search->key) || m->valueLen == 0 || m->valueLen > 9) {
+        return;
+    }
+    uint32_t value = 0;
+    for (size_t i = 0; i < m->valueLen; ++i) {
+        char c = m->value[i];
+        if (c < '0' || c > '9') {
+            return;
+        }
+        value = value * 10 + (c - '0');
+    }
+    search->value = value;
+    search->found = true;
+}
+
+/**
+ * @brief Reads an unsigned integer member of the top level object of a document.
+ * @param json The document.
+ * @param len Length of the document.
+ * @param key The member name.
+ * @param value[OUT] The value, left untouched if the member is missing.
+ * @return True if the document is an object with that member, an integer below 10^9.
+ */
+bool schemaGetUint(const char* json, size_t len, const char* key, uint32_t* value) {
+    GetUintCtx search = { key, 0, false };
+    if (!jsonWalkObject(json, len, getUintMemberCallback, &search) || !search.found) {
+        return false;
+    }
+    *value = search.value;
+    return true;
+}
+
+/* States of the streaming settings filter */
+enum SettingsFilterState {
+    FILTER_START,        /* Before the top level value */
+    FILTER_KEY_OR_END,   /* After '{' or ',' */
+    FILTER_KEY,          /* Inside a key */
+    FILTER_COLON,        /* After a key */
+    FILTER_VALUE,        /* After ':' */
+    FILTER_SCALAR,       /* Inside a number or literal */
+    FILTER_STRING,       /* Inside a string value */
+    FILTER_NESTED,       /* Inside an object or array value */
+    FILTER_AFTER_VALUE,  /* After a value */
+    FILTER_DONE,         /* After the closing '}' */
+    FILTER_INVALID,      /* Not an object, or malformed */
+};
+
+#define SCHEMA_FILTER_KNOWN_KEY(key, member) || strcmp(name, key) == 0
+
+static bool schemaIsSettingKey(const char* name) {
+    return false SETTINGS_FIELDS(SCHEMA_FILTER_KNOWN_KEY);
+}
+
+static bool jsonIsWs(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * @brief Handles the scalar value of a kept member: a setting is appended to the filter output,
+ *        "time" and "noSettings" (/sync responses) are stored in the filter.
+ * @param f The filter.
+ */
+static void schemaFilterKeep(SchemaSettingsFilter* f) {
+    if (!f->keep || f->tokenLen == 0 || f->tokenLen >= sizeof(f->token)) {
+        return;
+    }
+    f->token[f->tokenLen] = '\0';
+    if (strcmp(f->key, "time") == 0) {
+        f->serverTime = strtoull(f->token, NULL, 10);
+        return;
+    }
+    if (strcmp(f->key, "noSettings") == 0) {
+        f->noSettings = (strcmp(f->token, "true") == 0);
+        return;
+    }
+    size_t room = sizeof(f->out) - f->outLen;
+    int written = snprintf(&f->out[f->outLen], room, "%s\"%s\":%s", (f->outLen > 1) ? "," : "", f->key, f->token);
+    if (written > 0 && (size_t)written < room - 1) { /* Room left for the closing brace */
+        f->outLen += written;
+    } else {
+        f->out[f->outLen] = '\0';
+    }
+}
+
+/**
+ * @brief Starts filtering a new document.
+ * @param f The filter.
+ */
+void schemaFilterBegin(SchemaSettingsFilter* f) {
+    f->out[0] = '{';
+    f->out[1] = '\0';
+    f->outLen = 1;
+    f->tokenLen = 0;
+    f->state = FILTER_START;
+    f->depth = 0;
+    f->escape = false;
+    f->inString = false;
+    f->keep = false;
+    f->hasError = false;
+    f->noSettings = false;
+    f->serverTime = 0;
+}
+
+/**
+ * @brief Feeds the next piece of the document, pieces may split it anywhere.
+ * @param f The filter.
+ * @param data The piece.
+ * @param len Length of the piece.
+ */
+void schemaFilterFeed(SchemaSettingsFilter* f, const char* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        char c = data[i];
+        switch (f->state) {
+            case FILTER_START:
+                if (!jsonIsWs(c)) {
+                    f->state = (c == '{') ? FILTER_KEY_OR_END : FILTER_INVALID;
+                }
+                break;
+
+            case FILTER_KEY_OR_END:
+                if (c == '"') {
+                    f->tokenLen = 0;
+                    f->escape = false;
+                    f->state = FILTER_KEY;
+                } else if (c == '}') {
+                    f->state = FILTER_DONE;
+                } else if (!jsonIsWs(c)) {
+                    f->state = FILTER_INVALID;
+                }
+                break;
+
+            case FILTER_KEY:
+                if (c == '"' && !f->escape) {
+                    /* Keys that did not fit, or with escapes, cannot be known keys */
+                    f->keep = false;
+                    f->key[0] = '\0';
+                    if (f->tokenLen < sizeof(f->token)) {
+                        memcpy(f->key, f->token, f->tokenLen);
+                        f->key[f->tokenLen] = '\0';
+                        f->keep = schemaIsSettingKey(f->key) || strcmp(f->key, "time") == 0 ||
+                                  strcmp(f->key, "noSettings") == 0;
+                        f->hasError |= (strcmp(f->key, "error") == 0);
+                    }
+                    f->state = FILTER_COLON;
+                } else {
+                    f->escape = (c == '\\') && !f->escape;
+                    if (f->tokenLen < sizeof(f->token)) {
+                        f->token[f->tokenLen++] = c; /* Too long when it reaches the size */
+                    }
+                }
+                break;
+
+            case FILTER_COLON:
+                if (c == ':') {
+                    f->state = FILTER_VALUE;
+                } else if (!jsonIsWs(c)) {
+                    f->state = FILTER_INVALID;
+                }
+                break;
+
+            case FILTER_VALUE:
+                if (c == '"') {
+                    f->escape = false;
+                    f->state = FILTER_STRING;
+                } else if (c == '{' || c == '[') {
+                    f->depth = 1;
+                    f->escape = false;
+                    f->inString = false;
+                    f->state = FILTER_NESTED;
+                } else if (c == ',' || c == '}' || c == ']' || c == ':') {
+                    f->state = FILTER_INVALID;
+                } else if (!jsonIsWs(c)) {
+                    f->token[0] = c;
+                    f->tokenLen = 1;
+                    f->state = FILTER_SCALAR;
+                }
+                break;
+
+            case FILTER_SCALAR:
+                if (c == ',' || c == '}' || jsonIsWs(c)) {
+                    schemaFilterKeep(f);
+                    f->state = (c == ',') ? FILTER_KEY_OR_END : (c == '}') ? FILTER_DONE : FILTER_AFTER_VALUE;
+                } else if (f->tokenLen < sizeof(f->token)) {
+                    f->token[f->tokenLen++] = c; /* Too long when it reaches the size, then dropped */
+                }
+                break;
+
+            case FILTER_STRING:
+                if (c == '"' && !f->escape) {
+                    f->state = FILTER_AFTER_VALUE;
+                }
+                f->escape = (c == '\\') && !f->escape;
+                break;
+
+            case FILTER_NESTED:
+                if (f->inString) {
+                    f->inString = (c != '"') || f->escape;
+                    f->escape = (c == '\\') && !f->escape;
+                } else if (c == '"') {
+                    f->inString = true;
+                } else if (c == '{' || c == '[') {
+                    if (f->depth == UINT8_MAX) {
+                        f->state = FILTER_INVALID;
+                    }
+                    f->depth++;
+                } else if ((c == '}' || c == ']') && --f->depth == 0) {
+                    f->state = FILTER_AFTER_VALUE;
+                }
+                break;
+
+            case FILTER_AFTER_VALUE:
+                if (c == ',') {
+                    f->state = FILTER_KEY_OR_END;
+                } else if (c == '}') {
+                    f->state = FILTER_DONE;
+                } else if (!jsonIsWs(c)) {
+                    f->state = FILTER_INVALID;
+                }
+                break;
+
+            case FILTER_DONE:
+                if (!jsonIsWs(c)) {
+                    f->state = FILTER_INVALID;
+                }
+                break;
+
+            default:
+                return; /* Nothing more to learn from the rest */
+        }
+    }
+}
+
+/**
+ * @brief Ends the document and closes the filtered object.
+ * @param f The filter.
+ * @return True if the document was a complete, well formed object. f->out then holds its settings members.
+ */
+bool schemaFilterEnd(SchemaSettingsFilter* f) {
+    if (f->state != FILTER_DONE) {
+        return false;
+    }
+    f->out[f->outLen++] = '}';
+    f->out[f->outLen] = '\0';
+    return true;
+}
@@ -2,187 +2,664 @@
 #include <HTTPClient.h>
 #include "LogMgr.h"
 #include "ProcessMgr.h"
-#include <ArduinoJson.h>
+#include "TelemetryMgr.h"
+#include "TelemetryLog.h"
+#include "SchemaCodec.h"
+#include "ClockMgr.h"
 #include <WiFi.h> 
 
+/* Payload buffers, only used by the server task. The batch buffer is sized for the larger JSON encoding. */
+static SchemaSettingsFilter settingsFilter; /* Settings responses are filtered as they arrive, never buffered whole */
+static char settingsPayloadBuffer[SCHEMA_SETTINGS_JSON_SIZE];
+static uint8_t batchPayloadBuffer[SCHEMA_BATCH_HEADER_SIZE + TELEMETRY_BATCH_SIZE * SCHEMA_SAMPLE_JSON_SIZE];
+static char channelMessageBuffer[SERVER_SETTINGS_RESPONSE_SIZE];
+static char deferredSettings[SERVER_SETTINGS_RESPONSE_SIZE]; /* Settings received while the user was editing them */
+static size_t deferredSettingsLen = 0;                        /* 0 when none */
+static SystemData editBase;                                   /* Settings when the user started editing them */
+static bool editBaseValid = false;
+
+static const char* const serverOpNames[SERVER_OP_COUNT] = {
+    "Settings upload", "Sync", "Telemetry upload", "Telemetry backfill"
+};
+
+/* Operation scheduler state, only used by the server task */
+static uint8_t pendingOps = 0;                    /* Bit (1 << ServerOp) per requested operation */
+static ServerOp activeOp = SERVER_OP_COUNT;       /* Operation in progress, SERVER_OP_COUNT when idle */
+static bool activeOnChannel = false;              /* Waiting for a WebSocket acknowledgement instead of an HTTP response */
+static uint32_t activeStartTime = 0;
+static int64_t activeStartUs = 0;                 /* Device clock when the operation started */
+static int64_t activeFirstByteUs = 0;             /* Device clock when its response started arriving, 0 before */
+static uint32_t activeStartHeap = 0;              /* Free heap when the operation started */
+static uint32_t activeMinHeap = 0;                /* Lowest free heap seen while it was in progress */
+static uint16_t activeLiveCount = 0;              /* Buffered samples carried by the operation in progress */
+static uint32_t activeFirstSeq = 0;               /* First and last sample it carries, buffered or logged */
+static uint32_t activeLastSeq = 0;
+static uint16_t activeRecords = 0;                /* Log records of the backfill batch in progress */
+static uint32_t lastBackfillTime = 0;
+static uint32_t lastSyncTime = 0;                 /* Last successful /sync exchange */
+static bool synced = false;
+static uint32_t retainedWaitStart = 0;            /* When the MQTT retained settings started to be awaited */
+static bool retainedWait = false;
+static ServerOpStats opStats[SERVER_OP_COUNT];
+
 /**
- * @brief Fetch updated settings from the server and update the SystemData structure.
- * @param data Pointer to the SystemData structure to update.
+ * @brief How an operation ended.
  */
-void fetchUpdatedSettings(SystemData* data) {
-    uint64_t chipId = ESP.getEfuseMac();
-    char chipIdStr[18];
-    snprintf(chipIdStr, sizeof(chipIdStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-        (uint8_t)(chipId >> 40),
-        (uint8_t)(chipId >> 32),
-        (uint8_t)(chipId >> 24),
-        (uint8_t)(chipId >> 16),
-        (uint8_t)(chipId >> 8),
-        (uint8_t)chipId);
-
-    const char* serverUrl = data->SrvClient->getServerUrl();
-    String fullUrl = String(serverUrl) + "getSettings?chipId=" + chipIdStr;
-
-    HTTPClient http;
-    http.begin(fullUrl);
-    http.setTimeout(5000);
-
-    int httpResponseCode = http.GET();
-    if (httpResponseCode > 0) {
-        String response = http.getString();
-        LogSerial("Fetched updated settings: ", false);
-        LogSerialn(response, false);
-
-        /* Parse JSON response */
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, response);
-        if (!error) {
-            if (doc["maxLevel"].is<int>()) {
-                data->maxLevelPercentage = doc["maxLevel"];
-            }
-            if (doc["minLevel"].is<int>()) {
-                data->minLevelPercentage = doc["minLevel"];
-            }
-            if (doc["hotTemperature"].is<int>()) {
-                data->hotTemperature = doc["hotTemperature"];
-            }
-            if (doc["lowHumidity"].is<int>()) {
-                data->lowHumidity = doc["lowHumidity"];
-            }
+enum ServerOpResult {
+    SERVER_OP_DONE,       /* Accepted by the server */
+    SERVER_OP_FAILED,     /* No answer, a server error or a timeout: retried after a backoff */
+    SERVER_OP_REJECTED,   /* Payload refused by the server (400, 413): it would be refused again */
+};
+static uint8_t opRetryLevel[SERVER_OP_COUNT];     /* Consecutive failures of each operation */
+static uint32_t opRetryTime[SERVER_OP_COUNT];     /* When it failed last */
+static uint32_t opRetryDelay[SERVER_OP_COUNT];    /* Wait after that failure before it is started again */
+
+/**
+ * @brief Updates the retry backoff of an operation after an attempt. Each failure doubles the wait before the
+ *        next attempt, from SERVER_OP_RETRY_BASE_MS up to SERVER_OP_RETRY_MAX_MS, with jitter so devices that
+ *        failed together do not retry together. A success resets it.
+ *        The endpoint breakers only open after several failures, this keeps a failing batch from being sent
+ *        again on every poll in the meantime.
+ * @param op The operation.
+ * @param success True if the attempt succeeded.
+ */
+static void updateRetryBackoff(ServerOp op, bool success) {
+    if (success) {
+        opRetryLevel[op] = 0;
+        return;
+    }
+    uint32_t nominal = SERVER_OP_RETRY_BASE_MS << min<uint8_t>(opRetryLevel[op], 16);
+    if (nominal > SERVER_OP_RETRY_MAX_MS) {
+        nominal = SERVER_OP_RETRY_MAX_MS;
+    }
+    opRetryLevel[op] += (opRetryLevel[op] < UINT8_MAX) ? 1 : 0;
+    opRetryDelay[op] = nominal / 2 + esp_random() % (nominal / 2 + 1);
+    opRetryTime[op] = millis();
+    LogSerialn(String(serverOpNames[op]) + " retry in " + String(opRetryDelay[op]) + " ms", true);
+}
+
+/**
+ * @brief Checks if the retry backoff of an operation has elapsed.
+ * @param op The operation.
+ * @return True if it may be started.
+ */
+static bool opRetryDue(ServerOp op) {
+    return (opRetryLevel[op] == 0) || (millis() - opRetryTime[op] >= opRetryDelay[op]);
+}
+
+/**
+ * @brief Queues a requested operation again after it failed, it is retried once its backoff elapsed.
+ *        Telemetry and backfill need not be requested, they are started again while samples are waiting.
+ * @param op The operation.
+ */
+static void requeueFailedOp(ServerOp op) {
+    if (op == SERVER_OP_SETTINGS_SEND || op == SERVER_OP_SYNC) {
+        pendingOps |= (1 << op);
+    }
+}
+
+/**
+ * @brief Ends the operation in progress: updates its latency statistics and, once the server has
+ *        accepted the samples it carried, removes them from their buffer. Samples the server rejected
+ *        are removed too and logged, resending them would block the ones behind them.
+ * @param result How the operation ended.
+ */
+static void completeOp(ServerOpResult result) {
+    bool success = (result == SERVER_OP_DONE);
+    ServerOpStats& stats = opStats[activeOp];
+    stats.lastMs = millis() - activeStartTime;
+    stats.totalMs += stats.lastMs;
+    stats.maxMs = (stats.lastMs > stats.maxMs) ? stats.lastMs : stats.maxMs;
+    stats.count++;
+    stats.failures += success ? 0 : 1;
+    stats.rejections += (result == SERVER_OP_REJECTED) ? 1 : 0;
+    uint32_t heapUsed = activeStartHeap - min(activeMinHeap, activeStartHeap);
+    stats.maxHeapBytes = (heapUsed > stats.maxHeapBytes) ? heapUsed : stats.maxHeapBytes;
+    LogSerialn(String(serverOpNames[activeOp]) + (success ? " done in " : " failed after ") + String(stats.lastMs) +
+               " ms, peak heap use " + String(heapUsed) + " bytes", true);
+    updateRetryBackoff(activeOp, success);
+
+    bool carriesSamples = (activeOp == SERVER_OP_BACKFILL) ? (activeRecords > 0) : (activeLiveCount > 0);
+    if (result == SERVER_OP_REJECTED && carriesSamples) {
+        LogSerialn(String(serverOpNames[activeOp]) + " rejected by the server, dropping samples " +
+                   String(activeFirstSeq) + ".." + String(activeLastSeq), true);
+    }
+    if (result == SERVER_OP_FAILED) {
+        requeueFailedOp(activeOp);
+    }
+    if (result != SERVER_OP_FAILED && activeOp == SERVER_OP_BACKFILL) {
+        telemetryLogDrop(activeRecords);
+    } else if (result != SERVER_OP_FAILED && activeLiveCount > 0) {
+        telemetryDrop(activeLastSeq);
+    }
+    activeOp = SERVER_OP_COUNT;
+    activeOnChannel = false;
+}
+
+/**
+ * @brief Adjusts the device clock with the server time carried by a channel acknowledgement.
+ * @param message The null terminated JSON acknowledgement.
+ * @param len Length of the message.
+ */
+static void updateClockFromAck(const char* message, size_t len) {
+    SchemaSettingsFilter ack;
+    int64_t receivedUs = clockNowUs();
+
+    schemaFilterBegin(&ack);
+    schemaFilterFeed(&ack, message, len);
+    if (schemaFilterEnd(&ack) && ack.serverTime != 0) {
+        clockUpdate(ack.serverTime, receivedUs, receivedUs - activeStartUs);
+    }
+}
+
+/**
+ * @brief Checks if the user is editing the settings on the device.
+ * @param data Pointer to the SystemData structure.
+ * @return True while a settings menu is shown.
+ */
+static bool settingsBeingEdited(const SystemData* data) {
+    return (data->currentDisplayDataSelec == SCREEN_LVL_SETT_MENU) || (data->currentDisplayDataSelec == SCREEN_TEMP_HUM_SETT_MENU);
+}
+
+/**
+ * @brief Keeps settings received while the user is editing them, they are merged by endSettingsEdit().
+ *        A later document replaces an earlier one, each carries the full settings.
+ * @param data Pointer to the SystemData structure.
+ * @param settings The settings JSON object.
+ * @param len Length of the object.
+ */
+static void deferSettings(SystemData* data, const char* settings, size_t len) {
+    if (len >= sizeof(deferredSettings)) {
+        LogSerialn("Settings received while editing are too large to keep", true);
+        return;
+    }
+    if (!editBaseValid) {
+        beginSettingsEdit(data); /* Editing started while the server task was not watching */
+    }
+    memcpy(deferredSettings, settings, len);
+    deferredSettings[len] = '\0';
+    deferredSettingsLen = len;
+    LogSerialn("Settings received while editing, merged once the user is done", true);
+}
+
+/**
+ * @brief Records the settings the user starts editing from, so that settings received meanwhile can be merged.
+ *        Call it when a settings menu is entered.
+ * @param data Pointer to the SystemData structure.
+ */
+void beginSettingsEdit(SystemData* data) {
+    editBase = *data;
+    editBaseValid = true;
+}
+
+#define SERVER_MERGE_SETTING(key, member) \
+    if (data->member == editBase.member) { \
+        data->member = received.member; \
+    }
+
+/**
+ * @brief Merges the settings received while the user was editing, then uploads the result.
+ *        Each setting the user changed keeps the user's value, the others take the received value.
+ *        Call it when a settings menu is left.
+ * @param data Pointer to the SystemData structure.
+ */
+void endSettingsEdit(SystemData* data) {
+    if (deferredSettingsLen > 0 && editBaseValid) {
+        SystemData received = editBase;
+        if (schemaParseSettings(deferredSettings, deferredSettingsLen, &received) < 0) {
+            LogSerialn("Failed to parse settings JSON", true);
         } else {
-            LogSerial("Failed to parse settings JSON: ", true);
-            LogSerialn(error.c_str(), true);
+            SETTINGS_FIELDS(SERVER_MERGE_SETTING)
+            LogSerialn("Merged the settings received while editing", true);
         }
+    }
+    deferredSettingsLen = 0;
+    editBaseValid = false;
+    if (settingsBeingEdited(data)) {
+        beginSettingsEdit(data); /* Moved on to the other settings menu */
+    }
+    requestServerOp(SERVER_OP_SETTINGS_SEND);
+}
+
+/**
+ * @brief Handles a message pushed by the server over the WebSocket channel.
+ *        Acknowledgements complete the batch upload waiting for them and carry the server time. An error reply fails the
+ *        batch, it is retried after a backoff unless its status says the payload is bad. Settings are applied at once, or merged when
+ *        the user is done if they are being edited on the device.
+ * @param data Pointer to the SystemData structure to update.
+ * @param message The null terminated JSON message.
+ * @param len Length of the message.
+ */
+static void handleChannelMessage(SystemData* data, const char* message, size_t len) {
+    if (schemaHasKey(message, len, "ack")) {
+        if (activeOnChannel) {
+            updateClockFromAck(message, len);
+            completeOp(SERVER_OP_DONE);
+        }
+        return; /* Otherwise a late acknowledgement of a batch already sent again over HTTP */
+    }
+    if (schemaHasKey(message, len, "error")) {
+        uint32_t status = 0;
+        schemaGetUint(message, len, "status", &status);
+        LogSerial(activeOnChannel ? "SensActHistory batch rejected: " : "Server channel error: ", true);
+        LogSerialn(message, true);
+        if (activeOnChannel) {
+            /* Same classification as an HTTP response, a reply without status is retried */
+            completeOp(ServerClient::isPayloadRejected((int)status) ? SERVER_OP_REJECTED : SERVER_OP_FAILED);
+        }
+        return;
+    }
+    if (settingsBeingEdited(data)) {
+        deferSettings(data, message, len);
+        return;
+    }
+
+    LogSerial("Settings pushed by server: ", true);
+    LogSerialn(message, true);
+    if (schemaParseSettings(message, len, data) < 0) {
+        LogSerialn("Failed to parse settings JSON", true);
+    }
+    data->SrvClient->clearSettingsVersion(); /* The HTTP fallback downloads them again */
+}
+
+/**
+ * @brief Keeps the broker connection open and applies the settings published on the settings topic.
+ *        When the broker has no retained settings for this device yet, the current ones are published.
+ * @param data Pointer to the SystemData structure.
+ */
+static void serviceMqtt(SystemData* data) {
+    size_t len;
+    if (data->SrvClient->maintainMqtt()) {
+        retainedWait = true;
+        retainedWaitStart = millis();
+    }
+    while (data->SrvClient->mqttReceiveSettings(channelMessageBuffer, sizeof(channelMessageBuffer), &len, 0) == 1) {
+        retainedWait = false;
+        handleChannelMessage(data, channelMessageBuffer, len);
+    }
+    if (retainedWait && (millis() - retainedWaitStart >= SERVER_MQTT_RETAINED_WAIT_MS)) {
+        retainedWait = false;
+        LogSerialn("No retained settings on the broker, publishing the current ones...", true);
+        requestServerOp(SERVER_OP_SETTINGS_SEND);
+    }
+}
+
+/**
+ * @brief Keeps the WebSocket channel, or the MQTT broker connection, open and handles the settings pushed over it.
+ *        Call it periodically while WiFi is connected.
+ * @param data Pointer to the SystemData structure.
+ */
+void serviceServerChannel(SystemData* data) {
+    size_t len;
+    if (SERVER_TRANSPORT_MQTT) {
+        serviceMqtt(data);
+        return;
+    }
+    if (data->SrvClient->maintainChannel()) {
+        requestServerOp(SERVER_OP_SYNC); /* Catch up with changes made while the channel was closed */
+    }
+    while (data->SrvClient->channelReceive(channelMessageBuffer, sizeof(channelMessageBuffer), &len, 0) == 1) {
+        handleChannelMessage(data, channelMessageBuffer, len);
+    }
+}
+
+/**
+ * @brief Handles the response of a /sync exchange. It answers any pending sync request and carries the server
+ *        time. Settings are only included when they changed; they are applied unless the user is editing them
+ *        on the device. When the server has no settings for this device, the current ones are uploaded as defaults.
+ * @param data Pointer to the SystemData structure to update.
+ * @param httpResponseCode HTTP response code.
+ * @return True if the server stored the samples and answered as expected.
+ */
+static bool handleSyncResponse(SystemData* data, int httpResponseCode) {
+    bool complete = schemaFilterEnd(&settingsFilter);
+
+    if (httpResponseCode != HTTP_CODE_OK || !complete || settingsFilter.hasError) {
+        LogSerial("Sync response: ", true);
+        LogSerialn(String(httpResponseCode) + " (" + String(data->SrvClient->getResponseLength()) + " bytes)", true);
+        data->SrvClient->clearSettingsVersion(); /* Download the settings with the next exchange */
+        return false;
+    }
+
+    pendingOps &= ~(1 << SERVER_OP_SYNC);
+    lastSyncTime = millis();
+    synced = true;
+    if (settingsFilter.serverTime != 0) {
+        clockUpdate(settingsFilter.serverTime, activeFirstByteUs, activeFirstByteUs - activeStartUs);
+    }
+
+    if (settingsFilter.noSettings) {
+        LogSerialn("Sending default settings to the backend...", true);
+        requestServerOp(SERVER_OP_SETTINGS_SEND);
+        return true;
+    }
+    if (settingsFilter.outLen <= 2) {
+        return true; /* "{}": not modified */
+    }
+    if (settingsBeingEdited(data)) {
+        deferSettings(data, settingsFilter.out, settingsFilter.outLen);
+        return true;
+    }
+
+    LogSerial("Fetched updated settings: ", false);
+    LogSerialn(settingsFilter.out, false);
+    if (schemaParseSettings(settingsFilter.out, settingsFilter.outLen, data) < 0) {
+        LogSerialn("Failed to parse settings JSON", true);
+        data->SrvClient->clearSettingsVersion(); /* Download them again next time */
+    }
+    return true; /* The samples were stored either way */
+}
+
+/**
+ * @brief Feeds a piece of a settings response to the settings filter, see HttpBodyCallback.
+ */
+static void settingsFilterBody(const char* data, size_t len, void* ctx) {
+    if (activeFirstByteUs == 0) {
+        activeFirstByteUs = clockNowUs();
+    }
+    schemaFilterFeed((SchemaSettingsFilter*)ctx, data, len);
+}
+
+/**
+ * @brief Encodes a telemetry batch into the batch payload buffer.
+ *        Each sample carries its device time, the batch the current device time and wall time estimate, from which
+ *        the server derives the wall time of every sample, see schemaWriteBatchJson().
+ * @param samples Samples to encode, oldest first.
+ * @param count Number of samples, may be 0.
+ * @param contentType[OUT] "application/cbor" or "application/json".
+ * @return The payload length, 0 if it did not fit.
+ */
+static size_t encodeBatch(const TelemetrySample* samples, uint16_t count, const char** contentType) {
+    uint32_t encodeStart = micros();
+    ClockEstimate clock;
+    size_t len;
+
+    clockEstimate(&clock);
+
+    if (SERVER_TELEMETRY_CBOR) {
+        len = schemaWriteBatchCbor(batchPayloadBuffer, sizeof(batchPayloadBuffer), samples, count, clock);
+        *contentType = "application/cbor";
     } else {
-        LogSerial("Failed to fetch updated settings: ", true);
-        LogSerialn(http.errorToString(httpResponseCode).c_str(), true);
+        len = schemaWriteBatchJson((char*)batchPayloadBuffer, sizeof(batchPayloadBuffer), samples, count, clock);
+        *contentType = "application/json";
     }
 
-    http.end();
+    if (len == 0) {
+        LogSerialn("Batch payload buffer overflow", true);
+    } else {
+        LogSerialn("Batch encoded as " + String(*contentType) + ": " + String(len) + " bytes in " + String(micros() - encodeStart) + " us", true);
+    }
+    return len;
 }
 
 /**
- * @brief Checks if the 'settings' JSON package exists in the database for this device.
+ * @brief Starts a /sync exchange with the encoded batch, the response is filtered as it arrives.
  * @param data Pointer to the SystemData structure.
- * @return True if the json settings packet exists, false otherwise.
- */
-bool checkJsonSettingsExistence(SystemData* data) {
-    uint64_t chipId = ESP.getEfuseMac();
-    char chipIdStr[18];
-    snprintf(chipIdStr, sizeof(chipIdStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-        (uint8_t)(chipId >> 40),
-        (uint8_t)(chipId >> 32),
-        (uint8_t)(chipId >> 24),
-        (uint8_t)(chipId >> 16),
-        (uint8_t)(chipId >> 8),
-        (uint8_t)chipId);
-
-    const char* serverUrl = data->SrvClient->getServerUrl();
-    String fullUrl = String(serverUrl) + "getSettings?chipId=" + chipIdStr;
-
-    HTTPClient http;
-    http.begin(fullUrl);
-    http.setTimeout(5000);
-
-    int httpResponseCode = http.GET();
-    if (httpResponseCode > 0) {
-        String response = http.getString();
-        LogSerial("Settings existence check response: ", true);
-        LogSerialn(response, true);
-
-        /* Parse JSON response to check for error */
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, response);
-        if (!error) {
-            if (!doc["error"].isNull()) {
-                return false;
-            }
-        }
-        /* If response is not empty and not "null", settings exist */
-        if (!response.isEmpty() && response != "null") {
-            return true;
-        }
+ * @param len Length of the encoded batch.
+ * @param contentType Content-Type of the encoded batch.
+ * @return True if the exchange was started.
+ */
+static bool startSync(SystemData* data, size_t len, const char* contentType) {
+    schemaFilterBegin(&settingsFilter);
+    return data->SrvClient->beginSync(batchPayloadBuffer, len, contentType, settingsFilterBody, &settingsFilter);
+}
+
+/**
+ * @brief Encodes samples and starts uploading them.
+ *        The WebSocket channel is used while it is open, a /sync exchange otherwise, or the MQTT telemetry topic if selected.
+ * @param data Pointer to the SystemData structure.
+ * @param samples Samples to upload, oldest first.
+ * @param count Number of samples.
+ * @return True if the upload was started, or already completed for MQTT.
+ */
+static bool startBatchUpload(SystemData* data, const TelemetrySample* samples, uint16_t count) {
+    const char* contentType;
+    size_t len = encodeBatch(samples, count, &contentType);
+    if (len == 0) {
+        return false;
+    }
+
+    if (SERVER_TRANSPORT_MQTT) {
+        completeOp(data->SrvClient->mqttPublishTelemetry(batchPayloadBuffer, len) ? SERVER_OP_DONE : SERVER_OP_FAILED);
+        return true;
+    }
+    if (data->SrvClient->channelConnected() && data->SrvClient->channelSend(batchPayloadBuffer, len, SERVER_TELEMETRY_CBOR)) {
+        activeOnChannel = true; /* Completed by the acknowledgement, see handleChannelMessage() */
+        return true;
+    }
+    return startSync(data, len, contentType);
+}
+
+/**
+ * @brief Starts uploading the current settings, or publishes them retained when MQTT is selected.
+ * @param data Pointer to the SystemData structure.
+ * @return True if the upload was started, or already completed for MQTT.
+ */
+static bool startSettingsUpload(SystemData* data) {
+    size_t len;
+    if (SERVER_TRANSPORT_MQTT) {
+        len = schemaWriteSettingsObjectJson(settingsPayloadBuffer, sizeof(settingsPayloadBuffer), data);
     } else {
-        LogSerial("Failed to check settings existence: ", true);
-        LogSerialn(http.errorToString(httpResponseCode).c_str(), true);
+        len = schemaWriteSettingsJson(settingsPayloadBuffer, sizeof(settingsPayloadBuffer), data);
+    }
+    if (len == 0) {
+        LogSerialn("Settings payload buffer overflow", true);
+        return false;
     }
 
-    http.end();
-    return false;
+    if (SERVER_TRANSPORT_MQTT) {
+        /* Retained, new subscribers get it too */
+        completeOp(data->SrvClient->mqttPublishSettings(settingsPayloadBuffer, len) ? SERVER_OP_DONE : SERVER_OP_FAILED);
+        return true;
+    }
+    return data->SrvClient->beginSettingsUpload(settingsPayloadBuffer, len);
+}
+
+/**
+ * @brief Returns the circuit breaker state of the HTTP endpoint an operation would use.
+ *        Operations carried by MQTT or by the open WebSocket channel are never held back.
+ * @param data Pointer to the SystemData structure.
+ * @param op The operation.
+ * @return BREAKER_OPEN while the operation has to wait, BREAKER_HALF_OPEN if it would be the probe.
+ */
+static BreakerState opEndpointState(SystemData* data, ServerOp op) {
+    if (SERVER_TRANSPORT_MQTT) {
+        return BREAKER_CLOSED;
+    }
+    switch (op) {
+        case SERVER_OP_SETTINGS_SEND:
+            return data->SrvClient->checkEndpoint(SERVER_REQ_SETTINGS_UPLOAD);
+        case SERVER_OP_SYNC:
+            return data->SrvClient->checkEndpoint(SERVER_REQ_SYNC);
+        default:
+            return data->SrvClient->channelConnected() ? BREAKER_CLOSED : data->SrvClient->checkEndpoint(SERVER_REQ_SYNC);
+    }
 }
 
 /**
- * @brief Packs and sends sensor and actuator data in a single JSON under the ESP chip id.
+ * @brief Starts an operation.
+ *        A probe, sent while the /sync breaker is half-open, carries a single sample.
  * @param data Pointer to the SystemData structure.
+ * @param op The operation.
+ * @return True if it was started, false if there was nothing to do or it could not be started.
  */
-void sendSensActHistory(SystemData* data) {
-    uint64_t chipId = ESP.getEfuseMac();
-    char chipIdStr[18];
-    snprintf(chipIdStr, sizeof(chipIdStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-        (uint8_t)(chipId >> 40),
-        (uint8_t)(chipId >> 32),
-        (uint8_t)(chipId >> 24),
-        (uint8_t)(chipId >> 16),
-        (uint8_t)(chipId >> 8),
-        (uint8_t)chipId);
+static bool startOp(SystemData* data, ServerOp op) {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    uint16_t maxSamples = (opEndpointState(data, op) == BREAKER_HALF_OPEN) ? 1 : TELEMETRY_BATCH_SIZE;
+    const char* contentType;
+    uint16_t count;
+    size_t len;
+    bool attempted = true;   /* False when there was nothing to send */
+    bool started = false;
+
+    activeOp = op;
+    activeOnChannel = false;
+    activeStartTime = millis();
+    activeStartUs = clockNowUs();
+    activeFirstByteUs = 0;
+    activeStartHeap = ESP.getFreeHeap();
+    activeMinHeap = activeStartHeap;
+    activeLiveCount = 0;
+    activeRecords = 0;
+
+    switch (op) {
+        case SERVER_OP_SYNC:
+            /* With MQTT the retained settings topic takes the place of this exchange */
+            if (SERVER_TRANSPORT_MQTT) {
+                attempted = false;
+                break;
+            }
+            /* Buffered samples go along, possibly none */
+            activeLiveCount = telemetryPeek(samples, maxSamples);
+            activeFirstSeq = (activeLiveCount > 0) ? samples[0].seq : 0;
+            activeLastSeq = (activeLiveCount > 0) ? samples[activeLiveCount - 1].seq : 0;
+            len = encodeBatch(samples, activeLiveCount, &contentType);
+            started = (len > 0) && startSync(data, len, contentType);
+            break;
 
-    JsonDocument doc; /* Use static allocation as you requested */
+        case SERVER_OP_SETTINGS_SEND:
+            started = startSettingsUpload(data);
+            break;
 
-    /* Create root object with chipId as key */
-    JsonObject root = doc[chipIdStr].to<JsonObject>();
+        case SERVER_OP_TELEMETRY:
+            activeLiveCount = telemetryPeek(samples, maxSamples);
+            attempted = (activeLiveCount > 0);
+            if (attempted) {
+                activeFirstSeq = samples[0].seq;
+                activeLastSeq = samples[activeLiveCount - 1].seq;
+                started = startBatchUpload(data, samples, activeLiveCount);
+            }
+            break;
 
-    /* Pack sensor data */
-    JsonObject sensorData = root["sensorData"].to<JsonObject>();
-    sensorData["lvl"] = data->levelPercentage;
-    sensorData["tmp"] = data->sensorMgr->getTemperature();
-    sensorData["hum"] = data->sensorMgr->getHumidity();
-    sensorData["ldr"] = data->sensorMgr->getLightSensorValue() ? "1" : "0";
-    sensorData["pir"] = data->PirPresenceDetected ? "1" : "0";
-    sensorData["well"] = data->sensorMgr->getWellSensorValue() ? "1" : "0";
+        case SERVER_OP_BACKFILL:
+            while ((count = telemetryLogPeek(samples, maxSamples, &activeRecords)) == 0 && activeRecords > 0) {
+                telemetryLogDrop(activeRecords); /* Only unusable records were read */
+            }
+            attempted = (count > 0);
+            if (attempted) {
+                activeFirstSeq = samples[0].seq;
+                activeLastSeq = samples[count - 1].seq;
+                started = startBatchUpload(data, samples, count);
+            }
+            break;
 
-    /* Pack actuator data */
-    JsonObject actuatorData = root["actuatorData"].to<JsonObject>();
-    actuatorData["lmp"] = data->actuatorMgr->getLamp()->getOutstate() ? "1" : "0";
-    actuatorData["pmp"] = data->actuatorMgr->getPump()->getOutstate() ? "1" : "0";
-    actuatorData["irr"] = data->actuatorMgr->getIrrigator()->getOutstate() ? "1" : "0";
+        default:
+            attempted = false;
+            break;
+    }
 
-    String payload;
-    serializeJson(doc, payload);
+    if (!started && activeOp == op) {
+        if (attempted) {
+            updateRetryBackoff(op, false); /* Could not be encoded or sent, not retried on every poll either */
+            requeueFailedOp(op);
+        }
+        activeOp = SERVER_OP_COUNT;
+    }
+    return started;
+}
 
-    data->SrvClient->sendSensActHistoryPayload(payload);
+/**
+ * @brief Queues an operation, it is started by serviceServerRequests() once the connection is free.
+ *        A requested sync is answered by any /sync exchange, telemetry uploads over HTTP included.
+ * @param op The operation.
+ */
+void requestServerOp(ServerOp op) {
+    pendingOps |= (1 << op);
 }
 
 /**
- * @brief Sends manual systems settings to the server.
+ * @brief Advances the operation in progress without waiting for the network, and starts the next one when the
+ *        connection is free: requested settings uploads and syncs first, then telemetry when an upload is due,
+ *        then at most one backfill batch every TELEMETRY_BACKFILL_INTERVAL_MS. Operations whose endpoint breaker
+ *        is open, or that failed and wait for their retry backoff, are skipped, their samples stay buffered.
+ *        Call it periodically while WiFi is connected, more often while serverRequestsBusy().
  * @param data Pointer to the SystemData structure.
- * @param serverUrl URL of the backend server.
- */
-void sendSystemSettings(SystemData* data) {
-    uint64_t chipId = ESP.getEfuseMac();
-    char chipIdStr[18];
-    snprintf(chipIdStr, sizeof(chipIdStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-        (uint8_t)(chipId >> 40),
-        (uint8_t)(chipId >> 32),
-        (uint8_t)(chipId >> 24),
-        (uint8_t)(chipId >> 16),
-        (uint8_t)(chipId >> 8),
-        (uint8_t)chipId);
-
-    JsonDocument doc;
-
-    /** Create root object with chipId as key */
-    JsonObject root = doc[chipIdStr].to<JsonObject>();
-
-    /** Pack settings */
-    JsonObject settings = root["settings"].to<JsonObject>();
-    settings["maxLevel"] = data->maxLevelPercentage;
-    settings["minLevel"] = data->minLevelPercentage;
-    settings["hotTemperature"] = data->hotTemperature;
-    settings["lowHumidity"] = data->lowHumidity;
-
-    String payload;
-    serializeJson(doc, payload);
-
-    data->SrvClient->sendSysSettingsPayload(payload);
+ */
+void serviceServerRequests(SystemData* data) {
+    if (activeOp != SERVER_OP_COUNT) {
+        if (activeOnChannel) {
+            if (millis() - activeStartTime >= SERVER_CHANNEL_ACK_TIMEOUT_MS) {
+                LogSerialn("No acknowledgement on the WebSocket channel", true);
+                data->SrvClient->closeChannel(); /* The next batch goes out over HTTP */
+                completeOp(SERVER_OP_FAILED);
+            }
+            return;
+        }
+
+        HttpOpState state = data->SrvClient->pollRequest();
+        activeMinHeap = min(activeMinHeap, ESP.getFreeHeap());
+        if (state == HTTP_OP_IN_PROGRESS) {
+            return;
+        }
+        int httpResponseCode = data->SrvClient->getResponseCode();
+        bool success = (state == HTTP_OP_DONE);
+        if (success && activeOp == SERVER_OP_SETTINGS_SEND) {
+            success = (httpResponseCode >= 200) && (httpResponseCode < 300);
+        } else if (success) {
+            success = handleSyncResponse(data, httpResponseCode);
+        }
+        completeOp(success ? SERVER_OP_DONE : (data->SrvClient->responseRejected() ? SERVER_OP_REJECTED : SERVER_OP_FAILED));
+    }
+
+    for (uint8_t op = 0; op < SERVER_OP_COUNT && activeOp == SERVER_OP_COUNT; ++op) {
+        if ((pendingOps & (1 << op)) && opRetryDue((ServerOp)op) && opEndpointState(data, (ServerOp)op) != BREAKER_OPEN) {
+            pendingOps &= ~(1 << op);
+            startOp(data, (ServerOp)op);
+        }
+    }
+    if (activeOp != SERVER_OP_COUNT || opEndpointState(data, SERVER_OP_TELEMETRY) == BREAKER_OPEN) {
+        return;
+    }
+
+    if (telemetryUploadDue() && opRetryDue(SERVER_OP_TELEMETRY)) {
+        LogSerialn("Sending Sensor/Actuator batch to server...", true);
+        startOp(data, SERVER_OP_TELEMETRY);
+    } else if ((millis() - lastBackfillTime >= TELEMETRY_BACKFILL_INTERVAL_MS) && (telemetryLogCount() > 0) &&
+               opRetryDue(SERVER_OP_BACKFILL)) {
+        /* Samples logged to flash while offline, one batch at a time when no live batch is due */
+        lastBackfillTime = millis();
+        LogSerialn("Sending logged Sensor/Actuator batch to server (" + String(telemetryLogCount()) + " left)...", true);
+        startOp(data, SERVER_OP_BACKFILL);
+    }
+}
+
+/**
+ * @brief Aborts the operation in progress, e.g. when WiFi is lost. Its samples stay buffered, and it is
+ *        queued again with the operations still waiting, they are started once the connection is back.
+ * @param data Pointer to the SystemData structure.
+ */
+void cancelServerRequests(SystemData* data) {
+    if (activeOp == SERVER_OP_COUNT) {
+        return;
+    }
+    if (!activeOnChannel) {
+        data->SrvClient->cancelRequest();
+    }
+    completeOp(SERVER_OP_FAILED);
+}
+
+/**
+ * @brief Checks if an operation is in progress.
+ * @return True while waiting for the server.
+ */
+bool serverRequestsBusy() {
+    return activeOp != SERVER_OP_COUNT;
+}
+
+/**
+ * @brief Returns the latency statistics of an operation.
+ * @param op The operation.
+ * @return Its statistics since boot.
+ */
+const ServerOpStats& getServerOpStats(ServerOp op) {
+    return opStats[op];
+}
+
+/**
+ * @brief Returns the time since the last successful /sync exchange, telemetry uploads over HTTP included.
+ * @return Age in ms, UINT32_MAX if there was none yet.
+ */
+uint32_t getServerSyncAge() {
+    return synced ? millis() - lastSyncTime : UINT32_MAX;
 }
 
@@ -0,0 +1,462 @@
+#include "TelemetryLog.h"
+#include "ClockMgr.h"
+#include "LogMgr.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#define TELEMETRY_LOG_WALL_TIME (0x01) /* Record flag: timeMs is wall time */
+
+/* One sample as stored in flash, fixed size so a record is found by its index */
+struct __attribute__((packed)) TelemetryLogRecord {
+    uint16_t bootId;          /* Boot the sample was taken in */
+    uint32_t seq;
+    uint64_t timeMs;          /* Wall time in ms since epoch with TELEMETRY_LOG_WALL_TIME, else device time in ms of boot bootId */
+    float temperature;
+    float humidity;
+    uint8_t levelPercentage;
+    uint8_t inputs;
+    uint8_t actuators;
+    uint8_t flags;            /* TELEMETRY_LOG_* flags */
+    uint16_t crc;             /* CRC-16/CCITT of the fields above, detects records torn by a reset */
+};
+
+/* Upload progress within the head segment, so records already accepted are not sent again after a reset */
+struct __attribute__((packed)) TelemetryLogHead {
+    uint64_t firstKey;        /* segmentFirstKey() of the head segment, tells if the segment is still the same */
+    uint16_t record;          /* Records of that segment already uploaded */
+};
+
+/* Wall time of a boot, relates the device time of its records to wall time once the clock was set */
+struct __attribute__((packed)) TelemetryBootAnchor {
+    uint16_t bootId;
+    uint64_t wallMs;          /* Wall time in ms since epoch when the device clock of that boot was 0, 0 if unknown */
+};
+
+static uint16_t segmentRecords[TELEMETRY_LOG_SEGMENTS]; /* Records written to each segment file */
+static uint8_t headSegment = 0;   /* Segment holding the oldest record */
+static uint16_t headRecord = 0;   /* Records of the head segment already uploaded */
+static uint8_t tailSegment = 0;   /* Segment being appended to */
+static bool tailClosed = false;   /* The next append starts a new segment */
+static uint32_t logCount = 0;
+static uint16_t bootId = 0;
+static bool logMounted = false;
+static SemaphoreHandle_t xTelemetryLogMutex = NULL;
+static TelemetryBootAnchor bootAnchors[TELEMETRY_LOG_BOOT_ANCHORS]; /* Indexed by bootId % TELEMETRY_LOG_BOOT_ANCHORS */
+
+/**
+ * @brief Computes the CRC-16/CCITT (poly 0x1021, init 0xFFFF) of a record.
+ * @param buf Pointer to the data.
+ * @param len Number of bytes.
+ * @return The CRC value.
+ */
+static uint16_t logCrc16(const uint8_t* buf, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= (uint16_t)buf[i] << 8;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Stores the wall time of this boot once the clock is set, and again when its estimate moved by more than
+ *        TELEMETRY_LOG_ANCHOR_DRIFT_MS, so records logged before the clock was set can be dated after a reset.
+ */
+static void updateBootAnchor() {
+    if (!clockSynced()) {
+        return;
+    }
+    int64_t nowUs = clockNowUs();
+    uint64_t wallMs = clockWallMs(nowUs) - (uint64_t)(nowUs / 1000);
+    TelemetryBootAnchor& anchor = bootAnchors[bootId % TELEMETRY_LOG_BOOT_ANCHORS];
+    int64_t moved = (int64_t)(wallMs - anchor.wallMs);
+    if (anchor.bootId == bootId && anchor.wallMs != 0 && moved <= TELEMETRY_LOG_ANCHOR_DRIFT_MS &&
+        moved >= -TELEMETRY_LOG_ANCHOR_DRIFT_MS) {
+        return;
+    }
+    anchor.bootId = bootId;
+    anchor.wallMs = wallMs;
+
+    Preferences prefs;
+    prefs.begin("telemetry", false);
+    prefs.putBytes("anchors", bootAnchors, sizeof(bootAnchors));
+    prefs.end();
+}
+
+/**
+ * @brief Returns the wall time of a record: stored as is, or derived from the wall time of its boot.
+ * @param record The record.
+ * @param wallMs[OUT] Wall time in ms since epoch.
+ * @return False if the record was taken in a boot whose clock was never set.
+ */
+static bool recordWallMs(const TelemetryLogRecord& record, uint64_t* wallMs) {
+    if (record.flags & TELEMETRY_LOG_WALL_TIME) {
+        *wallMs = record.timeMs;
+        return true;
+    }
+    const TelemetryBootAnchor& anchor = bootAnchors[record.bootId % TELEMETRY_LOG_BOOT_ANCHORS];
+    if (anchor.bootId != record.bootId || anchor.wallMs == 0) {
+        return false;
+    }
+    *wallMs = anchor.wallMs + record.timeMs;
+    return true;
+}
+
+/**
+ * @brief Builds the file name of a segment.
+ * @param segment Segment index.
+ * @param path[OUT] Buffer of TELEMETRY_LOG_PATH_SIZE bytes.
+ */
+static void segmentPath(uint8_t segment, char* path) {
+    snprintf(path, TELEMETRY_LOG_PATH_SIZE, "/tlm%02u.bin", segment);
+}
+
+/**
+ * @brief Reads the boot and sequence number of the first record of a segment.
+ * @param segment Segment index.
+ * @return (bootId << 32) | seq, so records sort in the order they were taken.
+ */
+static uint64_t segmentFirstKey(uint8_t segment) {
+    char path[TELEMETRY_LOG_PATH_SIZE];
+    TelemetryLogRecord record;
+    segmentPath(segment, path);
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return UINT64_MAX;
+    }
+    size_t read = file.read((uint8_t*)&record, sizeof(record));
+    file.close();
+    if (read != sizeof(record)) {
+        return UINT64_MAX;
+    }
+    return ((uint64_t)record.bootId << 32) | record.seq;
+}
+
+/**
+ * @brief Stores the upload progress within the head segment. Only partial progress needs storing: a segment fully
+ *        uploaded is erased, and the progress stored for it no longer matches the first record of the head.
+ */
+static void saveHead() {
+    TelemetryLogHead head = { segmentFirstKey(headSegment), headRecord };
+    Preferences prefs;
+    prefs.begin("telemetry", false);
+    prefs.putBytes("head", &head, sizeof(head));
+    prefs.end();
+}
+
+/**
+ * @brief Erases a segment file.
+ * @param segment Segment index.
+ */
+static void eraseSegment(uint8_t segment) {
+    char path[TELEMETRY_LOG_PATH_SIZE];
+    segmentPath(segment, path);
+    LittleFS.remove(path);
+    segmentRecords[segment] = 0;
+}
+
+/**
+ * @brief Moves the tail to the next segment. When the log is full the head segment is erased,
+ *        dropping its samples, so the log always keeps the newest ones.
+ */
+static void openNextSegment() {
+    uint8_t next = (tailSegment + 1) % TELEMETRY_LOG_SEGMENTS;
+    if (segmentRecords[next] > 0) {
+        uint16_t lost = segmentRecords[next] - ((next == headSegment) ? headRecord : 0);
+        LogSerialn("Telemetry log full, dropping " + String(lost) + " oldest samples", true);
+        logCount -= lost;
+        eraseSegment(next);
+        headSegment = (next + 1) % TELEMETRY_LOG_SEGMENTS;
+        headRecord = 0;
+    }
+    tailSegment = next;
+    tailClosed = false;
+    if (logCount == 0) {
+        headSegment = tailSegment;
+        headRecord = 0;
+    }
+}
+
+/**
+ * @brief Mounts LittleFS and finds the samples left by previous boots.
+ *        The log is a ring of append-only segment files: records are appended to the tail segment and a segment
+ *        is erased once all its records are uploaded, so every flash block is written in turn and never rewritten
+ *        in place. Call once before the tasks start.
+ */
+void telemetryLogInit() {
+    char path[TELEMETRY_LOG_PATH_SIZE];
+    uint8_t usedSegments = 0;
+
+    xTelemetryLogMutex = xSemaphoreCreateMutex();
+
+    Preferences prefs;
+    prefs.begin("telemetry", false);
+    bootId = (uint16_t)(prefs.getUInt("boot", 0) + 1);
+    prefs.putUInt("boot", bootId);
+    uint32_t format = prefs.getUInt("format", 0);
+    prefs.putUInt("format", TELEMETRY_LOG_FORMAT);
+    if (format != TELEMETRY_LOG_FORMAT || prefs.getBytes("anchors", bootAnchors, sizeof(bootAnchors)) != sizeof(bootAnchors)) {
+        memset(bootAnchors, 0, sizeof(bootAnchors));
+    }
+    prefs.end();
+
+    if (!LittleFS.begin(true)) {
+        LogSerialn("LittleFS mount failed, samples that cannot be sent are dropped", true);
+        return;
+    }
+    logMounted = true;
+
+    if (format != TELEMETRY_LOG_FORMAT) {
+        for (uint8_t i = 0; i < TELEMETRY_LOG_SEGMENTS; ++i) {
+            eraseSegment(i); /* Written with another record layout */
+        }
+    }
+
+    logCount = 0;
+    for (uint8_t i = 0; i < TELEMETRY_LOG_SEGMENTS; ++i) {
+        segmentPath(i, path);
+        segmentRecords[i] = 0;
+        if (LittleFS.exists(path)) {
+            File file = LittleFS.open(path, "r");
+            if (file) {
+                segmentRecords[i] = (uint16_t)(file.size() / sizeof(TelemetryLogRecord));
+                file.close();
+            }
+        }
+        logCount += segmentRecords[i];
+        usedSegments += (segmentRecords[i] > 0) ? 1 : 0;
+    }
+
+    /* The used segments are consecutive in the ring, the head is the one following an unused segment */
+    headSegment = 0;
+    headRecord = 0;
+    if (usedSegments == TELEMETRY_LOG_SEGMENTS) {
+        uint64_t oldest = UINT64_MAX;
+        for (uint8_t i = 0; i < TELEMETRY_LOG_SEGMENTS; ++i) {
+            uint64_t key = segmentFirstKey(i);
+            if (key < oldest) {
+                oldest = key;
+                headSegment = i;
+            }
+        }
+    } else if (usedSegments > 0) {
+        for (uint8_t i = 0; i < TELEMETRY_LOG_SEGMENTS; ++i) {
+            uint8_t previous = (i + TELEMETRY_LOG_SEGMENTS - 1) % TELEMETRY_LOG_SEGMENTS;
+            if (segmentRecords[i] > 0 && segmentRecords[previous] == 0) {
+                headSegment = i;
+                break;
+            }
+        }
+    }
+
+    /* Skip the records of the head segment uploaded before the reset */
+    TelemetryLogHead head;
+    prefs.begin("telemetry", true);
+    size_t headLen = prefs.getBytes("head", &head, sizeof(head));
+    prefs.end();
+    if (usedSegments > 0 && headLen == sizeof(head) && head.firstKey == segmentFirstKey(headSegment) &&
+        head.record < segmentRecords[headSegment]) {
+        headRecord = head.record;
+        logCount -= headRecord;
+    }
+
+    /* Appends continue in a fresh segment so a record torn by a reset is never followed by new ones */
+    tailSegment = (headSegment + ((usedSegments > 0) ? usedSegments - 1 : 0)) % TELEMETRY_LOG_SEGMENTS;
+    tailClosed = (usedSegments > 0);
+
+    LogSerialn("Telemetry log: " + String(logCount) + " samples in flash, boot " + String(bootId), true);
+}
+
+/**
+ * @brief Appends samples to the tail of the log. They are stamped with their wall time once the clock is set,
+ *        with their device time otherwise, which the wall time of their boot relates to wall time later.
+ * @param samples Samples to store, oldest first.
+ * @param count Number of samples.
+ */
+static void telemetryLogAppend(const TelemetrySample* samples, uint16_t count) {
+    char path[TELEMETRY_LOG_PATH_SIZE];
+    uint16_t written = 0;
+    bool wallTime = clockSynced();
+
+    xSemaphoreTake(xTelemetryLogMutex, portMAX_DELAY);
+    while (written < count) {
+        if (tailClosed || segmentRecords[tailSegment] >= TELEMETRY_LOG_SEGMENT_RECORDS) {
+            openNextSegment();
+        }
+
+        segmentPath(tailSegment, path);
+        File file = LittleFS.open(path, "a");
+        if (!file) {
+            LogSerialn("Telemetry log write failed, " + String(count - written) + " samples dropped", true);
+            break;
+        }
+        while (written < count && segmentRecords[tailSegment] < TELEMETRY_LOG_SEGMENT_RECORDS) {
+            const TelemetrySample& sample = samples[written];
+            TelemetryLogRecord record;
+            record.bootId = bootId;
+            record.seq = sample.seq;
+            record.timeMs = wallTime ? clockWallMs(sample.timeUs) : (uint64_t)(sample.timeUs / 1000);
+            record.temperature = sample.temperature;
+            record.humidity = sample.humidity;
+            record.levelPercentage = (uint8_t)sample.levelPercentage;
+            record.inputs = sample.inputs;
+            record.actuators = sample.actuators;
+            record.flags = wallTime ? TELEMETRY_LOG_WALL_TIME : 0;
+            record.crc = logCrc16((const uint8_t*)&record, offsetof(TelemetryLogRecord, crc));
+
+            if (file.write((const uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+                break;
+            }
+            segmentRecords[tailSegment]++;
+            logCount++;
+            written++;
+        }
+        file.close();
+        if (written < count && segmentRecords[tailSegment] < TELEMETRY_LOG_SEGMENT_RECORDS) {
+            LogSerialn("Telemetry log write failed, " + String(count - written) + " samples dropped", true);
+            tailClosed = true; /* Do not append after a partial record */
+            break;
+        }
+    }
+    xSemaphoreGive(xTelemetryLogMutex);
+}
+
+/**
+ * @brief Moves the oldest samples from the RAM ring buffer to the log when the buffer is nearly full,
+ *        or once they waited TELEMETRY_SPILL_AGE_MS, so samples that cannot be sent are kept instead of
+ *        overwritten or lost to a reset. Samples only reach flash while uploads fail, which keeps flash wear low.
+ *        Call it periodically from the task that uploads the samples, while no batch is in flight.
+ */
+void telemetryLogSpill() {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    if (!logMounted) {
+        return;
+    }
+    updateBootAnchor();
+    uint16_t count = telemetryTakeOverflow(samples, TELEMETRY_BATCH_SIZE);
+    if (count > 0) {
+        telemetryLogAppend(samples, count);
+    }
+}
+
+/**
+ * @brief Number of samples in the log waiting for upload.
+ * @return The number of logged samples.
+ */
+uint32_t telemetryLogCount() {
+    if (!logMounted) {
+        return 0;
+    }
+    xSemaphoreTake(xTelemetryLogMutex, portMAX_DELAY);
+    uint32_t count = logCount;
+    xSemaphoreGive(xTelemetryLogMutex);
+    return count;
+}
+
+/**
+ * @brief Reads the oldest logged samples without removing them, so they survive a failed upload.
+ *        Their time is converted to the device time of this boot, negative for samples of previous boots.
+ *        Records with a bad CRC, or taken in a previous boot whose clock was never set, are skipped but still
+ *        counted in records so the following drop removes them. Records that need the wall time are only read
+ *        once the clock of this boot is set.
+ * @param samples[OUT] Destination array.
+ * @param maxSamples Capacity of the destination array.
+ * @param records[OUT] Number of records read, to pass to telemetryLogDrop() once the samples are uploaded.
+ * @return The number of samples copied, oldest first.
+ */
+uint16_t telemetryLogPeek(TelemetrySample* samples, uint16_t maxSamples, uint16_t* records) {
+    char path[TELEMETRY_LOG_PATH_SIZE];
+    uint16_t count = 0;
+    uint16_t skipped = 0;
+
+    ClockEstimate clock;
+    bool synced = clockSynced();
+    clockEstimate(&clock);
+
+    *records = 0;
+    if (!logMounted) {
+        return 0;
+    }
+
+    xSemaphoreTake(xTelemetryLogMutex, portMAX_DELAY);
+    uint16_t available = segmentRecords[headSegment] - headRecord;
+    uint16_t toRead = (available < maxSamples) ? available : maxSamples;
+    if (toRead > 0) {
+        segmentPath(headSegment, path);
+        File file = LittleFS.open(path, "r");
+        if (!file || !file.seek(headRecord * sizeof(TelemetryLogRecord))) {
+            skipped = toRead; /* Unreadable segment, let the drop move past it */
+            *records = toRead;
+        } else {
+            while (*records < toRead) {
+                TelemetryLogRecord record;
+                if (file.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+                    skipped += toRead - *records;
+                    *records = toRead;
+                    break;
+                }
+                bool valid = (record.crc == logCrc16((const uint8_t*)&record, offsetof(TelemetryLogRecord, crc)));
+                bool deviceTime = valid && (record.bootId == bootId) && !(record.flags & TELEMETRY_LOG_WALL_TIME);
+                if (valid && !deviceTime && !synced) {
+                    break; /* Read again once the clock is set */
+                }
+                (*records)++;
+                uint64_t wallMs = 0;
+                if (!valid || (!deviceTime && !recordWallMs(record, &wallMs))) {
+                    skipped++;
+                    continue;
+                }
+                TelemetrySample& sample = samples[count++];
+                sample.seq = record.seq;
+                if (deviceTime) {
+                    sample.timeUs = (int64_t)record.timeMs * 1000;
+                } else {
+                    /* Age on the wall clock, converted to the device clock the backend turns it back with */
+                    double ageMs = (double)(int64_t)(clock.wallMs - wallMs);
+                    sample.timeUs = clock.nowUs - (int64_t)(ageMs * 1000.0 / (1.0 + clock.driftPpm / 1e6));
+                }
+                sample.temperature = record.temperature;
+                sample.humidity = record.humidity;
+                sample.levelPercentage = record.levelPercentage;
+                sample.inputs = record.inputs;
+                sample.actuators = record.actuators;
+            }
+        }
+        if (file) {
+            file.close();
+        }
+    }
+    xSemaphoreGive(xTelemetryLogMutex);
+
+    if (skipped > 0) {
+        LogSerialn("Telemetry log: skipped " + String(skipped) + " corrupted or undated samples", true);
+    }
+    return count;
+}
+
+/**
+ * @brief Removes uploaded records from the head of the log, erasing segments that are fully uploaded.
+ *        Progress within a segment is stored in NVS, one small write per uploaded batch.
+ * @param records Number of records returned by telemetryLogPeek().
+ */
+void telemetryLogDrop(uint16_t records) {
+    if (!logMounted || records == 0) {
+        return;
+    }
+    xSemaphoreTake(xTelemetryLogMutex, portMAX_DELAY);
+    headRecord += records;
+    logCount -= records;
+    if (headRecord >= segmentRecords[headSegment]) {
+        eraseSegment(headSegment);
+        headRecord = 0;
+        if (headSegment != tailSegment) {
+            headSegment = (headSegment + 1) % TELEMETRY_LOG_SEGMENTS;
+        }
+    } else {
+        saveHead();
+    }
+    xSemaphoreGive(xTelemetryLogMutex);
+}
@@ -0,0 +1,174 @@
+#include "TelemetryMgr.h"
+#include "ClockMgr.h"
+#include <Arduino.h>
+#include <math.h>
+
+static TelemetrySample ring[TELEMETRY_RING_CAPACITY];
+static uint16_t ringHead = 0;   /* Index of the oldest sample */
+static uint16_t ringCount = 0;
+static uint32_t nextSeq = 0;
+static bool eventPending = false;  /* An actuator transition is buffered and should go out without waiting */
+static uint32_t eventSeq = 0;      /* Sequence number of the latest actuator transition */
+static TelemetrySample lastRecorded; /* Reference for the deadbands, only used by the sampling task */
+static bool lastRecordedValid = false;
+static SemaphoreHandle_t xTelemetryMutex = NULL;
+
+/**
+ * @brief Creates the ring buffer mutex. Call once before the tasks start.
+ */
+void telemetryInit() {
+    xTelemetryMutex = xSemaphoreCreateMutex();
+    ringHead = 0;
+    ringCount = 0;
+    nextSeq = 0;
+    eventPending = false;
+    lastRecordedValid = false;
+}
+
+/**
+ * @brief Checks if an analog value moved out of the deadband around the last reported one.
+ *        A reading appearing or disappearing (NaN) always counts as a change.
+ * @param value Current value.
+ * @param reference Last reported value.
+ * @param deadband Smallest change worth reporting.
+ * @return True if the change is significant.
+ */
+static bool outsideDeadband(float value, float reference, float deadband) {
+    if (isnan(value) || isnan(reference)) {
+        return isnan(value) != isnan(reference);
+    }
+    return fabsf(value - reference) >= deadband;
+}
+
+/**
+ * @brief Appends the current sensor and actuator state to the ring buffer if it is worth reporting.
+ *        Digital input changes and actuator transitions are recorded at once, the latter flagged for
+ *        immediate upload. Analog values are recorded only when they leave their deadband, and the state is repeated as a heartbeat
+ *        when nothing changed for TELEMETRY_HEARTBEAT_MS. When the buffer is full the oldest sample is overwritten,
+ *        telemetryTakeOverflow() normally moves it to flash before that happens.
+ *        Call it after every control cycle so short actuator pulses are not missed.
+ * @param data Pointer to the SystemData structure containing sensor and actuator objects.
+ * @return True if a sample was recorded.
+ */
+bool telemetryRecordOnChange(SystemData* data) {
+    TelemetrySample sample;
+    sample.timeUs = clockNowUs();
+    sample.temperature = data->sensorMgr->getTemperature();
+    sample.humidity = data->sensorMgr->getHumidity();
+    sample.levelPercentage = data->levelPercentage;
+    sample.inputs = (data->sensorMgr->getLightSensorValue() ? TELEMETRY_IN_LIGHT : 0) |
+                    (data->PirPresenceDetected ? TELEMETRY_IN_PIR : 0) |
+                    (data->sensorMgr->getWellSensorValue() ? TELEMETRY_IN_WELL : 0);
+    sample.actuators = (data->actuatorMgr->getLamp()->getOutstate() ? TELEMETRY_ACT_LAMP : 0) |
+                       (data->actuatorMgr->getPump()->getOutstate() ? TELEMETRY_ACT_PUMP : 0) |
+                       (data->actuatorMgr->getIrrigator()->getOutstate() ? TELEMETRY_ACT_IRRIGATOR : 0);
+
+    bool actuatorChange = lastRecordedValid && (sample.actuators != lastRecorded.actuators);
+    bool digitalChange = !lastRecordedValid || actuatorChange || (sample.inputs != lastRecorded.inputs);
+    bool analogChange = lastRecordedValid &&
+                        ((abs((int32_t)sample.levelPercentage - (int32_t)lastRecorded.levelPercentage) >= TELEMETRY_DEADBAND_LEVEL) ||
+                         outsideDeadband(sample.temperature, lastRecorded.temperature, TELEMETRY_DEADBAND_TEMP) ||
+                         outsideDeadband(sample.humidity, lastRecorded.humidity, TELEMETRY_DEADBAND_HUM));
+    bool heartbeat = lastRecordedValid && (sample.timeUs - lastRecorded.timeUs >= (int64_t)TELEMETRY_HEARTBEAT_MS * 1000);
+
+    if (!digitalChange && !analogChange && !heartbeat) {
+        return false;
+    }
+
+    xSemaphoreTake(xTelemetryMutex, portMAX_DELAY);
+    if (ringCount == TELEMETRY_RING_CAPACITY) {
+        ringHead = (ringHead + 1) % TELEMETRY_RING_CAPACITY;
+        ringCount--;
+    }
+    sample.seq = nextSeq++;
+    ring[(ringHead + ringCount) % TELEMETRY_RING_CAPACITY] = sample;
+    ringCount++;
+    if (actuatorChange) {
+        eventPending = true;
+        eventSeq = sample.seq;
+    }
+    xSemaphoreGive(xTelemetryMutex);
+
+    lastRecorded = sample;
+    lastRecordedValid = true;
+    return true;
+}
+
+/**
+ * @brief Number of samples waiting for upload.
+ * @return The number of buffered samples.
+ */
+uint16_t telemetryCount() {
+    xSemaphoreTake(xTelemetryMutex, portMAX_DELAY);
+    uint16_t count = ringCount;
+    xSemaphoreGive(xTelemetryMutex);
+    return count;
+}
+
+/**
+ * @brief Checks if the buffered samples should be uploaded now: a full batch is available,
+ *        an actuator transition is waiting, or the oldest sample has waited TELEMETRY_MAX_LATENCY_MS.
+ * @return True if an upload is due.
+ */
+bool telemetryUploadDue() {
+    xSemaphoreTake(xTelemetryMutex, portMAX_DELAY);
+    bool due = (ringCount >= TELEMETRY_BATCH_SIZE) || eventPending ||
+               ((ringCount > 0) && (clockNowUs() - ring[ringHead].timeUs >= (int64_t)TELEMETRY_MAX_LATENCY_MS * 1000));
+    xSemaphoreGive(xTelemetryMutex);
+    return due;
+}
+
+/**
+ * @brief Copies the oldest samples without removing them, so they survive a failed upload.
+ * @param samples[OUT] Destination array.
+ * @param maxSamples Capacity of the destination array.
+ * @return The number of samples copied, oldest first.
+ */
+uint16_t telemetryPeek(TelemetrySample* samples, uint16_t maxSamples) {
+    xSemaphoreTake(xTelemetryMutex, portMAX_DELAY);
+    uint16_t count = (ringCount < maxSamples) ? ringCount : maxSamples;
+    for (uint16_t i = 0; i < count; ++i) {
+        samples[i] = ring[(ringHead + i) % TELEMETRY_RING_CAPACITY];
+    }
+    xSemaphoreGive(xTelemetryMutex);
+    return count;
+}
+
+/**
+ * @brief Removes the samples up to and including lastSeq once they have been uploaded.
+ *        Samples overwritten since the peek are skipped, newer ones are kept.
+ * @param lastSeq Sequence number of the last uploaded sample.
+ */
+void telemetryDrop(uint32_t lastSeq) {
+    xSemaphoreTake(xTelemetryMutex, portMAX_DELAY);
+    while (ringCount > 0 && (int32_t)(ring[ringHead].seq - lastSeq) <= 0) {
+        ringHead = (ringHead + 1) % TELEMETRY_RING_CAPACITY;
+        ringCount--;
+    }
+    if (eventPending && (int32_t)(eventSeq - lastSeq) <= 0) {
+        eventPending = false;
+    }
+    xSemaphoreGive(xTelemetryMutex);
+}
+
+/**
+ * @brief Removes the oldest samples once more than TELEMETRY_SPILL_THRESHOLD are buffered, so they can be stored
+ *        elsewhere before the ring buffer overwrites them, and any sample waiting for more than TELEMETRY_SPILL_AGE_MS,
+ *        so a reset never loses more than that much of the samples that could not be sent.
+ * @param samples[OUT] Destination array.
+ * @param maxSamples Capacity of the destination array.
+ * @return The number of samples removed, oldest first, 0 while below the threshold and none is too old.
+ */
+uint16_t telemetryTakeOverflow(TelemetrySample* samples, uint16_t maxSamples) {
+    uint16_t count = 0;
+    int64_t oldestKeptUs = clockNowUs() - (int64_t)TELEMETRY_SPILL_AGE_MS * 1000;
+    xSemaphoreTake(xTelemetryMutex, portMAX_DELAY);
+    bool overflow = (ringCount > TELEMETRY_SPILL_THRESHOLD);
+    while (count < maxSamples && ringCount > 0 && (overflow || ring[ringHead].timeUs <= oldestKeptUs)) {
+        samples[count++] = ring[ringHead];
+        ringHead = (ringHead + 1) % TELEMETRY_RING_CAPACITY;
+        ringCount--;
+    }
+    xSemaphoreGive(xTelemetryMutex);
+    return count;
+}
@@ -0,0 +1,454 @@
+#include "TraceMgr.h"
+#include "ProcessMgr.h"
+#include <Arduino.h>
+#include <math.h>
+
+static TraceSnapshot currentState;   /* Latest observed state */
+static TraceSnapshot recordedState;  /* State as known by the trace reader */
+static uint16_t recordsSinceKeyframe = TRACE_KEYFRAME_INTERVAL; /* Forces a keyframe first */
+static SemaphoreHandle_t xTraceMutex = NULL;
+
+/**
+ * @brief Appends an unsigned LEB128 varint to the buffer.
+ * @param buf Output buffer.
+ * @param value Value to encode.
+ * @return Number of bytes written.
+ */
+static uint8_t traceWriteVarint(uint8_t* buf, uint32_t value) {
+    uint8_t len = 0;
+    while (value >= 0x80) {
+        buf[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[len++] = (uint8_t)value;
+    return len;
+}
+
+/**
+ * @brief Appends a signed value as a zigzag encoded varint.
+ * @param buf Output buffer.
+ * @param value Value to encode.
+ * @return Number of bytes written.
+ */
+static uint8_t traceWriteZigzag(uint8_t* buf, int32_t value) {
+    return traceWriteVarint(buf, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+/**
+ * @brief Computes the CRC-8 (poly 0x07) used to validate a trace frame.
+ * @param buf Payload bytes.
+ * @param len Payload length.
+ * @return The CRC value.
+ */
+static uint8_t traceCrc8(const uint8_t* buf, uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; ++i) {
+        crc ^= buf[i];
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Converts a sensor reading to fixed point tenths.
+ * @param value Reading as returned by the sensor manager.
+ * @return The reading in tenths, or 0 if the sensor has not produced a value yet.
+ */
+static int16_t traceToTenths(double value) {
+    if (isnan(value)) {
+        return 0;
+    }
+    return (int16_t)lround(value * 10.0);
+}
+
+/**
+ * @brief Encodes the fields of the current snapshot that differ from the recorded one and streams the frame.
+ *        Must be called with xTraceMutex held.
+ * @param groups TRACE_FLAG_* groups the caller has just refreshed.
+ */
+static void traceEmit(uint8_t groups) {
+    uint8_t frame[TRACE_MAX_RECORD_SIZE + 4];
+    uint8_t* payload = &frame[3];
+    uint8_t flags = 0;
+    uint8_t len = 1;
+    bool keyframe = (recordsSinceKeyframe >= TRACE_KEYFRAME_INTERVAL);
+
+    if (keyframe) {
+        flags = TRACE_FLAG_KEYFRAME | TRACE_FLAG_LEVEL | TRACE_FLAG_TEMP | TRACE_FLAG_HUM |
+                TRACE_FLAG_INPUTS | TRACE_FLAG_ACTUATORS | TRACE_FLAG_SETTINGS;
+    } else {
+        if ((groups & TRACE_FLAG_LEVEL) && currentState.level != recordedState.level) flags |= TRACE_FLAG_LEVEL;
+        if ((groups & TRACE_FLAG_TEMP) && currentState.temperature != recordedState.temperature) flags |= TRACE_FLAG_TEMP;
+        if ((groups & TRACE_FLAG_HUM) && currentState.humidity != recordedState.humidity) flags |= TRACE_FLAG_HUM;
+        if ((groups & TRACE_FLAG_INPUTS) && currentState.inputs != recordedState.inputs) flags |= TRACE_FLAG_INPUTS;
+        if ((groups & TRACE_FLAG_ACTUATORS) && currentState.actuators != recordedState.actuators) flags |= TRACE_FLAG_ACTUATORS;
+        if ((groups & TRACE_FLAG_SETTINGS) &&
+            memcmp(currentState.settings, recordedState.settings, sizeof(currentState.settings)) != 0) {
+            flags |= TRACE_FLAG_SETTINGS;
+        }
+        if (flags == 0) {
+            /* Nothing changed, the reader keeps the previous values */
+            return;
+        }
+    }
+
+    payload[0] = flags;
+    len += traceWriteVarint(&payload[len], keyframe ? currentState.timeMs : currentState.timeMs - recordedState.timeMs);
+
+    if (flags & TRACE_FLAG_LEVEL) {
+        len += keyframe ? traceWriteVarint(&payload[len], currentState.level)
+                        : traceWriteZigzag(&payload[len], (int32_t)currentState.level - recordedState.level);
+    }
+    if (flags & TRACE_FLAG_TEMP) {
+        len += traceWriteZigzag(&payload[len], keyframe ? currentState.temperature
+                                                        : (int32_t)currentState.temperature - recordedState.temperature);
+    }
+    if (flags & TRACE_FLAG_HUM) {
+        len += traceWriteZigzag(&payload[len], keyframe ? currentState.humidity
+                                                        : (int32_t)currentState.humidity - recordedState.humidity);
+    }
+    if (flags & TRACE_FLAG_INPUTS) {
+        payload[len++] = currentState.inputs;
+    }
+    if (flags & TRACE_FLAG_ACTUATORS) {
+        payload[len++] = currentState.actuators;
+    }
+    if (flags & TRACE_FLAG_SETTINGS) {
+        memcpy(&payload[len], currentState.settings, sizeof(currentState.settings));
+        len += sizeof(currentState.settings);
+    }
+
+    frame[0] = TRACE_FRAME_SYNC0;
+    frame[1] = TRACE_FRAME_SYNC1;
+    frame[2] = len;
+    frame[3 + len] = traceCrc8(payload, len);
+
+    /* A single write keeps the frame contiguous with respect to other Serial users */
+    Serial.write(frame, len + 4);
+
+    recordedState = currentState;
+    recordsSinceKeyframe = keyframe ? 1 : recordsSinceKeyframe + 1;
+}
+
+/**
+ * @brief Packs the actuator states into TRACE_ACT_* bits.
+ * @param data Pointer to the SystemData structure containing actuator objects.
+ * @return The packed states.
+ */
+static uint8_t traceActuatorBits(SystemData* data) {
+    uint8_t actuators = 0;
+    if (data->actuatorMgr->getLamp()->getOutstate()) actuators |= TRACE_ACT_LAMP;
+    if (data->actuatorMgr->getPump()->getOutstate()) actuators |= TRACE_ACT_PUMP;
+    if (data->actuatorMgr->getIrrigator()->getOutstate()) actuators |= TRACE_ACT_IRRIGATOR;
+    return actuators;
+}
+
+/**
+ * @brief Initializes the trace recorder. Must be called before the tasks start.
+ */
+void traceInit() {
+    if (!TRACE_RECORDER_ENABLED) {
+        return;
+    }
+
+    xTraceMutex = xSemaphoreCreateMutex();
+    memset(&currentState, 0, sizeof(currentState));
+    memset(&recordedState, 0, sizeof(recordedState));
+    recordsSinceKeyframe = TRACE_KEYFRAME_INTERVAL;
+}
+
+/**
+ * @brief Records the latest sensor readings and the control settings.
+ *        Call right after the SensorManager has been refreshed.
+ * @param data Pointer to the SystemData structure containing sensor objects.
+ */
+void traceRecordSensors(SystemData* data) {
+    if (!TRACE_RECORDER_ENABLED || xTraceMutex == NULL) {
+        return;
+    }
+
+    if (xSemaphoreTake(xTraceMutex, portMAX_DELAY)) {
+        SensorManager* sensorMgr = data->sensorMgr;
+        uint8_t inputs = 0;
+
+        if (sensorMgr->getPirSensorValue()) inputs |= TRACE_IN_PIR;
+        if (sensorMgr->getLightSensorValue()) inputs |= TRACE_IN_LIGHT;
+        if (sensorMgr->getButtonSelectorValue()) inputs |= TRACE_IN_SELECT;
+        if (sensorMgr->getButtonEscValue()) inputs |= TRACE_IN_ESC;
+        if (sensorMgr->getButtonUpValue()) inputs |= TRACE_IN_UP;
+        if (sensorMgr->getButtonDownValue()) inputs |= TRACE_IN_DOWN;
+        if (sensorMgr->getWellSensorValue()) inputs |= TRACE_IN_WELL;
+
+        currentState.timeMs = millis();
+        currentState.level = sensorMgr->getLevelSensorValue();
+        currentState.temperature = traceToTenths(sensorMgr->getTemperature());
+        currentState.humidity = traceToTenths(sensorMgr->getHumidity());
+        currentState.inputs = inputs;
+        currentState.settings[0] = data->maxLevelPercentage;
+        currentState.settings[1] = data->minLevelPercentage;
+        currentState.settings[2] = data->hotTemperature;
+        currentState.settings[3] = data->lowHumidity;
+
+        traceEmit(TRACE_FLAG_LEVEL | TRACE_FLAG_TEMP | TRACE_FLAG_HUM | TRACE_FLAG_INPUTS | TRACE_FLAG_SETTINGS);
+        xSemaphoreGive(xTraceMutex);
+    }
+}
+
+/**
+ * @brief Records the actuator states decided by ProcessMgr.
+ *        Call right after the ActuatorManager has applied its states.
+ * @param data Pointer to the SystemData structure containing actuator objects.
+ */
+void traceRecordActuators(SystemData* data) {
+    if (!TRACE_RECORDER_ENABLED || xTraceMutex == NULL) {
+        return;
+    }
+
+    if (xSemaphoreTake(xTraceMutex, portMAX_DELAY)) {
+        currentState.timeMs = millis();
+        currentState.actuators = traceActuatorBits(data);
+
+        traceEmit(TRACE_FLAG_ACTUATORS);
+        xSemaphoreGive(xTraceMutex);
+    }
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint.
+ * @param buf Payload bytes.
+ * @param len Payload length.
+ * @param pos[IN/OUT] Read position, advanced past the varint.
+ * @param value[OUT] Decoded value.
+ * @return False if the varint runs past the payload.
+ */
+static bool traceReadVarint(const uint8_t* buf, uint8_t len, uint8_t* pos, uint32_t* value) {
+    uint32_t result = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t byte = buf[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a zigzag encoded signed varint.
+ * @return False if the varint runs past the payload.
+ */
+static bool traceReadZigzag(const uint8_t* buf, uint8_t len, uint8_t* pos, int32_t* value) {
+    uint32_t raw;
+    if (!traceReadVarint(buf, len, pos, &raw)) {
+        return false;
+    }
+    *value = (int32_t)(raw >> 1) ^ -(int32_t)(raw & 1);
+    return true;
+}
+
+/**
+ * @brief Applies a record payload to the state known by the reader, the inverse of traceEmit().
+ * @param payload Record payload, CRC already checked.
+ * @param len Payload length.
+ * @param state[IN/OUT] Reconstructed state, only updated if the whole record decodes.
+ * @return The record flags, or 0 if the record is malformed.
+ */
+static uint8_t traceDecodeRecord(const uint8_t* payload, uint8_t len, TraceSnapshot* state) {
+    TraceSnapshot next = *state;
+    uint8_t pos = 1;
+    uint32_t value;
+    int32_t delta;
+
+    if (len < 2) {
+        return 0;
+    }
+    uint8_t flags = payload[0];
+    bool keyframe = (flags & TRACE_FLAG_KEYFRAME) != 0;
+
+    if (!traceReadVarint(payload, len, &pos, &value)) return 0;
+    next.timeMs = keyframe ? value : next.timeMs + value;
+    if (flags & TRACE_FLAG_LEVEL) {
+        if (keyframe) {
+            if (!traceReadVarint(payload, len, &pos, &value)) return 0;
+            next.level = (uint16_t)value;
+        } else {
+            if (!traceReadZigzag(payload, len, &pos, &delta)) return 0;
+            next.level = (uint16_t)(next.level + delta);
+        }
+    }
+    if (flags & TRACE_FLAG_TEMP) {
+        if (!traceReadZigzag(payload, len, &pos, &delta)) return 0;
+        next.temperature = (int16_t)(keyframe ? delta : next.temperature + delta);
+    }
+    if (flags & TRACE_FLAG_HUM) {
+        if (!traceReadZigzag(payload, len, &pos, &delta)) return 0;
+        next.humidity = (int16_t)(keyframe ? delta : next.humidity + delta);
+    }
+    if (flags & TRACE_FLAG_INPUTS) {
+        if (pos >= len) return 0;
+        next.inputs = payload[pos++];
+    }
+    if (flags & TRACE_FLAG_ACTUATORS) {
+        if (pos >= len) return 0;
+        next.actuators = payload[pos++];
+    }
+    if (flags & TRACE_FLAG_SETTINGS) {
+        if (pos + sizeof(next.settings) > len) return 0;
+        memcpy(next.settings, &payload[pos], sizeof(next.settings));
+        pos += sizeof(next.settings);
+    }
+    if (pos != len) {
+        return 0;
+    }
+
+    *state = next;
+    return flags;
+}
+
+/* Progress of a replay, see traceReplay() */
+struct TraceReplayRun {
+    SystemData* data;
+    TraceInputWriter writeInputs;
+    void* ctx;
+    TraceReplayStats* stats;
+    uint32_t nextCycleMs;      /* Time of the next timer driven cycle */
+    bool diverged;             /* The replayed actuators differ from the recorded ones */
+    bool divergenceCounted;    /* The divergence has been counted as a mismatch */
+    uint32_t divergedSinceMs;
+};
+
+/**
+ * @brief Counts a mismatch, keeping the details of the first one.
+ */
+static void traceReplayMismatch(TraceReplayStats* stats, uint32_t timeMs, uint8_t expected, uint8_t replayed) {
+    if (stats->mismatches == 0) {
+        stats->firstMismatchMs = timeMs;
+        stats->expected = expected;
+        stats->replayed = replayed;
+    }
+    stats->mismatches++;
+}
+
+/**
+ * @brief One cycle of the sensor, process and actuator tasks on the recorded readings.
+ *        The replay runs ahead of the device by less than a cycle, so a change it makes is recorded by the next
+ *        cycle. Actuator states that are still not recorded one cycle later are counted as a mismatch.
+ * @param run Replay in progress.
+ * @param state Recorded readings, settings and actuators.
+ * @param timeMs Time of the cycle.
+ */
+static void traceReplayCycle(TraceReplayRun* run, const TraceSnapshot* state, uint32_t timeMs) {
+    SystemData* data = run->data;
+    TraceSnapshot inputs = *state;
+    inputs.timeMs = timeMs;
+    run->writeInputs(&inputs, run->ctx);
+
+    data->sensorMgr->readLevelSensor();
+    data->sensorMgr->readPirSensor();
+    data->sensorMgr->readLightSensor();
+    data->sensorMgr->readButtonSelector();
+    data->sensorMgr->readButtonEsc();
+    data->sensorMgr->readButtonUp();
+    data->sensorMgr->readButtonDown();
+    data->sensorMgr->readWellSensor();
+    data->sensorMgr->readDht11TempHumSens();
+    data->maxLevelPercentage = state->settings[0];
+    data->minLevelPercentage = state->settings[1];
+    data->hotTemperature = state->settings[2];
+    data->lowHumidity = state->settings[3];
+
+    LampActivationCtrl(data);
+    PumpActivationCtrl(data);
+    IrrigatorActivationCtrl(data);
+    pButtonsCtrl(data);
+    data->actuatorMgr->applyState();
+    run->nextCycleMs = timeMs + TRACE_REPLAY_STEP_MS;
+
+    uint8_t replayed = traceActuatorBits(data);
+    if (replayed == state->actuators) {
+        run->diverged = false;
+    } else if (!run->diverged) {
+        run->diverged = true;
+        run->divergenceCounted = false;
+        run->divergedSinceMs = timeMs;
+    } else if (!run->divergenceCounted && timeMs - run->divergedSinceMs > TRACE_REPLAY_STEP_MS) {
+        run->divergenceCounted = true;
+        traceReplayMismatch(run->stats, timeMs, state->actuators, replayed);
+    }
+}
+
+/**
+ * @brief Replays a captured trace through ProcessMgr and compares its actuator decisions with the recorded ones.
+ *        A process cycle runs on every record carrying new readings, as the process task runs right after the
+ *        sensor task, and then every TRACE_REPLAY_STEP_MS for the timers. Each recorded actuator change must be
+ *        replayed by the time of its record, and the replay must not change an actuator the device left alone.
+ *        The capture must start at boot, ProcessMgr keeps its state between calls.
+ * @param data Pointer to the SystemData structure the replay runs on, built as in setup().
+ * @param buf Raw capture, text logs between the frames are skipped.
+ * @param len Capture length.
+ * @param writeInputs Presents the recorded readings to the sensor drivers and sets the clock.
+ * @param ctx Passed to writeInputs.
+ * @param stats[OUT] Counters and the first mismatch.
+ */
+void traceReplay(SystemData* data, const uint8_t* buf, size_t len, TraceInputWriter writeInputs, void* ctx,
+                 TraceReplayStats* stats) {
+    TraceReplayRun run = {data, writeInputs, ctx, stats, 0, false, false, 0};
+    TraceSnapshot state;
+    bool synced = false;
+
+    memset(&state, 0, sizeof(state));
+    memset(stats, 0, sizeof(*stats));
+
+    for (size_t i = 0; i + 4 <= len; ++i) {
+        if (buf[i] != TRACE_FRAME_SYNC0 || buf[i + 1] != TRACE_FRAME_SYNC1) {
+            continue;
+        }
+        uint8_t payloadLen = buf[i + 2];
+        if (i + 4 + payloadLen > len) {
+            break;
+        }
+        const uint8_t* payload = &buf[i + 3];
+        if (traceCrc8(payload, payloadLen) != payload[payloadLen]) {
+            /* Deltas are meaningless until the next keyframe */
+            stats->crcErrors++;
+            synced = false;
+            run.diverged = false;
+            continue;
+        }
+
+        TraceSnapshot next = state;
+        uint8_t flags = traceDecodeRecord(payload, payloadLen, &next);
+        bool keyframe = (flags & TRACE_FLAG_KEYFRAME) != 0;
+        if (flags == 0 || (!synced && !keyframe)) {
+            continue;
+        }
+        i += 3 + payloadLen;
+        stats->records++;
+
+        /* Timer driven cycles due by this record, on the previous readings */
+        while (synced && (int32_t)(next.timeMs - run.nextCycleMs) >= 0) {
+            traceReplayCycle(&run, &state, run.nextCycleMs);
+        }
+        state = next;
+        synced = true;
+
+        if (keyframe || (flags & (TRACE_FLAG_LEVEL | TRACE_FLAG_TEMP | TRACE_FLAG_HUM | TRACE_FLAG_INPUTS |
+                                  TRACE_FLAG_SETTINGS))) {
+            traceReplayCycle(&run, &state, state.timeMs);
+        } else if (flags & TRACE_FLAG_ACTUATORS) {
+            uint8_t replayed = traceActuatorBits(data);
+            stats->decisions++;
+            run.diverged = (replayed != state.actuators);
+            run.divergenceCounted = run.diverged;
+            if (run.diverged) {
+                traceReplayMismatch(stats, state.timeMs, state.actuators, replayed);
+            }
+        }
+    }
+}
@@ -10,15 +10,26 @@
  * @param lcd_addr I2C address of the OLED display.
  */
 OledDisplay::OledDisplay(uint8_t width, uint8_t height, uint8_t lcd_addr)
-    : display(width, height, &Wire, -1), lcd_addr(lcd_addr) {}
+    : display(width, height, &Wire, -1, OLED_I2C_CLOCK_HZ, OLED_I2C_CLOCK_HZ), lcd_addr(lcd_addr),
+      sentBufferValid(false), flushTaskHandle(NULL), xFlushDone(NULL) {}
 
 /**
  * @brief Initializes the OLED display.
- *        Sets up the display and provides a startup delay for stability.
+ *        Sets up the display, starts the background flush task and provides a startup delay for stability.
  */
 void OledDisplay::init() {
     display.begin(SSD1306_SWITCHCAPVCC, lcd_addr); /* Initialize display with I2C address */
     display.display();  /* Refresh display after initialization */
+    memcpy(sentBuffer, display.getBuffer(), sizeof(sentBuffer));
+    sentBufferValid = true;
+
+    /* Framebuffer transfers run in their own task so the caller never blocks on the I2C bus */
+    xFlushDone = xSemaphoreCreateBinary();
+    if (xFlushDone != NULL) {
+        xSemaphoreGive(xFlushDone); /* No transfer in progress */
+        xTaskCreatePinnedToCore(flushTask, "OledFlush", OLED_FLUSH_TASK_STACK, this,
+                                OLED_FLUSH_TASK_PRIORITY, &flushTaskHandle, OLED_FLUSH_TASK_CORE);
+    }
     vTaskDelay(pdMS_TO_TICKS(500)); /* Short delay for stabilization */
 }
 
@@ -46,10 +57,8 @@ void OledDisplay::setTextProperties(uint8_t textsize, uint8_t color) {
  * @param data String to display.
  */
 void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, const char* data) {
-    /* Clear the section where the text will be updated */
-    display.fillRect(posX, posY, display.width() - posX, 8, SSD1306_BLACK);
     display.setCursor(posX, posY);
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* White text on black background */
+    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* Opaque background clears only the written character cells */
     display.print(data);  /* Print the string to the display buffer */
 }
 
@@ -60,10 +69,8 @@ void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, const char* data) {
  * @param data Numerical value to display.
  */
 void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, uint16_t data) {
-    /* Clear the section where the text will be updated */
-    display.fillRect(posX, posY, display.width() - posX, 8, SSD1306_BLACK);
     display.setCursor(posX, posY);
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* White text on black background */
+    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* Opaque background clears only the written character cells */
     display.print(data);  /* Print the numerical value to the display buffer */
 }
 
@@ -74,10 +81,8 @@ void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, uint16_t data) {
  * @param data Numerical value to display.
  */
 void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, uint8_t data) {
-    /* Clear the section where the text will be updated */
-    display.fillRect(posX, posY, display.width() - posX, 8, SSD1306_BLACK);
     display.setCursor(posX, posY);
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* White text on black background */
+    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* Opaque background clears only the written character cells */
     display.print(data);  /* Print the numerical value to the display buffer */
 }
 
@@ -88,10 +93,8 @@ void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, uint8_t data) {
  * @param data Numerical value to display.
  */
 void OledDisplay::SetdisplayData(int16_t posX, int16_t posY, double data) {
-    /* Clear the section where the text will be updated */
-    display.fillRect(posX, posY, display.width() - posX, 8, SSD1306_BLACK);
     display.setCursor(posX, posY);
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* White text on black background */
+    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); /* Opaque background clears only the written character cells */
     display.print(data);  /* Print the numerical value to the display buffer */
 }
 
@@ -109,31 +112,197 @@ void OledDisplay::DrawLine(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t
 
 /**
  * @brief Draws an icon on the display.
+ *        The icon bytes are ORed straight into the page-organized framebuffer, split
+ *        across two pages when y is not a multiple of 8. Pixels off screen are clipped.
  * @param x X-coordinate of the icon.
  * @param y Y-coordinate of the icon.
- * @param icon Pointer to the icon data.
- * @param w Width of the icon.
- * @param h Height of the icon.
+ * @param icon Page-ordered icon from the icon atlas.
  */
-void OledDisplay::DrawIcon(int16_t x, int16_t y, const uint8_t* icon, uint8_t w, uint8_t h) {
-    display.drawBitmap(x, y, icon, w, h, SSD1306_WHITE); /* Draw an icon on the display */
+void OledDisplay::DrawIcon(int16_t x, int16_t y, const IconBitmap& icon) {
+    uint8_t* buffer = display.getBuffer();
+    int16_t firstPage = (y >= 0) ? (y / 8) : ((y - 7) / 8);
+    uint8_t shift = y - firstPage * 8;
+    uint8_t iconPages = (icon.height + 7) / 8;
+
+    for (uint8_t col = 0; col < icon.width; ++col) {
+        int16_t dstX = x + col;
+        if (dstX < 0 || dstX >= SCREEN_WIDTH) {
+            continue;
+        }
+
+        for (uint8_t page = 0; page < iconPages; ++page) {
+            uint8_t bits = pgm_read_byte(&icon.pages[page * icon.width + col]);
+            int16_t dstPage = firstPage + page;
+            if (bits == 0) {
+                continue;
+            }
+
+            if (dstPage >= 0 && dstPage < SCREEN_PAGES) {
+                buffer[dstPage * SCREEN_WIDTH + dstX] |= bits << shift;
+            }
+            if (shift != 0 && dstPage + 1 >= 0 && dstPage + 1 < SCREEN_PAGES) {
+                buffer[(dstPage + 1) * SCREEN_WIDTH + dstX] |= bits >> (8 - shift);
+            }
+        }
+    }
 }
 
 /**
- * @brief Sends the buffered display data to the OLED screen.
+ * @brief Clears a rectangular area of the display.
+ * @param x X-coordinate of the area.
+ * @param y Y-coordinate of the area.
+ * @param w Width of the area.
+ * @param h Height of the area.
+ */
+void OledDisplay::ClearArea(int16_t x, int16_t y, int16_t w, int16_t h) {
+    display.fillRect(x, y, w, h, SSD1306_BLACK);
+}
+
+/**
+ * @brief Sends the buffered display data to the OLED screen without waiting for the transfer.
+ *        The frame is snapshotted and handed to the flush task; the call only blocks
+ *        while a previous transfer is still running.
  */
 void OledDisplay::PrintdisplayData() {
-    display.display(); /* Refresh the display with new data */
+    if (flushTaskHandle == NULL) {
+        transmitDirtyRegions(display.getBuffer()); /* Flush task not running, transfer synchronously */
+        return;
+    }
+
+    xSemaphoreTake(xFlushDone, portMAX_DELAY);
+    memcpy(txBuffer, display.getBuffer(), sizeof(txBuffer));
+    xTaskNotifyGive(flushTaskHandle);
 }
 
 /**
- * @brief Returns the pixel width of a string using the current font and text size.
- * @param str The string to measure.
- * @return The width in pixels.
+ * @brief Waits until the last frame handed to PrintdisplayData has been transmitted.
+ * @param timeout Maximum time to wait, in ticks.
+ * @return True if no transfer is pending, false on timeout.
  */
-uint16_t OledDisplay::getStringWidth(const char* str) {
-    int16_t x1, y1;
-    uint16_t w, h;
-    display.getTextBounds(str, 0, 0, &x1, &y1, &w, &h);
-    return w;
+bool OledDisplay::waitFlushDone(TickType_t timeout) {
+    if (flushTaskHandle == NULL) {
+        return true;
+    }
+
+    if (xSemaphoreTake(xFlushDone, timeout) == pdTRUE) {
+        xSemaphoreGive(xFlushDone);
+        return true;
+    }
+    return false;
 }
+
+/**
+ * @brief Background task transmitting the frame snapshots and signalling completion.
+ * @param pvParameters Pointer to the owning OledDisplay object.
+ */
+void OledDisplay::flushTask(void* pvParameters) {
+    OledDisplay* oled = (OledDisplay*)pvParameters;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        oled->transmitDirtyRegions(oled->txBuffer);
+        xSemaphoreGive(oled->xFlushDone);
+    }
+}
+
+/**
+ * @brief Transmits a frame to the panel.
+ *        Only the column range that changed in each 8-pixel page since the last
+ *        transfer is sent, using the SSD1306 page/column addressing window.
+ * @param frame The framebuffer to transmit.
+ */
+void OledDisplay::transmitDirtyRegions(const uint8_t* frame) {
+    for (uint8_t page = 0; page < SCREEN_PAGES; ++page) {
+        const uint8_t* pageData = &frame[page * SCREEN_WIDTH];
+        uint8_t* sentPage = &sentBuffer[page * SCREEN_WIDTH];
+        int16_t first = 0;
+        int16_t last = SCREEN_WIDTH - 1;
+
+        /* Find the dirty column range of this page, the whole page if the panel content is unknown */
+        if (sentBufferValid) {
+            while (first < SCREEN_WIDTH && pageData[first] == sentPage[first]) {
+                first++;
+            }
+            if (first == SCREEN_WIDTH) {
+                continue; /* Page unchanged */
+            }
+            while (pageData[last] == sentPage[last]) {
+                last--;
+            }
+        }
+
+        const uint8_t window[] = {
+            SSD1306_PAGEADDR, page, page,
+            SSD1306_COLUMNADDR, (uint8_t)first, (uint8_t)last
+        };
+        sendCommands(window, sizeof(window));
+        sendData(&pageData[first], last - first + 1);
+        memcpy(&sentPage[first], &pageData[first], last - first + 1);
+    }
+
+    sentBufferValid = true;
+}
+
+/**
+ * @brief Sends a list of commands to the controller in a single I2C transaction.
+ * @param cmds Command bytes.
+ * @param len Number of command bytes.
+ */
+void OledDisplay::sendCommands(const uint8_t* cmds, uint8_t len) {
+    Wire.beginTransmission(lcd_addr);
+    Wire.write((uint8_t)0x00); /* Control byte: command stream */
+    Wire.write(cmds, len);
+    Wire.endTransmission();
+}
+
+/**
+ * @brief Writes framebuffer bytes into the current addressing window.
+ * @param buf Framebuffer bytes.
+ * @param len Number of bytes to send.
+ */
+void OledDisplay::sendData(const uint8_t* buf, uint16_t len) {
+    while (len > 0) {
+        uint16_t chunk = (len > OLED_I2C_CHUNK_SIZE) ? OLED_I2C_CHUNK_SIZE : len;
+        Wire.beginTransmission(lcd_addr);
+        Wire.write((uint8_t)0x40); /* Control byte: data stream */
+        Wire.write(buf, chunk);
+        Wire.endTransmission();
+        buf += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Writes the current framebuffer as a binary PBM (P4) image, lit pixels as 1.
+ *        The screen id, frame name and render time are stored as a PBM comment so captures can be
+ *        split and compared with the goldens by name (see tools/oledSnapshots.js).
+ * @param out Destination stream, typically Serial.
+ * @param screenId Identifier of the rendered screen.
+ * @param name Name of the rendered frame, see displayFrameName().
+ * @param renderTimeUs Time spent rendering the frame, in microseconds.
+ */
+void OledDisplay::dumpFramePbm(Print& out, uint8_t screenId, const char* name, uint32_t renderTimeUs) {
+    const uint8_t* buffer = display.getBuffer();
+    uint8_t row[SCREEN_WIDTH / 8];
+    char header[96];
+
+    snprintf(header, sizeof(header), "P4\n# screen=%u name=%s render_us=%lu\n%d %d\n",
+             screenId, name, (unsigned long)renderTimeUs, SCREEN_WIDTH, SCREEN_HEIGHT);
+    out.print(header);
+
+    /* Convert the page-organized (vertical bytes) framebuffer to row-major bits */
+    for (uint8_t y = 0; y < SCREEN_HEIGHT; ++y) {
+        const uint8_t* page = &buffer[(y / 8) * SCREEN_WIDTH];
+        uint8_t mask = 1 << (y & 7);
+        for (uint8_t xByte = 0; xByte < sizeof(row); ++xByte) {
+            uint8_t bits = 0;
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                if (page[xByte * 8 + bit] & mask) {
+                    bits |= 0x80 >> bit;
+                }
+            }
+            row[xByte] = bits;
+        }
+        out.write(row, sizeof(row));
+    }
+}
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <Preferences.h>
+#include <esp_wifi.h>
+
+/* Set from the WiFi event task, consumed by the poll functions */
+static volatile bool scanDoneEvent = false;
+static volatile bool gotIpEvent = false;
 
 /**
  * @brief Constructor for WiFiManager class.
@@ -10,22 +15,59 @@
  * @param password WiFi network password.
  */
 WiFiManager::WiFiManager(const char* ssid, const char* password)
-    : ssid(ssid), password(password) {}
+    : ssid(ssid), password(password), scanCacheTime(0), scanCacheValid(false),
+      scanState(WIFI_OP_IDLE), scanStartTime(0), connectState(WIFI_OP_IDLE), connectStartTime(0),
+      xStateMutex(NULL) {}
+
+/**
+ * @brief Creates the state mutex and registers the WiFi event handler used by the asynchronous scan and connect.
+ *        Call once before the tasks start.
+ */
+void WiFiManager::init() {
+    xStateMutex = xSemaphoreCreateMutex();
+    WiFi.onEvent(onWiFiEvent);
+}
+
+/**
+ * @brief WiFi event handler, runs in the WiFi event task and only raises flags.
+ * @param event The WiFi event.
+ */
+void WiFiManager::onWiFiEvent(WiFiEvent_t event) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_SCAN_DONE:
+            scanDoneEvent = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            gotIpEvent = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            gotIpEvent = false;
+            break;
+        default:
+            break;
+    }
+}
 
 /**
  * @brief Get the SSID of the WiFi network.
  * @return The SSID of the WiFi network.
  */
-const char* WiFiManager::getSSID() {
-    return ssid.c_str();
+String WiFiManager::getSSID() {
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
+    String value = ssid;
+    xSemaphoreGive(xStateMutex);
+    return value;
 }
 
 /**
  * @brief Get the password of the WiFi network.
  * @return The password of the WiFi network.
  */
-const char* WiFiManager::getPassword() {
-    return password.c_str();
+String WiFiManager::getPassword() {
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
+    String value = password;
+    xSemaphoreGive(xStateMutex);
+    return value;
 }
 
 /**
@@ -33,7 +75,9 @@ const char* WiFiManager::getPassword() {
  * @param ssid The new SSID of the WiFi network.
  */
 void WiFiManager::setSSID(const char* ssid) {
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
     this->ssid = ssid;
+    xSemaphoreGive(xStateMutex);
 }
 
 /**
@@ -41,7 +85,9 @@ void WiFiManager::setSSID(const char* ssid) {
  * @param password The new password of the WiFi network.
  */
 void WiFiManager::setPassword(const char* password) {
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
     this->password = password;
+    xSemaphoreGive(xStateMutex);
 }
 
 /**
@@ -69,48 +115,156 @@ IPAddress WiFiManager::getWiFiLocalIp() {
 }
 
 /**
- * @brief Scans for available WiFi networks and returns a list of SSIDs.
- * @return A vector of SSIDs of available WiFi networks.
+ * @brief Starts an asynchronous scan for WiFi networks.
+ *        Results younger than WIFI_SCAN_CACHE_TTL_MS are reused without scanning.
+ * @param forceRefresh True to ignore the cached results.
+ * @return WIFI_OP_DONE if cached results are available, WIFI_OP_IN_PROGRESS if a scan was started,
+ *         WIFI_OP_FAILED if the scan could not be started.
+ */
+WiFiOpState WiFiManager::startScan(bool forceRefresh) {
+    if (scanState == WIFI_OP_IN_PROGRESS) {
+        return scanState;
+    }
+
+    if (!forceRefresh && scanCacheValid && (millis() - scanCacheTime < WIFI_SCAN_CACHE_TTL_MS)) {
+        scanState = WIFI_OP_DONE;
+        return scanState;
+    }
+
+    scanDoneEvent = false;
+    WiFi.scanDelete();
+    if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+        LogSerialn("WiFi scan could not be started", true);
+        scanState = WIFI_OP_FAILED;
+    } else {
+        scanStartTime = millis();
+        scanState = WIFI_OP_IN_PROGRESS;
+    }
+    return scanState;
+}
+
+/**
+ * @brief Checks the progress of the scan started with startScan.
+ * @param ssidList[OUT] The SSIDs found, filled once the scan is done.
+ * @return The scan state.
+ */
+WiFiOpState WiFiManager::pollScan(std::vector<String>& ssidList) {
+    if (scanState == WIFI_OP_IN_PROGRESS) {
+        int16_t total_networks = scanDoneEvent ? WiFi.scanComplete() : WIFI_SCAN_RUNNING;
+
+        if (total_networks >= 0) {
+            scanCache.clear();
+            for (int16_t curr = 0; curr < total_networks; ++curr) {
+                scanCache.push_back(WiFi.SSID(curr));
+            }
+            WiFi.scanDelete();
+            scanCacheTime = millis();
+            scanCacheValid = true;
+            scanState = WIFI_OP_DONE;
+        } else if (total_networks == WIFI_SCAN_FAILED || millis() - scanStartTime > WIFI_SCAN_TIMEOUT_MS) {
+            LogSerialn("WiFi scan failed", true);
+            scanState = WIFI_OP_FAILED;
+        }
+    }
+
+    if (scanState == WIFI_OP_DONE) {
+        ssidList = scanCache;
+    }
+    return scanState;
+}
+
+/**
+ * @brief Stops the scan started with startScan, so leaving the list does not keep the radio scanning.
+ *        The cached results of an earlier scan are kept.
  */
-std::vector<String> WiFiManager::scanNetworks() {
-    std::vector<String> ssidList;
-    int16_t total_networks = WiFi.scanNetworks();
-    for (uint8_t curr = 0; curr < total_networks; ++curr) {
-        ssidList.push_back(WiFi.SSID(curr));
+void WiFiManager::cancelScan() {
+    if (scanState == WIFI_OP_IN_PROGRESS) {
+        esp_wifi_scan_stop();
+        WiFi.scanDelete();
+        scanDoneEvent = false;
+        LogSerialn("WiFi scan cancelled", true);
     }
-    return ssidList;
+    scanState = WIFI_OP_IDLE;
 }
 
 /**
- * @brief Connects to a specified WiFi network.
+ * @brief Starts connecting to a WiFi network without waiting for the result.
  * @param ssid The SSID of the WiFi network.
  * @param password The password of the WiFi network.
- * @return True if connection is successful, false otherwise.
  */
-bool WiFiManager::connectToNetwork(const String& ssid, const String& password) {
+void WiFiManager::beginConnect(const String& ssid, const String& password) {
     LogSerialn("Connecting to SSID: " + ssid, true);
 
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
+    gotIpEvent = false;
     WiFi.disconnect(true); // Disconnect from any previous network
     WiFi.mode(WIFI_STA);
     WiFi.begin(ssid.c_str(), password.c_str());
 
-    unsigned long startAttemptTime = millis();
-    const unsigned long timeout = 5000;
+    pendingSsid = ssid;
+    pendingPassword = password;
+    connectStartTime = millis();
+    connectState = WIFI_OP_IN_PROGRESS;
+    xSemaphoreGive(xStateMutex);
+}
 
-    while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < timeout) {
-        delay(200);
+/**
+ * @brief Checks the progress of the connection started with beginConnect.
+ *        The credentials are stored once the connection succeeds.
+ * @return The connection state.
+ */
+WiFiOpState WiFiManager::pollConnect() {
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
+    if (connectState != WIFI_OP_IN_PROGRESS) {
+        WiFiOpState state = connectState;
+        xSemaphoreGive(xStateMutex);
+        return state;
     }
 
-    if (WiFi.status() == WL_CONNECTED) {
+    if (gotIpEvent && WiFi.status() == WL_CONNECTED) {
         LogSerialn("WiFi connected!", true);
-        this->ssid = ssid;
-        this->password = password;
-        saveCredentials(ssid, password);
-        return true;
-    } else {
+        this->ssid = pendingSsid;
+        this->password = pendingPassword;
+        saveCredentials(pendingSsid, pendingPassword);
+        connectState = WIFI_OP_DONE;
+    } else if (millis() - connectStartTime >= WIFI_CONNECT_TIMEOUT_MS) {
         LogSerialn("WiFi connection failed.", true);
-        return false;
+        WiFi.disconnect();
+        connectState = WIFI_OP_FAILED;
+    }
+    WiFiOpState state = connectState;
+    xSemaphoreGive(xStateMutex);
+    return state;
+}
+
+/**
+ * @brief Aborts the connection started with beginConnect.
+ */
+void WiFiManager::cancelConnect() {
+    xSemaphoreTake(xStateMutex, portMAX_DELAY);
+    if (connectState == WIFI_OP_IN_PROGRESS) {
+        WiFi.disconnect();
+        LogSerialn("WiFi connection cancelled", true);
     }
+    connectState = WIFI_OP_IDLE;
+    xSemaphoreGive(xStateMutex);
+}
+
+/**
+ * @brief Connects to a specified WiFi network, waiting for the result.
+ * @param ssid The SSID of the WiFi network.
+ * @param password The password of the WiFi network.
+ * @return True if connection is successful, false otherwise.
+ */
+bool WiFiManager::connectToNetwork(const String& ssid, const String& password) {
+    beginConnect(ssid, password);
+
+    WiFiOpState state;
+    while ((state = pollConnect()) == WIFI_OP_IN_PROGRESS) {
+        delay(200);
+    }
+
+    return state == WIFI_OP_DONE;
 }
 
 /**
@@ -1,79 +1,448 @@
 #include "client_classes.h"
 #include <Arduino.h>
-#include <ArduinoJson.h>
 #include "LogMgr.h"
+#include "DeviceId.h"
 #include <HTTPClient.h>
+#include <esp_system.h>
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+
+#define WS_OPCODE_TEXT   (0x1)
+#define WS_OPCODE_BINARY (0x2)
+#define WS_OPCODE_CLOSE  (0x8)
+#define WS_OPCODE_PING   (0x9)
+#define WS_OPCODE_PONG   (0xA)
+#define WS_FIN           (0x80)
+#define WS_MASKED        (0x80)
 
 /**
  * @brief Constructor for ServerClient class.
+ *        The endpoint paths are built once here, the connection is opened by the first request.
+ *        Only plain http:// server URLs are supported.
  * @param serverUrl URL of the backend server.
  * @param wifiManager Pointer to the WiFiManager instance.
  */
 ServerClient::ServerClient(const char* serverUrl, WiFiManager* wifiManager)
-    : serverUrl(serverUrl), wifiManager(wifiManager), payload("{}") {}
+    : serverUrl(serverUrl), wifiManager(wifiManager), pendingRequest(SERVER_REQ_NONE),
+      breakers{{"None", SERVER_BREAKER_THRESHOLD, SERVER_BACKOFF_BASE_MS},
+               {"Settings upload", SERVER_BREAKER_THRESHOLD, SERVER_BACKOFF_BASE_MS},
+               {"Sync", SERVER_BREAKER_THRESHOLD, SERVER_BACKOFF_BASE_MS}},
+      retryTokens(SERVER_RETRY_BUDGET * SERVER_RETRY_EARN_COUNT),
+      channelBreaker("WebSocket channel", 1, SERVER_WS_RECONNECT_MS),
+      mqttBreaker("MQTT broker", 1, SERVER_MQTT_RECONNECT_MS) {
+    String baseUrl = String(serverUrl);
+    if (!baseUrl.endsWith("/")) {
+        baseUrl += "/";
+    }
+
+    String basePath = "/";
+    serverPort = 0;
+    if (baseUrl.startsWith("http://")) {
+        int pathStart = baseUrl.indexOf('/', 7);
+        String hostPort = baseUrl.substring(7, pathStart);
+        int colon = hostPort.indexOf(':');
+        serverHost = (colon < 0) ? hostPort : hostPort.substring(0, colon);
+        serverPort = (colon < 0) ? 80 : hostPort.substring(colon + 1).toInt();
+        basePath = baseUrl.substring(pathStart);
+    } else {
+        LogSerialn("Unsupported server URL, only http:// is supported", true);
+    }
+    http.setServer(serverHost, serverPort);
+
+    updateSettingsPath = basePath + "updateSettings";
+    syncPath = basePath + "sync";
+
+    /* WebSocket channel endpoint on the same server */
+    channelPath = basePath + "ws?chipId=" + deviceIdStr();
+
+    /* MQTT topics of this device, the broker is set by setMqttBroker() */
+    mqttHost = NULL;
+    String topicPrefix = String(SERVER_MQTT_TOPIC_ROOT "/") + deviceIdStr() + "/";
+    telemetryTopic = topicPrefix + "telemetry";
+    settingsTopic = topicPrefix + "settings";
+    statusTopic = topicPrefix + "status";
+
+    memset(&stats, 0, sizeof(stats));
+    settingsEtag[0] = '\0';
+}
 
 /**
- * @brief Sends a JSON payload with settings to the server at /updateSettings.
- * @param settingsPayload The JSON string to send.
+ * @brief Checks if requests to an endpoint are let through by its circuit breaker.
+ *        An open breaker turns half-open once its backoff elapsed, the next request is then the probe.
+ * @param request The endpoint.
+ * @return BREAKER_OPEN if requests are refused.
  */
-void ServerClient::sendSysSettingsPayload(const String& settingsPayload) {
-    HTTPClient http;
-    String fullUrl = String(serverUrl) + "updateSettings";
-    if (serverUrl[strlen(serverUrl) - 1] != '/') {
-        fullUrl = String(serverUrl) + "/updateSettings";
+BreakerState ServerClient::checkEndpoint(ServerRequest request) {
+    return breakers[request].check();
+}
+
+/**
+ * @brief Starts a request on the kept-alive connection.
+ * @param request What the response is used for, see pollRequest().
+ * @param method "GET" or "POST".
+ * @param path Path of the endpoint.
+ * @param contentType Content-Type of the body, NULL without body.
+ * @param body Body to send, NULL for none. Must stay valid until the request completes.
+ * @param bodyLen Length of the body in bytes.
+ * @param ifNoneMatch ETag to send as If-None-Match, NULL to request the resource unconditionally.
+ * @param onBody Receives the response body as it arrives, NULL to discard it.
+ * @param bodyCtx Passed to onBody.
+ * @return True if the request was started, false if the server is not configured, the endpoint breaker is open
+ *         or another request is in progress.
+ */
+bool ServerClient::beginRequest(ServerRequest request, const char* method, const String& path, const char* contentType,
+                                const uint8_t* body, size_t bodyLen, const char* ifNoneMatch, HttpBodyCallback onBody,
+                                void* bodyCtx) {
+    if (serverPort == 0 || pendingRequest != SERVER_REQ_NONE) {
+        return false;
+    }
+    BreakerState breakerState = breakers[request].check();
+    if (breakerState == BREAKER_OPEN) {
+        return false;
     }
+    /* A probe gets no second chance, nor does any request once the retry budget is spent */
+    bool retryAllowed = (breakerState == BREAKER_CLOSED) && (retryTokens >= SERVER_RETRY_EARN_COUNT);
+    if (!http.begin(method, path, contentType, body, bodyLen, ifNoneMatch, onBody, bodyCtx, retryAllowed)) {
+        return false;
+    }
+    pendingRequest = request;
+    return true;
+}
 
+/**
+ * @brief Starts sending a JSON payload with settings to the server at /updateSettings.
+ * @param settingsPayload The null terminated JSON document, must stay valid until the request completes.
+ * @param len Length of the document.
+ * @return True if the request was started.
+ */
+bool ServerClient::beginSettingsUpload(const char* settingsPayload, size_t len) {
     LogSerial("Sending settings payload: ", false);
     LogSerialn(settingsPayload, false);
 
-    http.begin(fullUrl);
-    http.addHeader("Content-Type", "application/json");
-    int httpResponseCode = http.POST(settingsPayload);
+    return beginRequest(SERVER_REQ_SETTINGS_UPLOAD, "POST", updateSettingsPath, "application/json",
+                        (const uint8_t*)settingsPayload, len, NULL, NULL, NULL);
+}
 
-    if (httpResponseCode > 0) {
-        LogSerial("Settings POST successful, response code: ", true);
-        LogSerialn(String(httpResponseCode), true);
+/**
+ * @brief Starts a /sync exchange: uploads a batch of sensor and actuator samples, possibly empty, and downloads
+ *        the settings in the same round trip. The version of the last received settings is sent along,
+ *        the response only carries the settings when they changed. The server time comes with it.
+ * @param batchPayload The encoded batch, must stay valid until the request completes.
+ * @param len Length of the encoded batch in bytes.
+ * @param contentType "application/json" or "application/cbor".
+ * @param onBody Receives the response body as it arrives, so it can be parsed without being buffered whole.
+ * @param bodyCtx Passed to onBody.
+ * @return True if the request was started.
+ */
+bool ServerClient::beginSync(const uint8_t* batchPayload, size_t len, const char* contentType, HttpBodyCallback onBody,
+                             void* bodyCtx) {
+    return beginRequest(SERVER_REQ_SYNC, "POST", syncPath, contentType, batchPayload, len, settingsEtag, onBody, bodyCtx);
+}
+
+/**
+ * @brief Advances the request in progress without waiting. When it completes the counters are updated,
+ *        the settings version is kept, and the outcome is logged.
+ * @return HTTP_OP_IN_PROGRESS while running, then HTTP_OP_DONE (any HTTP response) or HTTP_OP_FAILED once,
+ *         HTTP_OP_IDLE when no request is in progress. See getResponseCode().
+ */
+HttpOpState ServerClient::pollRequest() {
+    if (pendingRequest == SERVER_REQ_NONE) {
+        return HTTP_OP_IDLE;
+    }
+    HttpOpState state = http.poll();
+    if (state == HTTP_OP_IN_PROGRESS) {
+        return state;
+    }
+
+    ServerRequest request = pendingRequest;
+    pendingRequest = SERVER_REQ_NONE;
+    int httpResponseCode = http.getStatusCode();
+
+    if (state == HTTP_OP_DONE) {
+        stats.requests++;
+        stats.reusedConnections += http.wasReused() ? 1 : 0;
+        stats.lastLatencyMs = http.getLatencyMs();
+        stats.totalLatencyMs += stats.lastLatencyMs;
     } else {
-        LogSerial("Settings POST failed, error: ", true);
-        LogSerialn(http.errorToString(httpResponseCode).c_str(), true);
+        stats.failures++;
+    }
+    if (http.wasRetried()) {
+        stats.reconnects++;
+        retryTokens -= SERVER_RETRY_EARN_COUNT;
+    } else if (http.wasRetrySkipped()) {
+        stats.retriesSkipped++;
+    }
+
+    /* Only a response, or the rejection of a bad payload, shows the endpoint is up. Server errors, timeouts,
+       throttling, missing routes and refused credentials count as failures */
+    if (state == HTTP_OP_DONE && (httpResponseCode < 400 || isPayloadRejected(httpResponseCode))) {
+        breakers[request].recordSuccess();
+        if (retryTokens < SERVER_RETRY_BUDGET * SERVER_RETRY_EARN_COUNT) {
+            retryTokens++;
+        }
+    } else if (breakers[request].recordFailure()) {
+        stats.breakerTrips++;
+    }
+
+    switch (request) {
+        case SERVER_REQ_SETTINGS_UPLOAD:
+            storeSettingsEtag(httpResponseCode); /* The server already has these settings, no need to download them back */
+            if (state == HTTP_OP_DONE) {
+                LogSerial("Settings POST successful, response code: ", true);
+                LogSerialn(String(httpResponseCode) + " (" + String(stats.lastLatencyMs) + " ms)", true);
+            } else {
+                LogSerial("Settings POST failed, error: ", true);
+                LogSerialn(HTTPClient::errorToString(httpResponseCode).c_str(), true);
+            }
+            break;
+
+        case SERVER_REQ_SYNC:
+            storeSettingsEtag(httpResponseCode);
+            if (state == HTTP_OP_DONE) {
+                LogSerial("Sync response code: ", true);
+                LogSerialn(String(httpResponseCode) + " (" + String(stats.lastLatencyMs) + " ms)", true);
+            } else {
+                LogSerial("Sync failed, error: ", true);
+                LogSerialn(HTTPClient::errorToString(httpResponseCode).c_str(), true);
+            }
+            break;
+
+        default:
+            break;
     }
-    http.end();
+    return state;
 }
 
 /**
- * @brief Sends a JSON payload with sensor and actuator history to the server at /updateSensActHistory.
- * @param sensActPayload The JSON string to send.
+ * @brief Aborts the request in progress, e.g. when WiFi is lost. The connection is closed.
  */
-void ServerClient::sendSensActHistoryPayload(const String& sensActPayload) {
-    HTTPClient http;
-    String fullUrl = String(serverUrl) + "updateSensActHistory";
-    if (serverUrl[strlen(serverUrl) - 1] != '/') {
-        fullUrl = String(serverUrl) + "/updateSensActHistory";
+void ServerClient::cancelRequest() {
+    if (pendingRequest != SERVER_REQ_NONE) {
+        http.stop();
+        pendingRequest = SERVER_REQ_NONE;
+        stats.failures++;
     }
+}
 
-    LogSerial("Sending sensor/actuator history payload: ", false);
-    LogSerialn(sensActPayload, false);
+/**
+ * @brief Returns the outcome of the last completed request.
+ * @return HTTP response code, or a negative HTTPClient error code.
+ */
+int ServerClient::getResponseCode() {
+    return http.getStatusCode();
+}
 
-    http.begin(fullUrl);
-    http.addHeader("Content-Type", "application/json");
-    int httpResponseCode = http.POST(sensActPayload);
+/**
+ * @brief Checks if a status says the payload itself is bad: 400 (Bad Request) or 413 (Payload Too Large).
+ *        The same payload would be refused again. Other 4xx, such as 401/403 from a proxy or 404 from a server
+ *        without the route, say nothing about the payload and are retried.
+ * @param httpResponseCode HTTP response code, or the status of a channel error reply.
+ * @return True if the payload was rejected.
+ */
+bool ServerClient::isPayloadRejected(int httpResponseCode) {
+    return (httpResponseCode == HTTP_CODE_BAD_REQUEST) || (httpResponseCode == HTTP_CODE_PAYLOAD_TOO_LARGE);
+}
 
-    if (httpResponseCode > 0) {
-        LogSerial("SensActHistory POST successful, response code: ", true);
-        LogSerialn(String(httpResponseCode), true);
+/**
+ * @brief Checks if the server refused the payload of the last completed request, see isPayloadRejected().
+ * @return True if the request was rejected.
+ */
+bool ServerClient::responseRejected() {
+    return isPayloadRejected(http.getStatusCode());
+}
+
+/**
+ * @brief Returns the length of the response body of the last completed request.
+ * @return Number of body bytes received.
+ */
+size_t ServerClient::getResponseLength() {
+    return http.getResponseLength();
+}
+
+/**
+ * @brief Keeps the settings version returned by the server, or forgets it if the request failed.
+ * @param httpResponseCode Response code of the settings request.
+ */
+void ServerClient::storeSettingsEtag(int httpResponseCode) {
+    if (httpResponseCode == HTTP_CODE_OK) {
+        strlcpy(settingsEtag, http.getEtag(), sizeof(settingsEtag));
     } else {
-        LogSerial("SensActHistory POST failed, error: ", true);
-        LogSerialn(http.errorToString(httpResponseCode).c_str(), true);
+        settingsEtag[0] = '\0'; /* Unknown version, the next fetch downloads the settings */
+    }
+}
+
+/**
+ * @brief Forgets the settings version so the next fetch downloads the settings, e.g. when they could not be applied.
+ */
+void ServerClient::clearSettingsVersion() {
+    settingsEtag[0] = '\0';
+}
+
+/**
+ * @brief Opens the WebSocket channel if it is closed. After a failed attempt the next one waits for the
+ *        channel breaker backoff, SERVER_WS_RECONNECT_MS doubled after each further failure.
+ * @return True if the channel has just been (re)opened.
+ */
+bool ServerClient::maintainChannel() {
+    if (serverPort == 0 || channel.isOpen() || channelBreaker.check() == BREAKER_OPEN) {
+        return false;
+    }
+
+    if (!channel.connect(serverHost.c_str(), serverPort, channelPath.c_str())) {
+        LogSerialn("WebSocket channel unavailable, using HTTP", true);
+        channelBreaker.recordFailure();
+        return false;
     }
-    http.end();
+    channelBreaker.recordSuccess();
+    LogSerialn("WebSocket channel connected", true);
+    return true;
+}
+
+/**
+ * @brief Checks if the WebSocket channel is open.
+ * @return True if telemetry can be sent over the channel.
+ */
+bool ServerClient::channelConnected() {
+    return channel.isOpen();
+}
+
+/**
+ * @brief Sends a message over the WebSocket channel.
+ * @param payload The message.
+ * @param len Length of the message.
+ * @param binary True for a binary frame (CBOR), false for a text frame (JSON).
+ * @return True if the frame was written, the channel is closed otherwise.
+ */
+bool ServerClient::channelSend(const uint8_t* payload, size_t len, bool binary) {
+    return channel.send(payload, len, binary);
+}
+
+/**
+ * @brief Waits for a message from the server on the WebSocket channel.
+ * @param message[OUT] Buffer receiving the null terminated message.
+ * @param capacity Size of the buffer.
+ * @param len[OUT] Length of the message.
+ * @param timeoutMs Time to wait, 0 to only check for a pending message.
+ * @return 1 if a message was received, 0 if none arrived in time, -1 if the channel is closed.
+ */
+int ServerClient::channelReceive(char* message, size_t capacity, size_t* len, uint32_t timeoutMs) {
+    return channel.receive(message, capacity, len, timeoutMs);
+}
+
+/**
+ * @brief Closes the WebSocket channel, it is reopened by maintainChannel().
+ */
+void ServerClient::closeChannel() {
+    channel.close();
 }
 
 /**
- * @brief Closes the HTTP connection (minimal cleanup).
+ * @brief Selects the MQTT broker, the connection is opened by maintainMqtt().
+ * @param host Broker host name or IP, listening on SERVER_MQTT_PORT.
+ */
+void ServerClient::setMqttBroker(const char* host) {
+    mqttHost = host;
+}
+
+/**
+ * @brief Connects to the broker if the connection is closed. After a failed attempt the next one waits for the
+ *        broker breaker backoff, SERVER_MQTT_RECONNECT_MS doubled after each further failure.
+ *        The status topic is set to "online", with "offline" as last will, and the settings topic is subscribed.
+ * @return True if the connection has just been (re)opened; the retained settings follow.
+ */
+bool ServerClient::maintainMqtt() {
+    if (mqttHost == NULL || mqtt.isOpen() || mqttBreaker.check() == BREAKER_OPEN) {
+        return false;
+    }
+
+    if (!mqtt.connect(mqttHost, SERVER_MQTT_PORT, deviceIdStr(), statusTopic.c_str(), "offline")) {
+        LogSerialn("MQTT broker unavailable", true);
+        mqttBreaker.recordFailure();
+        return false;
+    }
+    if (!mqtt.publish(statusTopic.c_str(), (const uint8_t*)"online", 6, 0, true) ||
+        !mqtt.subscribe(settingsTopic.c_str(), 1)) {
+        mqttBreaker.recordFailure();
+        return false;
+    }
+    mqttBreaker.recordSuccess();
+    LogSerialn("MQTT connected, telemetry on " + telemetryTopic, true);
+    return true;
+}
+
+/**
+ * @brief Checks if the broker connection is open.
+ * @return True if the broker connection is open.
+ */
+bool ServerClient::mqttConnected() {
+    return mqtt.isOpen();
+}
+
+/**
+ * @brief Publishes a telemetry batch with QoS 0.
+ * @param payload The encoded batch, CBOR or JSON.
+ * @param len Length of the encoded batch.
+ * @return True if the batch was written to the broker connection.
+ */
+bool ServerClient::mqttPublishTelemetry(const uint8_t* payload, size_t len) {
+    uint32_t startTime = millis();
+    bool published = mqtt.publish(telemetryTopic.c_str(), payload, len, 0, false);
+
+    if (published) {
+        stats.requests++;
+        stats.lastLatencyMs = millis() - startTime;
+        stats.totalLatencyMs += stats.lastLatencyMs;
+    } else {
+        stats.failures++;
+        LogSerialn("SensActHistory batch publish failed", true);
+    }
+    return published;
+}
+
+/**
+ * @brief Publishes the settings as a retained QoS 1 message, kept for retransmission until acknowledged.
+ * @param settingsPayload The null terminated JSON settings object.
+ * @param len Length of the settings object.
+ * @return True if the message was accepted for delivery.
+ */
+bool ServerClient::mqttPublishSettings(const char* settingsPayload, size_t len) {
+    LogSerial("Publishing settings: ", false);
+    LogSerialn(settingsPayload, false);
+    return mqtt.publish(settingsTopic.c_str(), (const uint8_t*)settingsPayload, len, 1, true);
+}
+
+/**
+ * @brief Waits for a settings message from the broker.
+ * @param settingsPayload[OUT] Buffer receiving the null terminated settings object.
+ * @param capacity Size of the buffer.
+ * @param len[OUT] Length of the settings object.
+ * @param timeoutMs Time to wait, 0 to only check for a pending message.
+ * @return 1 if settings were received, 0 if none arrived in time, -1 if the connection is closed.
+ */
+int ServerClient::mqttReceiveSettings(char* settingsPayload, size_t capacity, size_t* len, uint32_t timeoutMs) {
+    char topic[MQTT_MAX_TOPIC];
+    uint32_t start = millis();
+
+    for (;;) {
+        uint32_t elapsed = millis() - start;
+        int result = mqtt.receive(topic, sizeof(topic), (uint8_t*)settingsPayload, capacity - 1, len,
+                                  (elapsed < timeoutMs) ? (timeoutMs - elapsed) : 0);
+        if (result <= 0) {
+            return result;
+        }
+        if (settingsTopic == topic) {
+            settingsPayload[*len] = '\0';
+            return 1;
+        }
+    }
+}
+
+/**
+ * @brief Closes the kept-alive connection to the server.
  */
 void ServerClient::closeConnection() {
-    HTTPClient http;
-    http.end(); /* Ensure connection cleanup */
+    cancelRequest();
+    http.stop();
 }
 
 /**
@@ -82,4 +451,868 @@ void ServerClient::closeConnection() {
  */
 const char* ServerClient::getServerUrl() {
     return serverUrl;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Returns the request counters of the backend connection.
+ * @return The request counters.
+ */
+const ServerClientStats& ServerClient::getStats() {
+    return stats;
+}
+
+/**
+ * @brief Returns the state of the most degraded breaker of the selected transport: the HTTP endpoints,
+ *        or the broker connection with MQTT. The WebSocket channel is left out, HTTP covers for it.
+ *        Safe to call from another task, nothing is updated.
+ * @return BREAKER_CLOSED while the backend is reachable.
+ */
+BreakerState ServerClient::getHealth() {
+    BreakerState health = (mqttHost != NULL) ? mqttBreaker.getState() : BREAKER_CLOSED;
+    for (uint8_t request = SERVER_REQ_NONE + 1; request < SERVER_REQ_COUNT; ++request) {
+        BreakerState state = breakers[request].getState();
+        health = (state > health) ? state : health;
+    }
+    return health;
+}
+
+/**
+ * @brief Constructor for CircuitBreaker class.
+ * @param name Endpoint name used in the logs.
+ * @param threshold Consecutive failures that open the breaker.
+ * @param baseMs Backoff after the breaker opens, before jitter.
+ */
+CircuitBreaker::CircuitBreaker(const char* name, uint8_t threshold, uint32_t baseMs)
+    : name(name), threshold(threshold), baseMs(baseMs), state(BREAKER_CLOSED), failures(0), backoffLevel(0),
+      openTime(0), backoffMs(0), trips(0) {
+}
+
+/**
+ * @brief Checks if a request may go through, an open breaker turns half-open once its backoff elapsed.
+ * @return The breaker state, requests are refused while it is BREAKER_OPEN.
+ */
+BreakerState CircuitBreaker::check() {
+    if (state == BREAKER_OPEN && (millis() - openTime >= backoffMs)) {
+        state = BREAKER_HALF_OPEN;
+        LogSerialn(String(name) + " breaker half-open, probing", true);
+    }
+    return state;
+}
+
+/**
+ * @brief Returns the breaker state without updating it.
+ * @return The breaker state.
+ */
+BreakerState CircuitBreaker::getState() {
+    return state;
+}
+
+/**
+ * @brief Records a successful request, which closes the breaker.
+ */
+void CircuitBreaker::recordSuccess() {
+    if (state != BREAKER_CLOSED) {
+        LogSerialn(String(name) + " breaker closed", true);
+    }
+    state = BREAKER_CLOSED;
+    failures = 0;
+    backoffLevel = 0;
+}
+
+/**
+ * @brief Records a failed request. The breaker opens on the threshold-th consecutive failure or a failed probe,
+ *        for a backoff doubled after each failed probe, with equal jitter so devices do not retry in step.
+ * @return True if the breaker has just opened.
+ */
+bool CircuitBreaker::recordFailure() {
+    if (failures < UINT8_MAX) {
+        failures++;
+    }
+    if (state == BREAKER_CLOSED && failures < threshold) {
+        return false;
+    }
+
+    if (state == BREAKER_HALF_OPEN && backoffLevel < 31) {
+        backoffLevel++;
+    }
+    uint32_t nominal = baseMs << backoffLevel;
+    if (nominal > SERVER_BACKOFF_MAX_MS || (nominal >> backoffLevel) != baseMs) {
+        nominal = SERVER_BACKOFF_MAX_MS;
+    }
+    backoffMs = nominal / 2 + esp_random() % (nominal / 2 + 1);
+    openTime = millis();
+    bool opened = (state == BREAKER_CLOSED);
+    state = BREAKER_OPEN;
+    trips += opened ? 1 : 0;
+    LogSerialn(String(name) + " breaker open, retry in " + String(backoffMs) + " ms", true);
+    return opened;
+}
+
+/**
+ * @brief Returns the time left before an open breaker lets a probe through.
+ * @return Remaining backoff in ms, 0 unless the breaker is open.
+ */
+uint32_t CircuitBreaker::getRetryInMs() {
+    uint32_t elapsed = millis() - openTime;
+    return (state == BREAKER_OPEN && elapsed < backoffMs) ? backoffMs - elapsed : 0;
+}
+
+/**
+ * @brief Returns how many times the breaker opened.
+ * @return Number of times it went from closed to open.
+ */
+uint32_t CircuitBreaker::getTrips() {
+    return trips;
+}
+
+/**
+ * @brief Encodes bytes as base64, used for the handshake key.
+ * @param data Bytes to encode.
+ * @param len Number of bytes.
+ * @param out[OUT] Null terminated base64 text, at least 4 * ((len + 2) / 3) + 1 bytes.
+ */
+static void base64Encode(const uint8_t* data, size_t len, char* out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t group = (uint32_t)data[i] << 16;
+        if (i + 1 < len) group |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) group |= data[i + 2];
+        *out++ = alphabet[(group >> 18) & 0x3F];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        *out++ = (i + 1 < len) ? alphabet[(group >> 6) & 0x3F] : '=';
+        *out++ = (i + 2 < len) ? alphabet[group & 0x3F] : '=';
+    }
+    *out = '\0';
+}
+
+/**
+ * @brief Constructor for WebSocketClient class.
+ */
+WebSocketClient::WebSocketClient() : open(false), lastRxTime(0), readStart(0) {}
+
+/**
+ * @brief Opens the TCP connection and performs the WebSocket handshake, within SERVER_HTTP_TIMEOUT_MS
+ *        altogether so a slow server cannot hold the server task longer. The server is trusted, only the 101 status
+ *        is checked.
+ * @param host Server host name or IP.
+ * @param port Server port.
+ * @param path Request path, query included.
+ * @return True if the channel is open.
+ */
+bool WebSocketClient::connect(const char* host, uint16_t port, const char* path) {
+    close();
+    readStart = millis();
+    if (!tcp.connect(host, port, SERVER_HTTP_TIMEOUT_MS)) {
+        return false;
+    }
+    tcp.setNoDelay(true);
+
+    uint8_t nonce[16];
+    char key[25];
+    for (uint8_t i = 0; i < sizeof(nonce); i += 4) {
+        uint32_t random = esp_random();
+        memcpy(&nonce[i], &random, 4);
+    }
+    base64Encode(nonce, sizeof(nonce), key);
+
+    char request[256];
+    int requestLen = snprintf(request, sizeof(request),
+        "GET %s HTTP/1.1\r\nHost: %s:%u\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        path, host, port, key);
+    if (requestLen <= 0 || requestLen >= (int)sizeof(request) ||
+        tcp.write((const uint8_t*)request, requestLen) != (size_t)requestLen) {
+        tcp.stop();
+        return false;
+    }
+
+    /* Status line, then skip the headers up to the empty line */
+    char line[128];
+    if (!readLine(line, sizeof(line)) || strncmp(line, "HTTP/1.1 101", 12) != 0) {
+        tcp.stop();
+        return false;
+    }
+    do {
+        if (!readLine(line, sizeof(line))) {
+            tcp.stop();
+            return false;
+        }
+    } while (line[0] != '\0');
+
+    open = true;
+    lastRxTime = millis();
+    return true;
+}
+
+/**
+ * @brief Closes the connection without waiting for the close handshake.
+ */
+void WebSocketClient::close() {
+    if (open) {
+        writeFrame(WS_OPCODE_CLOSE, NULL, 0);
+    }
+    open = false;
+    tcp.stop();
+}
+
+/**
+ * @brief Checks if the channel is open.
+ * @return True if the channel is open.
+ */
+bool WebSocketClient::isOpen() {
+    if (open && !tcp.connected() && tcp.available() == 0) {
+        close(); /* Closed by the server or the network */
+    }
+    return open;
+}
+
+/**
+ * @brief Sends a data frame.
+ * @param payload The message.
+ * @param len Length of the message, up to SERVER_WS_MAX_FRAME.
+ * @param binary True for a binary frame, false for a text frame.
+ * @return True if the frame was written, the channel is closed otherwise.
+ */
+bool WebSocketClient::send(const uint8_t* payload, size_t len, bool binary) {
+    if (!open || len > SERVER_WS_MAX_FRAME) {
+        return false;
+    }
+    if (!writeFrame(binary ? WS_OPCODE_BINARY : WS_OPCODE_TEXT, payload, len)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Waits for a data frame, answering pings and dropping pongs meanwhile.
+ * @param message[OUT] Buffer receiving the null terminated message.
+ * @param capacity Size of the buffer.
+ * @param len[OUT] Length of the message.
+ * @param timeoutMs Time to wait, 0 to only check for a pending frame.
+ * @return 1 if a message was received, 0 if none arrived in time, -1 if the channel is closed.
+ */
+int WebSocketClient::receive(char* message, size_t capacity, size_t* len, uint32_t timeoutMs) {
+    uint32_t start = millis();
+
+    for (;;) {
+        if (!isOpen()) {
+            return -1;
+        }
+        if (tcp.available() > 0) {
+            int result = readFrame(message, capacity, len);
+            if (result != 0) {
+                return result;
+            }
+            continue; /* Control frame handled */
+        }
+        if (millis() - lastRxTime >= SERVER_WS_IDLE_TIMEOUT_MS) {
+            close();
+            return -1;
+        }
+        if (millis() - start >= timeoutMs) {
+            return 0;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * @brief Writes one masked frame, client frames must be masked.
+ * @param opcode Frame opcode.
+ * @param payload Frame payload, may be NULL if len is 0.
+ * @param len Length of the payload, below 65536.
+ * @return True if the whole frame was written.
+ */
+bool WebSocketClient::writeFrame(uint8_t opcode, const uint8_t* payload, size_t len) {
+    uint8_t header[8];
+    uint8_t headerLen = 0;
+    uint32_t maskKey = esp_random();
+    uint8_t* mask;
+
+    header[headerLen++] = WS_FIN | opcode;
+    if (len < 126) {
+        header[headerLen++] = WS_MASKED | (uint8_t)len;
+    } else {
+        header[headerLen++] = WS_MASKED | 126;
+        header[headerLen++] = (uint8_t)(len >> 8);
+        header[headerLen++] = (uint8_t)len;
+    }
+    mask = &header[headerLen];
+    memcpy(mask, &maskKey, 4);
+    headerLen += 4;
+
+    if (tcp.write(header, headerLen) != headerLen) {
+        return false;
+    }
+
+    /* Mask through a small buffer so the caller's payload is left untouched */
+    uint8_t chunk[64];
+    for (size_t offset = 0; offset < len; offset += sizeof(chunk)) {
+        size_t chunkLen = (len - offset < sizeof(chunk)) ? (len - offset) : sizeof(chunk);
+        for (size_t i = 0; i < chunkLen; ++i) {
+            chunk[i] = payload[offset + i] ^ mask[(offset + i) & 3];
+        }
+        if (tcp.write(chunk, chunkLen) != chunkLen) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one frame, the first byte is already available. The whole frame must arrive within
+ *        SERVER_HTTP_TIMEOUT_MS.
+ * @param message[OUT] Buffer receiving the null terminated data frame payload.
+ * @param capacity Size of the buffer.
+ * @param len[OUT] Length of the payload.
+ * @return 1 for a data frame, 0 for a handled control or dropped frame, -1 if the channel was closed.
+ */
+int WebSocketClient::readFrame(char* message, size_t capacity, size_t* len) {
+    uint8_t header[2];
+    readStart = millis();
+    if (!readExact(header, sizeof(header)) || (header[1] & WS_MASKED)) {
+        close(); /* Truncated, or masked which servers must not do */
+        return -1;
+    }
+
+    uint8_t opcode = header[0] & 0x0F;
+    size_t payloadLen = header[1] & 0x7F;
+    if (payloadLen == 126) {
+        uint8_t ext[2];
+        if (!readExact(ext, sizeof(ext))) {
+            close();
+            return -1;
+        }
+        payloadLen = ((size_t)ext[0] << 8) | ext[1];
+    } else if (payloadLen == 127) {
+        close(); /* Never sent by the backend */
+        return -1;
+    }
+    lastRxTime = millis();
+
+    if ((opcode == WS_OPCODE_TEXT || opcode == WS_OPCODE_BINARY) && payloadLen < capacity) {
+        if (!readExact((uint8_t*)message, payloadLen)) {
+            close();
+            return -1;
+        }
+        message[payloadLen] = '\0';
+        *len = payloadLen;
+        return 1;
+    }
+
+    if (opcode == WS_OPCODE_PING && payloadLen <= 125) {
+        uint8_t ping[125];
+        if (!readExact(ping, payloadLen) || !writeFrame(WS_OPCODE_PONG, ping, payloadLen)) {
+            close();
+            return -1;
+        }
+        return 0;
+    }
+
+    if (opcode == WS_OPCODE_CLOSE) {
+        discard(payloadLen);
+        close();
+        return -1;
+    }
+
+    if (opcode == WS_OPCODE_TEXT || opcode == WS_OPCODE_BINARY) {
+        LogSerialn("WebSocket message too large, dropped", true);
+    }
+    if (!discard(payloadLen)) {
+        close();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads exactly len bytes, as long as SERVER_HTTP_TIMEOUT_MS has not passed since readStart.
+ *        A server sending a byte at a time cannot extend the deadline of the handshake or frame.
+ * @param buf[OUT] Destination buffer.
+ * @param len Number of bytes to read.
+ * @return True if all bytes were read.
+ */
+bool WebSocketClient::readExact(uint8_t* buf, size_t len) {
+    size_t received = 0;
+
+    while (received < len) {
+        if (tcp.available() > 0) {
+            int n = tcp.read(&buf[received], len - received);
+            if (n > 0) {
+                received += n;
+                continue;
+            }
+        }
+        if (!tcp.connected() || (millis() - readStart >= SERVER_HTTP_TIMEOUT_MS)) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return true;
+}
+
+/**
+ * @brief Skips the payload of a frame that is not returned to the caller.
+ * @param len Number of bytes to skip.
+ * @return True if all bytes were skipped.
+ */
+bool WebSocketClient::discard(size_t len) {
+    uint8_t chunk[64];
+    while (len > 0) {
+        size_t chunkLen = (len < sizeof(chunk)) ? len : sizeof(chunk);
+        if (!readExact(chunk, chunkLen)) {
+            return false;
+        }
+        len -= chunkLen;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one CRLF terminated handshake line, longer lines are truncated.
+ * @param line[OUT] The line without its line ending.
+ * @param capacity Size of the line buffer.
+ * @return True if a complete line was read.
+ */
+bool WebSocketClient::readLine(char* line, size_t capacity) {
+    size_t len = 0;
+    uint8_t c;
+
+    for (;;) {
+        if (!readExact(&c, 1)) {
+            return false;
+        }
+        if (c == '\n') {
+            break;
+        }
+        if (c != '\r' && len < capacity - 1) {
+            line[len++] = (char)c;
+        }
+    }
+    line[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Constructor for AsyncHttpClient class.
+ */
+AsyncHttpClient::AsyncHttpClient()
+    : port(0), addressResolved(false), address(0), sock(-1), state(HTTP_OP_IDLE), phase(PHASE_CONNECT),
+      reused(false), retryAllowed(false), retried(false), retrySkipped(false), body(NULL), bodyLen(0), sent(0), onBody(NULL), bodyCtx(NULL),
+      responseLen(0), statusCode(0), remaining(0), chunked(false), closeAfter(false),
+      lineLen(0), startTime(0), latencyMs(0) {
+    etag[0] = '\0';
+}
+
+/**
+ * @brief Sets the server all requests go to.
+ * @param host Host name or IPv4 address.
+ * @param port TCP port.
+ */
+void AsyncHttpClient::setServer(const String& host, uint16_t port) {
+    stop();
+    this->host = host;
+    this->port = port;
+    addressResolved = false;
+}
+
+/**
+ * @brief Starts a request. The kept-alive connection is used if there is one, a new one is opened otherwise.
+ * @param method "GET" or "POST".
+ * @param path Path and query of the resource.
+ * @param contentType Content-Type of the body, NULL without body.
+ * @param body Body to send, NULL for none. Must stay valid until the request completes.
+ * @param bodyLen Length of the body in bytes.
+ * @param ifNoneMatch ETag to send as If-None-Match, NULL or empty to request the resource unconditionally.
+ * @param onBody Receives the response body as it arrives, NULL to discard it.
+ * @param bodyCtx Passed to onBody.
+ * @param retryAllowed True to send the request again on a new connection if the kept-alive one turns out closed.
+ * @return True if the request was started, false if another one is in progress.
+ */
+bool AsyncHttpClient::begin(const char* method, const String& path, const char* contentType, const uint8_t* body,
+                            size_t bodyLen, const char* ifNoneMatch, HttpBodyCallback onBody, void* bodyCtx,
+                            bool retryAllowed) {
+    if (state == HTTP_OP_IN_PROGRESS) {
+        return false;
+    }
+
+    request = String(method) + " " + path + " HTTP/1.1\r\nHost: " + host + ":" + String(port) + "\r\n";
+    if (ifNoneMatch != NULL && ifNoneMatch[0] != '\0') {
+        request += "If-None-Match: " + String(ifNoneMatch) + "\r\n";
+    }
+    if (body != NULL) {
+        request += "Content-Type: " + String(contentType) + "\r\nContent-Length: " + String((uint32_t)bodyLen) + "\r\n";
+    }
+    request += "\r\n";
+
+    this->body = body;
+    this->bodyLen = (body != NULL) ? bodyLen : 0;
+    this->onBody = onBody;
+    this->bodyCtx = bodyCtx;
+    this->retryAllowed = retryAllowed;
+    retried = false;
+    retrySkipped = false;
+    startTime = millis();
+    state = HTTP_OP_IN_PROGRESS;
+    restart();
+    return true;
+}
+
+/**
+ * @brief (Re)sends the current request from the start, on the kept-alive connection if there is one.
+ */
+void AsyncHttpClient::restart() {
+    sent = 0;
+    responseLen = 0;
+    statusCode = 0;
+    remaining = 0;
+    chunked = false;
+    closeAfter = false;
+    lineLen = 0;
+    etag[0] = '\0';
+
+    reused = (sock >= 0);
+    if (reused) {
+        phase = PHASE_SEND;
+    } else if (!openSocket()) {
+        fail(HTTPC_ERROR_CONNECTION_REFUSED);
+    }
+}
+
+/**
+ * @brief Starts a non-blocking connection to the server, the outcome is checked by poll().
+ *        The host name is resolved once, IPv4 literals need no lookup.
+ * @return False if the connection could not be started.
+ */
+bool AsyncHttpClient::openSocket() {
+    if (!addressResolved) {
+        struct in_addr addr;
+        if (inet_aton(host.c_str(), &addr)) {
+            address = addr.s_addr;
+        } else {
+            struct addrinfo hints;
+            struct addrinfo* result = NULL;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            if (getaddrinfo(host.c_str(), NULL, &hints, &result) != 0 || result == NULL) {
+                return false;
+            }
+            address = ((struct sockaddr_in*)result->ai_addr)->sin_addr.s_addr;
+            freeaddrinfo(result);
+        }
+        addressResolved = true;
+    }
+
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        return false;
+    }
+    int flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in server;
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = address;
+    if (connect(sock, (struct sockaddr*)&server, sizeof(server)) < 0 && errno != EINPROGRESS) {
+        closeSocket();
+        return false;
+    }
+    phase = PHASE_CONNECT;
+    return true;
+}
+
+/**
+ * @brief Closes the connection.
+ */
+void AsyncHttpClient::closeSocket() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+}
+
+/**
+ * @brief Completes the request successfully, the connection is kept unless the server asked to close it.
+ */
+void AsyncHttpClient::finish() {
+    if (closeAfter) {
+        closeSocket();
+    }
+    latencyMs = millis() - startTime;
+    state = HTTP_OP_DONE;
+}
+
+/**
+ * @brief Ends the request with an error. A kept-alive connection the server closed in the meantime
+ *        fails before any response byte, the request is then sent once more on a new connection if allowed.
+ * @param error Negative HTTPClient error code.
+ */
+void AsyncHttpClient::fail(int error) {
+    closeSocket();
+    bool stale = reused && !retried && statusCode == 0 && (millis() - startTime < SERVER_HTTP_TIMEOUT_MS);
+    if (stale && retryAllowed) {
+        retried = true;
+        restart();
+        return;
+    }
+    retrySkipped = stale;
+    statusCode = error;
+    latencyMs = millis() - startTime;
+    state = HTTP_OP_FAILED;
+}
+
+/**
+ * @brief Aborts the request in progress and closes the connection.
+ */
+void AsyncHttpClient::stop() {
+    closeSocket();
+    if (state == HTTP_OP_IN_PROGRESS) {
+        statusCode = HTTPC_ERROR_CONNECTION_LOST;
+        state = HTTP_OP_FAILED;
+    }
+}
+
+/**
+ * @brief Advances the request with the data the socket can take or has available, without waiting.
+ * @return The request state, HTTP_OP_DONE as soon as the whole response is received.
+ */
+HttpOpState AsyncHttpClient::poll() {
+    if (state != HTTP_OP_IN_PROGRESS) {
+        return state;
+    }
+    if (millis() - startTime >= SERVER_HTTP_TIMEOUT_MS) {
+        fail(HTTPC_ERROR_READ_TIMEOUT);
+        return state;
+    }
+
+    if (phase == PHASE_CONNECT) {
+        fd_set writable;
+        struct timeval noWait = { 0, 0 };
+        FD_ZERO(&writable);
+        FD_SET(sock, &writable);
+        if (select(sock + 1, NULL, &writable, NULL, &noWait) <= 0) {
+            return state; /* Still connecting */
+        }
+        int error = 0;
+        socklen_t errorLen = sizeof(error);
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &errorLen) < 0 || error != 0) {
+            fail(HTTPC_ERROR_CONNECTION_REFUSED);
+            return state;
+        }
+        phase = PHASE_SEND;
+    }
+
+    if (phase == PHASE_SEND) {
+        size_t headerLen = request.length();
+        while (sent < headerLen + bodyLen) {
+            const uint8_t* chunk = (sent < headerLen) ? (const uint8_t*)request.c_str() + sent : body + (sent - headerLen);
+            size_t chunkLen = (sent < headerLen) ? headerLen - sent : bodyLen - (sent - headerLen);
+            ssize_t written = send(sock, chunk, chunkLen, 0);
+            if (written < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return state; /* Send buffer full, continue on the next poll */
+                }
+                fail(HTTPC_ERROR_SEND_PAYLOAD_FAILED);
+                return state;
+            }
+            sent += written;
+        }
+        phase = PHASE_STATUS;
+    }
+
+    uint8_t buf[128];
+    while (state == HTTP_OP_IN_PROGRESS) {
+        ssize_t received = recv(sock, buf, sizeof(buf), 0);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(HTTPC_ERROR_CONNECTION_LOST);
+            }
+            break;
+        }
+        if (received == 0) {
+            /* Closed by the server, which completes a body without length */
+            if (phase == PHASE_BODY && remaining < 0) {
+                closeAfter = true;
+                finish();
+            } else {
+                fail(HTTPC_ERROR_CONNECTION_LOST);
+            }
+            break;
+        }
+        consume(buf, received);
+    }
+    return state;
+}
+
+/**
+ * @brief Parses received response bytes: status line, headers, then the body with a length, chunked, or up to the close.
+ * @param data Received bytes.
+ * @param len Number of bytes.
+ */
+void AsyncHttpClient::consume(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len && state == HTTP_OP_IN_PROGRESS; ++i) {
+        if (phase == PHASE_BODY || phase == PHASE_CHUNK_DATA) {
+            size_t count = len - i;
+            if (remaining >= 0 && count > (size_t)remaining) {
+                count = remaining;
+            }
+            if (onBody != NULL) {
+                onBody((const char*)&data[i], count, bodyCtx);
+            }
+            responseLen += count;
+            i += count - 1;
+            if (remaining >= 0) {
+                remaining -= count;
+                if (remaining == 0) {
+                    if (phase == PHASE_BODY) {
+                        finish();
+                    } else {
+                        phase = PHASE_CHUNK_SIZE;
+                    }
+                }
+            }
+            continue;
+        }
+
+        char c = (char)data[i];
+        if (c == '\n') {
+            line[lineLen] = '\0';
+            lineLen = 0;
+            handleLine();
+        } else if (c != '\r' && lineLen < sizeof(line) - 1) {
+            line[lineLen++] = c;
+        }
+    }
+}
+
+/**
+ * @brief Handles a complete line of the response head or of the chunked body framing.
+ */
+void AsyncHttpClient::handleLine() {
+    switch (phase) {
+        case PHASE_STATUS:
+            if (strncmp(line, "HTTP/1.", 7) != 0 || strlen(line) < 12) {
+                reused = false;
+                fail(HTTPC_ERROR_NO_HTTP_SERVER);
+                return;
+            }
+            statusCode = atoi(&line[9]);
+            remaining = -1;
+            phase = PHASE_HEADERS;
+            break;
+
+        case PHASE_HEADERS:
+            if (line[0] != '\0') {
+                char* value = strchr(line, ':');
+                if (value == NULL) {
+                    return;
+                }
+                *value++ = '\0';
+                while (*value == ' ') {
+                    value++;
+                }
+                if (strcasecmp(line, "Content-Length") == 0) {
+                    remaining = atol(value);
+                } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+                    chunked = (strstr(value, "chunked") != NULL);
+                } else if (strcasecmp(line, "Connection") == 0) {
+                    closeAfter = (strcasecmp(value, "close") == 0);
+                } else if (strcasecmp(line, "ETag") == 0) {
+                    strlcpy(etag, value, sizeof(etag));
+                }
+                return;
+            }
+            /* End of the head: a 304 never has a body */
+            if (statusCode == HTTP_CODE_NOT_MODIFIED || statusCode == 204) {
+                finish();
+            } else if (chunked) {
+                phase = PHASE_CHUNK_SIZE;
+            } else if (remaining == 0) {
+                finish();
+            } else {
+                if (remaining < 0) {
+                    closeAfter = true; /* Only the close tells where the body ends */
+                }
+                phase = PHASE_BODY;
+            }
+            break;
+
+        case PHASE_CHUNK_SIZE:
+            if (line[0] == '\0') {
+                return; /* Line break closing the previous chunk */
+            }
+            remaining = strtol(line, NULL, 16);
+            phase = (remaining > 0) ? PHASE_CHUNK_DATA : PHASE_TRAILERS;
+            break;
+
+        case PHASE_TRAILERS:
+            if (line[0] == '\0') {
+                finish();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Returns the outcome of the last request.
+ * @return HTTP response code, or a negative HTTPClient error code.
+ */
+int AsyncHttpClient::getStatusCode() {
+    return statusCode;
+}
+
+/**
+ * @brief Returns the length of the last response body.
+ * @return Number of body bytes received.
+ */
+size_t AsyncHttpClient::getResponseLength() {
+    return responseLen;
+}
+
+/**
+ * @brief Returns the ETag header of the last response.
+ * @return The header value, empty if there was none.
+ */
+const char* AsyncHttpClient::getEtag() {
+    return etag;
+}
+
+/**
+ * @brief Checks if the last request was sent on a connection kept from a previous one.
+ * @return True if no new connection was needed.
+ */
+bool AsyncHttpClient::wasReused() {
+    return reused;
+}
+
+/**
+ * @brief Checks if the last request had to be sent again because the server had closed the kept-alive connection.
+ * @return True if the request was retried on a new connection.
+ */
+bool AsyncHttpClient::wasRetried() {
+    return retried;
+}
+
+/**
+ * @brief Checks if the last request failed on a kept-alive connection the server had closed, without being retried.
+ * @return True if a retry was needed but not allowed.
+ */
+bool AsyncHttpClient::wasRetrySkipped() {
+    return retrySkipped;
+}
+
+/**
+ * @brief Returns the duration of the last request.
+ * @return Time from begin() to completion in ms, connection setup included.
+ */
+uint32_t AsyncHttpClient::getLatencyMs() {
+    return latencyMs;
+}
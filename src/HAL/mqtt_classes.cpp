@@ -0,0 +1,405 @@
+#include "mqtt_classes.h"
+#include <Arduino.h>
+#include "LogMgr.h"
+
+#define MQTT_CONNECT     (0x10)
+#define MQTT_CONNACK     (0x20)
+#define MQTT_PUBLISH     (0x30)
+#define MQTT_PUBACK      (0x40)
+#define MQTT_SUBSCRIBE   (0x82) /* Reserved flags 0010 */
+#define MQTT_SUBACK      (0x90)
+#define MQTT_PINGREQ     (0xC0)
+#define MQTT_PINGRESP    (0xD0)
+
+#define MQTT_FLAG_DUP    (0x08)
+#define MQTT_FLAG_RETAIN (0x01)
+
+#define MQTT_CONNECT_CLEAN_SESSION (0x02)
+#define MQTT_CONNECT_WILL          (0x04)
+#define MQTT_CONNECT_WILL_QOS1     (0x08)
+#define MQTT_CONNECT_WILL_RETAIN   (0x20)
+
+/**
+ * @brief Constructor for MqttClient class.
+ */
+MqttClient::MqttClient()
+    : open(false), nextPacketId(1), lastTxTime(0), lastRxTime(0), readStart(0), inflightLen(0), inflightId(0) {}
+
+/**
+ * @brief Opens the connection to the broker with a clean session, within MQTT_TIMEOUT_MS altogether so a slow
+ *        broker cannot hold the server task longer. A QoS 1 message not acknowledged on the previous connection is sent again.
+ * @param host Broker host name or IP.
+ * @param port Broker port.
+ * @param clientId Client identifier, unique per device.
+ * @param willTopic Topic of the last will, NULL for none. The will is retained and sent with QoS 1.
+ * @param willMessage Message published by the broker if the connection is lost.
+ * @return True if the broker accepted the connection.
+ */
+bool MqttClient::connect(const char* host, uint16_t port, const char* clientId, const char* willTopic, const char* willMessage) {
+    static const uint8_t protocol[] = { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04 }; /* Protocol name, level 4 (3.1.1) */
+
+    close();
+    readStart = millis();
+    if (!tcp.connect(host, port, MQTT_TIMEOUT_MS)) {
+        return false;
+    }
+
+    uint8_t flags = MQTT_CONNECT_CLEAN_SESSION;
+    size_t remainingLen = sizeof(protocol) + 1 + 2 + 2 + strlen(clientId);
+    if (willTopic != NULL) {
+        flags |= MQTT_CONNECT_WILL | MQTT_CONNECT_WILL_QOS1 | MQTT_CONNECT_WILL_RETAIN;
+        remainingLen += 2 + strlen(willTopic) + 2 + strlen(willMessage);
+    }
+    const uint8_t options[] = { flags, (uint8_t)(MQTT_KEEPALIVE_S >> 8), (uint8_t)MQTT_KEEPALIVE_S };
+
+    bool written = writeHeader(MQTT_CONNECT, remainingLen) &&
+                   (tcp.write(protocol, sizeof(protocol)) == sizeof(protocol)) &&
+                   (tcp.write(options, sizeof(options)) == sizeof(options)) &&
+                   writeString(clientId);
+    if (written && willTopic != NULL) {
+        written = writeString(willTopic) && writeString(willMessage);
+    }
+
+    uint8_t connack[4];
+    if (!written || !readExact(connack, sizeof(connack)) || connack[0] != MQTT_CONNACK || connack[3] != 0) {
+        tcp.stop();
+        return false;
+    }
+
+    open = true;
+    lastRxTime = millis();
+    lastTxTime = lastRxTime;
+
+    if (inflightLen > 0) {
+        inflight[0] |= MQTT_FLAG_DUP;
+        if (tcp.write(inflight, inflightLen) != inflightLen) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Drops the connection without a DISCONNECT, so the broker publishes the last will.
+ */
+void MqttClient::close() {
+    open = false;
+    tcp.stop();
+}
+
+/**
+ * @brief Checks if the connection is open.
+ * @return True if the connection is open.
+ */
+bool MqttClient::isOpen() {
+    if (open && !tcp.connected() && tcp.available() == 0) {
+        close(); /* Closed by the broker or the network */
+    }
+    return open;
+}
+
+/**
+ * @brief Publishes a message. A QoS 1 message replaces the one still waiting for its acknowledgement.
+ * @param topic Topic name.
+ * @param payload Message payload.
+ * @param len Length of the payload.
+ * @param qos 0 or 1.
+ * @param retain True to have the broker keep the message for new subscribers.
+ * @return True if the message was written, or kept for retransmission (QoS 1).
+ */
+bool MqttClient::publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retain) {
+    size_t topicLen = strlen(topic);
+    size_t remainingLen = 2 + topicLen + (qos > 0 ? 2 : 0) + len;
+    uint8_t type = MQTT_PUBLISH | (qos > 0 ? 0x02 : 0x00) | (retain ? MQTT_FLAG_RETAIN : 0x00);
+
+    if (qos == 0) {
+        if (!isOpen()) {
+            return false;
+        }
+        if (!writeHeader(type, remainingLen) || !writeString(topic) || (tcp.write(payload, len) != len)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /* QoS 1: encode the whole packet into the inflight buffer so it can be sent again */
+    if (remainingLen + 3 > sizeof(inflight)) {
+        return false;
+    }
+    uint16_t packetId = allocPacketId();
+    size_t pos = 0;
+    inflight[pos++] = type;
+    if (remainingLen >= 128) {
+        inflight[pos++] = (uint8_t)(remainingLen & 0x7F) | 0x80;
+        inflight[pos++] = (uint8_t)(remainingLen >> 7);
+    } else {
+        inflight[pos++] = (uint8_t)remainingLen;
+    }
+    inflight[pos++] = (uint8_t)(topicLen >> 8);
+    inflight[pos++] = (uint8_t)topicLen;
+    memcpy(&inflight[pos], topic, topicLen);
+    pos += topicLen;
+    inflight[pos++] = (uint8_t)(packetId >> 8);
+    inflight[pos++] = (uint8_t)packetId;
+    memcpy(&inflight[pos], payload, len);
+    inflightLen = pos + len;
+    inflightId = packetId;
+
+    if (isOpen()) {
+        if (tcp.write(inflight, inflightLen) != inflightLen) {
+            close(); /* Sent again after the reconnect */
+        } else {
+            lastTxTime = millis();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Subscribes to a topic, the SUBACK is consumed by receive().
+ * @param topic Topic filter.
+ * @param qos Maximum QoS of the delivered messages, 0 or 1.
+ * @return True if the request was written.
+ */
+bool MqttClient::subscribe(const char* topic, uint8_t qos) {
+    if (!isOpen()) {
+        return false;
+    }
+    uint16_t packetId = allocPacketId();
+    const uint8_t id[] = { (uint8_t)(packetId >> 8), (uint8_t)packetId };
+
+    if (!writeHeader(MQTT_SUBSCRIBE, 2 + 2 + strlen(topic) + 1) ||
+        (tcp.write(id, sizeof(id)) != sizeof(id)) || !writeString(topic) || (tcp.write(qos) != 1)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Waits for a message on the subscribed topics, keeping the connection alive meanwhile.
+ * @param topic[OUT] Buffer receiving the null terminated topic.
+ * @param topicCapacity Size of the topic buffer.
+ * @param payload[OUT] Buffer receiving the payload.
+ * @param payloadCapacity Size of the payload buffer.
+ * @param payloadLen[OUT] Length of the payload.
+ * @param timeoutMs Time to wait, 0 to only check for a pending message.
+ * @return 1 if a message was received, 0 if none arrived in time, -1 if the connection is closed.
+ */
+int MqttClient::receive(char* topic, size_t topicCapacity, uint8_t* payload, size_t payloadCapacity, size_t* payloadLen, uint32_t timeoutMs) {
+    static const uint8_t pingreq[] = { MQTT_PINGREQ, 0x00 };
+    uint32_t start = millis();
+
+    for (;;) {
+        if (!isOpen()) {
+            return -1;
+        }
+        if (millis() - lastTxTime >= MQTT_KEEPALIVE_S * 1000UL / 2) {
+            if (tcp.write(pingreq, sizeof(pingreq)) != sizeof(pingreq)) {
+                close();
+                return -1;
+            }
+            lastTxTime = millis();
+        }
+        if (tcp.available() > 0) {
+            int result = readPacket(topic, topicCapacity, payload, payloadCapacity, payloadLen);
+            if (result != 0) {
+                return result;
+            }
+            continue; /* Acknowledgement or ping response handled */
+        }
+        if (millis() - lastRxTime >= MQTT_KEEPALIVE_S * 1500UL) {
+            close(); /* No PINGRESP, the broker is gone */
+            return -1;
+        }
+        if (millis() - start >= timeoutMs) {
+            return 0;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * @brief Checks if a QoS 1 message is still waiting for its acknowledgement.
+ * @return True if a message is pending.
+ */
+bool MqttClient::inflightPending() {
+    return inflightLen > 0;
+}
+
+/**
+ * @brief Reads one packet, the first byte is already available. The whole packet must arrive within
+ *        MQTT_TIMEOUT_MS. QoS 1 messages are acknowledged, messages that do not fit the buffers are dropped.
+ * @return 1 for a message, 0 for a handled or dropped packet, -1 if the connection was closed.
+ */
+int MqttClient::readPacket(char* topic, size_t topicCapacity, uint8_t* payload, size_t payloadCapacity, size_t* payloadLen) {
+    uint8_t type;
+    size_t remainingLen = 0;
+    uint8_t digit;
+    uint8_t shift = 0;
+
+    readStart = millis();
+    if (!readExact(&type, 1)) {
+        close();
+        return -1;
+    }
+    do {
+        if (shift > 21 || !readExact(&digit, 1)) {
+            close();
+            return -1;
+        }
+        remainingLen |= (size_t)(digit & 0x7F) << shift;
+        shift += 7;
+    } while (digit & 0x80);
+    lastRxTime = millis();
+
+    if ((type & 0xF0) == MQTT_PUBLISH) {
+        uint8_t qos = (type >> 1) & 0x03;
+        uint8_t header[2];
+        uint8_t id[2] = { 0, 0 };
+        if (remainingLen < 2 || !readExact(header, sizeof(header))) {
+            close();
+            return -1;
+        }
+        size_t topicLen = ((size_t)header[0] << 8) | header[1];
+        size_t idLen = (qos > 0) ? 2 : 0;
+        if (remainingLen < 2 + topicLen + idLen) {
+            close();
+            return -1;
+        }
+        size_t len = remainingLen - 2 - topicLen - idLen;
+        bool fits = (topicLen < topicCapacity) && (len <= payloadCapacity);
+
+        bool read = fits ? readExact((uint8_t*)topic, topicLen) : discard(topicLen);
+        read = read && ((idLen == 0) || readExact(id, idLen));
+        read = read && (fits ? readExact(payload, len) : discard(len));
+        if (!read) {
+            close();
+            return -1;
+        }
+
+        if (qos > 0) {
+            const uint8_t puback[] = { MQTT_PUBACK, 0x02, id[0], id[1] };
+            if (tcp.write(puback, sizeof(puback)) != sizeof(puback)) {
+                close();
+                return -1;
+            }
+            lastTxTime = millis();
+        }
+
+        if (!fits) {
+            LogSerialn("MQTT message too large, dropped", true);
+            return 0;
+        }
+        topic[topicLen] = '\0';
+        *payloadLen = len;
+        return 1;
+    }
+
+    if (type == MQTT_PUBACK && remainingLen == 2) {
+        uint8_t id[2];
+        if (!readExact(id, sizeof(id))) {
+            close();
+            return -1;
+        }
+        if ((((uint16_t)id[0] << 8) | id[1]) == inflightId) {
+            inflightLen = 0;
+        }
+        return 0;
+    }
+
+    /* SUBACK, PINGRESP and anything else carry nothing we need */
+    if (!discard(remainingLen)) {
+        close();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes a fixed header: packet type and remaining length.
+ * @param type Packet type and flags.
+ * @param remainingLen Length of the rest of the packet.
+ * @return True if the header was written.
+ */
+bool MqttClient::writeHeader(uint8_t type, size_t remainingLen) {
+    uint8_t header[5];
+    uint8_t len = 0;
+
+    header[len++] = type;
+    do {
+        uint8_t digit = remainingLen & 0x7F;
+        remainingLen >>= 7;
+        header[len++] = digit | ((remainingLen > 0) ? 0x80 : 0x00);
+    } while (remainingLen > 0 && len < sizeof(header));
+
+    lastTxTime = millis();
+    return tcp.write(header, len) == len;
+}
+
+/**
+ * @brief Writes a length-prefixed UTF-8 string.
+ * @param text The string.
+ * @return True if the string was written.
+ */
+bool MqttClient::writeString(const char* text) {
+    size_t len = strlen(text);
+    const uint8_t prefix[] = { (uint8_t)(len >> 8), (uint8_t)len };
+    return (tcp.write(prefix, sizeof(prefix)) == sizeof(prefix)) && (tcp.write((const uint8_t*)text, len) == len);
+}
+
+/**
+ * @brief Reads exactly len bytes, as long as MQTT_TIMEOUT_MS has not passed since readStart.
+ *        A broker sending a byte at a time cannot extend the deadline of the connection or packet.
+ * @param buf[OUT] Destination buffer.
+ * @param len Number of bytes to read.
+ * @return True if all bytes were read.
+ */
+bool MqttClient::readExact(uint8_t* buf, size_t len) {
+    size_t received = 0;
+
+    while (received < len) {
+        if (tcp.available() > 0) {
+            int n = tcp.read(&buf[received], len - received);
+            if (n > 0) {
+                received += n;
+                continue;
+            }
+        }
+        if (!tcp.connected() || (millis() - readStart >= MQTT_TIMEOUT_MS)) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return true;
+}
+
+/**
+ * @brief Skips bytes of a packet that is not returned to the caller.
+ * @param len Number of bytes to skip.
+ * @return True if all bytes were skipped.
+ */
+bool MqttClient::discard(size_t len) {
+    uint8_t chunk[64];
+    while (len > 0) {
+        size_t chunkLen = (len < sizeof(chunk)) ? len : sizeof(chunk);
+        if (!readExact(chunk, chunkLen)) {
+            return false;
+        }
+        len -= chunkLen;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the next packet identifier, never 0.
+ * @return The packet identifier.
+ */
+uint16_t MqttClient::allocPacketId() {
+    if (nextPacketId == 0) {
+        nextPacketId = 1;
+    }
+    return nextPacketId++;
+}
@@ -4,6 +4,10 @@
 #include "DisplayMgr.h"
 #include "SrvClientMgr.h" 
 #include "LogMgr.h"
+#include "TraceMgr.h"
+#include "TelemetryMgr.h"
+#include "TelemetryLog.h"
+#include "DeviceId.h"
 
 using namespace std;
 
@@ -23,6 +27,7 @@ using namespace std;
 #define OLED_DISPLAY_SCL_PIN    (SHIELD_OLED_SCL_D22)
 #define OLED_DISPLAY_SDA_PIN    (SHIELD_OLED_SDA_D21)
 
+#define SUBTASK_INTERVAL_10_MS   (10)
 #define SUBTASK_INTERVAL_100_MS  (100)
 #define SUBTASK_INTERVAL_500_MS  (500)
 #define SUBTASK_INTERVAL_1000_MS (1000)     
@@ -71,6 +76,9 @@ void TaskReadSensors(void* pvParameters) {
             lastTempHumReadTime = currentMillis;
             data->sensorMgr->readDht11TempHumSens();
         }
+
+        /* Record the readings for offline replay */
+        traceRecordSensors(data);
  
         vTaskDelay(pdMS_TO_TICKS(SUBTASK_INTERVAL_100_MS)); // Delay for button debounce
     }
@@ -92,6 +100,9 @@ void TaskProcessData(void* pvParameters) {
         /* Button control logic */
         pButtonsCtrl(data);
 
+        /* Buffer a telemetry sample when the state changed significantly */
+        telemetryRecordOnChange(data);
+
         vTaskDelay(pdMS_TO_TICKS(SUBTASK_INTERVAL_100_MS)); // Process data every 100ms
     }
 }
@@ -101,6 +112,7 @@ void TaskControlActuators(void* pvParameters) {
     for (;;) {
         /* Apply internal states to hardware outputs */
         data->actuatorMgr->applyState();
+        traceRecordActuators(data);
 
         vTaskDelay(pdMS_TO_TICKS(SUBTASK_INTERVAL_100_MS)); // Update actuators every 100ms
     }
@@ -110,54 +122,23 @@ void TaskControlActuators(void* pvParameters) {
 void TaskDisplay(void* pvParameters) {
     SystemData* data = (SystemData*)pvParameters;
     bool IsLog = true; // Enable or disable logging
-    uint8_t* Levelsettings[] = {
-        &data->maxLevelPercentage,
-        &data->minLevelPercentage,
-    };
-    uint8_t* TempHumsettings[] = {
-        &data->hotTemperature,
-        &data->lowHumidity
-    };
-   
+
     for (;;) {
         static uint32_t lastLogTime = 0;
         uint32_t currentMillis = millis();
+        pb1Selector currentScreen = data->currentDisplayDataSelec;
 
-        data->oledDisplay->clearAllDisplay();
-        data->oledDisplay->setTextProperties(1, SSD1306_WHITE);
-
-        switch (data->currentDisplayDataSelec) {
-            case SCREEN_LGT_PIR_LAMP_DATA:
-                displayLightAndPresence(data);
-                break;
-            case SCREEN_LVL_PUMP_DATA:
-                displayWaterLevelAndPump(data);
-                break;
-            case SCREEN_TEMP_HUM_IRR_DATA:
-                displayTemperatureAndHumidity(data);
-                break;
-            case SCREEN_WIFI_STATUS:
-                displayWiFiStatus(data);
-                break;
-            case SCREEN_DEV_INFO:
-                displayDeviceInfo(data);
-                break;
-            case SCREEN_LVL_SETT_MENU:
-                displayLevelSettings(data, *Levelsettings[data->currentSettingMenu]);
-                break;
-            case SCREEN_TEMP_HUM_SETT_MENU:
-                displayTempHumSettings(data, *TempHumsettings[data->currentSettingMenu]);
-                break;
-            case SCREEN_WIFI_SETT_MENU:
-            case SCREEN_WIFI_SETT_SUB_MENU:
-                displayWiFiSettings(data);
-                break;
-            default:
-                displayLightAndPresence(data);
-                break;
-        }
+        uint32_t renderStartUs = micros();
+        bool frameRendered = displayRender(data);
+        uint32_t renderTimeUs = micros() - renderStartUs;
 
-        data->oledDisplay->PrintdisplayData();
+        if (frameRendered) {
+            if (DISPLAY_SNAPSHOT_ENABLED) {
+                /* Capture the frame for golden image comparison on a host */
+                data->oledDisplay->dumpFramePbm(Serial, currentScreen, displayFrameName(), renderTimeUs);
+            }
+            data->oledDisplay->PrintdisplayData();
+        }
 
         if (currentMillis - lastLogTime >= SUBTASK_INTERVAL_1000_MS) {
             lastLogTime = currentMillis;
@@ -189,49 +170,59 @@ void TaskSendDataToServer(void* pvParameters) {
     const uint32_t wifiRetryInterval = WIFI_RETRY_INTERVAL_MS;
 
     for (;;) {
-        if (strcmp(data->wifiManager->getSSID(), "DUMMY_WIFI_SSID") == 0 && strcmp(data->wifiManager->getPassword(), "DUMMY_WIFI_PASSWORD") == 0) {
+        /* Move samples that could not be sent to flash before the ring buffer overwrites them, or once they waited so long
+           that a reset would lose too many. Not while a batch is in flight, it may carry them */
+        if (!serverRequestsBusy()) {
+            telemetryLogSpill();
+        }
+
+        if (data->wifiManager->getSSID() == "DUMMY_WIFI_SSID" && data->wifiManager->getPassword() == "DUMMY_WIFI_PASSWORD") {
             LogSerialn("WiFi credentials are dummy. Please set correct SSID and password.", IsLog);
             customTaskDelay = SUBTASK_INTERVAL_15_S;
         } else if (data->wifiManager->IsWiFiConnected()) {
             customTaskDelay = SUBTASK_INTERVAL_100_MS;
             wifiConnecting = false; /* Reset the flag once WiFi is connected */ 
             uint32_t currentMillis = millis();
-            static uint32_t lastSendTime = 0;
             
             /* Execute this every time wifi connection is restablished */
             if (!wifiConnectedMessagePrinted) {
                 LogSerialn("WiFi connected! ESP32 IP Address: " + data->wifiManager->getWiFiLocalIp().toString(), IsLog);
                 wifiConnectedMessagePrinted = true; 
 
-                /* Check if settings exist in the database */
-                if (!checkJsonSettingsExistence(data)) {
-                    /* Send default settings if they do not exist */
-                    LogSerialn("Sending default settings to the backend...", IsLog);
-                    sendSystemSettings(data);
+                /* Fetch the settings, or send the defaults if the database has none.
+                   With MQTT the retained settings topic takes the place of this request */
+                if (!SERVER_TRANSPORT_MQTT) {
+                    requestServerOp(SERVER_OP_SYNC);
                 }
-
-                /* Fetch updated settings on initial connection */
-                fetchUpdatedSettings(data);
             }
 
             /* Check if system settins have been manually modified */
             if ( (previousDisplayDataSelec == SCREEN_LVL_SETT_MENU) && (data->currentDisplayDataSelec != SCREEN_LVL_SETT_MENU) || 
                  (previousDisplayDataSelec == SCREEN_TEMP_HUM_SETT_MENU) && (data->currentDisplayDataSelec != SCREEN_TEMP_HUM_SETT_MENU) ) {
+                /* Settings received while editing are merged first, the user's changes win */
+                endSettingsEdit(data);
                 LogSerialn("Sending manual systems settings to the backend...", IsLog);
                 LogSerial("maxlvl: " + String(data->maxLevelPercentage), IsLog);
                 LogSerial(" minlvl: " + String(data->minLevelPercentage), IsLog);
                 LogSerial(" hotTmp: " + String(data->hotTemperature), IsLog);
                 LogSerialn(" lowHum: " + String(data->lowHumidity), IsLog);
-                sendSystemSettings(data);
+            } else if ( (data->currentDisplayDataSelec == SCREEN_LVL_SETT_MENU || data->currentDisplayDataSelec == SCREEN_TEMP_HUM_SETT_MENU) &&
+                        (previousDisplayDataSelec != SCREEN_LVL_SETT_MENU) && (previousDisplayDataSelec != SCREEN_TEMP_HUM_SETT_MENU) ) {
+                beginSettingsEdit(data); /* Settings the user changes are told apart from the ones received meanwhile */
             }
 
-            /* Periodically fetch updated settings if sys settings are not being changed manually using user buttons */
-            if ( (currentMillis - lastSettingsFetchTime >= SUBTASK_INTERVAL_15_S) && 
+            /* Keep the WebSocket channel or MQTT connection open, settings changes are pushed over it */
+            serviceServerChannel(data);
+
+            /* Periodically fetch updated settings if sys settings are not being changed manually using user buttons,
+               not needed while the channel is open or with MQTT, nor after a telemetry upload over /sync brought them */
+            if ( (currentMillis - lastSettingsFetchTime >= SUBTASK_INTERVAL_15_S) && (getServerSyncAge() >= SUBTASK_INTERVAL_15_S) && 
+                 !SERVER_TRANSPORT_MQTT && !data->SrvClient->channelConnected() && 
                  (data->currentDisplayDataSelec != SCREEN_LVL_SETT_MENU) && 
                  (data->currentDisplayDataSelec != SCREEN_TEMP_HUM_SETT_MENU) ) {
                     lastSettingsFetchTime = currentMillis;
                     LogSerialn("Fetching system settings from server...", IsLog);
-                    fetchUpdatedSettings(data);
+                    requestServerOp(SERVER_OP_SYNC);
             } else if( (data->currentDisplayDataSelec == SCREEN_LVL_SETT_MENU) || (data->currentDisplayDataSelec == SCREEN_TEMP_HUM_SETT_MENU)) {
                 lastSettingsFetchTime = currentMillis;
             } else {
@@ -240,12 +231,11 @@ void TaskSendDataToServer(void* pvParameters) {
 
             /* Update the previous state */
             previousDisplayDataSelec = data->currentDisplayDataSelec;
-            /* Send data to Firebase server */
-            if (currentMillis - lastSendTime >= SUBTASK_INTERVAL_15_S) {
-                lastSendTime = currentMillis;
-
-                LogSerialn("Sending Sensor/Actuator data to server...", IsLog);
-                sendSensActHistory(data);
+            /* Advance the request in progress and start the next one: settings first, then buffered samples on a full batch,
+               an actuator transition or a stale sample, then samples logged to flash while offline */
+            serviceServerRequests(data);
+            if (serverRequestsBusy()) {
+                customTaskDelay = SUBTASK_INTERVAL_10_MS; /* Poll the socket until the response is in */
             }
         } else if (data->currentDisplayDataSelec == SCREEN_WIFI_SETT_MENU || data->currentDisplayDataSelec == SCREEN_WIFI_SETT_SUB_MENU) {
             /* Let full control to the user to cofigure a new wifi network */
@@ -253,12 +243,15 @@ void TaskSendDataToServer(void* pvParameters) {
         } else {
             customTaskDelay = SUBTASK_INTERVAL_100_MS;
             wifiConnectedMessagePrinted = false; /* Reset the flag when WiFi is disconnected */ 
+            cancelServerRequests(data); /* Samples stay buffered, queued requests go out once reconnected */
             uint32_t now = millis();
-            if (!wifiConnecting || (now - lastWifiAttempt > wifiRetryInterval)) {
+            /* Poll the attempt in progress instead of waiting for it */
+            if ((data->wifiManager->pollConnect() != WIFI_OP_IN_PROGRESS) && 
+                (!wifiConnecting || (now - lastWifiAttempt > wifiRetryInterval))) {
                 wifiConnecting = true; /* Set the flag to prevent multiple connection attempts */ 
                 lastWifiAttempt = now;
                 LogSerialn("WiFi disconnected! Attempting to reconnect...", IsLog);
-                data->wifiManager->connectToNetwork(data->wifiManager->getSSID(), data->wifiManager->getPassword());
+                data->wifiManager->beginConnect(data->wifiManager->getSSID(), data->wifiManager->getPassword());
             }
         }
 
@@ -280,9 +273,13 @@ void setup() {
         LogSerialn("Failed to create mutex", true);
     }
 
+    /* Format the chip id once, the server client and display read it from here */
+    deviceIdInit();
+
     const char* Dev_ssid = "DUMMY_WIFI_SSID"; /* Dev is able to hardcode the ssid to connect */
     const char* Dev_password = "DUMMY_WIFI_PASSWORD"; /* Dev is able to hardcode the password to connect */
     const char* BackendServerUrl = "http://192.168.100.9:3000/"; /* Use hostname IP in case server is running locally */
+    const char* MqttBrokerHost = "192.168.100.9"; /* Broker used when SERVER_TRANSPORT_MQTT is true */
 
     static AnalogSensor analogSensor(SENSOR_LVL_PIN);
     static Dht11TempHumSens dht11Sensor(SENSOR_HUM_TEMP_PIN);
@@ -318,6 +315,7 @@ void setup() {
 
     static OledDisplay oledDisplay(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_ADDRESS);
     static WiFiManager wifiManager(Dev_ssid, Dev_password);
+    wifiManager.init();
 
     /* Try to load saved credentials and connect */ 
     String savedSsid, savedPassword;
@@ -335,6 +333,9 @@ void setup() {
     }
 
     static ServerClient serverClient(BackendServerUrl, &wifiManager);
+    if (SERVER_TRANSPORT_MQTT) {
+        serverClient.setMqttBroker(MqttBrokerHost);
+    }
 
     static SystemData systemData = {
         &sensorManager,
@@ -364,6 +365,15 @@ void setup() {
 
     LogSerialn("Sensor/Actuator/Display/WiFi objects initialized", true);
 
+    /* Init binary trace recorder (no-op unless TRACE_RECORDER_ENABLED) */
+    traceInit();
+
+    /* Init telemetry ring buffer for the batched upload */
+    telemetryInit();
+
+    /* Mount the flash log keeping the samples that could not be sent */
+    telemetryLogInit();
+
     /* Core 0: Real-Time Peripheral and Logic */
     xTaskCreatePinnedToCore(TaskReadSensors, "ReadSensors", SENSOR_TASK_STACK_SIZE, &systemData, SENSOR_TASK_PRIORITY, NULL, TASK_CORE_0);
     xTaskCreatePinnedToCore(TaskProcessData, "ProcessData", PROCESS_TASK_STACK_SIZE, &systemData, PROCESS_TASK_PRIORITY, NULL, TASK_CORE_0);
@@ -0,0 +1,128 @@
+/*
+ * Device clock to wall time estimate, run with `pio test -e native -f test_clock_mgr`.
+ * The estimate is kept in static state that cannot be reset, the tests run in order on the same clock.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <math.h>
+#include <stdint.h>
+#include "ClockMgr.h"
+
+#define SERVER_EPOCH_MS   (1760000000000ull) /* Wall time of the first exchange */
+#define FAST_RTT_US       (80000)
+#define EXCHANGE_PERIOD_US (60000000LL)      /* A /sync exchange every minute */
+
+SemaphoreHandle_t xSystemDataMutex;
+
+/**
+ * @brief Wall time of a server whose clock runs ppm faster than the device, in ms since epoch.
+ * @param deviceUs Device time.
+ * @param originUs Device time at SERVER_EPOCH_MS.
+ */
+static uint64_t serverMs(int64_t deviceUs, int64_t originUs, double ppm) {
+    double elapsedUs = (double)(deviceUs - originUs) * (1.0 + ppm / 1e6);
+    return SERVER_EPOCH_MS + (uint64_t)llround(elapsedUs / 1000.0);
+}
+
+static int64_t wallErrorMs(int64_t deviceUs, int64_t originUs, double ppm) {
+    return (int64_t)(clockWallMs(deviceUs) - serverMs(deviceUs, originUs, ppm));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_unset_until_first_exchange(void) {
+    ClockEstimate estimate;
+    nativeSetMicros(5000000);
+
+    TEST_ASSERT_FALSE(clockSynced());
+    TEST_ASSERT_TRUE(clockWallMs(5000000) == 0);
+    clockEstimate(&estimate);
+    TEST_ASSERT_TRUE(estimate.nowUs == 5000000);
+    TEST_ASSERT_TRUE(estimate.wallMs == 0);
+}
+
+void test_first_exchange_sets_the_clock(void) {
+    ClockEstimate estimate;
+
+    /* Even over a slow link, there is nothing better yet */
+    clockUpdate(SERVER_EPOCH_MS, 10000000, CLOCK_SYNC_MAX_RTT_US * 3);
+    TEST_ASSERT_TRUE(clockSynced());
+    TEST_ASSERT_TRUE(clockWallMs(10000000) == SERVER_EPOCH_MS);
+    TEST_ASSERT_TRUE(clockWallMs(12500000) == SERVER_EPOCH_MS + 2500);
+    TEST_ASSERT_TRUE(clockWallMs(0) == SERVER_EPOCH_MS - 10000);
+
+    nativeSetMicros(11000000);
+    clockEstimate(&estimate);
+    TEST_ASSERT_TRUE(estimate.nowUs == 11000000);
+    TEST_ASSERT_TRUE(estimate.wallMs == SERVER_EPOCH_MS + 1000);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, estimate.driftPpm);
+}
+
+void test_small_errors_are_corrected_gradually(void) {
+    /* The server answers 400 ms later than predicted */
+    clockUpdate(SERVER_EPOCH_MS + 20400, 30000000, FAST_RTT_US);
+    TEST_ASSERT_TRUE(clockWallMs(30000000) == SERVER_EPOCH_MS + 20000 + (uint64_t)(400 * CLOCK_SYNC_GAIN));
+
+    /* Exchanges over a slow link are ignored */
+    clockUpdate(SERVER_EPOCH_MS + 39000, 40000000, CLOCK_SYNC_MAX_RTT_US + 1);
+    TEST_ASSERT_TRUE(clockWallMs(40000000) == SERVER_EPOCH_MS + 30100);
+}
+
+void test_large_errors_step_the_clock(void) {
+    clockUpdate(SERVER_EPOCH_MS + 3600000, 50000000, FAST_RTT_US);
+    TEST_ASSERT_TRUE(clockWallMs(50000000) == SERVER_EPOCH_MS + 3600000);
+    clockUpdate(SERVER_EPOCH_MS, 60000000, FAST_RTT_US);
+    TEST_ASSERT_TRUE(clockWallMs(60000000) == SERVER_EPOCH_MS);
+}
+
+/**
+ * @brief A device clock running slow is measured as a positive drift, and the estimate follows the server
+ *        between exchanges.
+ */
+void test_drift_is_measured(void) {
+    const double ppm = 80.0;
+    const int64_t originUs = 100000000;
+    ClockEstimate estimate;
+
+    clockUpdate(serverMs(originUs, originUs, ppm) + 3000, originUs, FAST_RTT_US); /* Steps, drift span restarts */
+    for (int64_t t = originUs; t <= originUs + 4 * 3600 * 1000000LL; t += EXCHANGE_PERIOD_US) {
+        clockUpdate(serverMs(t, originUs, ppm), t, FAST_RTT_US);
+    }
+    int64_t lastUs = originUs + 4 * 3600 * 1000000LL;
+
+    nativeSetMicros(lastUs);
+    clockEstimate(&estimate);
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, (float)ppm, estimate.driftPpm);
+
+    /* Half an hour without an exchange, 144 ms of drift without the estimate */
+    TEST_ASSERT_TRUE(llabs(wallErrorMs(lastUs + 1800 * 1000000LL, originUs, ppm)) <= 10);
+}
+
+void test_drift_is_bounded(void) {
+    const double ppm = 5000.0;
+    const int64_t originUs = 20000000000LL;
+    ClockEstimate estimate;
+
+    clockUpdate(serverMs(originUs, originUs, ppm) + 3000, originUs, FAST_RTT_US);
+    for (int64_t t = originUs; t <= originUs + 3600 * 1000000LL; t += EXCHANGE_PERIOD_US / 4) {
+        clockUpdate(serverMs(t, originUs, ppm), t, FAST_RTT_US);
+    }
+    clockEstimate(&estimate);
+    TEST_ASSERT_EQUAL_FLOAT((float)CLOCK_DRIFT_MAX_PPM, estimate.driftPpm);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_unset_until_first_exchange);
+    RUN_TEST(test_first_exchange_sets_the_clock);
+    RUN_TEST(test_small_errors_are_corrected_gradually);
+    RUN_TEST(test_large_errors_step_the_clock);
+    RUN_TEST(test_drift_is_measured);
+    RUN_TEST(test_drift_is_bounded);
+    return UNITY_END();
+}
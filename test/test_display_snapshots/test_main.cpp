@@ -0,0 +1,345 @@
+/*
+ * Golden image test of the OLED screens, run with `pio test -e native -f test_display_snapshots`.
+ *
+ * The firmware runs on the host: sensor reads, ProcessMgr, the actuators and displayRender() are called in the
+ * order of the device tasks, one cycle per 100 ms of virtual time. The frame that reaches the panel over I2C is
+ * compared with golden/<name>.pbm, where the name comes from displayFrameName(). Run with SNAPSHOT_UPDATE=1 to
+ * write the goldens of the frames that changed, then review the images before committing them.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <NativeSystem.h>
+#include <chrono>
+#include <string>
+#include "ProcessMgr.h"
+#include "DisplayMgr.h"
+#include "DeviceId.h"
+
+#define CYCLE_MS          (100) /* Period of the device tasks */
+#define BUTTON_RELEASE_CYCLES (4) /* Cycles after a press, longer than the 300 ms debounce */
+#define PBM_PIXEL_BYTES   ((SCREEN_WIDTH / 8) * SCREEN_HEIGHT)
+
+SemaphoreHandle_t xSystemDataMutex;
+
+/**
+ * @brief Collects the bytes of a dumped frame.
+ */
+class FrameSink : public Print {
+public:
+    std::string bytes;
+    size_t write(uint8_t c) override { bytes.push_back((char)c); return 1; }
+    using Print::write;
+};
+
+static SystemData* data;
+static FrameSink lastFrame;
+static uint32_t framesRendered = 0;
+static uint32_t renderTimeMaxUs = 0;
+static uint64_t renderTimeTotalUs = 0;
+static uint32_t goldensChecked = 0;
+
+/**
+ * @brief One pass of the sensor, process, actuator and display tasks, then 100 ms of virtual time.
+ */
+static void runCycle() {
+    data->sensorMgr->readLevelSensor();
+    data->sensorMgr->readPirSensor();
+    data->sensorMgr->readLightSensor();
+    data->sensorMgr->readButtonSelector();
+    data->sensorMgr->readButtonEsc();
+    data->sensorMgr->readButtonUp();
+    data->sensorMgr->readButtonDown();
+    data->sensorMgr->readWellSensor();
+    data->sensorMgr->readDht11TempHumSens();
+
+    LampActivationCtrl(data);
+    PumpActivationCtrl(data);
+    IrrigatorActivationCtrl(data);
+    pButtonsCtrl(data);
+    data->actuatorMgr->applyState();
+
+    pb1Selector currentScreen = data->currentDisplayDataSelec;
+    auto renderStart = std::chrono::steady_clock::now();
+    bool frameRendered = displayRender(data);
+    uint32_t renderTimeUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - renderStart).count();
+
+    if (frameRendered) {
+        lastFrame.bytes.clear();
+        data->oledDisplay->dumpFramePbm(lastFrame, currentScreen, displayFrameName(), renderTimeUs);
+        data->oledDisplay->PrintdisplayData();
+        framesRendered++;
+        renderTimeTotalUs += renderTimeUs;
+        renderTimeMaxUs = max(renderTimeMaxUs, renderTimeUs);
+    }
+
+    nativeAdvanceMillis(CYCLE_MS);
+}
+
+static void runCycles(uint32_t count) {
+    while (count-- > 0) {
+        runCycle();
+    }
+}
+
+static void runFor(uint32_t ms) {
+    runCycles((ms + CYCLE_MS - 1) / CYCLE_MS);
+}
+
+/**
+ * @brief Holds a button (active low) for one cycle and waits until the debounce allows the next press.
+ */
+static void press(uint8_t pin) {
+    nativeSetDigitalInput(pin, LOW);
+    runCycle();
+    nativeSetDigitalInput(pin, HIGH);
+    runCycles(BUTTON_RELEASE_CYCLES);
+}
+
+static std::string testDir() {
+    std::string file = __FILE__;
+    size_t slash = file.find_last_of('/');
+    return (file[0] == '/' && slash != std::string::npos) ? file.substr(0, slash) : "test/test_display_snapshots";
+}
+
+/**
+ * @brief Converts the page ordered panel RAM to PBM rows, lit pixels as 1.
+ */
+static std::string panelToPbmPixels(const uint8_t* panel) {
+    std::string pixels(PBM_PIXEL_BYTES, '\0');
+    for (uint8_t y = 0; y < SCREEN_HEIGHT; ++y) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; ++x) {
+            if (panel[(y / 8) * SCREEN_WIDTH + x] & (1 << (y & 7))) {
+                pixels[y * (SCREEN_WIDTH / 8) + x / 8] |= (char)(0x80 >> (x & 7));
+            }
+        }
+    }
+    return pixels;
+}
+
+static bool readFile(const std::string& path, std::string& contents) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    char buf[512];
+    size_t n;
+    contents.clear();
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        contents.append(buf, n);
+    }
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief Checks the frame on the panel: it is the last rendered one, it has the expected name and it matches
+ *        its golden image. SNAPSHOT_UPDATE=1 rewrites a golden whose pixels differ instead of failing.
+ * @param name Expected frame name, see displayFrameName().
+ * @param variant Suffix of the golden image when a screen is checked in several states, NULL for none.
+ */
+static void expectFrame(const char* name, const char* variant) {
+    char message[160];
+    std::string goldenName = std::string(name) + (variant ? std::string("_") + variant : "") + ".pbm";
+    std::string goldenPath = testDir() + "/golden/" + goldenName;
+    std::string panel = panelToPbmPixels(nativeOledPanel());
+
+    TEST_ASSERT_EQUAL_STRING(name, displayFrameName());
+    TEST_ASSERT_TRUE_MESSAGE(lastFrame.bytes.size() > PBM_PIXEL_BYTES, "no frame rendered");
+    TEST_ASSERT_TRUE_MESSAGE(lastFrame.bytes.compare(lastFrame.bytes.size() - PBM_PIXEL_BYTES, PBM_PIXEL_BYTES, panel) == 0,
+                             "the panel does not show the rendered frame");
+
+    std::string golden;
+    bool found = readFile(goldenPath, golden) && golden.size() >= PBM_PIXEL_BYTES;
+    uint32_t diffBytes = 0;
+    if (found) {
+        const char* expected = &golden[golden.size() - PBM_PIXEL_BYTES];
+        for (size_t i = 0; i < PBM_PIXEL_BYTES; ++i) {
+            diffBytes += (expected[i] != panel[i]) ? 1 : 0;
+        }
+    }
+    goldensChecked++;
+    if (found && diffBytes == 0) {
+        return;
+    }
+
+    const char* update = getenv("SNAPSHOT_UPDATE");
+    if (update != NULL && strcmp(update, "1") == 0) {
+        FILE* fp = fopen(goldenPath.c_str(), "wb");
+        TEST_ASSERT_NOT_NULL(fp);
+        fwrite(lastFrame.bytes.data(), 1, lastFrame.bytes.size(), fp);
+        fclose(fp);
+        snprintf(message, sizeof(message), "%s written", goldenName.c_str());
+        TEST_MESSAGE(message);
+        return;
+    }
+    if (!found) {
+        snprintf(message, sizeof(message), "%s missing, run with SNAPSHOT_UPDATE=1", goldenName.c_str());
+    } else {
+        snprintf(message, sizeof(message), "%s: %u of %u bytes differ", goldenName.c_str(), (unsigned)diffBytes,
+                 (unsigned)PBM_PIXEL_BYTES);
+    }
+    TEST_FAIL_MESSAGE(message);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * @brief The data screens in the order the select button cycles them, with the settings menus behind ESC.
+ */
+void test_data_screens() {
+    runCycles(2);
+    expectFrame("lamp", "idle");
+
+    nativeSetDigitalInput(SENSOR_PIR_PIN, HIGH);
+    runCycles(2);
+    expectFrame("lamp", "presence");
+    nativeSetDigitalInput(SENSOR_PIR_PIN, LOW);
+    runFor(6000); /* PIR cool down, the lamp goes off */
+    expectFrame("lamp", "idle");
+
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("cistern", NULL);
+
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("level_settings", "max");
+    press(SENSOR_PB_UP_PIN);
+    expectFrame("level_settings", "max_raised");
+    press(SENSOR_PB_DOWN_PIN);
+    expectFrame("level_settings", "max");
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("level_settings", "min");
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("cistern", NULL);
+
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("irrigator", NULL);
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("temp_hum_settings", NULL);
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("irrigator", NULL);
+
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("network", "offline");
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("device_info", NULL);
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("lamp", "idle");
+}
+
+/**
+ * @brief Enters the four character password "aaaa": UP sets the first character and SELECT appends the others,
+ *        then ESC walks the cursor back and accepts the password from the first position.
+ * @param network Golden variant of the password screen, it shows the SSID.
+ */
+static void enterPasswordAaaa(const char* network) {
+    press(SENSOR_PB_UP_PIN);
+    for (int i = 0; i < 4; ++i) {
+        press(SENSOR_PB_SELECT_PIN);
+    }
+    expectFrame("wifi_password", network);
+    for (int i = 0; i < 5; ++i) {
+        press(SENSOR_PB_ESC_PIN);
+    }
+}
+
+/**
+ * @brief The WiFi settings flow: scan, network list, password entry, a failed and a successful connection,
+ *        then the disconnection.
+ */
+void test_wifi_screens() {
+    nativeWiFiAddNetwork("HomeNet", "aaaa");
+    nativeWiFiAddNetwork("Garden", "bbbb");
+
+    /* lamp -> cistern -> irrigator -> network */
+    press(SENSOR_PB_SELECT_PIN);
+    press(SENSOR_PB_SELECT_PIN);
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("network", "offline");
+
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("wifi_menu", "scan");
+
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("wifi_scanning", NULL);
+    runFor(NATIVE_SCAN_TIME_MS);
+    expectFrame("wifi_networks", "first");
+
+    /* Wrong password for Garden, the attempt times out */
+    press(SENSOR_PB_DOWN_PIN);
+    expectFrame("wifi_networks", "second");
+    press(SENSOR_PB_SELECT_PIN);
+    enterPasswordAaaa("garden");
+    expectFrame("wifi_connecting", "garden");
+    runFor(WIFI_CONNECT_TIMEOUT_MS);
+    expectFrame("wifi_failed", NULL);
+    runFor(1500);
+    expectFrame("wifi_menu", "scan");
+
+    /* HomeNet from the cached scan */
+    press(SENSOR_PB_SELECT_PIN);
+    expectFrame("wifi_networks", "first");
+    press(SENSOR_PB_SELECT_PIN);
+    enterPasswordAaaa("homenet");
+    expectFrame("wifi_connecting", "homenet");
+    runFor(NATIVE_CONNECT_TIME_MS);
+    expectFrame("wifi_connected", NULL);
+    runFor(1500);
+    expectFrame("wifi_menu", "scan");
+
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("network", "online");
+
+    press(SENSOR_PB_ESC_PIN);
+    press(SENSOR_PB_DOWN_PIN);
+    expectFrame("wifi_menu", "disconnect");
+    press(SENSOR_PB_SELECT_PIN);
+    runCycle();
+    expectFrame("wifi_disconnected", NULL);
+    runFor(1500);
+    press(SENSOR_PB_UP_PIN);
+    press(SENSOR_PB_ESC_PIN);
+    expectFrame("network", "offline");
+}
+
+/**
+ * @brief Render time of the frames on this host, for comparison between builds of the same machine only.
+ */
+void test_render_time_summary() {
+    char message[128];
+    TEST_ASSERT_TRUE(framesRendered > 0);
+    snprintf(message, sizeof(message), "%u frames, %u goldens, render avg %u us, max %u us on the host",
+             (unsigned)framesRendered, (unsigned)goldensChecked, (unsigned)(renderTimeTotalUs / framesRendered),
+             (unsigned)renderTimeMaxUs);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(true);
+    nativeFlashErase();
+    nativeSetAnalogInput(SENSOR_LVL_PIN, 2000);
+    nativeSetDigitalInput(SENSOR_LDR_PIN, LOW);  /* Daylight */
+    nativeSetDigitalInput(SENSOR_PIR_PIN, LOW);
+    nativeSetDigitalInput(SENSOR_WELL_PIN, HIGH); /* Well full */
+    nativeSetDht(24.0f, 55.0f);
+
+    static OledDisplay oledDisplay(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_ADDRESS);
+    static WiFiManager wifiManager("DUMMY_WIFI_SSID", "DUMMY_WIFI_PASSWORD");
+    static ServerClient serverClient("http://127.0.0.1:3000/", &wifiManager);
+    data = nativeCreateSystem(&oledDisplay, &wifiManager, &serverClient);
+    deviceIdInit();
+    wifiManager.init();
+    oledDisplay.init();
+    oledDisplay.clearAllDisplay();
+    oledDisplay.setTextProperties(1, SSD1306_WHITE);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_data_screens);
+    RUN_TEST(test_wifi_screens);
+    RUN_TEST(test_render_time_summary);
+    return UNITY_END();
+}
@@ -0,0 +1,286 @@
+/*
+ * CBOR encoder and telemetry batch encoding, run with `pio test -e native -f test_schema_cbor`.
+ * The batches are read back with a small decoder written from RFC 8949, independent of the encoder.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <NativeSystem.h>
+#include <math.h>
+#include <stdint.h>
+#include "CborEncoder.h"
+#include "SchemaCodec.h"
+#include "DeviceId.h"
+
+SemaphoreHandle_t xSystemDataMutex;
+
+/**
+ * @brief Reads CBOR items from a buffer, any error is sticky.
+ */
+struct CborReader {
+    const uint8_t* buf;
+    size_t len;
+    size_t pos;
+    bool error;
+
+    uint8_t byte() {
+        if (pos >= len) {
+            error = true;
+            return 0;
+        }
+        return buf[pos++];
+    }
+
+    /**
+     * @brief Reads an initial byte and its argument.
+     * @param major[OUT] Major type, already shifted.
+     * @return The argument.
+     */
+    uint64_t head(uint8_t* major) {
+        uint8_t initial = byte();
+        uint8_t info = initial & 0x1F;
+        uint8_t bytes = (info < 24) ? 0 : (info == 24) ? 1 : (info == 25) ? 2 : (info == 26) ? 4 : (info == 27) ? 8 : 0xFF;
+        uint64_t value = (info < 24) ? info : 0;
+        *major = initial & 0xE0;
+        if (bytes == 0xFF) {
+            error = true;
+            return 0;
+        }
+        for (uint8_t i = 0; i < bytes; ++i) {
+            value = (value << 8) | byte();
+        }
+        return value;
+    }
+
+    uint64_t expect(uint8_t major) {
+        uint8_t actual;
+        uint64_t value = head(&actual);
+        error |= (actual != major);
+        return value;
+    }
+
+    int64_t integer() {
+        uint8_t major;
+        uint64_t value = head(&major);
+        if (major == CBOR_MAJOR_NINT) {
+            return -1 - (int64_t)value;
+        }
+        error |= (major != CBOR_MAJOR_UINT);
+        return (int64_t)value;
+    }
+
+    float float32() {
+        uint32_t bits = 0;
+        error |= (byte() != CBOR_FLOAT32);
+        for (uint8_t i = 0; i < 4; ++i) {
+            bits = (bits << 8) | byte();
+        }
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    bool text(const char* expected) {
+        size_t n = (size_t)expect(CBOR_MAJOR_TEXT);
+        bool equal = (n == strlen(expected)) && (pos + n <= len) && memcmp(&buf[pos], expected, n) == 0;
+        pos += n;
+        error |= !equal;
+        return equal;
+    }
+};
+
+static CborReader reader(const uint8_t* buf, size_t len) {
+    CborReader r = { buf, len, 0, false };
+    return r;
+}
+
+static size_t encodeUint(uint32_t value, uint8_t* buf) {
+    CborEncoder enc;
+    cborBegin(&enc, buf, 9);
+    cborWriteUint(&enc, value);
+    return enc.len;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_uint_uses_shortest_head(void) {
+    uint8_t buf[9];
+    const uint8_t v23[] = {0x17};
+    const uint8_t v24[] = {0x18, 0x18};
+    const uint8_t v255[] = {0x18, 0xFF};
+    const uint8_t v256[] = {0x19, 0x01, 0x00};
+    const uint8_t v65535[] = {0x19, 0xFF, 0xFF};
+    const uint8_t v65536[] = {0x1A, 0x00, 0x01, 0x00, 0x00};
+
+    TEST_ASSERT_EQUAL(1, encodeUint(0, buf));
+    TEST_ASSERT_EQUAL_HEX8(0x00, buf[0]);
+    TEST_ASSERT_EQUAL(sizeof(v23), encodeUint(23, buf));
+    TEST_ASSERT_EQUAL_MEMORY(v23, buf, sizeof(v23));
+    TEST_ASSERT_EQUAL(sizeof(v24), encodeUint(24, buf));
+    TEST_ASSERT_EQUAL_MEMORY(v24, buf, sizeof(v24));
+    TEST_ASSERT_EQUAL(sizeof(v255), encodeUint(255, buf));
+    TEST_ASSERT_EQUAL_MEMORY(v255, buf, sizeof(v255));
+    TEST_ASSERT_EQUAL(sizeof(v256), encodeUint(256, buf));
+    TEST_ASSERT_EQUAL_MEMORY(v256, buf, sizeof(v256));
+    TEST_ASSERT_EQUAL(sizeof(v65535), encodeUint(65535, buf));
+    TEST_ASSERT_EQUAL_MEMORY(v65535, buf, sizeof(v65535));
+    TEST_ASSERT_EQUAL(sizeof(v65536), encodeUint(65536, buf));
+    TEST_ASSERT_EQUAL_MEMORY(v65536, buf, sizeof(v65536));
+}
+
+void test_fixed_width_items(void) {
+    uint8_t buf[64];
+    CborEncoder enc;
+    const uint8_t expected[] = {
+        0x1A, 0x00, 0x00, 0x00, 0x07,                         /* cborWriteUintFixed(7) */
+        0x1B, 0x00, 0x00, 0x01, 0x99, 0xC8, 0x2C, 0xC0, 0x00, /* cborWriteUint64Fixed(1760000000000) */
+        0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* cborWriteInt64Fixed(-1) */
+        0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, /* cborWriteInt64Fixed(INT64_MIN) */
+        0xFA, 0x3F, 0xC0, 0x00, 0x00,                         /* cborWriteFloat(1.5) */
+        0xFA, 0x7F, 0xC0, 0x00, 0x00,                         /* cborWriteFloat(NAN) */
+    };
+
+    cborBegin(&enc, buf, sizeof(buf));
+    cborWriteUintFixed(&enc, 7);
+    cborWriteUint64Fixed(&enc, 1760000000000ull);
+    cborWriteInt64Fixed(&enc, -1);
+    cborWriteInt64Fixed(&enc, INT64_MIN);
+    cborWriteFloat(&enc, 1.5f);
+    cborWriteFloat(&enc, NAN);
+
+    TEST_ASSERT_FALSE(enc.overflow);
+    TEST_ASSERT_EQUAL(sizeof(expected), enc.len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(expected));
+}
+
+void test_strings_and_containers(void) {
+    uint8_t buf[64];
+    CborEncoder enc;
+    const uint8_t bytes[] = {0xDE, 0xAD};
+    const uint8_t expected[] = {
+        0xA2,                          /* map, 2 pairs */
+        0x62, 'i', 'd', 0x42, 0xDE, 0xAD,
+        0x67, 's', 'a', 'm', 'p', 'l', 'e', 's', 0x98, 0x18, /* array of 24 items, 1 byte count */
+    };
+
+    cborBegin(&enc, buf, sizeof(buf));
+    cborWriteMap(&enc, 2);
+    cborWriteText(&enc, "id");
+    cborWriteBytes(&enc, bytes, sizeof(bytes));
+    cborWriteText(&enc, "samples");
+    cborWriteArray(&enc, 24);
+
+    TEST_ASSERT_EQUAL(sizeof(expected), enc.len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(expected));
+}
+
+void test_overflow_is_sticky(void) {
+    uint8_t buf[8];
+    CborEncoder enc;
+
+    cborBegin(&enc, buf, sizeof(buf));
+    cborWriteUintFixed(&enc, 1);    /* 5 bytes */
+    cborWriteUintFixed(&enc, 2);    /* Does not fit */
+    cborWriteUint(&enc, 3);         /* Would fit, but the output is already broken */
+    TEST_ASSERT_TRUE(enc.overflow);
+    TEST_ASSERT_EQUAL(5, enc.len);
+
+    cborBegin(&enc, buf, 0);
+    cborWriteUint(&enc, 0);
+    TEST_ASSERT_TRUE(enc.overflow);
+}
+
+void test_batch_decodes(void) {
+    uint8_t buf[SCHEMA_BATCH_HEADER_SIZE + 2 * SCHEMA_SAMPLE_CBOR_SIZE];
+    TelemetrySample samples[2] = {
+        nativeSample(-2500000, 21.5f, 40.0f, 55, TELEMETRY_IN_LIGHT | TELEMETRY_IN_WELL, TELEMETRY_ACT_PUMP),
+        nativeSample(1000, NAN, 12.25f, 100, TELEMETRY_IN_PIR, TELEMETRY_ACT_LAMP | TELEMETRY_ACT_IRRIGATOR),
+    };
+    ClockEstimate clock = { 5000000, 1760000000123ull, -1.5f };
+
+    size_t len = schemaWriteBatchCbor(buf, sizeof(buf), samples, 2, clock);
+    TEST_ASSERT_GREATER_THAN(0, len);
+
+    CborReader r = reader(buf, len);
+    TEST_ASSERT_EQUAL(5, r.expect(CBOR_MAJOR_MAP));
+    r.text("id");
+    TEST_ASSERT_EQUAL(DEVICE_ID_SIZE, r.expect(CBOR_MAJOR_BYTES));
+    TEST_ASSERT_EQUAL_MEMORY(deviceIdBytes(), &buf[r.pos], DEVICE_ID_SIZE);
+    r.pos += DEVICE_ID_SIZE;
+    r.text("now");
+    TEST_ASSERT_EQUAL_INT64(5000000, r.integer());
+    r.text("wall");
+    TEST_ASSERT_EQUAL_INT64(1760000000123ll, r.integer());
+    r.text("ppm");
+    TEST_ASSERT_EQUAL_FLOAT(-1.5f, r.float32());
+    r.text("samples");
+    TEST_ASSERT_EQUAL(2, r.expect(CBOR_MAJOR_ARRAY));
+
+    /* [t, lvl, tmp, hum, ldr, pir, well, lmp, pmp, irr] */
+    TEST_ASSERT_EQUAL(10, r.expect(CBOR_MAJOR_ARRAY));
+    TEST_ASSERT_EQUAL_INT64(-2500000, r.integer());
+    TEST_ASSERT_EQUAL_INT64(55, r.integer());
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, r.float32());
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, r.float32());
+    TEST_ASSERT_EQUAL_INT64(1, r.integer());
+    TEST_ASSERT_EQUAL_INT64(0, r.integer());
+    TEST_ASSERT_EQUAL_INT64(1, r.integer());
+    TEST_ASSERT_EQUAL_INT64(0, r.integer());
+    TEST_ASSERT_EQUAL_INT64(1, r.integer());
+    TEST_ASSERT_EQUAL_INT64(0, r.integer());
+
+    TEST_ASSERT_EQUAL(10, r.expect(CBOR_MAJOR_ARRAY));
+    TEST_ASSERT_EQUAL_INT64(1000, r.integer());
+    TEST_ASSERT_EQUAL_INT64(100, r.integer());
+    TEST_ASSERT_FLOAT_IS_NAN(r.float32());
+    TEST_ASSERT_EQUAL_FLOAT(12.25f, r.float32());
+    TEST_ASSERT_EQUAL_INT64(0, r.integer());
+    TEST_ASSERT_EQUAL_INT64(1, r.integer());
+    TEST_ASSERT_EQUAL_INT64(0, r.integer());
+    TEST_ASSERT_EQUAL_INT64(1, r.integer());
+    TEST_ASSERT_EQUAL_INT64(0, r.integer());
+    TEST_ASSERT_EQUAL_INT64(1, r.integer());
+
+    TEST_ASSERT_FALSE(r.error);
+    TEST_ASSERT_EQUAL(len, r.pos);
+}
+
+/**
+ * @brief Every sample takes SCHEMA_SAMPLE_CBOR_SIZE bytes whatever its values, the batch buffer relies on it.
+ */
+void test_sample_size_is_fixed(void) {
+    static uint8_t buf[SCHEMA_BATCH_HEADER_SIZE + TELEMETRY_BATCH_SIZE * SCHEMA_SAMPLE_CBOR_SIZE];
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    ClockEstimate clock = { INT64_MAX, UINT64_MAX, NAN };
+
+    for (uint16_t i = 0; i < TELEMETRY_BATCH_SIZE; ++i) {
+        samples[i] = (i % 2 == 0) ? nativeSample(0, 0.0f, 0.0f, 0, 0, 0)
+                                  : nativeSample(INT64_MIN, -3.4e38f, NAN, UINT16_MAX, 0xFF, 0xFF);
+    }
+    size_t header = schemaWriteBatchCbor(buf, sizeof(buf), samples, 0, clock);
+    TEST_ASSERT_LESS_OR_EQUAL(SCHEMA_BATCH_HEADER_SIZE, header);
+
+    for (uint16_t count = 1; count <= TELEMETRY_BATCH_SIZE; ++count) {
+        size_t len = schemaWriteBatchCbor(buf, sizeof(buf), samples, count, clock);
+        /* The array head grows by a byte from 24 items, none of the samples do */
+        size_t arrayHead = (count >= 24) ? 1 : 0;
+        TEST_ASSERT_EQUAL(header + arrayHead + count * SCHEMA_SAMPLE_CBOR_SIZE, len);
+    }
+    TEST_ASSERT_EQUAL(0, schemaWriteBatchCbor(buf, header + SCHEMA_SAMPLE_CBOR_SIZE - 1, samples, 1, clock));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(true);
+    deviceIdInit();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_uint_uses_shortest_head);
+    RUN_TEST(test_fixed_width_items);
+    RUN_TEST(test_strings_and_containers);
+    RUN_TEST(test_overflow_is_sticky);
+    RUN_TEST(test_batch_decodes);
+    RUN_TEST(test_sample_size_is_fixed);
+    return UNITY_END();
+}
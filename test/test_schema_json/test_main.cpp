@@ -0,0 +1,196 @@
+/*
+ * JSON codecs generated from the field lists of include/SchemaCodec.h, run with
+ * `pio test -e native -f test_schema_json`.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <NativeSystem.h>
+#include <math.h>
+#include <stdint.h>
+#include <string>
+#include "SchemaCodec.h"
+#include "DeviceId.h"
+
+SemaphoreHandle_t xSystemDataMutex;
+
+static SystemData data;
+
+static void setSettings(uint8_t maxLevel, uint8_t minLevel, uint8_t hotTemperature, uint8_t lowHumidity) {
+    data.maxLevelPercentage = maxLevel;
+    data.minLevelPercentage = minLevel;
+    data.hotTemperature = hotTemperature;
+    data.lowHumidity = lowHumidity;
+}
+
+static int8_t parse(const char* json) {
+    return schemaParseSettings(json, strlen(json), &data);
+}
+
+void setUp(void) {
+    setSettings(90, 20, 30, 15);
+}
+
+void tearDown(void) {}
+
+void test_settings_object(void) {
+    char buf[SCHEMA_SETTINGS_JSON_SIZE];
+    size_t len = schemaWriteSettingsObjectJson(buf, sizeof(buf), &data);
+
+    TEST_ASSERT_EQUAL_STRING("{\"maxLevel\":90,\"minLevel\":20,\"hotTemperature\":30,\"lowHumidity\":15}", buf);
+    TEST_ASSERT_EQUAL(strlen(buf), len);
+}
+
+void test_settings_payload_carries_chip_id(void) {
+    char buf[SCHEMA_SETTINGS_JSON_SIZE];
+    char expected[SCHEMA_SETTINGS_JSON_SIZE];
+    setSettings(255, 255, 255, 255);
+    size_t len = schemaWriteSettingsJson(buf, sizeof(buf), &data);
+
+    snprintf(expected, sizeof(expected),
+             "{\"%s\":{\"settings\":{\"maxLevel\":255,\"minLevel\":255,\"hotTemperature\":255,\"lowHumidity\":255}}}",
+             deviceIdStr());
+    TEST_ASSERT_EQUAL_STRING("AA:BB:CC:DD:EE:FF", deviceIdStr());
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL(strlen(expected), len);
+    TEST_ASSERT_LESS_THAN(SCHEMA_SETTINGS_JSON_SIZE, len); /* Worst case values */
+}
+
+void test_settings_overflow_returns_zero(void) {
+    char buf[SCHEMA_SETTINGS_JSON_SIZE];
+    size_t len = schemaWriteSettingsObjectJson(buf, sizeof(buf), &data);
+
+    /* One byte is kept for the terminator */
+    for (size_t capacity = 0; capacity <= len; ++capacity) {
+        TEST_ASSERT_EQUAL(0, schemaWriteSettingsObjectJson(buf, capacity, &data));
+    }
+    TEST_ASSERT_EQUAL(len, schemaWriteSettingsObjectJson(buf, len + 1, &data));
+}
+
+void test_settings_round_trip(void) {
+    char buf[SCHEMA_SETTINGS_JSON_SIZE];
+    setSettings(87, 12, 41, 3);
+    size_t len = schemaWriteSettingsObjectJson(buf, sizeof(buf), &data);
+    setSettings(0, 0, 0, 0);
+
+    TEST_ASSERT_EQUAL(4, schemaParseSettings(buf, len, &data));
+    TEST_ASSERT_EQUAL(87, data.maxLevelPercentage);
+    TEST_ASSERT_EQUAL(12, data.minLevelPercentage);
+    TEST_ASSERT_EQUAL(41, data.hotTemperature);
+    TEST_ASSERT_EQUAL(3, data.lowHumidity);
+}
+
+void test_parse_skips_unknown_members(void) {
+    TEST_ASSERT_EQUAL(2, parse(" { \"note\" : \"a \\\"quoted\\\" } value\",\n"
+                               "  \"history\": [{\"maxLevel\": 1}, [2, 3]],\n"
+                               "  \"maxLevel\" : 70 , \"flag\": true, \"lowHumidity\":9 }"));
+    TEST_ASSERT_EQUAL(70, data.maxLevelPercentage);
+    TEST_ASSERT_EQUAL(20, data.minLevelPercentage);
+    TEST_ASSERT_EQUAL(9, data.lowHumidity);
+}
+
+void test_parse_ignores_invalid_values(void) {
+    TEST_ASSERT_EQUAL(1, parse("{\"maxLevel\":256,\"minLevel\":-1,\"hotTemperature\":\"35\",\"lowHumidity\":7}"));
+    TEST_ASSERT_EQUAL(90, data.maxLevelPercentage);
+    TEST_ASSERT_EQUAL(20, data.minLevelPercentage);
+    TEST_ASSERT_EQUAL(30, data.hotTemperature);
+    TEST_ASSERT_EQUAL(7, data.lowHumidity);
+    TEST_ASSERT_EQUAL(0, parse("{\"maxLevel\":1.5,\"minLevel\":1e2}"));
+    TEST_ASSERT_EQUAL(0, parse("{}"));
+}
+
+void test_parse_rejects_malformed_documents(void) {
+    TEST_ASSERT_EQUAL(-1, parse(""));
+    TEST_ASSERT_EQUAL(-1, parse("null"));
+    TEST_ASSERT_EQUAL(-1, parse("[1,2]"));
+    TEST_ASSERT_EQUAL(-1, parse("{\"maxLevel\":50"));
+    TEST_ASSERT_EQUAL(-1, parse("{\"maxLevel\" 50}"));
+    TEST_ASSERT_EQUAL(-1, parse("{\"maxLevel\":50,}"));
+    TEST_ASSERT_EQUAL(-1, parse("{\"note\":\"unterminated}"));
+    TEST_ASSERT_EQUAL(-1, parse("{\"nested\":{\"a\":1}"));
+    /* Nothing is applied from a document that turns out malformed past the setting */
+    TEST_ASSERT_EQUAL(90, data.maxLevelPercentage);
+}
+
+void test_has_key_and_get_uint(void) {
+    const char* json = "{\"error\":\"Not found\",\"stored\":15,\"seq\":\"7\",\"big\":1234567890}";
+    uint32_t value = 99;
+
+    TEST_ASSERT_TRUE(schemaHasKey(json, strlen(json), "error"));
+    TEST_ASSERT_FALSE(schemaHasKey(json, strlen(json), "err"));
+    TEST_ASSERT_FALSE(schemaHasKey("{\"error\":", 9, "error"));
+
+    TEST_ASSERT_TRUE(schemaGetUint(json, strlen(json), "stored", &value));
+    TEST_ASSERT_EQUAL(15, value);
+    TEST_ASSERT_FALSE(schemaGetUint(json, strlen(json), "seq", &value));  /* A string */
+    TEST_ASSERT_FALSE(schemaGetUint(json, strlen(json), "big", &value));  /* 10 digits */
+    TEST_ASSERT_FALSE(schemaGetUint(json, strlen(json), "missing", &value));
+    TEST_ASSERT_EQUAL(15, value);
+}
+
+void test_batch_json(void) {
+    char buf[SCHEMA_BATCH_HEADER_SIZE + 2 * SCHEMA_SAMPLE_JSON_SIZE];
+    char expected[sizeof(buf)];
+    TelemetrySample samples[2] = {
+        nativeSample(-2500000, 21.5f, 40.0f, 55, TELEMETRY_IN_LIGHT | TELEMETRY_IN_WELL, TELEMETRY_ACT_PUMP),
+        nativeSample(1000, NAN, NAN, 100, TELEMETRY_IN_PIR, TELEMETRY_ACT_LAMP | TELEMETRY_ACT_IRRIGATOR),
+    };
+    ClockEstimate clock = { 5000000, 1760000000123ull, -1.5f };
+
+    size_t len = schemaWriteBatchJson(buf, sizeof(buf), samples, 2, clock);
+    snprintf(expected, sizeof(expected),
+             "{\"%s\":{\"now\":5000000,\"wall\":1760000000123,\"ppm\":-1.5,\"samples\":["
+             "{\"t\":-2500000,\"sensorData\":{\"lvl\":55,\"tmp\":21.5,\"hum\":40,\"ldr\":\"1\",\"pir\":\"0\",\"well\":\"1\"},"
+             "\"actuatorData\":{\"lmp\":\"0\",\"pmp\":\"1\",\"irr\":\"0\"}},"
+             "{\"t\":1000,\"sensorData\":{\"lvl\":100,\"tmp\":null,\"hum\":null,\"ldr\":\"0\",\"pir\":\"1\",\"well\":\"0\"},"
+             "\"actuatorData\":{\"lmp\":\"1\",\"pmp\":\"0\",\"irr\":\"1\"}}]}}",
+             deviceIdStr());
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL(strlen(expected), len);
+
+    ClockEstimate unset = { 0, 0, 0.0f };
+    TEST_ASSERT_EQUAL(0, schemaWriteBatchJson(buf, len, samples, 2, clock));
+    len = schemaWriteBatchJson(buf, sizeof(buf), samples, 0, unset);
+    snprintf(expected, sizeof(expected), "{\"%s\":{\"now\":0,\"wall\":0,\"ppm\":0,\"samples\":[]}}", deviceIdStr());
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+}
+
+/**
+ * @brief The payload buffer of the server task is sized from these, they must hold the longest values.
+ */
+void test_batch_json_worst_case_sizes(void) {
+    static char buf[SCHEMA_BATCH_HEADER_SIZE + TELEMETRY_BATCH_SIZE * SCHEMA_SAMPLE_JSON_SIZE];
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    for (uint16_t i = 0; i < TELEMETRY_BATCH_SIZE; ++i) {
+        samples[i] = nativeSample(INT64_MIN, -1.23456e-30f, -3.40282e38f, UINT16_MAX, 0xFF, 0xFF);
+    }
+    ClockEstimate clock = { INT64_MAX, UINT64_MAX, -1.23456e-30f };
+
+    size_t header = schemaWriteBatchJson(buf, sizeof(buf), samples, 0, clock);
+    size_t one = schemaWriteBatchJson(buf, sizeof(buf), samples, 1, clock);
+    size_t full = schemaWriteBatchJson(buf, sizeof(buf), samples, TELEMETRY_BATCH_SIZE, clock);
+
+    TEST_ASSERT_GREATER_THAN(0, header);
+    TEST_ASSERT_LESS_OR_EQUAL(SCHEMA_BATCH_HEADER_SIZE, header);
+    TEST_ASSERT_LESS_OR_EQUAL(SCHEMA_SAMPLE_JSON_SIZE, one - header);
+    TEST_ASSERT_GREATER_THAN(0, full);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(true);
+    deviceIdInit();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_settings_object);
+    RUN_TEST(test_settings_payload_carries_chip_id);
+    RUN_TEST(test_settings_overflow_returns_zero);
+    RUN_TEST(test_settings_round_trip);
+    RUN_TEST(test_parse_skips_unknown_members);
+    RUN_TEST(test_parse_ignores_invalid_values);
+    RUN_TEST(test_parse_rejects_malformed_documents);
+    RUN_TEST(test_has_key_and_get_uint);
+    RUN_TEST(test_batch_json);
+    RUN_TEST(test_batch_json_worst_case_sizes);
+    return UNITY_END();
+}
@@ -0,0 +1,265 @@
+/*
+ * Heap use of the settings download, run with `pio test -e native -f test_settings_fetch`.
+ *
+ * A loopback HTTP server thread answers /sync with the settings padded to 200 B, 4 KB and 64 KB of unrelated
+ * members, as a backend that grew its response would. The exchange runs through serviceServerRequests() on the
+ * host build and the heap it takes is read from the counting operator new of lib/NativeHost. The response is
+ * filtered as it arrives, so the peak must not grow with its size. Socket buffers (lwIP on the device) are not
+ * counted.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <NativeSystem.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ProcessMgr.h"
+#include "SrvClientMgr.h"
+#include "TelemetryMgr.h"
+#include "DeviceId.h"
+
+#define FETCH_TIMEOUT_MS   (5000) /* Virtual time allowed for one exchange */
+#define POLL_INTERVAL_MS   (10)   /* Server task period while a request is in progress */
+#define FETCH_HEAP_LIMIT   (1024) /* Logs included, far below the smallest response */
+#define FETCH_HEAP_SLACK   (64)   /* Log lines grow with the length of the numbers they carry */
+
+SemaphoreHandle_t xSystemDataMutex;
+
+#define SERVER_CONNECTIONS (4)    /* Connections the loopback server keeps open at once */
+#define SERVER_REQUEST_SIZE (4096) /* Requests are small, header and body fit */
+
+/**
+ * @brief HTTP/1.1 server on a loopback port, answering every request with the same prepared response.
+ *        It does not allocate once started, so the heap counters only see the firmware.
+ */
+class LoopbackServer {
+private:
+    struct Connection {
+        int fd;
+        size_t len;
+        char request[SERVER_REQUEST_SIZE];
+    };
+
+    int listenFd;
+    Connection connections[SERVER_CONNECTIONS];
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<const std::string*> response;
+
+    /**
+     * @brief Reads what the connection has to give and answers the complete requests.
+     * @return False once the connection is closed.
+     */
+    bool serve(Connection* c) {
+        ssize_t n = recv(c->fd, &c->request[c->len], sizeof(c->request) - 1 - c->len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        c->len += n;
+        c->request[c->len] = '\0';
+        for (;;) {
+            char* headerEnd = strstr(c->request, "\r\n\r\n");
+            if (headerEnd == NULL) {
+                return true;
+            }
+            const char* lengthHeader = strcasestr(c->request, "Content-Length:");
+            size_t bodyLen = (lengthHeader != NULL && lengthHeader < headerEnd) ? strtoul(lengthHeader + 15, NULL, 10) : 0;
+            size_t requestLen = headerEnd + 4 - c->request + bodyLen;
+            if (c->len < requestLen) {
+                return true;
+            }
+
+            const std::string* body = response.load();
+            char header[160];
+            int headerLen = snprintf(header, sizeof(header),
+                                     "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: \"v2\"\r\n"
+                                     "Content-Length: %zu\r\nConnection: keep-alive\r\n\r\n", body->size());
+            send(c->fd, header, headerLen, MSG_NOSIGNAL);
+            for (size_t sent = 0; sent < body->size();) {
+                ssize_t s = send(c->fd, body->data() + sent, body->size() - sent, MSG_NOSIGNAL);
+                if (s <= 0) {
+                    return false;
+                }
+                sent += s;
+            }
+
+            memmove(c->request, &c->request[requestLen], c->len - requestLen + 1);
+            c->len -= requestLen;
+        }
+    }
+
+    void run() {
+        while (!stopping) {
+            struct pollfd pfds[SERVER_CONNECTIONS + 1];
+            pfds[0] = {listenFd, POLLIN, 0};
+            for (uint8_t i = 0; i < SERVER_CONNECTIONS; ++i) {
+                pfds[i + 1] = {connections[i].fd, POLLIN, 0};
+            }
+            if (poll(pfds, SERVER_CONNECTIONS + 1, 50) <= 0) {
+                continue;
+            }
+            for (uint8_t i = 0; i < SERVER_CONNECTIONS; ++i) {
+                if ((pfds[i + 1].revents & (POLLIN | POLLHUP)) && !serve(&connections[i])) {
+                    close(connections[i].fd);
+                    connections[i].fd = -1;
+                }
+            }
+            if (pfds[0].revents & POLLIN) {
+                int fd = accept(listenFd, NULL, NULL);
+                for (uint8_t i = 0; i < SERVER_CONNECTIONS && fd >= 0; ++i) {
+                    if (connections[i].fd < 0) {
+                        connections[i].fd = fd;
+                        connections[i].len = 0;
+                        fd = -1;
+                    }
+                }
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        }
+        for (uint8_t i = 0; i < SERVER_CONNECTIONS; ++i) {
+            if (connections[i].fd >= 0) {
+                close(connections[i].fd);
+            }
+        }
+    }
+
+public:
+    LoopbackServer() : listenFd(-1), stopping(false), response(NULL) {
+        for (uint8_t i = 0; i < SERVER_CONNECTIONS; ++i) {
+            connections[i].fd = -1;
+        }
+    }
+
+    uint16_t start() {
+        struct sockaddr_in addr = {};
+        socklen_t addrLen = sizeof(addr);
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 1) != 0 ||
+            getsockname(listenFd, (struct sockaddr*)&addr, &addrLen) != 0) {
+            return 0;
+        }
+        thread = std::thread(&LoopbackServer::run, this);
+        return ntohs(addr.sin_port);
+    }
+
+    void stop() {
+        stopping = true;
+        thread.join();
+        close(listenFd);
+    }
+
+    void respondWith(const std::string* body) { response = body; }
+};
+
+static LoopbackServer server;
+static SystemData* data;
+
+/**
+ * @brief A /sync response carrying the given settings, padded with members the filter must skip.
+ * @param size Size of the response body.
+ */
+static std::string syncResponse(size_t size, uint8_t maxLevel) {
+    std::string body = "{\"time\":1760000000000,\"stored\":0,\"history\":[";
+    char settings[128];
+    snprintf(settings, sizeof(settings),
+             "\"maxLevel\":%u,\"minLevel\":25,\"hotTemperature\":31,\"lowHumidity\":18", maxLevel);
+
+    /* Nested values and long strings, as a backend that grew its response would send */
+    while (body.size() + 64 + strlen(settings) < size / 2) {
+        body += "{\"t\":1760000000000,\"lvl\":42,\"note\":\"{not a member}\"},";
+    }
+    body.back() = (body.back() == ',') ? ']' : body.back();
+    if (body.back() == '[') {
+        body += "]";
+    }
+    body += ",";
+    body += settings;
+    body += ",\"notes\":\"";
+    while (body.size() + 2 < size) {
+        body += "x";
+    }
+    body += "\"}";
+    return body;
+}
+
+/**
+ * @brief Runs one /sync exchange answered with a response of the given size.
+ * @return The most heap the exchange took, above what was in use before it.
+ */
+static uint32_t fetchPeakHeap(size_t size, uint8_t maxLevel) {
+    std::string body = syncResponse(size, maxLevel);
+    uint32_t count = getServerOpStats(SERVER_OP_SYNC).count;
+    server.respondWith(&body);
+
+    uint32_t inUse = nativeHeapInUse();
+    nativeHeapResetPeak();
+    requestServerOp(SERVER_OP_SYNC);
+    for (uint32_t waited = 0; waited < FETCH_TIMEOUT_MS && getServerOpStats(SERVER_OP_SYNC).count == count;
+         waited += POLL_INTERVAL_MS) {
+        serviceServerRequests(data);
+        nativeAdvanceMillis(POLL_INTERVAL_MS);
+        /* The client never waits on its socket, the server thread needs real time to answer */
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint32_t peak = nativeHeapPeak() - inUse;
+
+    TEST_ASSERT_EQUAL_MESSAGE(count + 1, getServerOpStats(SERVER_OP_SYNC).count, "The exchange did not complete");
+    TEST_ASSERT_EQUAL_MESSAGE(0, getServerOpStats(SERVER_OP_SYNC).failures, "The exchange failed");
+    TEST_ASSERT_EQUAL(body.size(), data->SrvClient->getResponseLength());
+    TEST_ASSERT_EQUAL(maxLevel, data->maxLevelPercentage);
+    TEST_ASSERT_EQUAL(25, data->minLevelPercentage);
+    TEST_ASSERT_EQUAL(31, data->hotTemperature);
+    TEST_ASSERT_EQUAL(18, data->lowHumidity);
+    printf("%6zu B response: peak heap %u B during the fetch, %u B sampled by ServerOpStats\n", body.size(), peak,
+           getServerOpStats(SERVER_OP_SYNC).maxHeapBytes);
+    return peak;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fetch_heap_does_not_grow_with_response(void) {
+    uint32_t small = fetchPeakHeap(200, 80);
+    uint32_t medium = fetchPeakHeap(4096, 81);
+    uint32_t large = fetchPeakHeap(65536, 82);
+
+    TEST_ASSERT_LESS_OR_EQUAL(FETCH_HEAP_LIMIT, small);
+    TEST_ASSERT_LESS_OR_EQUAL(small + FETCH_HEAP_SLACK, medium);
+    TEST_ASSERT_LESS_OR_EQUAL(small + FETCH_HEAP_SLACK, large);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    static char serverUrl[48];
+
+    nativeSerialMute(getenv("VERBOSE") == NULL);
+    nativeFlashErase();
+    uint16_t port = server.start();
+    if (port == 0) {
+        printf("Cannot listen on a loopback port\n");
+        return 1;
+    }
+    snprintf(serverUrl, sizeof(serverUrl), "http://127.0.0.1:%u/", port);
+
+    static WiFiManager wifiManager("DUMMY_WIFI_SSID", "DUMMY_WIFI_PASSWORD");
+    static ServerClient serverClient(serverUrl, &wifiManager);
+    data = nativeCreateSystem(NULL, &wifiManager, &serverClient);
+    deviceIdInit();
+    telemetryInit();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_fetch_heap_does_not_grow_with_response);
+    int failures = UNITY_END();
+    server.stop();
+    return failures;
+}
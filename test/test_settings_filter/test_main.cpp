@@ -0,0 +1,146 @@
+/*
+ * Streaming settings filter of /sync and /getSettings responses, run with `pio test -e native -f test_settings_filter`.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <stdint.h>
+#include <string>
+#include "SchemaCodec.h"
+
+SemaphoreHandle_t xSystemDataMutex;
+
+static SchemaSettingsFilter filter;
+
+/**
+ * @brief Filters a whole document fed in one piece.
+ * @return True if it was a complete, well formed object.
+ */
+static bool filterDocument(const char* json) {
+    schemaFilterBegin(&filter);
+    schemaFilterFeed(&filter, json, strlen(json));
+    return schemaFilterEnd(&filter);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_keeps_settings_and_sync_members(void) {
+    TEST_ASSERT_TRUE(filterDocument("{\"time\":1760000000123,\"stored\":15,\"maxLevel\":80,\"minLevel\":25,"
+                                    "\"hotTemperature\":31,\"lowHumidity\":18,\"noSettings\":false}"));
+    TEST_ASSERT_EQUAL_STRING("{\"maxLevel\":80,\"minLevel\":25,\"hotTemperature\":31,\"lowHumidity\":18}", filter.out);
+    TEST_ASSERT_EQUAL(strlen(filter.out), filter.outLen);
+    TEST_ASSERT_TRUE(filter.serverTime == 1760000000123ull);
+    TEST_ASSERT_FALSE(filter.noSettings);
+    TEST_ASSERT_FALSE(filter.hasError);
+
+    TEST_ASSERT_TRUE(filterDocument(" {\n\t\"noSettings\" : true , \"time\" : 5 }\r\n"));
+    TEST_ASSERT_EQUAL_STRING("{}", filter.out);
+    TEST_ASSERT_TRUE(filter.noSettings);
+    TEST_ASSERT_TRUE(filter.serverTime == 5);
+
+    TEST_ASSERT_TRUE(filterDocument("{}"));
+    TEST_ASSERT_EQUAL_STRING("{}", filter.out);
+    TEST_ASSERT_TRUE(filter.serverTime == 0);
+}
+
+/**
+ * @brief Responses arrive in pieces of any size, every split of the document must give the same result.
+ */
+void test_pieces_split_anywhere(void) {
+    const char* json = "{\"history\":[{\"maxLevel\":1,\"note\":\"}]\\\"\"}],\"time\":1760000000000,"
+                       "\"maxLevel\":70,\"label\":\"a \\\"b\\\" {c}\",\"lowHumidity\":9}";
+    size_t len = strlen(json);
+
+    for (size_t split = 0; split <= len; ++split) {
+        schemaFilterBegin(&filter);
+        schemaFilterFeed(&filter, json, split);
+        schemaFilterFeed(&filter, json + split, len - split);
+        TEST_ASSERT_TRUE(schemaFilterEnd(&filter));
+        TEST_ASSERT_EQUAL_STRING("{\"maxLevel\":70,\"lowHumidity\":9}", filter.out);
+        TEST_ASSERT_TRUE(filter.serverTime == 1760000000000ull);
+    }
+
+    schemaFilterBegin(&filter);
+    for (size_t i = 0; i < len; ++i) {
+        schemaFilterFeed(&filter, &json[i], 1);
+    }
+    TEST_ASSERT_TRUE(schemaFilterEnd(&filter));
+    TEST_ASSERT_EQUAL_STRING("{\"maxLevel\":70,\"lowHumidity\":9}", filter.out);
+}
+
+void test_skips_nested_values_and_strings(void) {
+    std::string json = "{\"settings\":{\"maxLevel\":1,\"minLevel\":2},\"deep\":";
+    json += std::string(200, '[') + "\"]}\"" + std::string(200, ']');
+    json += ",\"minLevel\":\"30\",\"note\":\"\\\\\",\"hotTemperature\":33}";
+
+    /* Only top level members are kept, string values are not settings */
+    TEST_ASSERT_TRUE(filterDocument(json.c_str()));
+    TEST_ASSERT_EQUAL_STRING("{\"hotTemperature\":33}", filter.out);
+
+    /* Large documents are skipped byte by byte */
+    json = "{\"notes\":\"" + std::string(65536, 'x') + "\",\"maxLevel\":64}";
+    TEST_ASSERT_TRUE(filterDocument(json.c_str()));
+    TEST_ASSERT_EQUAL_STRING("{\"maxLevel\":64}", filter.out);
+}
+
+void test_error_member(void) {
+    TEST_ASSERT_TRUE(filterDocument("{\"error\":\"Device not registered\"}"));
+    TEST_ASSERT_TRUE(filter.hasError);
+    TEST_ASSERT_TRUE(filterDocument("{\"errors\":0,\"message\":\"error\",\"x\":{\"error\":1}}"));
+    TEST_ASSERT_FALSE(filter.hasError);
+}
+
+void test_rejects_invalid_documents(void) {
+    TEST_ASSERT_FALSE(filterDocument(""));
+    TEST_ASSERT_FALSE(filterDocument("   "));
+    TEST_ASSERT_FALSE(filterDocument("[{\"maxLevel\":1}]"));
+    TEST_ASSERT_FALSE(filterDocument("null"));
+    TEST_ASSERT_FALSE(filterDocument("{\"maxLevel\":70"));
+    TEST_ASSERT_FALSE(filterDocument("{\"maxLevel\" 70}"));
+    TEST_ASSERT_FALSE(filterDocument("{\"maxLevel\":}"));
+    TEST_ASSERT_FALSE(filterDocument("{maxLevel:70}"));
+    TEST_ASSERT_FALSE(filterDocument("{\"a\":\"b\" \"c\":1}"));
+    TEST_ASSERT_FALSE(filterDocument("{\"a\":[1,2}"));
+    TEST_ASSERT_FALSE(filterDocument("{\"a\":\"unterminated}"));
+    TEST_ASSERT_FALSE(filterDocument("{} {}"));
+    TEST_ASSERT_FALSE(filterDocument("{\"maxLevel\":70}x"));
+}
+
+void test_drops_tokens_too_long(void) {
+    /* Keys of SCHEMA_FILTER_TOKEN_SIZE bytes or more cannot be known, even when one is their prefix */
+    TEST_ASSERT_TRUE(filterDocument("{\"maxLevelPercentage\":10,\"hotTemperatureXYZ\":11,\"minLevel\":12}"));
+    TEST_ASSERT_EQUAL_STRING("{\"minLevel\":12}", filter.out);
+
+    /* Values that do not fit are dropped rather than cut */
+    TEST_ASSERT_TRUE(filterDocument("{\"maxLevel\":0000000000000070,\"minLevel\":000000000000071}"));
+    TEST_ASSERT_EQUAL_STRING("{\"minLevel\":000000000000071}", filter.out);
+    TEST_ASSERT_TRUE(filterDocument("{\"time\":17600000000000000000}"));
+    TEST_ASSERT_TRUE(filter.serverTime == 0);
+}
+
+void test_output_is_parsed_by_schema(void) {
+    SystemData data = {};
+    data.maxLevelPercentage = 90;
+
+    TEST_ASSERT_TRUE(filterDocument("{\"time\":1,\"maxLevel\":75,\"minLevel\":300,\"hotTemperature\":28,\"lowHumidity\":20}"));
+    TEST_ASSERT_EQUAL(3, schemaParseSettings(filter.out, filter.outLen, &data));
+    TEST_ASSERT_EQUAL(75, data.maxLevelPercentage);
+    TEST_ASSERT_EQUAL(28, data.hotTemperature);
+    TEST_ASSERT_EQUAL(20, data.lowHumidity);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_keeps_settings_and_sync_members);
+    RUN_TEST(test_pieces_split_anywhere);
+    RUN_TEST(test_skips_nested_values_and_strings);
+    RUN_TEST(test_error_member);
+    RUN_TEST(test_rejects_invalid_documents);
+    RUN_TEST(test_drops_tokens_too_long);
+    RUN_TEST(test_output_is_parsed_by_schema);
+    return UNITY_END();
+}
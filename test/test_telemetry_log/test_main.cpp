@@ -0,0 +1,239 @@
+/*
+ * Flash log of the samples that could not be sent, run with `pio test -e native -f test_telemetry_log`.
+ *
+ * Samples are recorded through telemetryRecordOnChange() and moved to the log by telemetryLogSpill() once they
+ * waited TELEMETRY_SPILL_AGE_MS. A reset is a new telemetryLogInit() on the same flash. The clock of the process
+ * can only be set once, so the tests that need it unset run first.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <NativeSystem.h>
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+#include "ClockMgr.h"
+#include "ProcessMgr.h"
+#include "TelemetryLog.h"
+
+#define LOG_RECORD_SIZE        (28)   /* sizeof(TelemetryLogRecord) */
+#define LOG_RECORD_LEVEL       (22)   /* Offset of levelPercentage in a record */
+#define SAMPLE_INTERVAL_MS     (1000) /* Time between two recorded samples */
+
+SemaphoreHandle_t xSystemDataMutex;
+
+static SystemData* data;
+
+/**
+ * @brief Boots on the flash as it is: the log is reloaded and the sample sequence restarts.
+ */
+static void boot() {
+    telemetryInit();
+    telemetryLogInit();
+}
+
+/**
+ * @brief Records samples that are never uploaded until they all moved to the log.
+ *        The level alternates so each one is recorded, and says which one it is.
+ * @param count Number of samples.
+ */
+static void logSamples(uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        data->levelPercentage = (i % 2 == 0) ? 10 : 60;
+        TEST_ASSERT_TRUE(telemetryRecordOnChange(data));
+        nativeAdvanceMillis(SAMPLE_INTERVAL_MS);
+        telemetryLogSpill();
+    }
+    nativeAdvanceMillis(TELEMETRY_SPILL_AGE_MS);
+    while (telemetryCount() > 0) {
+        telemetryLogSpill();
+    }
+}
+
+/**
+ * @brief Uploads the oldest logged samples.
+ * @param samples[OUT] Destination array of TELEMETRY_BATCH_SIZE samples.
+ * @param records[OUT] Records read.
+ * @return The number of samples read.
+ */
+static uint16_t upload(TelemetrySample* samples, uint16_t* records) {
+    uint16_t count = telemetryLogPeek(samples, TELEMETRY_BATCH_SIZE, records);
+    telemetryLogDrop(*records);
+    return count;
+}
+
+static std::string segmentFile(uint8_t segment) {
+    char path[TELEMETRY_LOG_PATH_SIZE];
+    snprintf(path, sizeof(path), "/tlm%02u.bin", segment);
+    return std::string(nativeFsRoot()) + path;
+}
+
+static long fileSize(const std::string& path) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+void setUp(void) {
+    nativeFlashErase();
+    boot();
+}
+
+void tearDown(void) {}
+
+void test_samples_come_back_in_order(void) {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    uint16_t records;
+    int64_t firstUs = clockNowUs();
+
+    logSamples(40);
+    TEST_ASSERT_EQUAL(40, telemetryLogCount());
+    TEST_ASSERT_EQUAL(40 * LOG_RECORD_SIZE, fileSize(segmentFile(0)));
+
+    /* A failed upload leaves them in place */
+    TEST_ASSERT_EQUAL(TELEMETRY_BATCH_SIZE, telemetryLogPeek(samples, TELEMETRY_BATCH_SIZE, &records));
+    TEST_ASSERT_EQUAL(40, telemetryLogCount());
+
+    for (uint32_t seq = 0; seq < 40;) {
+        uint16_t count = upload(samples, &records);
+        TEST_ASSERT_EQUAL(records, count);
+        for (uint16_t i = 0; i < count; ++i, ++seq) {
+            TEST_ASSERT_EQUAL(seq, samples[i].seq);
+            TEST_ASSERT_EQUAL((seq % 2 == 0) ? 10 : 60, samples[i].levelPercentage);
+            TEST_ASSERT_TRUE(samples[i].timeUs == firstUs + (int64_t)seq * SAMPLE_INTERVAL_MS * 1000);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, telemetryLogCount());
+    TEST_ASSERT_EQUAL(-1, fileSize(segmentFile(0))); /* Erased once uploaded */
+}
+
+/**
+ * @brief Samples of a boot whose clock was never set cannot be dated: they wait for the clock of this boot,
+ *        then are dropped.
+ */
+void test_undated_samples_of_previous_boot(void) {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    uint16_t records;
+
+    logSamples(10);
+    boot();
+    TEST_ASSERT_EQUAL(10, telemetryLogCount());
+    TEST_ASSERT_EQUAL(0, telemetryLogPeek(samples, TELEMETRY_BATCH_SIZE, &records));
+    TEST_ASSERT_EQUAL(0, records);
+
+    clockUpdate(1760000000000ull, clockNowUs(), 50000);
+    TEST_ASSERT_TRUE(clockSynced());
+    TEST_ASSERT_EQUAL(0, upload(samples, &records));
+    TEST_ASSERT_EQUAL(10, records);
+    TEST_ASSERT_EQUAL(0, telemetryLogCount());
+}
+
+/**
+ * @brief A reset in the middle of a write leaves a partial record, and a corrupted one is caught by its CRC.
+ *        Both are skipped and the samples logged after the reset go to a fresh segment.
+ */
+void test_torn_and_corrupted_records_are_skipped(void) {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    uint16_t records;
+    int64_t firstUs = clockNowUs();
+
+    logSamples(20);
+    std::string path = segmentFile(0);
+    TEST_ASSERT_EQUAL(0, truncate(path.c_str(), 20 * LOG_RECORD_SIZE - 5));
+    FILE* fp = fopen(path.c_str(), "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, 3 * LOG_RECORD_SIZE + LOG_RECORD_LEVEL, SEEK_SET);
+    fputc(99, fp);
+    fclose(fp);
+
+    boot();
+    TEST_ASSERT_EQUAL(19, telemetryLogCount());
+    logSamples(5);
+    TEST_ASSERT_EQUAL(24, telemetryLogCount());
+    TEST_ASSERT_EQUAL(19 * LOG_RECORD_SIZE + LOG_RECORD_SIZE - 5, fileSize(path));
+    TEST_ASSERT_EQUAL(5 * LOG_RECORD_SIZE, fileSize(segmentFile(1)));
+
+    /* Logged with wall time, they come back at their device time, the clock was not adjusted since */
+    TEST_ASSERT_EQUAL(14, upload(samples, &records));
+    TEST_ASSERT_EQUAL(15, records);
+    for (uint16_t i = 0; i < 14; ++i) {
+        uint32_t seq = (i < 3) ? i : i + 1;
+        TEST_ASSERT_EQUAL(seq, samples[i].seq);
+        TEST_ASSERT_TRUE(llabs(samples[i].timeUs - (firstUs + (int64_t)seq * SAMPLE_INTERVAL_MS * 1000)) <= 1000);
+    }
+    TEST_ASSERT_EQUAL(4, upload(samples, &records));
+    TEST_ASSERT_EQUAL(4, records);
+    TEST_ASSERT_EQUAL(18, samples[3].seq);
+
+    TEST_ASSERT_EQUAL(5, upload(samples, &records));
+    TEST_ASSERT_EQUAL(0, samples[0].seq);
+    TEST_ASSERT_EQUAL(0, telemetryLogCount());
+}
+
+/**
+ * @brief Records uploaded before a reset are not sent again, the backend could not tell them from new ones.
+ */
+void test_upload_progress_survives_reset(void) {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    uint16_t records;
+
+    logSamples(40);
+    TEST_ASSERT_EQUAL(TELEMETRY_BATCH_SIZE, upload(samples, &records));
+    TEST_ASSERT_EQUAL(TELEMETRY_BATCH_SIZE, upload(samples, &records));
+    boot();
+    TEST_ASSERT_EQUAL(40 - 2 * TELEMETRY_BATCH_SIZE, telemetryLogCount());
+    TEST_ASSERT_EQUAL(10, upload(samples, &records));
+    TEST_ASSERT_EQUAL(2 * TELEMETRY_BATCH_SIZE, samples[0].seq);
+    TEST_ASSERT_EQUAL(0, telemetryLogCount());
+
+    /* Progress stored for a segment since erased does not apply to the next one */
+    logSamples(20);
+    boot();
+    TEST_ASSERT_EQUAL(20, telemetryLogCount());
+    TEST_ASSERT_EQUAL(TELEMETRY_BATCH_SIZE, upload(samples, &records));
+    TEST_ASSERT_EQUAL(0, samples[0].seq);
+}
+
+/**
+ * @brief When the ring of segments is full the oldest segment is erased, and after a reset the head is found
+ *        from the first record of each segment.
+ */
+void test_full_log_drops_oldest_segment(void) {
+    TelemetrySample samples[TELEMETRY_BATCH_SIZE];
+    uint16_t records;
+    const uint32_t capacity = TELEMETRY_LOG_SEGMENTS * TELEMETRY_LOG_SEGMENT_RECORDS;
+
+    logSamples(capacity + 20);
+    TEST_ASSERT_EQUAL(capacity + 20 - TELEMETRY_LOG_SEGMENT_RECORDS, telemetryLogCount());
+    TEST_ASSERT_EQUAL(20 * LOG_RECORD_SIZE, fileSize(segmentFile(0)));
+
+    boot();
+    TEST_ASSERT_EQUAL(capacity + 20 - TELEMETRY_LOG_SEGMENT_RECORDS, telemetryLogCount());
+    TEST_ASSERT_EQUAL(TELEMETRY_BATCH_SIZE, upload(samples, &records));
+    TEST_ASSERT_EQUAL(TELEMETRY_LOG_SEGMENT_RECORDS, samples[0].seq);
+
+    /* The segment after the newest one is the next to be erased */
+    logSamples(1);
+    TEST_ASSERT_EQUAL(LOG_RECORD_SIZE, fileSize(segmentFile(1)));
+    TEST_ASSERT_EQUAL(TELEMETRY_BATCH_SIZE, upload(samples, &records));
+    TEST_ASSERT_EQUAL(2 * TELEMETRY_LOG_SEGMENT_RECORDS, samples[0].seq);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(getenv("VERBOSE") == NULL);
+    data = nativeCreateSystem(NULL, NULL, NULL);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_samples_come_back_in_order);
+    RUN_TEST(test_undated_samples_of_previous_boot);
+    RUN_TEST(test_torn_and_corrupted_records_are_skipped);
+    RUN_TEST(test_upload_progress_survives_reset);
+    RUN_TEST(test_full_log_drops_oldest_segment);
+    return UNITY_END();
+}
@@ -0,0 +1,280 @@
+/*
+ * Replay test of the sensor/actuator trace, run with `pio test -e native -f test_trace_replay`.
+ *
+ * fixture.trace is a capture of a scripted day (presence, night, the tank emptying and refilling, the well
+ * running dry, a hot and dry spell) recorded by the host build with the device task phases. traceReplay() feeds
+ * it through ProcessMgr and every recorded actuator change must be reproduced.
+ *
+ * TRACE_FILE=<capture> replays a device capture instead (raw Serial output, logs included, from boot).
+ * TRACE_RECORD=<path> re-records the fixture after the scenario or the recorder format changed.
+ */
+#include <unity.h>
+#include <NativeHost.h>
+#include <NativeSystem.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "ProcessMgr.h"
+#include "TraceMgr.h"
+
+#define TASK_PERIOD_MS     (100)   /* Period of the device tasks */
+#define TICK_MS            (10)    /* Resolution of the recording scheduler */
+#define PROCESS_PHASE_MS   (30)    /* Offsets of the process and actuator tasks from the sensor task */
+#define ACTUATOR_PHASE_MS  (60)
+#define DHT_READ_PERIOD_MS (2000)  /* As TaskReadSensors */
+#define SCENARIO_MS        (64000)
+
+SemaphoreHandle_t xSystemDataMutex;
+
+static SystemData* data;
+
+/**
+ * @brief Raw ADC value of a tank level in percent, inverse of PumpActivationCtrl().
+ */
+static uint16_t levelAdc(uint32_t percentage) {
+    return (uint16_t)(SENSOR_LVL_ADC_0_V + SENSOR_LVL_THRESHOLD_V +
+                      percentage * ((SENSOR_LVL_ADC_100_V - SENSOR_LVL_THRESHOLD_V) -
+                                    (SENSOR_LVL_ADC_0_V + SENSOR_LVL_THRESHOLD_V)) / 100);
+}
+
+/**
+ * @brief Sets the inputs of the scripted day at a time of the recording.
+ */
+static void scenarioInputs(uint32_t t) {
+    uint32_t level = 50;
+    if (t >= 20000 && t < 30000) {
+        level = 50 - (t - 20000) * 40 / 10000;   /* The tank empties down to 10 % */
+    } else if (t >= 30000 && t < 34000) {
+        level = 10;
+    } else if (t >= 34000 && t < 44000) {
+        level = 10 + (t - 34000) * 85 / 10000;   /* And refills up to 95 % */
+    } else if (t >= 44000) {
+        level = 95 - min((t - 44000) / 200, (uint32_t)20);
+    }
+    bool pir = (t >= 2000 && t < 3000) || (t >= 12000 && t < 12500);
+    bool dark = (t >= 10000 && t < 16000);
+    bool wellEmpty = (t >= 31000 && t < 36000);
+    bool hotAndDry = (t >= 48000 && t < 56000);
+
+    nativeSetAnalogInput(SENSOR_LVL_PIN, levelAdc(level));
+    nativeSetDigitalInput(SENSOR_PIR_PIN, pir ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_LDR_PIN, dark ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_WELL_PIN, wellEmpty ? LOW : HIGH);
+    nativeSetDht(hotAndDry ? 33.4f : 24.6f, hotAndDry ? 9.0f : 41.5f);
+}
+
+/**
+ * @brief Runs the scripted day with the sensor, process and actuator tasks out of phase, as on the device,
+ *        and returns what the recorder streamed over Serial.
+ */
+static std::vector<uint8_t> recordScenario() {
+    std::vector<uint8_t> capture;
+    uint32_t lastTempHumReadTime = 0;
+    bool firstDhtRead = true;
+
+    nativeSerialCapture(&capture);
+    traceInit();
+    for (uint32_t t = 0; t < SCENARIO_MS; t += TICK_MS) {
+        scenarioInputs(t);
+        if (t % TASK_PERIOD_MS == 0) {
+            data->sensorMgr->readLevelSensor();
+            data->sensorMgr->readPirSensor();
+            data->sensorMgr->readLightSensor();
+            data->sensorMgr->readButtonSelector();
+            data->sensorMgr->readButtonEsc();
+            data->sensorMgr->readButtonUp();
+            data->sensorMgr->readButtonDown();
+            data->sensorMgr->readWellSensor();
+            if (firstDhtRead || millis() - lastTempHumReadTime >= DHT_READ_PERIOD_MS) {
+                firstDhtRead = false;
+                lastTempHumReadTime = millis();
+                data->sensorMgr->readDht11TempHumSens();
+            }
+            traceRecordSensors(data);
+        }
+        if (t % TASK_PERIOD_MS == PROCESS_PHASE_MS) {
+            LampActivationCtrl(data);
+            PumpActivationCtrl(data);
+            IrrigatorActivationCtrl(data);
+            pButtonsCtrl(data);
+        }
+        if (t % TASK_PERIOD_MS == ACTUATOR_PHASE_MS) {
+            data->actuatorMgr->applyState();
+            traceRecordActuators(data);
+        }
+        nativeAdvanceMillis(TICK_MS);
+    }
+    nativeSerialCapture(NULL);
+    return capture;
+}
+
+/**
+ * @brief Presents the recorded readings on the pins read by the sensor drivers.
+ */
+static void writeInputs(const TraceSnapshot* state, void* ctx) {
+    (void)ctx;
+    nativeSetMicros((int64_t)state->timeMs * 1000);
+    nativeSetAnalogInput(SENSOR_LVL_PIN, state->level);
+    nativeSetDht(state->temperature / 10.0f, state->humidity / 10.0f);
+    nativeSetDigitalInput(SENSOR_PIR_PIN, (state->inputs & TRACE_IN_PIR) ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_LDR_PIN, (state->inputs & TRACE_IN_LIGHT) ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_PB_SELECT_PIN, (state->inputs & TRACE_IN_SELECT) ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_PB_ESC_PIN, (state->inputs & TRACE_IN_ESC) ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_PB_UP_PIN, (state->inputs & TRACE_IN_UP) ? HIGH : LOW);
+    nativeSetDigitalInput(SENSOR_PB_DOWN_PIN, (state->inputs & TRACE_IN_DOWN) ? HIGH : LOW);
+    /* The recorded well state is the inverted pin, see readWellSensor() */
+    nativeSetDigitalInput(SENSOR_WELL_PIN, (state->inputs & TRACE_IN_WELL) ? LOW : HIGH);
+}
+
+static std::string testDir() {
+    std::string file = __FILE__;
+    size_t slash = file.find_last_of('/');
+    return (file[0] == '/' && slash != std::string::npos) ? file.substr(0, slash) : "test/test_trace_replay";
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& contents) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    uint8_t buf[512];
+    size_t n;
+    contents.clear();
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        contents.insert(contents.end(), buf, buf + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief The capture to replay: TRACE_FILE if set, the committed fixture otherwise.
+ */
+static std::vector<uint8_t> loadCapture() {
+    std::vector<uint8_t> capture;
+    const char* path = getenv("TRACE_FILE");
+    std::string fixture = testDir() + "/fixture.trace";
+    if (!readFile(path != NULL ? path : fixture, capture)) {
+        TEST_FAIL_MESSAGE("Cannot read the trace, record it with TRACE_RECORD=test/test_trace_replay/fixture.trace");
+    }
+    return capture;
+}
+
+/**
+ * @brief Replays a capture from the start of the virtual clock.
+ */
+static TraceReplayStats replay(const std::vector<uint8_t>& capture) {
+    TraceReplayStats stats;
+    nativeSetMicros(0);
+    traceReplay(data, capture.data(), capture.size(), writeInputs, NULL, &stats);
+    return stats;
+}
+
+static void printStats(const char* name, const TraceReplayStats& stats) {
+    printf("%s: %u records, %u CRC errors, %u decisions, %u mismatches", name, stats.records, stats.crcErrors,
+           stats.decisions, stats.mismatches);
+    if (stats.mismatches > 0) {
+        printf(", first at %u ms: recorded 0x%02X replayed 0x%02X", stats.firstMismatchMs, stats.expected,
+               stats.replayed);
+    }
+    printf("\n");
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/**
+ * @brief Runs first, on the ProcessMgr state of a fresh boot like the capture. The fixture ends in that same
+ *        state, so the replays of the tests below start from it too.
+ */
+void test_replay_matches_recorded_decisions(void) {
+    std::vector<uint8_t> capture = loadCapture();
+    TraceReplayStats stats = replay(capture);
+    printStats("replay", stats);
+
+    TEST_ASSERT_GREATER_THAN(TRACE_KEYFRAME_INTERVAL, stats.records);
+    TEST_ASSERT_GREATER_THAN(0, stats.decisions);
+    TEST_ASSERT_EQUAL(0, stats.crcErrors);
+    TEST_ASSERT_EQUAL_MESSAGE(0, stats.mismatches, "ProcessMgr no longer takes the recorded decisions");
+}
+
+/**
+ * @brief A decision changed in the capture (CRC fixed up) must be reported, or the check above proves nothing.
+ */
+void test_replay_reports_changed_decision(void) {
+    std::vector<uint8_t> capture = loadCapture();
+    bool changed = false;
+
+    for (size_t i = 0; i + 4 <= capture.size() && !changed; ++i) {
+        uint8_t len = capture[i + 2];
+        uint8_t* payload = &capture[i + 3];
+        if (capture[i] != TRACE_FRAME_SYNC0 || capture[i + 1] != TRACE_FRAME_SYNC1 || i + 4 + len > capture.size() ||
+            payload[0] != TRACE_FLAG_ACTUATORS || len != 3) {
+            continue;
+        }
+        /* Delta record carrying only the actuators: flags, time delta (1 byte), actuators */
+        payload[2] ^= TRACE_ACT_LAMP;
+        uint8_t crc = 0;
+        for (uint8_t k = 0; k < len; ++k) {
+            crc ^= payload[k];
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+            }
+        }
+        payload[len] = crc;
+        changed = true;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(changed, "No actuator record to change in the trace");
+
+    TraceReplayStats stats = replay(capture);
+    printStats("changed decision", stats);
+    TEST_ASSERT_GREATER_THAN(0, stats.mismatches);
+}
+
+/**
+ * @brief A corrupted frame is dropped and the replay resumes at the next keyframe.
+ */
+void test_replay_skips_corrupted_frames(void) {
+    std::vector<uint8_t> capture = loadCapture();
+    size_t corrupted = 0;
+
+    for (size_t i = capture.size() / 2; i + 4 <= capture.size(); ++i) {
+        if (capture[i] == TRACE_FRAME_SYNC0 && capture[i + 1] == TRACE_FRAME_SYNC1 && capture[i + 2] > 1) {
+            capture[i + 4] ^= 0x01;
+            corrupted = i;
+            break;
+        }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(corrupted != 0, "No frame to corrupt in the second half of the trace");
+
+    TraceReplayStats stats = replay(capture);
+    printStats("corrupted frame", stats);
+    TEST_ASSERT_EQUAL(1, stats.crcErrors);
+    TEST_ASSERT_GREATER_THAN(0, stats.decisions);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    nativeSerialMute(true);
+    data = nativeCreateSystem(NULL, NULL, NULL);
+
+    const char* recordPath = getenv("TRACE_RECORD");
+    if (recordPath != NULL) {
+        std::vector<uint8_t> capture = recordScenario();
+        FILE* fp = fopen(recordPath, "wb");
+        if (fp == NULL || fwrite(capture.data(), 1, capture.size(), fp) != capture.size()) {
+            printf("Cannot write %s\n", recordPath);
+            return 1;
+        }
+        fclose(fp);
+        printf("Recorded %zu bytes to %s\n", capture.size(), recordPath);
+        return 0;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_matches_recorded_decisions);
+    RUN_TEST(test_replay_reports_changed_decision);
+    RUN_TEST(test_replay_skips_corrupted_frames);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/**
+ * Load benchmark of the backend read paths with many simulated devices and
+ * dashboards. Each device sends a one-sample /sync with the settings version
+ * it has (If-None-Match) every 15 s, each dashboard polls /getLastData for
+ * sensors and actuators and /getHistoryData of one device every 5 s, like the
+ * frontend. Intervals are divided by the speedup factor and every client
+ * starts at a random offset. Prints the latency per endpoint and the cache
+ * hit ratio over the run, read from /getCacheStats.
+ *
+ * Usage: node tools/cacheBench.js [baseUrl] [devices] [dashboards] [seconds] [speedup]
+ *
+ * Defaults to http://localhost:3000/, 50 devices, 20 dashboards, 30 s and a
+ * speedup of 10.
+ */
+const http = require("http");
+
+const DEVICE_INTERVAL_MS = 15000;
+const DASHBOARD_INTERVAL_MS = 5000;
+
+const agent = new http.Agent({ keepAlive: true, maxSockets: 64 });
+const latencies = new Map();
+
+function chipIdOf(index) {
+  return `BE:NC:00:00:${String(Math.floor(index / 100)).padStart(2, "0")}:${String(index % 100).padStart(2, "0")}`;
+}
+
+/**
+ * Sends one request and resolves with { status, headers, body }, recording its latency under name
+ */
+function request(base, name, method, path, body, headers = {}) {
+  const payload = body === undefined ? undefined : JSON.stringify(body);
+  const options = {
+    agent,
+    method,
+    headers: payload ? { ...headers, "Content-Type": "application/json", "Content-Length": Buffer.byteLength(payload) } : headers,
+  };
+
+  return new Promise((resolve, reject) => {
+    const start = process.hrtime.bigint();
+    const req = http.request(new URL(path, base), options, (res) => {
+      const chunks = [];
+      res.on("data", (chunk) => chunks.push(chunk));
+      res.on("end", () => {
+        if (!latencies.has(name)) latencies.set(name, { values: [], errors: 0 });
+        const entry = latencies.get(name);
+        entry.values.push(Number(process.hrtime.bigint() - start) / 1e6);
+        if (res.statusCode >= 500) entry.errors++;
+        resolve({ status: res.statusCode, headers: res.headers, body: Buffer.concat(chunks).toString() });
+      });
+    });
+    req.on("error", reject);
+    req.end(payload);
+  });
+}
+
+/**
+ * Runs fn every intervalMs until deadline, starting at a random offset
+ */
+async function every(intervalMs, deadline, fn) {
+  await new Promise((resolve) => setTimeout(resolve, Math.random() * intervalMs));
+  while (Date.now() < deadline) {
+    const start = Date.now();
+    await fn().catch((error) => console.error(`Request failed: ${error.message}`));
+    await new Promise((resolve) => setTimeout(resolve, Math.max(0, intervalMs - (Date.now() - start))));
+  }
+}
+
+function device(base, index, intervalMs, deadline) {
+  const chipId = chipIdOf(index);
+  let etag;
+  return every(intervalMs, deadline, async () => {
+    const sample = {
+      t: Math.round(process.uptime() * 1e6),
+      sensorData: { lvl: 50, tmp: 24.5, hum: 40, ldr: "0", pir: "0", well: "0" },
+      actuatorData: { lmp: "0", pmp: "0", irr: "0" },
+    };
+    const now = Math.round(process.uptime() * 1e6);
+    const res = await request(base, "/sync", "POST", "sync", { [chipId]: { now, wall: Date.now(), ppm: 0, samples: [sample] } },
+      etag ? { "If-None-Match": etag } : {});
+    etag = res.headers.etag || etag;
+    if (res.status === 200 && JSON.parse(res.body).noSettings) {
+      const settings = { maxLevel: 90, minLevel: 20, hotTemperature: 30, lowHumidity: 40 };
+      const stored = await request(base, "/updateSettings", "POST", "updateSettings", { [chipId]: { settings } });
+      etag = stored.headers.etag || etag;
+    }
+  });
+}
+
+function dashboard(base, devices, intervalMs, deadline) {
+  return every(intervalMs, deadline, async () => {
+    const chipId = encodeURIComponent(chipIdOf(Math.floor(Math.random() * devices)));
+    await Promise.all([
+      request(base, "/getLastData", "GET", `getLastData?chipId=${chipId}&type=sensors`),
+      request(base, "/getLastData", "GET", `getLastData?chipId=${chipId}&type=actuators`),
+      request(base, "/getHistoryData", "GET", `getHistoryData?chipId=${chipId}&type=sensors`),
+    ]);
+  });
+}
+
+async function cacheStats(base) {
+  const res = await request(base, "/getCacheStats", "GET", "getCacheStats");
+  return JSON.parse(res.body);
+}
+
+async function main() {
+  const base = process.argv[2] || "http://localhost:3000/";
+  const devices = parseInt(process.argv[3] || "50", 10);
+  const dashboards = parseInt(process.argv[4] || "20", 10);
+  const seconds = parseFloat(process.argv[5] || "30");
+  const speedup = parseFloat(process.argv[6] || "10");
+
+  const before = await cacheStats(base);
+  const deadline = Date.now() + seconds * 1000;
+  const clients = [];
+  for (let i = 0; i < devices; i++) clients.push(device(base, i, DEVICE_INTERVAL_MS / speedup, deadline));
+  for (let i = 0; i < dashboards; i++) clients.push(dashboard(base, devices, DASHBOARD_INTERVAL_MS / speedup, deadline));
+  await Promise.all(clients);
+  const after = await cacheStats(base);
+  agent.destroy();
+
+  console.log(`${devices} devices, ${dashboards} dashboards, ${seconds} s at ${speedup}x`);
+  for (const [name, { values, errors }] of latencies) {
+    if (name === "/getCacheStats") continue;
+    values.sort((a, b) => a - b);
+    const pick = (q) => values[Math.min(values.length - 1, Math.floor(q * values.length))].toFixed(2);
+    console.log(
+      `${name.padEnd(16)} ${String(values.length).padStart(6)} req  ${(values.length / seconds).toFixed(1).padStart(7)} req/s  ` +
+        `p50 ${pick(0.5)} ms  p95 ${pick(0.95)} ms  max ${pick(1)} ms  errors ${errors}`
+    );
+  }
+  for (const cache of ["settings", "history"]) {
+    const hits = after[cache].hits - before[cache].hits;
+    const misses = after[cache].misses - before[cache].misses;
+    const ratio = hits + misses > 0 ? ((100 * hits) / (hits + misses)).toFixed(1) : "-";
+    console.log(`${cache} cache: ${hits} hits, ${misses} misses, ${ratio} % hit ratio, ${after[cache].devices} devices cached`);
+  }
+}
+
+main().catch((error) => {
+  console.error(`Benchmark failed: ${error.message}`);
+  process.exit(1);
+});
@@ -0,0 +1,150 @@
+/**
+ * Size and encode/decode time of a telemetry batch as JSON, as CBOR with the
+ * shortest integer encodings and as the fixed-width CBOR the firmware sends.
+ * The encoders below reproduce the layouts of schemaWriteBatchJson() and
+ * schemaWriteBatchCbor() in src/DAL/SchemaCodec.cpp; decoding goes through
+ * the backend decoder (backend/cbor.js) and JSON.parse. Times are measured on
+ * this machine, they compare the formats, not the ESP32.
+ *
+ * Usage: node tools/cborBench.js [iterations]
+ *
+ * Defaults to 20000 iterations per batch size and format.
+ */
+const cbor = require("../backend/cbor");
+
+const CHIP_ID = [0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff];
+const BATCH_SIZES = [1, 15, 146];
+
+/**
+ * Returns count samples like the device records them: a change or a heartbeat a minute apart, an hour after boot
+ */
+function makeSamples(count) {
+  const samples = [];
+  for (let i = 0; i < count; i++) {
+    samples.push({
+      t: 3600e6 + i * 60e6,
+      lvl: 40 + (i % 20),
+      tmp: 24.5 + (i % 7) * 0.5,
+      hum: 40 + (i % 11) * 2,
+      flags: [i % 2, 0, 1, i % 3 === 0 ? 1 : 0, 0, 0],
+    });
+  }
+  return samples;
+}
+
+/**
+ * Layout of schemaWriteBatchJson()
+ */
+function encodeJson(samples, clock) {
+  const chipId = CHIP_ID.map((b) => b.toString(16).toUpperCase().padStart(2, "0")).join(":");
+  const flag = (value) => (value ? "1" : "0");
+  return Buffer.from(JSON.stringify({
+    [chipId]: {
+      now: clock.now, wall: clock.wall, ppm: clock.ppm,
+      samples: samples.map((s) => ({
+        t: s.t,
+        sensorData: { lvl: s.lvl, tmp: s.tmp, hum: s.hum, ldr: flag(s.flags[0]), pir: flag(s.flags[1]), well: flag(s.flags[2]) },
+        actuatorData: { lmp: flag(s.flags[3]), pmp: flag(s.flags[4]), irr: flag(s.flags[5]) },
+      })),
+    },
+  }));
+}
+
+/**
+ * Minimal CBOR writer with the shortest or the fixed-width integer encodings, like src/DAL/CborEncoder.cpp
+ */
+class Writer {
+  constructor(fixed, capacity) {
+    this.fixed = fixed;
+    this.buf = Buffer.allocUnsafe(capacity);
+    this.len = 0;
+  }
+
+  head(major, value) {
+    if (value < 24) { this.buf[this.len++] = major | value; }
+    else if (value <= 0xff) { this.buf[this.len++] = major | 24; this.buf[this.len++] = value; }
+    else if (value <= 0xffff) { this.buf[this.len++] = major | 25; this.buf.writeUInt16BE(value, this.len); this.len += 2; }
+    else if (value <= 0xffffffff) { this.buf[this.len++] = major | 26; this.buf.writeUInt32BE(value, this.len); this.len += 4; }
+    else { this.head64(major, value); }
+  }
+
+  head64(major, value) {
+    this.buf[this.len++] = major | 27;
+    this.buf.writeBigUInt64BE(BigInt(value), this.len);
+    this.len += 8;
+  }
+
+  uint(value) {
+    if (this.fixed) { this.buf[this.len++] = 26; this.buf.writeUInt32BE(value, this.len); this.len += 4; }
+    else this.head(0x00, value);
+  }
+
+  uint64(value) {
+    if (this.fixed) this.head64(0x00, value);
+    else this.head(0x00, value);
+  }
+
+  flag(value) { this.buf[this.len++] = value ? 1 : 0; }
+  float(value) { this.buf[this.len++] = 0xfa; this.buf.writeFloatBE(value, this.len); this.len += 4; }
+  text(text) { this.head(0x60, Buffer.byteLength(text)); this.len += this.buf.write(text, this.len); }
+  bytes(bytes) { this.head(0x40, bytes.length); for (const b of bytes) this.buf[this.len++] = b; }
+
+  result() { return this.buf.subarray(0, this.len); }
+}
+
+/**
+ * Layout of schemaWriteBatchCbor()
+ */
+function encodeCbor(samples, clock, fixed) {
+  const w = new Writer(fixed, 128 + 32 * samples.length); /** SCHEMA_BATCH_HEADER_SIZE, SCHEMA_SAMPLE_CBOR_SIZE rounded up */
+  w.head(0xa0, 5);
+  w.text("id"); w.bytes(CHIP_ID);
+  w.text("now"); w.uint64(clock.now);
+  w.text("wall"); w.uint64(clock.wall);
+  w.text("ppm"); w.float(clock.ppm);
+  w.text("samples"); w.head(0x80, samples.length);
+  for (const s of samples) {
+    w.head(0x80, 10);
+    w.uint64(s.t);
+    w.uint(s.lvl);
+    w.float(s.tmp);
+    w.float(s.hum);
+    for (const f of s.flags) w.flag(f);
+  }
+  return w.result();
+}
+
+/**
+ * Runs fn iterations times and returns the mean time per call in us
+ */
+function time(iterations, fn) {
+  for (let i = 0; i < Math.min(iterations, 1000); i++) fn(); /** Warm up */
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < iterations; i++) fn();
+  return Number(process.hrtime.bigint() - start) / 1e3 / iterations;
+}
+
+function main() {
+  const iterations = Number(process.argv[2]) || 20000;
+  const clock = { now: 3600e6 + 200 * 60e6, wall: Date.now(), ppm: 12.5 };
+
+  console.log("samples  format        bytes  bytes/sample  encode us  decode us");
+  for (const count of BATCH_SIZES) {
+    const samples = makeSamples(count);
+    const formats = [
+      ["JSON", () => encodeJson(samples, clock), (buf) => JSON.parse(buf.toString())],
+      ["CBOR shortest", () => encodeCbor(samples, clock, false), (buf) => cbor.decode(buf)],
+      ["CBOR fixed", () => encodeCbor(samples, clock, true), (buf) => cbor.decode(buf)],
+    ];
+    for (const [name, encode, decode] of formats) {
+      const payload = encode();
+      const encodeUs = time(iterations, encode);
+      const decodeUs = time(iterations, () => decode(payload));
+      console.log(
+        `${String(count).padStart(7)}  ${name.padEnd(13)} ${String(payload.length).padStart(6)}  ` +
+        `${(payload.length / count).toFixed(1).padStart(12)}  ${encodeUs.toFixed(2).padStart(9)}  ${decodeUs.toFixed(2).padStart(9)}`);
+    }
+  }
+}
+
+main();
@@ -0,0 +1,149 @@
+/**
+ * Load test of the SensActHistory retention against an in-memory stand-in of the
+ * storage engine, which counts round trips and nodes transferred.
+ * Compares the former retention (write, then read the whole history and remove
+ * the excess) with backend/historyStore.js (write and trim in one update) for
+ * several retention sizes, after a cold start with an oversized history.
+ *
+ * Usage: node tools/historyLoadTest.js [inserts] [rttMs]
+ *
+ * Defaults to 1000 single-sample inserts per run and 30 ms per round trip;
+ * the modeled time per insert adds 0.02 ms per node transferred. historyStore
+ * runs with the 48 hour age limit of the server as well, samples are 20 s
+ * apart so the count limit applies first; the cpu column shows the cost of both
+ * limits, which must not grow with the retention size.
+ */
+const historyStore = require("../backend/historyStore");
+
+const NODE_MS = 0.02;
+const MAX_AGE_MS = 48 * 3600 * 1000;  /** HISTORY_RETENTION_MS of the server */
+const SAMPLE_INTERVAL_MS = 20 * 1000;  /** 6000 samples span 33 hours */
+
+/**
+ * Minimal storage engine with the interface of backend/storage.js for the history,
+ * keys sort in creation order
+ */
+class FakeStorage {
+  constructor() {
+    this.histories = new Map();
+    this.nextKey = 0;
+    this.stats = { roundTrips: 0, nodesRead: 0, nodesWritten: 0 };
+  }
+
+  history(chipId) {
+    if (!this.histories.has(chipId)) this.histories.set(chipId, new Map());
+    return this.histories.get(chipId);
+  }
+
+  async loadHistory(chipId) {
+    const history = this.history(chipId);
+    this.stats.roundTrips++;
+    this.stats.nodesRead += history.size;
+    return [...history].sort(([a], [b]) => (a < b ? -1 : a > b ? 1 : 0));
+  }
+
+  newHistoryKey() {
+    return `k${String(this.nextKey++).padStart(12, "0")}`;
+  }
+
+  async writeHistory(chipId, added, removedKeys) {
+    const history = this.history(chipId);
+    this.stats.roundTrips++;
+    this.stats.nodesWritten += added.length + removedKeys.length;
+    for (const [key, entry] of added) history.set(key, entry);
+    for (const key of removedKeys) history.delete(key);
+  }
+}
+
+/**
+ * The retention used before historyStore: one write, then a read of the whole history and one removal update
+ */
+const legacyStore = {
+  async append(storage, chipId, entries, maxEntries) {
+    await storage.writeHistory(chipId, entries.map((entry) => [storage.newHistoryKey(chipId), entry]), []);
+
+    const history = await storage.loadHistory(chipId);
+    if (history.length > maxEntries) {
+      await storage.writeHistory(chipId, [], history.slice(0, history.length - maxEntries).map(([key]) => key));
+    }
+    return entries.length;
+  },
+};
+
+/**
+ * Function to build a history entry taken at the given time
+ */
+function entryAt(time) {
+  return {
+    sensorData: { lvl: 50, tmp: 24.5, hum: 40, ldr: "0", pir: "0", well: "0" },
+    actuatorData: { lmp: "0", pmp: "0", irr: "0" },
+    timestamp: new Date(time).toISOString(),
+  };
+}
+
+async function run(name, store, maxEntries, inserts, rttMs, chipId) {
+  const storage = new FakeStorage();
+  /** Left over by an older server, the latest sample is taken now and the inserted ones follow in the future */
+  const start = Date.now() - 2 * maxEntries * SAMPLE_INTERVAL_MS;
+  const preload = [];
+  for (let i = 0; i < 2 * maxEntries; i++) preload.push([storage.newHistoryKey(chipId), entryAt(start + i * SAMPLE_INTERVAL_MS)]);
+  await storage.writeHistory(chipId, preload, []);
+
+  const windows = [];
+  const windowSize = Math.max(1, Math.floor(inserts / 4));
+  let lastEnd = 0;
+  let last = { roundTrips: 0, nodesRead: 0, nodesWritten: 0, cpu: 0 };
+  storage.stats = { roundTrips: 0, nodesRead: 0, nodesWritten: 0 };
+  let cpuMs = 0;
+
+  for (let i = 1; i <= inserts; i++) {
+    const entry = entryAt(Date.now() + i * SAMPLE_INTERVAL_MS);
+    const cpuStart = process.hrtime.bigint();
+    await store.append(storage, chipId, [entry], maxEntries, MAX_AGE_MS);
+    cpuMs += Number(process.hrtime.bigint() - cpuStart) / 1e6;
+
+    if (i === 1 || i % windowSize === 0) {
+      const count = i - lastEnd;
+      const s = storage.stats;
+      const perInsert = (value, prev) => (value - prev) / count;
+      const trips = perInsert(s.roundTrips, last.roundTrips);
+      const nodes = perInsert(s.nodesRead + s.nodesWritten, last.nodesRead + last.nodesWritten);
+      windows.push({
+        label: i === 1 ? "first" : `${lastEnd + 1}-${i}`,
+        trips,
+        read: perInsert(s.nodesRead, last.nodesRead),
+        modeledMs: trips * rttMs + nodes * NODE_MS,
+        cpuMs: perInsert(cpuMs, last.cpu),
+      });
+      last = { ...s, cpu: cpuMs };
+      lastEnd = i;
+    }
+  }
+
+  const kept = storage.history(chipId).size;
+  if (kept !== maxEntries) {
+    throw new Error(`${name} kept ${kept} entries instead of ${maxEntries}`);
+  }
+  for (const w of windows) {
+    console.log(
+      `${String(maxEntries).padStart(9)}  ${name.padEnd(12)} ${w.label.padEnd(10)} ${w.trips.toFixed(2).padStart(6)} ` +
+        `${w.read.toFixed(1).padStart(10)} ${w.modeledMs.toFixed(2).padStart(12)} ${w.cpuMs.toFixed(3).padStart(9)}`
+    );
+  }
+}
+
+async function main() {
+  const inserts = parseInt(process.argv[2] || "1000", 10);
+  const rttMs = parseFloat(process.argv[3] || "30");
+
+  console.log("retention  store        inserts     trips nodes read  modeled ms    cpu ms   (per insert)");
+  for (const maxEntries of [60, 600, 6000]) {
+    await run("legacy", legacyStore, maxEntries, inserts, rttMs, `legacy-${maxEntries}`);
+    await run("historyStore", historyStore, maxEntries, inserts, rttMs, `store-${maxEntries}`);
+  }
+}
+
+main().catch((error) => {
+  console.error(`Load test failed: ${error.message}`);
+  process.exit(1);
+});
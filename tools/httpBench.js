@@ -0,0 +1,75 @@
+/**
+ * Measures requests/s and latency per request against the backend, with a
+ * new TCP connection per request (the former device behaviour) and with a
+ * single kept-alive connection (ServerClient).
+ *
+ * Usage: node tools/httpBench.js [baseUrl] [requests]
+ *
+ * Defaults to http://localhost:3000/ and 200 requests per mode. The GET
+ * /getSettings and POST /updateSensActHistory requests alternate like on
+ * the device.
+ */
+const http = require("http");
+
+const CHIP_ID = "AA:BB:CC:DD:EE:FF";
+
+/**
+ * Sends one request and resolves with its latency in ms
+ */
+function request(base, agent, index) {
+  const isPost = index % 2 === 1;
+  const body = JSON.stringify({
+    [CHIP_ID]: {
+      sensorData: { lvl: 50, tmp: 24.5, hum: 40, ldr: "0", pir: "0", well: "0" },
+      actuatorData: { lmp: "0", pmp: "0", irr: "0" },
+    },
+  });
+  const url = new URL(isPost ? "updateSensActHistory" : `getSettings?chipId=${CHIP_ID}`, base);
+  const options = {
+    agent,
+    method: isPost ? "POST" : "GET",
+    headers: isPost ? { "Content-Type": "application/json", "Content-Length": Buffer.byteLength(body) } : {},
+  };
+
+  return new Promise((resolve, reject) => {
+    const start = process.hrtime.bigint();
+    const req = http.request(url, options, (res) => {
+      res.resume();
+      res.on("end", () => resolve(Number(process.hrtime.bigint() - start) / 1e6));
+    });
+    req.on("error", reject);
+    req.end(isPost ? body : undefined);
+  });
+}
+
+async function run(base, count, keepAlive) {
+  const agent = new http.Agent({ keepAlive, maxSockets: 1 });
+  const latencies = [];
+  const start = Date.now();
+
+  for (let i = 0; i < count; i++) {
+    latencies.push(await request(base, agent, i));
+  }
+
+  const elapsed = (Date.now() - start) / 1000;
+  agent.destroy();
+  latencies.sort((a, b) => a - b);
+  const pick = (q) => latencies[Math.min(latencies.length - 1, Math.floor(q * latencies.length))].toFixed(2);
+  console.log(
+    `${keepAlive ? "keep-alive    " : "new connection"}  ${(count / elapsed).toFixed(1)} req/s  ` +
+      `p50 ${pick(0.5)} ms  p95 ${pick(0.95)} ms  max ${pick(1)} ms`
+  );
+}
+
+async function main() {
+  const base = process.argv[2] || "http://localhost:3000/";
+  const count = parseInt(process.argv[3] || "200", 10);
+
+  await run(base, count, false);
+  await run(base, count, true);
+}
+
+main().catch((error) => {
+  console.error(`Benchmark failed: ${error.message}`);
+  process.exit(1);
+});
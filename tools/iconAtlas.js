@@ -0,0 +1,338 @@
+/**
+ * Generates include/IconAtlas.h, the display icons converted to the SSD1306
+ * page order (one byte per column of 8 vertical pixels, LSB on top), so the
+ * firmware can blit them byte by byte instead of plotting single pixels.
+ *
+ * Usage: node tools/iconAtlas.js [output.h]
+ *
+ * Icons are edited here as pixel art, '#' is a lit pixel. Re-run the script
+ * after changing them and commit the regenerated header.
+ */
+const fs = require("fs");
+const path = require("path");
+
+const ICONS = {
+  Sun_Icon: [
+    ".......#.......",
+    "..#....#....#..",
+    "...#.......#...",
+    "......###......",
+    "#...##...##...#",
+    ".#..#.....#..#.",
+    "...#.......#...",
+    "...#.......#...",
+    "...#.......#...",
+    ".#..#.....#..#.",
+    "#...##...##...#",
+    "......###......",
+    "...#.......#...",
+    "..#....#....#..",
+    ".......#.......",
+    "...............",
+  ],
+  Moon_Icon: [
+    ".....#.........",
+    "...###......###",
+    "..###.........#",
+    ".####........#.",
+    ".###...####.###",
+    "####.....#.....",
+    "####....#......",
+    "####...####....",
+    "#####..........",
+    "#####........##",
+    ".######....###.",
+    ".#############.",
+    "..###########..",
+    "...#########...",
+    ".....#####.....",
+    "...............",
+  ],
+  Presence_Icon: [
+    ".....###.......",
+    "....#...#......",
+    "...#.....#.....",
+    "...#.....#.....",
+    "...#.....#.....",
+    "....#...#......",
+    ".....###.......",
+    "...............",
+    "....#####......",
+    "..##.....##....",
+    ".#.........#...",
+    ".#.........#...",
+    "#...........#..",
+    "#...........#..",
+    "#...........#..",
+    "#############..",
+  ],
+  Lamp_On_Icon: [
+    "......#......",
+    ".....###.....",
+    ".....#.#.....",
+    "....#...#....",
+    "....#...#....",
+    "....#...#....",
+    "..##.....##..",
+    ".#.........#.",
+    "#...........#",
+    ".###########.",
+    "....#...#....",
+    "##...###...##",
+    ".............",
+    "...#.....#...",
+    "..#...#...#..",
+    "......#......",
+  ],
+  Lamp_Off_Icon: [
+    "......#......",
+    ".....###.....",
+    ".....#.#.....",
+    "....#...#....",
+    "....#...#....",
+    "....#...#....",
+    "..##.....##..",
+    ".#.........#.",
+    "#...........#",
+    ".###########.",
+    "....#...#....",
+    ".....###.....",
+    ".............",
+    ".............",
+    ".............",
+    ".............",
+  ],
+  Lvl_Icon: [
+    "......................",
+    "......................",
+    "..........#...........",
+    ".........###..........",
+    "..##......#..#......##",
+    "..##.........#......##",
+    "..##.......#........##",
+    "..##..#####.........##",
+    "..##.########.....#.##",
+    "..##.##############.##",
+    "..##.##############.##",
+    "..##.#######..#####.##",
+    "..##.##############.##",
+    "..##.##############.##",
+    "..##..############..##",
+    "...##..............##.",
+    "...##################.",
+    ".....##############...",
+    "......................",
+  ],
+  Water_well_icon: [
+    "...##################...",
+    "..#..................#..",
+    "..#..................#..",
+    ".#....................#.",
+    ".#....................#.",
+    "##....................##",
+    ".######################.",
+    "....#.......#......#....",
+    "....#.......#......#....",
+    "....#.......#......#....",
+    "....#..##########..#....",
+    "....#...#......#...#....",
+    "....#...#......#...#....",
+    "....#...#......#...#....",
+    "....#...#......#...#....",
+    "....#....#....#....#....",
+    "....#....#....#....#....",
+    "....#....######....#....",
+    "....#..............#....",
+    ".#####################..",
+    ".#.....#....#...#....#..",
+    ".#.....#....#...#....#..",
+    ".#.....#....#...#....#..",
+    ".#.....#....#...#....#..",
+  ],
+  Pump_Icon: [
+    "..........................",
+    "..........................",
+    "..........................",
+    "..........................",
+    ".....................##...",
+    "...........############...",
+    ".........#......#....##...",
+    "........#........#...##...",
+    ".......#..........#..##...",
+    "......#............####...",
+    "......#....#..#....#.##...",
+    "......#...#...#....#......",
+    "......#...#........#......",
+    "...##.#....#..#....#......",
+    "...####.....#.............",
+    "...##..#..........#.......",
+    "...##...#........#........",
+    "...##...##......#.........",
+    "...############...........",
+    "...##.....................",
+    "..........................",
+    "..........................",
+    "..........................",
+  ],
+  Temperature_Icon: [
+    "...###..........",
+    "..#...#.......#.",
+    "..#.#.##.....#.#",
+    "..#.#.#.......#.",
+    "..#.#.##..###...",
+    "..#.#.#..##.....",
+    "..#.#.##.#......",
+    "..#.#.#..#......",
+    "..#.#.#..##.....",
+    ".#..#..#..###...",
+    "#..###..#.......",
+    "#.#.###.#.......",
+    "#.#####.#.......",
+    "#..###..#.......",
+    ".#.....#........",
+    "..#####.........",
+  ],
+  Humidity_Icon: [
+    ".....#..........",
+    ".....#..........",
+    "....##..........",
+    "....###.........",
+    "...####.........",
+    "...#####........",
+    "..#######.......",
+    "..#######.......",
+    ".######.##......",
+    ".#######.#......",
+    "########.##.....",
+    "###########.....",
+    ".#########......",
+    ".#########......",
+    "..#######.......",
+    "....####........",
+  ],
+  Irrigator_Off_Icon: [
+    "......................",
+    "......................",
+    ".....###..............",
+    "....#...#.#...........",
+    "...#...#...#..........",
+    "...#..#.....#.........",
+    "...#.#.......#........",
+    "....#.........#.......",
+    "..#............#......",
+    ".#............#.....#.",
+    "..#..........#....#.#.",
+    "...#........#.......#.",
+    "....#...............#.",
+    ".....#.....########.#.",
+    "......#...#........##.",
+    ".......#.#............",
+    "........#.............",
+    "......................",
+  ],
+  Irrigator_On_Icon: [
+    "...............................",
+    "...............................",
+    ".....###.......................",
+    "....#...#.#....................",
+    "...#...#...#...................",
+    "...#..#.....#..................",
+    "...#.#.......#.................",
+    "....#.........#................",
+    "..#............#...............",
+    ".#............#.....#..........",
+    "..#..........#....#.#..........",
+    "...#........#.......#....##....",
+    "....#...............#..........",
+    ".....#.....########.#...#..#...",
+    "......#...#........##....#.#...",
+    ".......#.#.............#.#.#...",
+    "........#..............#.#.#...",
+    ".......................#.#.#...",
+    ".......................#.#.#...",
+    "...............................",
+    "...............................",
+  ],
+  WiFi_Connected_Icon: [
+    ".......#####.......",
+    ".....#########.....",
+    "...####.....####...",
+    "..###..#####..###..",
+    ".###.#########.###.",
+    "###.####...####.###",
+    ".#.###..###..###.#.",
+    "..###.#######.###..",
+    "...#.###...###.#...",
+    "....###.###.###....",
+    ".....#.#####.#.....",
+    "......###.###......",
+    ".......#.#.#.......",
+    "........###........",
+    ".........#.........",
+    "...................",
+  ],
+  WiFi_Not_Connected_Icon: [
+    "..#....#####.......",
+    "...#.##.....##.....",
+    "....#.........##...",
+    "..#..#.#####....#..",
+    ".#....#.....##...#.",
+    "#...#..#......#...#",
+    "...#....#.#....#...",
+    "..#...##.#.##...#..",
+    ".....#....#..#.....",
+    "....#....#.#..#....",
+    ".......##.#.#......",
+    "......#......#.....",
+    ".........#....#....",
+    "........#.#....#...",
+    ".........#......#..",
+    "...................",
+  ],
+};
+
+/**
+ * Converts pixel art rows to page-ordered bytes: pages of `width` columns
+ */
+function toPages(name, rows) {
+  const width = rows[0].length;
+  const height = rows.length;
+  const pages = Math.ceil(height / 8);
+  const bytes = new Array(pages * width).fill(0);
+
+  rows.forEach((row, y) => {
+    if (row.length !== width) {
+      throw new Error(`${name}: row ${y} is ${row.length} pixels wide, expected ${width}`);
+    }
+    [...row].forEach((pixel, x) => {
+      if (pixel === "#") bytes[(y >> 3) * width + x] |= 1 << (y & 7);
+    });
+  });
+  return { width, height, bytes };
+}
+
+function main() {
+  const output = process.argv[2] || path.join(__dirname, "..", "include", "IconAtlas.h");
+  const lines = [
+    "/* Generated by tools/iconAtlas.js, do not edit. */",
+    "#ifndef ICON_ATLAS_H",
+    "#define ICON_ATLAS_H",
+    "",
+    '#include "OledDisplay_classes.h"',
+    "",
+  ];
+
+  for (const [name, rows] of Object.entries(ICONS)) {
+    const { width, height, bytes } = toPages(name, rows);
+    const hex = bytes.map((b) => "0x" + b.toString(16).padStart(2, "0")).join(",");
+    lines.push(`static const uint8_t PROGMEM ${name}_Pages[] = {${hex}};`);
+    lines.push(`static const IconBitmap ${name} = {${width}, ${height}, ${name}_Pages};`);
+    lines.push("");
+  }
+
+  lines.push("#endif // ICON_ATLAS_H", "");
+  fs.writeFileSync(output, lines.join("\n"));
+  console.log(`Wrote ${Object.keys(ICONS).length} icons to ${output}`);
+}
+
+main();
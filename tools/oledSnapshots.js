@@ -0,0 +1,113 @@
+/**
+ * Extracts the OLED frames dumped by the ESP32 when DISPLAY_SNAPSHOT_ENABLED is
+ * set (see include/DisplayMgr.h) and optionally compares them with golden images.
+ *
+ * Usage: node tools/oledSnapshots.js <capture.bin> <outDir> [goldenDir]
+ *
+ * Every frame is written as <outDir>/<name>_NNNN.pbm together with its render
+ * time, where <name> is the frame name from the dump (see displayFrameName()) and
+ * NNNN counts the frames of that name. Matching frames by name keeps a screen
+ * compared with its own golden image when an earlier screen renders more or fewer
+ * frames. When a golden directory is given, each frame is compared with the file
+ * of the same name and the number of differing pixels is reported; the process
+ * exits with code 1 on any mismatch or missing golden image.
+ */
+const fs = require("fs");
+const path = require("path");
+
+const WIDTH = 128;
+const HEIGHT = 64;
+const FRAME_BYTES = (WIDTH / 8) * HEIGHT;
+const HEADER_RE = /^P4\n# screen=(\d+) name=([a-z0-9_]+) render_us=(\d+)\n(\d+) (\d+)\n/;
+const HEADER_MAX = 96;
+
+/**
+ * Counts the differing pixels between two PBM images of the same geometry
+ */
+function diffPixels(a, b) {
+  let diff = 0;
+  for (let i = 0; i < FRAME_BYTES; i++) {
+    let x = a[a.length - FRAME_BYTES + i] ^ b[b.length - FRAME_BYTES + i];
+    while (x) {
+      diff += x & 1;
+      x >>= 1;
+    }
+  }
+  return diff;
+}
+
+/**
+ * Locates the frames in a capture that may also contain the regular ASCII logs
+ */
+function extractFrames(data) {
+  const frames = [];
+  let pos = data.indexOf("P4\n# screen=");
+
+  while (pos >= 0) {
+    const match = HEADER_RE.exec(data.subarray(pos, pos + HEADER_MAX).toString("latin1"));
+    const headerLen = match ? match[0].length : 0;
+
+    if (match && +match[4] === WIDTH && +match[5] === HEIGHT && pos + headerLen + FRAME_BYTES <= data.length) {
+      frames.push({
+        screen: +match[1],
+        name: match[2],
+        renderUs: +match[3],
+        image: data.subarray(pos, pos + headerLen + FRAME_BYTES),
+      });
+      pos += headerLen + FRAME_BYTES;
+    } else {
+      pos += 1; /** Truncated or corrupted header, resume the search */
+    }
+    pos = data.indexOf("P4\n# screen=", pos);
+  }
+  return frames;
+}
+
+function main() {
+  const [input, outDir, goldenDir] = process.argv.slice(2);
+  if (!input || !outDir) {
+    console.error("Usage: node tools/oledSnapshots.js <capture.bin> <outDir> [goldenDir]");
+    process.exit(1);
+  }
+
+  const frames = extractFrames(fs.readFileSync(input));
+  fs.mkdirSync(outDir, { recursive: true });
+  const counts = new Map();
+  let failures = 0;
+
+  frames.forEach((frame) => {
+    const count = counts.get(frame.name) || 0;
+    counts.set(frame.name, count + 1);
+    const name = `${frame.name}_${String(count).padStart(4, "0")}.pbm`;
+    fs.writeFileSync(path.join(outDir, name), frame.image);
+
+    let result = "";
+    if (goldenDir) {
+      const goldenPath = path.join(goldenDir, name);
+      if (!fs.existsSync(goldenPath)) {
+        result = "  MISSING golden";
+        failures++;
+      } else {
+        const diff = diffPixels(frame.image, fs.readFileSync(goldenPath));
+        result = diff === 0 ? "  ok" : `  MISMATCH ${diff} px`;
+        failures += diff === 0 ? 0 : 1;
+      }
+    }
+    console.log(`${name}  screen ${frame.screen}  render ${frame.renderUs} us${result}`);
+  });
+
+  if (frames.length > 0) {
+    const times = frames.map((f) => f.renderUs);
+    const avg = times.reduce((a, b) => a + b, 0) / times.length;
+    console.log(`${frames.length} frames, render time avg ${avg.toFixed(0)} us, max ${Math.max(...times)} us`);
+  } else {
+    console.log("No frames found");
+  }
+
+  if (goldenDir && failures > 0) {
+    console.error(`${failures} frame(s) differ from ${goldenDir}`);
+    process.exit(1);
+  }
+}
+
+main();
@@ -0,0 +1,149 @@
+/**
+ * Decodes a binary sensor/actuator trace captured from the ESP32 serial port
+ * (see include/TraceMgr.h) into one CSV row per record with the full
+ * reconstructed state.
+ *
+ * Usage: node tools/traceDecode.js <capture.bin> [output.csv]
+ *
+ * The capture may contain the regular ASCII logs, frames are located by their
+ * sync bytes and validated with CRC-8.
+ */
+const fs = require("fs");
+
+const SYNC0 = 0xa5;
+const SYNC1 = 0x5a;
+
+const FLAG_LEVEL = 0x01;
+const FLAG_TEMP = 0x02;
+const FLAG_HUM = 0x04;
+const FLAG_INPUTS = 0x08;
+const FLAG_ACTUATORS = 0x10;
+const FLAG_SETTINGS = 0x20;
+const FLAG_KEYFRAME = 0x80;
+
+const INPUT_BITS = ["pir", "light", "select", "esc", "up", "down", "well"];
+const ACTUATOR_BITS = ["lamp", "pump", "irr"];
+const SETTINGS = ["maxLevel", "minLevel", "hotTemperature", "lowHumidity"];
+
+/**
+ * CRC-8 (poly 0x07), identical to traceCrc8() on the device
+ */
+function crc8(buf) {
+  let crc = 0;
+  for (const byte of buf) {
+    crc ^= byte;
+    for (let bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? ((crc << 1) ^ 0x07) & 0xff : (crc << 1) & 0xff;
+    }
+  }
+  return crc;
+}
+
+/**
+ * Minimal cursor over a record payload
+ */
+class Reader {
+  constructor(buf) {
+    this.buf = buf;
+    this.pos = 0;
+  }
+
+  byte() {
+    return this.buf[this.pos++];
+  }
+
+  varint() {
+    let value = 0;
+    let shift = 0;
+    let byte;
+    do {
+      byte = this.byte();
+      value += (byte & 0x7f) * 2 ** shift;
+      shift += 7;
+    } while (byte & 0x80);
+    return value;
+  }
+
+  zigzag() {
+    const value = this.varint();
+    return value % 2 ? -(value + 1) / 2 : value / 2;
+  }
+}
+
+/**
+ * Applies one record to the running state, returns false if the record cannot be applied
+ */
+function applyRecord(state, payload) {
+  const r = new Reader(payload);
+  const flags = r.byte();
+  const keyframe = (flags & FLAG_KEYFRAME) !== 0;
+
+  if (!keyframe && !state.synced) {
+    return false; /** Deltas are meaningless until the first keyframe */
+  }
+
+  state.timeMs = keyframe ? r.varint() : state.timeMs + r.varint();
+  if (flags & FLAG_LEVEL) state.level = keyframe ? r.varint() : state.level + r.zigzag();
+  if (flags & FLAG_TEMP) state.temp = keyframe ? r.zigzag() : state.temp + r.zigzag();
+  if (flags & FLAG_HUM) state.hum = keyframe ? r.zigzag() : state.hum + r.zigzag();
+  if (flags & FLAG_INPUTS) {
+    const inputs = r.byte();
+    INPUT_BITS.forEach((name, bit) => (state[name] = (inputs >> bit) & 1));
+  }
+  if (flags & FLAG_ACTUATORS) {
+    const actuators = r.byte();
+    ACTUATOR_BITS.forEach((name, bit) => (state[name] = (actuators >> bit) & 1));
+  }
+  if (flags & FLAG_SETTINGS) {
+    SETTINGS.forEach((name) => (state[name] = r.byte()));
+  }
+
+  state.synced = true;
+  state.flags = flags;
+  return r.pos === payload.length;
+}
+
+function main() {
+  const [input, output] = process.argv.slice(2);
+  if (!input) {
+    console.error("Usage: node tools/traceDecode.js <capture.bin> [output.csv]");
+    process.exit(1);
+  }
+
+  const data = fs.readFileSync(input);
+  const state = { synced: false, timeMs: 0, level: 0, temp: 0, hum: 0 };
+  const columns = ["timeMs", "level", "temp", "hum", ...INPUT_BITS, ...ACTUATOR_BITS, ...SETTINGS, "flags"];
+  const rows = [columns.join(",")];
+  let frames = 0;
+  let crcErrors = 0;
+
+  for (let i = 0; i + 4 <= data.length; i++) {
+    if (data[i] !== SYNC0 || data[i + 1] !== SYNC1) continue;
+
+    const len = data[i + 2];
+    if (i + 4 + len > data.length) break;
+
+    const payload = data.subarray(i + 3, i + 3 + len);
+    if (crc8(payload) !== data[i + 3 + len]) {
+      crcErrors++;
+      state.synced = false; /** Wait for the next keyframe after a corrupted frame */
+      continue;
+    }
+
+    frames++;
+    if (applyRecord(state, payload)) {
+      rows.push(columns.map((c) => (c === "temp" || c === "hum" ? (state[c] / 10).toFixed(1) : state[c] ?? "")).join(","));
+    }
+    i += 3 + len;
+  }
+
+  const csv = rows.join("\n") + "\n";
+  if (output) {
+    fs.writeFileSync(output, csv);
+  } else {
+    process.stdout.write(csv);
+  }
+  console.error(`Decoded ${frames} frames (${rows.length - 1} records), ${crcErrors} CRC errors`);
+}
+
+main();